@@ -0,0 +1,81 @@
+#include "bench_framework.hpp"
+#include <mapnik/image_reader.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/png_encoder.hpp>
+#include <algorithm>
+#include <memory>
+
+// png32 encoders, filters and parallel compression on a 256x256 tile and on
+// a 2048x2048 metatile made of copies of it
+class test : public benchmark::test_case
+{
+    std::shared_ptr<mapnik::image_rgba8> im_;
+    std::string format_;
+
+  public:
+    test(mapnik::parameters const& params, std::string const& format, std::size_t tiles)
+        : test_case(params),
+          format_(format)
+    {
+        std::string filename("./benchmark/data/multicolor.png");
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(filename, "png"));
+        if (!reader.get())
+        {
+            throw mapnik::image_reader_exception("Failed to load: " + filename);
+        }
+        mapnik::image_rgba8 tile(reader->width(), reader->height());
+        reader->read(0, 0, tile);
+        im_ = std::make_shared<mapnik::image_rgba8>(tile.width() * tiles, tile.height() * tiles);
+        for (std::size_t y = 0; y < im_->height(); ++y)
+        {
+            auto const* row = tile.get_row(y % tile.height());
+            for (std::size_t x = 0; x < tiles; ++x)
+            {
+                std::copy(row, row + tile.width(), im_->get_row(y, x * tile.width()));
+            }
+        }
+    }
+    bool validate() const
+    {
+        std::string const out = mapnik::save_to_string(*im_, format_);
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(out.data(), out.size()));
+        if (!reader.get() || reader->width() != im_->width() || reader->height() != im_->height())
+        {
+            return false;
+        }
+        auto decoded = mapnik::util::get<mapnik::image_rgba8>(reader->read(0, 0, reader->width(), reader->height()));
+        return std::equal(decoded.begin(), decoded.end(), im_->begin());
+    }
+    bool operator()() const
+    {
+        std::string out;
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            out.clear();
+            out = mapnik::save_to_string(*im_, format_);
+        }
+        return true;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    mapnik::setup();
+    benchmark::sequencer seq(argc, argv);
+    seq.run<test>("png32 libpng", "png32", 1)
+      .run<test>("png32 libpng f=auto", "png32:f=auto", 1)
+      .run<test>("png32 zlib", "png32:e=zlib", 1)
+      .run<test>("png32 zlib f=auto", "png32:e=zlib:f=auto", 1)
+      .run<test>("png32 zlib z=1 s=rle", "png32:e=zlib:z=1:s=rle", 1)
+      .run<test>("2048 png32 libpng", "png32", 8)
+      .run<test>("2048 png32 zlib f=auto", "png32:e=zlib:f=auto", 8)
+      .run<test>("2048 png32 zlib f=auto j=4", "png32:e=zlib:f=auto:j=4", 8)
+      .run<test>("2048 png32 zlib f=auto j=8", "png32:e=zlib:f=auto:j=8", 8);
+    if (mapnik::png_encoder_available(mapnik::png_encoder::libdeflate))
+    {
+        seq.run<test>("png32 libdeflate", "png32:e=libdeflate", 1)
+          .run<test>("png32 libdeflate f=auto", "png32:e=libdeflate:f=auto", 1)
+          .run<test>("2048 png32 libdeflate f=auto", "png32:e=libdeflate:f=auto", 8);
+    }
+    return seq.done();
+}
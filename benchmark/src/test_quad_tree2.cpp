@@ -0,0 +1,160 @@
+#include "bench_framework.hpp"
+#include <mapnik/label_collision_detector.hpp>
+#include <mapnik/quad_tree.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// quad_tree bulk loading or inserts followed by compact() and collision checks, see test_quad_tree for
+// incremental inserts
+
+using quad_tree_type = mapnik::quad_tree<std::size_t>;
+using item_type = std::pair<std::size_t, mapnik::box2d<double>>;
+
+namespace {
+
+std::vector<item_type> random_boxes(std::size_t count, double max_size)
+{
+    std::default_random_engine engine(42);
+    std::uniform_real_distribution<double> position(0, 2048);
+    std::uniform_real_distribution<double> size(1, max_size);
+    std::vector<item_type> items;
+    items.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        double const cx = position(engine);
+        double const cy = position(engine);
+        double const sx = size(engine);
+        double const sy = size(engine) / 4;
+        items.emplace_back(i, mapnik::box2d<double>(cx - sx, cy - sy, cx + sx, cy + sy));
+    }
+    return items;
+}
+
+std::uint32_t hilbert_index(std::uint32_t x, std::uint32_t y)
+{
+    std::uint32_t index = 0;
+    for (std::uint32_t s = 1u << 15; s > 0; s >>= 1)
+    {
+        std::uint32_t const rx = (x & s) > 0;
+        std::uint32_t const ry = (y & s) > 0;
+        index += s * s * ((3 * rx) ^ ry);
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+} // namespace
+
+class load_tree : public benchmark::test_case
+{
+    std::vector<item_type> items_;
+    bool bulk_;
+
+    void load(quad_tree_type& tree) const
+    {
+        if (bulk_)
+        {
+            tree.bulk_load(items_.begin(), items_.end());
+            return;
+        }
+        for (auto const& item : items_)
+        {
+            tree.insert(item.first, item.second);
+        }
+        tree.compact();
+    }
+
+  public:
+    load_tree(mapnik::parameters const& params, bool sorted, bool bulk)
+        : test_case(params),
+          items_(random_boxes(100000, 20)),
+          bulk_(bulk)
+    {
+        if (sorted)
+        {
+            std::sort(items_.begin(), items_.end(), [](item_type const& a, item_type const& b) {
+                auto const ca = a.second.center();
+                auto const cb = b.second.center();
+                return hilbert_index(ca.x * 32, ca.y * 32) < hilbert_index(cb.x * 32, cb.y * 32);
+            });
+        }
+    }
+
+    bool validate() const
+    {
+        quad_tree_type tree(mapnik::box2d<double>(0, 0, 2048, 2048));
+        load(tree);
+        return tree.count_items() == static_cast<int>(items_.size());
+    }
+
+    bool operator()() const
+    {
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            quad_tree_type tree(mapnik::box2d<double>(0, 0, 2048, 2048));
+            load(tree);
+            std::size_t count = 0;
+            for (std::size_t j = 0; j < 1000; ++j)
+            {
+                auto const& box = items_[j * 97 % items_.size()].second;
+                tree.visit_in_box(box, [&](std::size_t) {
+                    ++count;
+                    return true;
+                });
+            }
+        }
+        return true;
+    }
+};
+
+// label placement on a 2048px metatile, most candidates collide
+class collisions : public benchmark::test_case
+{
+    std::vector<item_type> candidates_;
+
+  public:
+    collisions(mapnik::parameters const& params)
+        : test_case(params),
+          candidates_(random_boxes(20000, 60))
+    {}
+
+    bool validate() const { return true; }
+
+    bool operator()() const
+    {
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            mapnik::label_collision_detector4 detector(mapnik::box2d<double>(0, 0, 2048, 2048));
+            for (auto const& candidate : candidates_)
+            {
+                if (detector.has_placement(candidate.second, 4.0))
+                {
+                    detector.insert(candidate.second);
+                }
+            }
+        }
+        return true;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    return benchmark::sequencer(argc, argv)
+      .run<load_tree>("insert and compact", false, false)
+      .run<load_tree>("insert and compact hilbert order", true, false)
+      .run<load_tree>("bulk load", false, true)
+      .run<load_tree>("bulk load hilbert order", true, true)
+      .run<collisions>("label collisions")
+      .done();
+}
@@ -44,6 +44,9 @@ function(create_pkg_config_file_mapnik _lib_name _description)
     if(USE_PNG)
         list(APPEND m_requires libpng)
     endif()
+    if(USE_PNG AND USE_LIBDEFLATE)
+        list(APPEND m_requires libdeflate)
+    endif()
     if(USE_JPEG)
         list(APPEND m_requires libjpeg)
     endif()
@@ -35,6 +35,7 @@
 #include <mapnik/request.hpp>
 #include <mapnik/symbolizer_enumerations.hpp>
 #include <mapnik/renderer_common.hpp>
+#include <mapnik/resolved_symbolizer.hpp>
 #include <mapnik/image_util.hpp>
 // stl
 #include <memory>
@@ -179,6 +180,9 @@ class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T0>
 
     inline attributes const& variables() const { return common_.vars_; }
 
+    // converted geometries of the layer being rendered, nullptr unless the map sets `geometry-cache`
+    inline geometry_cache const* get_geometry_cache() const { return common_.geometry_cache_.get(); }
+
   protected:
     template<typename R>
     void debug_draw_box(R& buf, box2d<double> const& extent, double x, double y, double angle = 0.0);
@@ -193,6 +197,7 @@ class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T0>
     gamma_method_enum gamma_method_;
     double gamma_;
     renderer_common common_;
+    resolved_symbolizer_cache resolved_symbolizers_;
     void setup(Map const& m, buffer_type& pixmap);
 };
 
@@ -32,6 +32,7 @@
 #include <mapnik/rule.hpp> // for all symbolizers
 #include <mapnik/cairo/cairo_context.hpp>
 #include <mapnik/renderer_common.hpp>
+#include <mapnik/resolved_symbolizer.hpp>
 
 // stl
 #include <memory>
@@ -132,6 +133,7 @@ class MAPNIK_DECL cairo_renderer : public feature_style_processor<cairo_renderer
     Map const& m_;
     cairo_context context_;
     renderer_common common_;
+    resolved_symbolizer_cache resolved_symbolizers_;
     cairo_face_manager face_manager_;
     bool style_level_compositing_;
     void setup(Map const& m);
@@ -30,8 +30,10 @@
 #include <mapnik/util/noncopyable.hpp>
 
 // stl
+#include <future>
 #include <map>
 #include <set>
+#include <string>
 #include <vector>
 #include <memory>
 #include <mutex>
@@ -53,11 +55,24 @@ class MAPNIK_DECL datasource_cache : public singleton<datasource_cache, CreateSt
     std::vector<std::string> plugin_directories() const;
     bool register_datasources(std::string const& path, bool recurse = false);
     bool register_datasource(std::string const& path);
+    // Creates a datasource, or returns the shared one when params contain `shared=true`
     std::shared_ptr<datasource> create(parameters const& params);
+    // Returns the datasource created for an identical parameter set while anything
+    // still holds a reference to it, otherwise creates and registers a new one.
+    // Concurrent callers wait for a single construction. Shared datasources are
+    // queried from many maps at once and must not be modified.
+    std::shared_ptr<datasource> create_shared(parameters const& params);
+    // Forgets the datasource registered for params so the next create_shared()
+    // builds a new one, current holders keep theirs. Returns false if none was registered.
+    bool release_shared(parameters const& params);
+    void clear_shared();
+    // Number of registered datasources that are still alive
+    std::size_t shared_size() const;
 
   private:
     datasource_cache();
     ~datasource_cache();
+    std::shared_ptr<datasource> create_datasource(parameters const& params);
     std::map<std::string, std::shared_ptr<PluginInfo>> plugins_;
     std::set<std::string> plugin_directories_;
     // the singleton has a mutex protecting the instance pointer,
@@ -65,6 +80,10 @@ class MAPNIK_DECL datasource_cache : public singleton<datasource_cache, CreateSt
     // plugins_ and plugin_directories_ members which are potentially
     // modified recusrively by register_datasources(path, true);
     mutable std::recursive_mutex instance_mutex_;
+    // shared datasources by serialized parameters, and the ones being created
+    std::map<std::string, std::weak_ptr<datasource>> shared_;
+    std::map<std::string, std::shared_future<std::shared_ptr<datasource>>> pending_;
+    mutable std::mutex shared_mutex_;
 };
 
 MAPNIK_DISABLE_WARNING_PUSH
@@ -31,10 +31,13 @@
 #include <mapnik/geometry.hpp>
 #include <mapnik/geometry/envelope.hpp>
 //
+#include <mapnik/feature_arena.hpp>
 #include <mapnik/feature_kv_iterator.hpp>
 #include <mapnik/util/noncopyable.hpp>
 
 // stl
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <map>
@@ -50,6 +53,10 @@ class feature_impl;
 
 using raster_ptr = std::shared_ptr<raster>;
 
+// Attribute name to feature data index mapping shared by all features of a
+// featureset. Names are kept in an ordered map for iteration while lookups go
+// through an open addressing table (linear probing, load factor <= 0.5) holding
+// the hash of each name, so a lookup usually costs one hash and one string compare.
 template<typename T>
 class context : private util::noncopyable
 
@@ -64,26 +71,97 @@ class context : private util::noncopyable
     using difference_type = typename map_type::difference_type;
     using iterator = typename map_type::iterator;
     using const_iterator = typename map_type::const_iterator;
+    static constexpr size_type npos = static_cast<size_type>(-1);
 
     context()
-        : mapping_()
+        : mapping_(),
+          slots_()
     {}
 
     inline size_type push(key_type const& name)
     {
         size_type index = mapping_.size();
-        mapping_.emplace(name, index);
+        add(name, index);
         return index;
     }
 
-    inline void add(key_type const& name, size_type index) { mapping_.emplace(name, index); }
+    inline void add(key_type const& name, size_type index)
+    {
+        auto result = mapping_.emplace(name, index);
+        if (result.second)
+        {
+            if ((mapping_.size() << 1) > slots_.size())
+            {
+                rehash(std::max(std::size_t(16), slots_.size() << 1));
+            }
+            else
+            {
+                insert(result.first);
+            }
+        }
+    }
 
     inline size_type size() const { return mapping_.size(); }
+
+    inline const_iterator find(key_type const& name) const
+    {
+        if (slots_.empty())
+            return mapping_.end();
+        std::size_t const hash = std::hash<key_type>()(name);
+        std::size_t const mask = slots_.size() - 1;
+        for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            slot const& s = slots_[i];
+            if (!s.used)
+                return mapping_.end();
+            if (s.hash == hash && s.itr->first == name)
+                return s.itr;
+        }
+    }
+
+    // Resolve `name` once and use feature_impl::get(index) afterwards, returns npos if unknown
+    inline size_type index_of(key_type const& name) const
+    {
+        const_iterator itr = find(name);
+        return itr != mapping_.end() ? itr->second : npos;
+    }
+
     inline const_iterator begin() const { return mapping_.begin(); }
     inline const_iterator end() const { return mapping_.end(); }
 
   private:
+    struct slot
+    {
+        std::size_t hash = 0;
+        const_iterator itr;
+        bool used = false;
+    };
+
+    void insert(const_iterator itr)
+    {
+        std::size_t const hash = std::hash<key_type>()(itr->first);
+        std::size_t const mask = slots_.size() - 1;
+        std::size_t i = hash & mask;
+        while (slots_[i].used)
+        {
+            i = (i + 1) & mask;
+        }
+        slots_[i].hash = hash;
+        slots_[i].itr = itr;
+        slots_[i].used = true;
+    }
+
+    void rehash(std::size_t count)
+    {
+        slots_.assign(count, slot());
+        for (const_iterator itr = mapping_.begin(); itr != mapping_.end(); ++itr)
+        {
+            insert(itr);
+        }
+    }
+
     map_type mapping_;
+    std::vector<slot> slots_;
 };
 
 using context_type = context<std::map<std::string, std::size_t>>;
@@ -98,13 +176,18 @@ class MAPNIK_DECL feature_impl : private util::noncopyable
   public:
 
     using value_type = mapnik::value;
-    using cont_type = std::vector<value_type>;
+    using cont_type = std::vector<value_type, arena_allocator<value_type>>;
     using iterator = feature_kv_iterator;
 
     feature_impl(context_ptr const& ctx, mapnik::value_integer _id)
+        : feature_impl(ctx, _id, cont_type::allocator_type())
+    {}
+
+    // attributes are allocated with `alloc`, see feature_factory::create_transient
+    feature_impl(context_ptr const& ctx, mapnik::value_integer _id, cont_type::allocator_type const& alloc)
         : id_(_id),
           ctx_(ctx),
-          data_(ctx_->mapping_.size()),
+          data_(ctx_->mapping_.size(), alloc),
           geom_(geometry::geometry_empty()),
           raster_()
     {}
@@ -125,8 +208,8 @@ class MAPNIK_DECL feature_impl : private util::noncopyable
 
     inline void put(context_type::key_type const& key, value&& val)
     {
-        context_type::map_type::const_iterator itr = ctx_->mapping_.find(key);
-        if (itr != ctx_->mapping_.end() && itr->second < data_.size())
+        context_type::const_iterator itr = ctx_->find(key);
+        if (itr != ctx_->end() && itr->second < data_.size())
         {
             data_[itr->second] = std::move(val);
         }
@@ -138,8 +221,8 @@ class MAPNIK_DECL feature_impl : private util::noncopyable
 
     inline void put_new(context_type::key_type const& key, value&& val)
     {
-        context_type::map_type::const_iterator itr = ctx_->mapping_.find(key);
-        if (itr != ctx_->mapping_.end() && itr->second < data_.size())
+        context_type::const_iterator itr = ctx_->find(key);
+        if (itr != ctx_->end() && itr->second < data_.size())
         {
             data_[itr->second] = std::move(val);
         }
@@ -151,17 +234,18 @@ class MAPNIK_DECL feature_impl : private util::noncopyable
         }
     }
 
-    inline bool has_key(context_type::key_type const& key) const { return (ctx_->mapping_.count(key) == 1); }
+    inline bool has_key(context_type::key_type const& key) const { return ctx_->find(key) != ctx_->end(); }
 
     inline value_type const& get(context_type::key_type const& key) const
     {
-        context_type::map_type::const_iterator itr = ctx_->mapping_.find(key);
-        if (itr != ctx_->mapping_.end())
+        context_type::const_iterator itr = ctx_->find(key);
+        if (itr != ctx_->end())
             return get(itr->second);
         else
             return default_feature_value;
     }
 
+    // index as returned by context_type::index_of
     inline value_type const& get(std::size_t index) const
     {
         if (index < data_.size())
@@ -177,6 +261,8 @@ class MAPNIK_DECL feature_impl : private util::noncopyable
 
     inline context_ptr context() const { return ctx_; }
 
+    inline context_type const& get_context() const { return *ctx_; }
+
     inline void set_geometry(geometry::geometry<double>&& geom) { geom_ = std::move(geom); }
 
     inline void set_geometry_copy(geometry::geometry<double> const& geom) { geom_ = geom; }
@@ -0,0 +1,145 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_FEATURE_ARENA_HPP
+#define MAPNIK_FEATURE_ARENA_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace mapnik {
+
+// Monotonic memory arena for features created during a render pass, holding the
+// features and their attribute vectors (geometries use the heap). Memory is
+// never released piecemeal, the whole arena is freed once the last feature
+// allocated from it is gone: a single feature kept beyond the render pass (by a
+// cache or the caller) retains its whole arena, up to `capacity` bytes of a
+// scope. Arenas are only allocated from by the thread which installed them (see
+// feature_arena::scope) and need no locking.
+class MAPNIK_DECL feature_arena : private util::noncopyable
+{
+  public:
+    static constexpr std::size_t block_size = 64 * 1024;
+    // a scope switches to a fresh arena once this many bytes were handed out,
+    // which bounds the memory a surviving feature can retain
+    static constexpr std::size_t default_capacity = 1024 * 1024;
+
+    feature_arena();
+    ~feature_arena();
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+    std::size_t allocated() const { return allocated_; }
+    std::size_t blocks() const { return blocks_.size(); }
+
+    // Installs an arena for the calling thread for the lifetime of the scope.
+    // Scopes nest, a disabled scope hides any enclosing one.
+    class MAPNIK_DECL scope : private util::noncopyable
+    {
+      public:
+        explicit scope(bool enabled = true, std::size_t capacity = default_capacity);
+        ~scope();
+
+      private:
+        friend class feature_arena;
+        std::shared_ptr<feature_arena> arena_;
+        std::size_t capacity_;
+        scope* previous_;
+    };
+
+    // Arena of the innermost scope on this thread, nullptr if there is none
+    static std::shared_ptr<feature_arena> current();
+
+  private:
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::byte* ptr_;
+    std::size_t space_;
+    std::size_t allocated_;
+};
+
+// Allocator keeping its arena alive, for std::allocate_shared and the attribute
+// vectors of features. Without an arena it allocates from the heap. Containers
+// keep their allocator when copied into, so a feature allocated from an arena
+// keeps its attributes there.
+template<typename T>
+class arena_allocator
+{
+  public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    arena_allocator() noexcept = default;
+
+    explicit arena_allocator(std::shared_ptr<feature_arena> arena) noexcept
+        : arena_(std::move(arena))
+    {}
+
+    template<typename U>
+    arena_allocator(arena_allocator<U> const& other) noexcept
+        : arena_(other.arena())
+    {}
+
+    T* allocate(std::size_t n)
+    {
+        if (arena_)
+        {
+            return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (!arena_)
+        {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    std::shared_ptr<feature_arena> const& arena() const { return arena_; }
+
+    template<typename U>
+    bool operator==(arena_allocator<U> const& other) const
+    {
+        return arena_ == other.arena();
+    }
+
+    template<typename U>
+    bool operator!=(arena_allocator<U> const& other) const
+    {
+        return arena_ != other.arena();
+    }
+
+  private:
+    std::shared_ptr<feature_arena> arena_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_FEATURE_ARENA_HPP
@@ -25,6 +25,7 @@
 
 // mapnik
 #include <mapnik/feature.hpp>
+#include <mapnik/feature_arena.hpp>
 #include <mapnik/value/types.hpp>
 
 // boost
@@ -39,6 +40,19 @@ struct feature_factory
         // return boost::allocate_shared<feature_impl>(boost::fast_pool_allocator<feature_impl>(),fid);
         return std::make_shared<feature_impl>(ctx, fid);
     }
+
+    // Features which don't outlive the render pass are allocated, together with
+    // their attributes, from the arena installed by feature_arena::scope, if any.
+    static std::shared_ptr<feature_impl> create_transient(context_ptr const& ctx, mapnik::value_integer fid)
+    {
+        std::shared_ptr<feature_arena> arena = feature_arena::current();
+        if (arena)
+        {
+            arena_allocator<feature_impl> alloc(std::move(arena));
+            return std::allocate_shared<feature_impl>(alloc, ctx, fid, feature_impl::cont_type::allocator_type(alloc));
+        }
+        return std::make_shared<feature_impl>(ctx, fid);
+    }
 };
 } // namespace mapnik
 
@@ -0,0 +1,123 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_FEATURE_QUERY_CACHE_HPP
+#define MAPNIK_FEATURE_QUERY_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/datasource.hpp>
+#include <mapnik/query.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/util/featureset_buffer.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace mapnik {
+
+// Features queried during a single render pass, shared between the layers and
+// styles querying the same data. A query is answered by an earlier query of an
+// equal datasource (see datasource::operator==) with the same resolution, scale
+// denominator, unbuffered extent and variables, whose bounding box contains the
+// new one and which fetched at least the same attributes. Features outside a
+// smaller bounding box are filtered out on reuse. Raster datasources are never
+// shared. The cache is only used from the rendering thread.
+//
+// Layers reserve their query in rendering order before the first one is
+// rendered, so the features of an entry are released as soon as its last
+// reader has read them instead of at the end of the pass.
+class MAPNIK_DECL feature_query_cache : private util::noncopyable
+{
+  public:
+    using feature_list = std::vector<feature_ptr>;
+    using result_type = std::shared_future<std::shared_ptr<feature_list const>>;
+
+    struct entry
+    {
+        datasource_ptr ds;
+        query q;
+        // invalid until the first reader fetched the features
+        result_type features;
+        // envelopes of `features`, computed on the first filtered reuse
+        std::vector<box2d<double>> envelopes;
+        // reservations which didn't read the features yet
+        std::size_t readers;
+    };
+
+    struct lookup
+    {
+        std::shared_ptr<entry> source;
+        box2d<double> bbox;
+        bool filter;
+    };
+
+    feature_query_cache();
+
+    // Reserves the features of `q` for one reader, sharing the entry of an
+    // earlier reservation which answers it.
+    lookup reserve(datasource_ptr const& ds, query const& q);
+    // Drops the reservation of `l` once its reader is done with the features
+    // returned by features(), the last one releases them.
+    void release(lookup const& l);
+
+    // Calls `fetch()` for a result_type holding the features of a reservation
+    // unless an earlier reader of the same entry already did.
+    template<typename Fetch>
+    static void fetch(lookup const& l, Fetch&& fetch)
+    {
+        if (!l.source->features.valid())
+        {
+            l.source->features = fetch();
+        }
+    }
+
+    // true when nothing but the reader of `l` reads its features
+    static bool exclusive(lookup const& l) { return l.source->readers == 1 && !l.source->features.valid(); }
+
+    lookup find(datasource const& ds, query const& q) const;
+    void clear();
+
+    std::size_t size() const { return entries_.size(); }
+    std::size_t hits() const { return hits_; }
+    std::size_t misses() const { return misses_; }
+
+    // single reader lookup of a query which isn't shared through a cache
+    static lookup make_lookup(datasource_ptr const& ds, query const& q, result_type features);
+    // drains `features` into a list
+    static std::shared_ptr<feature_list const> collect(featureset_ptr const& features);
+    static result_type make_ready(std::shared_ptr<feature_list const> features);
+    // Features of a lookup ready for replay. Blocks until the result is available.
+    static std::shared_ptr<featureset_buffer> features(lookup const& l);
+
+  private:
+    std::vector<std::shared_ptr<entry>> entries_;
+    std::size_t hits_;
+    std::size_t misses_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_FEATURE_QUERY_CACHE_HPP
@@ -43,6 +43,8 @@ class proj_transform;
 class feature_type_style;
 class rule_cache;
 struct layer_rendering_material;
+struct layer_query_pipeline;
+class feature_query_cache;
 
 enum eAttributeCollectionPolicy { DEFAULT = 0, COLLECT_ALL = 1 };
 
@@ -117,6 +119,8 @@ class feature_style_processor
     void render_submaterials(layer_rendering_material const& mat, Processor& p);
 
     Map const& m_;
+    layer_query_pipeline* pipeline_;
+    feature_query_cache* query_cache_;
 };
 } // namespace mapnik
 
@@ -29,6 +29,9 @@
 #include <mapnik/map.hpp>
 #include <mapnik/debug.hpp>
 #include <mapnik/feature.hpp>
+#include <mapnik/feature_arena.hpp>
+#include <mapnik/feature_query_cache.hpp>
+#include <mapnik/boolean.hpp>
 #include <mapnik/feature_style_processor.hpp>
 #include <mapnik/query.hpp>
 #include <mapnik/datasource.hpp>
@@ -45,9 +48,13 @@
 #include <mapnik/util/featureset_buffer.hpp>
 #include <mapnik/util/variant.hpp>
 #include <mapnik/symbolizer_dispatch.hpp>
+#include <mapnik/thread_pool.hpp>
 
 // stl
 #include <vector>
+#include <deque>
+#include <future>
+#include <optional>
 #include <stdexcept>
 
 namespace mapnik {
@@ -63,6 +70,10 @@ struct layer_rendering_material
     std::vector<featureset_ptr> featureset_ptr_list_;
     std::vector<rule_cache> rule_caches_;
     std::vector<layer_rendering_material> materials_;
+    // query deferred to the layer_query_pipeline or the feature_query_cache
+    std::optional<query> query_;
+    // reservation of query_ in the feature_query_cache, if the layer caches its features
+    feature_query_cache::lookup cached_{};
 
     layer_rendering_material(layer const& lay, projection const& dest)
         : lay_(lay),
@@ -73,9 +84,123 @@ struct layer_rendering_material
     layer_rendering_material(layer_rendering_material&& rhs) = default;
 };
 
+// Issues deferred layer queries on the shared thread pool in rendering order and
+// drains them into featureset buffers, keeping at most `lookahead` layers ahead of
+// the layer currently being rendered. Enabled with the `query-threads` map parameter
+// for layers that set `query-ahead`, since their datasource is then queried off the
+// rendering thread.
+struct layer_query_pipeline
+{
+    layer_query_pipeline(layer_query_pipeline*& owner,
+                         feature_query_cache& cache,
+                         std::size_t lookahead,
+                         bool use_arena = false)
+        : owner_(owner),
+          cache_(cache),
+          lookahead_(lookahead),
+          use_arena_(use_arena),
+          next_(0),
+          consumed_(0)
+    {
+        if (lookahead_ > 0 && thread_pool::instance().size() > 0)
+        {
+            owner_ = this;
+        }
+    }
+
+    ~layer_query_pipeline() { owner_ = nullptr; }
+
+    // collect deferred materials in the order render_submaterials visits them
+    void collect(layer_rendering_material const& parent_mat)
+    {
+        for (layer_rendering_material const& mat : parent_mat.materials_)
+        {
+            if (!mat.active_styles_.empty())
+            {
+                if (mat.query_ && mat.lay_.query_ahead())
+                {
+                    pending_.push_back(&mat);
+                }
+                collect(mat);
+            }
+        }
+    }
+
+    void start() { fill(); }
+
+    std::shared_ptr<featureset_buffer> fetch(layer_rendering_material const& mat)
+    {
+        if (consumed_ >= pending_.size() || pending_[consumed_] != &mat)
+        {
+            throw std::runtime_error("feature_style_processor: layer query pipeline out of order");
+        }
+        feature_query_cache::lookup features = std::move(lookups_.front());
+        lookups_.pop_front();
+        ++consumed_;
+        fill();
+        thread_pool::instance().wait(features.source->features);
+        std::shared_ptr<featureset_buffer> buffer = feature_query_cache::features(features);
+        cache_.release(features);
+        return buffer;
+    }
+
+  private:
+    void fill()
+    {
+        while (next_ < pending_.size() && next_ < consumed_ + lookahead_)
+        {
+            layer_rendering_material const& mat = *pending_[next_++];
+            datasource_ptr ds = mat.lay_.datasource();
+            query const& q = *mat.query_;
+            auto submit = [&ds, &q, use_arena = use_arena_]() {
+                return thread_pool::instance()
+                  .submit([ds, q, use_arena]() {
+                      feature_arena::scope arena(use_arena);
+                      return feature_query_cache::collect(ds->features_with_context(q, processor_context_ptr()));
+                  })
+                  .share();
+            };
+            if (mat.cached_.source)
+            {
+                feature_query_cache::fetch(mat.cached_, submit);
+                lookups_.push_back(mat.cached_);
+            }
+            else
+            {
+                lookups_.push_back(feature_query_cache::make_lookup(ds, q, submit()));
+            }
+        }
+    }
+
+    layer_query_pipeline*& owner_;
+    feature_query_cache& cache_;
+    std::size_t lookahead_;
+    bool use_arena_;
+    std::size_t next_;
+    std::size_t consumed_;
+    std::vector<layer_rendering_material const*> pending_;
+    std::deque<feature_query_cache::lookup> lookups_;
+};
+
+// Points the processor at the query cache of the current pass
+struct scoped_query_cache
+{
+    scoped_query_cache(feature_query_cache*& owner, feature_query_cache& cache)
+        : owner_(owner)
+    {
+        owner_ = &cache;
+    }
+
+    ~scoped_query_cache() { owner_ = nullptr; }
+
+    feature_query_cache*& owner_;
+};
+
 template<typename Processor>
 feature_style_processor<Processor>::feature_style_processor(Map const& m, double scale_factor)
-    : m_(m)
+    : m_(m),
+      pipeline_(nullptr),
+      query_cache_(nullptr)
 {
     // https://github.com/mapnik/mapnik/issues/1100
     if (scale_factor <= 0)
@@ -123,6 +248,10 @@ template<typename Processor>
 void feature_style_processor<Processor>::apply(double scale_denom)
 {
     Processor& p = static_cast<Processor&>(*this);
+    // Optionally allocate the features of this pass from per-thread arenas,
+    // released once the last feature is gone after end_map_processing.
+    bool const use_arena = *m_.get_extra_parameters().get<boolean_type>("feature-arena", false);
+    feature_arena::scope arena(use_arena);
     p.start_map_processing(m_);
 
     projection proj(m_.srs(), true);
@@ -140,11 +269,24 @@ void feature_style_processor<Processor>::apply(double scale_denom)
     // implementing asynchronous queries
     feature_style_context_map ctx_map;
 
+    // Optionally issue the queries of the remaining layers on the shared
+    // thread pool while earlier layers are rendered. Painting order is unchanged.
+    value_integer const query_threads = *m_.get_extra_parameters().get<value_integer>("query-threads", 0);
+    // Layers caching their features share query results for the whole pass
+    feature_query_cache query_cache;
+    scoped_query_cache cache_guard(query_cache_, query_cache);
+    layer_query_pipeline pipeline(pipeline_,
+                                  query_cache,
+                                  query_threads > 0 ? static_cast<std::size_t>(query_threads) : 0,
+                                  use_arena);
+
     if (!m_.layers().empty())
     {
         layer_rendering_material root_mat(m_.layers().front(), proj);
         prepare_layers(root_mat, m_.layers(), ctx_map, p, scale_denom);
 
+        pipeline.collect(root_mat);
+        pipeline.start();
         render_submaterials(root_mat, p);
     }
 
@@ -157,12 +299,15 @@ void feature_style_processor<Processor>::apply(mapnik::layer const& lyr,
                                                double scale_denom)
 {
     Processor& p = static_cast<Processor&>(*this);
+    feature_arena::scope arena(*m_.get_extra_parameters().get<boolean_type>("feature-arena", false));
     p.start_map_processing(m_);
     projection proj(m_.srs(), true);
     if (scale_denom <= 0.0)
         scale_denom = mapnik::scale_denominator(m_.scale(), proj.is_geographic());
     scale_denom *= p.scale_factor();
 
+    feature_query_cache query_cache;
+    scoped_query_cache cache_guard(query_cache_, query_cache);
     if (lyr.visible(scale_denom))
     {
         apply_to_layer(lyr,
@@ -437,6 +582,20 @@ void feature_style_processor<Processor>::prepare_layer(layer_rendering_material&
         q.add_property_name((*sort_by).first);
     }
 
+    // Datasources without asynchronous processing context of layers with
+    // `query-ahead` are queried ahead of rendering by the query pipeline,
+    // see apply(). Layers caching their features are queried through the
+    // feature_query_cache.
+    if (!current_ctx && ((pipeline_ && lay.query_ahead()) || (query_cache_ && lay.cache_features())))
+    {
+        if (query_cache_ && lay.cache_features())
+        {
+            mat.cached_ = query_cache_->reserve(ds, q);
+        }
+        mat.query_ = std::move(q);
+        return;
+    }
+
     bool cache_features = lay.cache_features() && active_styles.size() > 1;
 
     std::vector<featureset_ptr>& featureset_ptr_list = mat.featureset_ptr_list_;
@@ -474,8 +633,33 @@ template<typename Processor>
 void feature_style_processor<Processor>::render_material(layer_rendering_material const& mat, Processor& p)
 {
     std::vector<feature_type_style const*> const& active_styles = mat.active_styles_;
-    std::vector<featureset_ptr> const& featureset_ptr_list = mat.featureset_ptr_list_;
-    if (featureset_ptr_list.empty())
+    std::vector<featureset_ptr> streamed;
+    std::shared_ptr<featureset_buffer> prefetched;
+    if (pipeline_ && mat.query_ && mat.lay_.query_ahead())
+    {
+        prefetched = pipeline_->fetch(mat);
+    }
+    else if (mat.query_)
+    {
+        datasource_ptr ds = mat.lay_.datasource();
+        query const& q = *mat.query_;
+        if (active_styles.size() == 1 && feature_query_cache::exclusive(mat.cached_))
+        {
+            // a single style reading features no other layer shares, no need to buffer them
+            streamed.push_back(ds->features_with_context(q, processor_context_ptr()));
+        }
+        else
+        {
+            feature_query_cache::fetch(mat.cached_, [&ds, &q]() {
+                return feature_query_cache::make_ready(
+                  feature_query_cache::collect(ds->features_with_context(q, processor_context_ptr())));
+            });
+            prefetched = feature_query_cache::features(mat.cached_);
+        }
+        query_cache_->release(mat.cached_);
+    }
+    std::vector<featureset_ptr> const& featureset_ptr_list = mat.query_ ? streamed : mat.featureset_ptr_list_;
+    if (featureset_ptr_list.empty() && !prefetched)
     {
         // The datasource wasn't queried because of early return
         // but we have to apply compositing operations on styles
@@ -498,9 +682,14 @@ void feature_style_processor<Processor>::render_material(layer_rendering_materia
     auto sort_by = lay.sort_by();
     std::string group_by = lay.group_by();
 
+    if (prefetched)
+    {
+        prefetched->prepare();
+    }
+
     if (sort_by) // sort features
     {
-        featureset_ptr features = *featureset_ptr_list.begin();
+        featureset_ptr features = prefetched ? prefetched : *featureset_ptr_list.begin();
         if (features)
         {
             std::shared_ptr<featureset_buffer> cache = std::make_shared<featureset_buffer>();
@@ -522,7 +711,7 @@ void feature_style_processor<Processor>::render_material(layer_rendering_materia
     else if (!group_by.empty())
     {
         // Render incrementally when the column that we group by changes value.
-        featureset_ptr features = *featureset_ptr_list.begin();
+        featureset_ptr features = prefetched ? prefetched : *featureset_ptr_list.begin();
         if (features)
         {
             // Cache all features into the memory_datasource before rendering.
@@ -556,10 +745,11 @@ void feature_style_processor<Processor>::render_material(layer_rendering_materia
             cache->clear();
         }
     }
-    else if (cache_features)
+    else if (cache_features || prefetched)
     {
-        std::shared_ptr<featureset_buffer> cache = std::make_shared<featureset_buffer>();
-        featureset_ptr features = *featureset_ptr_list.begin();
+        // Features queried ahead are already buffered
+        std::shared_ptr<featureset_buffer> cache = prefetched ? prefetched : std::make_shared<featureset_buffer>();
+        featureset_ptr features = prefetched ? featureset_ptr() : *featureset_ptr_list.begin();
         if (features)
         {
             // Cache all features into the memory_datasource before rendering.
@@ -603,18 +793,20 @@ void feature_style_processor<Processor>::render_style(Processor& p,
         return;
     }
     mapnik::attributes vars = p.variables();
+    filter_program::evaluator filters(rc.get_filter_program(), vars);
+    rule_cache::rule_ptrs const& if_rules = rc.get_if_rules();
+    rule_cache::filter_indices const& if_filters = rc.get_if_filters();
     feature_ptr feature;
     bool was_painted = false;
     while ((feature = features->next()))
     {
         bool do_else = true;
         bool do_also = false;
-        for (rule const* r : rc.get_if_rules())
+        filters.start(*feature);
+        for (std::size_t index = 0; index < if_rules.size(); ++index)
         {
-            expression_ptr const& expr = r->get_filter();
-            value_type result =
-              util::apply_visitor(evaluate<feature_impl, value_type, attributes>(*feature, vars), *expr);
-            if (result.to_bool())
+            rule const* r = if_rules[index];
+            if (filters.pass(if_filters[index]))
             {
                 was_painted = true;
                 do_else = false;
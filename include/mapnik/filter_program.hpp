@@ -0,0 +1,136 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_FILTER_PROGRAM_HPP
+#define MAPNIK_FILTER_PROGRAM_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/attribute.hpp>
+#include <mapnik/expression.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/value.hpp>
+
+// stl
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mapnik {
+
+// Rule filters flattened into a single DAG of instructions. Children always
+// precede their parents and identical sub-expressions shared by several filters
+// (e.g. `[highway]` or `[zoom] > 10`) are emitted once. Attribute names are resolved
+// to feature data indices when the evaluator sees a new context, not per lookup.
+class MAPNIK_DECL filter_program
+{
+  public:
+    enum class opcode : std::uint8_t {
+        constant,
+        attribute,
+        global_attribute,
+        geometry_type,
+        negate,
+        plus,
+        minus,
+        mult,
+        div,
+        mod,
+        less,
+        less_equal,
+        greater,
+        greater_equal,
+        equal_to,
+        not_equal_to,
+        logical_not,
+        logical_and,
+        logical_or,
+        regex_match,
+        regex_replace,
+        unary_function,
+        binary_function
+    };
+
+    struct instruction
+    {
+        opcode op;
+        std::uint32_t left;
+        std::uint32_t right;
+        // index into constants, attribute names, global names or the AST node (regex/function)
+        std::uint32_t data;
+        void const* node;
+    };
+
+    filter_program() = default;
+    filter_program(filter_program&&) = default;
+    filter_program& operator=(filter_program&&) = default;
+
+    // Compile `expr` into the program and return the instruction holding its result
+    std::uint32_t add(expression_ptr const& expr);
+
+    std::vector<instruction> const& instructions() const { return instructions_; }
+    std::vector<std::string> const& attribute_names() const { return attribute_names_; }
+    std::vector<std::string> const& global_names() const { return global_names_; }
+    std::vector<value> const& constants() const { return constants_; }
+
+    // Per render evaluation state, intermediate results are memoized per feature
+    class MAPNIK_DECL evaluator
+    {
+      public:
+        evaluator(filter_program const& program, attributes const& vars);
+
+        // Must be called for each feature before evaluating any filter against it
+        void start(feature_impl const& feature);
+        value const& eval(std::uint32_t index);
+        bool pass(std::uint32_t index) { return eval(index).to_bool(); }
+
+      private:
+        void bind(context_type const& ctx);
+        value compute(instruction const& ins);
+
+        filter_program const& program_;
+        std::vector<value> globals_;
+        std::vector<std::size_t> attribute_index_;
+        std::vector<value> values_;
+        std::vector<std::uint32_t> stamps_;
+        std::uint32_t generation_ = 0;
+        feature_impl const* feature_ = nullptr;
+        context_type const* context_ = nullptr;
+        std::size_t context_size_ = 0;
+    };
+
+  private:
+    friend struct filter_compiler;
+    std::uint32_t emit(std::string const& key, instruction const& ins);
+
+    std::vector<instruction> instructions_;
+    std::vector<std::string> attribute_names_;
+    std::vector<std::string> global_names_;
+    std::vector<value> constants_;
+    std::vector<expression_ptr> expressions_; // keeps regex and function nodes alive
+    std::unordered_map<std::string, std::uint32_t> keys_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_FILTER_PROGRAM_HPP
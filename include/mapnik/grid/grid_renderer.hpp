@@ -35,6 +35,7 @@
 #include <mapnik/image_compositing.hpp> // for composite_mode_e
 #include <mapnik/pixel_position.hpp>
 #include <mapnik/renderer_common.hpp>
+#include <mapnik/resolved_symbolizer.hpp>
 
 // stl
 #include <memory>
@@ -120,6 +121,7 @@ class MAPNIK_DECL grid_renderer : public feature_style_processor<grid_renderer<T
     buffer_type& pixmap_;
     std::unique_ptr<grid_rasterizer> const ras_ptr;
     renderer_common common_;
+    resolved_symbolizer_cache resolved_symbolizers_;
     void setup(Map const& m);
 };
 } // namespace mapnik
@@ -25,6 +25,7 @@
 
 // mapnik
 #include <mapnik/global.hpp>
+#include <mapnik/image_simd.hpp>
 #include <mapnik/palette.hpp>
 #include <mapnik/util/noncopyable.hpp>
 
@@ -116,6 +117,8 @@ class hextree : private util::noncopyable
     std::unique_ptr<node> const root_;
     // working palette for quantization, sorted on mean(r,g,b,a) for easier searching NN
     std::vector<rgba> sorted_pal_;
+    // sorted_pal_ packed like image pixels for the vector search
+    std::vector<std::uint32_t> packed_pal_;
     // index remaping of sorted_pal_ indexes to indexes of returned image palette
     std::vector<unsigned> pal_remap_;
     // rgba hashtable for quantization
@@ -179,6 +182,9 @@ class hextree : private util::noncopyable
         }
     }
 
+    // pixels with this alpha are only recorded as holes by insert()
+    bool is_hole(std::uint8_t a) const { return preprocessAlpha(a) < InsertPolicy::MIN_ALPHA; }
+
     void insert(T const& data)
     {
         std::uint8_t a = preprocessAlpha(data.a);
@@ -244,6 +250,16 @@ class hextree : private util::noncopyable
             ind = pit - sorted_pal_.begin();
             if (ind == sorted_pal_.size())
                 ind--;
+
+            // the vector search finds the same color as the neighbour search below
+            // when the sorted position was looked up with the compared alpha
+            std::size_t nearest;
+            if (a == c.a && simd::nearest_rgba8(packed_pal_.data(), packed_pal_.size(), val, ind, nearest))
+            {
+                color_hashmap_[val] = nearest;
+                return pal_remap_[nearest];
+            }
+
             dr = sorted_pal_[ind].r - c.r;
             dg = sorted_pal_[ind].g - c.g;
             db = sorted_pal_[ind].b - c.b;
@@ -314,6 +330,12 @@ class hextree : private util::noncopyable
 
         // sort palette for binary searching in quantization
         std::sort(sorted_pal_.begin(), sorted_pal_.end(), rgba::mean_sort_cmp());
+        packed_pal_.clear();
+        packed_pal_.reserve(sorted_pal_.size());
+        for (rgba const& c : sorted_pal_)
+        {
+            packed_pal_.push_back(c.r | (c.g << 8) | (c.b << 16) | (c.a << 24));
+        }
         // returned palette is rearanged, so that colors with a<255 are at the begining
         pal_remap_.resize(sorted_pal_.size());
         palette.clear();
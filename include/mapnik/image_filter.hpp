@@ -25,7 +25,9 @@
 
 // mapnik
 #include <mapnik/image_filter_types.hpp>
+#include <mapnik/image_simd.hpp>
 #include <mapnik/image_util.hpp>
+#include <mapnik/thread_pool.hpp>
 #include <mapnik/util/hsl.hpp>
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -50,7 +52,12 @@ MAPNIK_DISABLE_WARNING_PUSH
 MAPNIK_DISABLE_WARNING_POP
 
 // stl
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
 
 #if BOOST_VERSION >= 106800
 namespace boost {
@@ -140,6 +147,17 @@ static float const emboss_matrix[] = {-2, -1, 0, -1, 1, 1, 0, 1, 2};
 static float const sharpen_matrix[] = {0, -1, 0, -1, 5, -1, 0, -1, 0};
 static float const edge_detect_matrix[] = {0, 1, 0, 1, -4, 1, 0, 1, 0};
 
+// Filters process the image in bands of rows on the shared thread_pool,
+// a band covers at least this many pixels.
+constexpr std::size_t min_band_pixels = 1 << 16;
+
+template<typename F>
+void for_each_band(std::size_t rows, std::size_t row_pixels, F const& f)
+{
+    std::size_t const grain = std::max(min_band_pixels / std::max(row_pixels, std::size_t(1)), std::size_t(1));
+    thread_pool::instance().parallel_for(rows, grain, f);
+}
+
 } // namespace detail
 
 using boost::gil::rgba8_image_t;
@@ -232,164 +250,64 @@ void process_channel(Src const& src, Dst& dst, mapnik::filter::sobel)
     dst = out_value;
 }
 
+// p0 p1 p2
+// p3 p4 p5
+// p6 p7 p8
+//
+// Rows y0 to y1 of dst_view. Rows outside the image are mirrored across
+// the edge row, columns are clamped to the edge column.
 template<typename Src, typename Dst, typename Filter>
-void apply_convolution_3x3(Src const& src_view, Dst& dst_view, Filter const& filter)
+void apply_convolution_3x3(Src const& src_view,
+                           Dst& dst_view,
+                           Filter const& filter,
+                           std::ptrdiff_t y0,
+                           std::ptrdiff_t y1)
 {
     using boost::gil::bits32f;
-    using boost::gil::point2;
-
-    // p0 p1 p2
-    // p3 p4 p5
-    // p6 p7 p8
-
-    typename Src::xy_locator src_loc = src_view.xy_at(0, 0);
-    typename Src::xy_locator::cached_location_t loc00 = src_loc.cache_location(-1, -1);
-    typename Src::xy_locator::cached_location_t loc10 = src_loc.cache_location(0, -1);
-    typename Src::xy_locator::cached_location_t loc20 = src_loc.cache_location(1, -1);
-    typename Src::xy_locator::cached_location_t loc01 = src_loc.cache_location(-1, 0);
-    typename Src::xy_locator::cached_location_t loc11 = src_loc.cache_location(0, 0);
-    typename Src::xy_locator::cached_location_t loc21 = src_loc.cache_location(1, 0);
-    typename Src::xy_locator::cached_location_t loc02 = src_loc.cache_location(-1, 1);
-    typename Src::xy_locator::cached_location_t loc12 = src_loc.cache_location(0, 1);
-    typename Src::xy_locator::cached_location_t loc22 = src_loc.cache_location(1, 1);
-
-    typename Src::x_iterator dst_it = dst_view.row_begin(0);
-
-    // top row
-    for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
-    {
-        (*dst_it)[3] = src_loc[loc11][3]; // Dst.a = Src.a
-        for (std::ptrdiff_t i = 0; i < 3; ++i)
-        {
-            bits32f p[9];
-
-            p[4] = src_loc[loc11][i];
-            p[7] = src_loc[loc12][i];
-
-            if (x == 0)
-            {
-                p[3] = p[4];
-                p[6] = p[7];
-            }
-            else
-            {
-                p[3] = src_loc[loc01][i];
-                p[6] = src_loc[loc02][i];
-            }
-
-            if (x == (src_view.width()) - 1)
-            {
-                p[5] = p[4];
-                p[8] = p[7];
-            }
-            else
-            {
-                p[5] = src_loc[loc21][i];
-                p[8] = src_loc[loc22][i];
-            }
-
-            p[0] = p[6];
-            p[1] = p[7];
-            p[2] = p[8];
 
-            process_channel(p, (*dst_it)[i], filter);
-        }
-        ++src_loc.x();
-        ++dst_it;
-    }
-    // carrige-return
-    src_loc += point2<std::ptrdiff_t>(-src_view.width(), 1);
-
-    // 1... height-1 rows
-    for (std::ptrdiff_t y = 1; y < src_view.height() - 1; ++y)
+    std::ptrdiff_t const width = src_view.width();
+    std::ptrdiff_t const height = src_view.height();
+    for (std::ptrdiff_t y = y0; y < y1; ++y)
     {
-        for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
+        std::ptrdiff_t above = (y > 0) ? y - 1 : std::min(y + 1, height - 1);
+        std::ptrdiff_t below = (y < height - 1) ? y + 1 : std::max(y - 1, std::ptrdiff_t(0));
+        typename Src::x_iterator row0 = src_view.row_begin(above);
+        typename Src::x_iterator row1 = src_view.row_begin(y);
+        typename Src::x_iterator row2 = src_view.row_begin(below);
+        typename Dst::x_iterator dst_it = dst_view.row_begin(y);
+        for (std::ptrdiff_t x = 0; x < width; ++x)
         {
-            (*dst_it)[3] = src_loc[loc11][3]; // Dst.a = Src.a
+            std::ptrdiff_t left = (x > 0) ? x - 1 : x;
+            std::ptrdiff_t right = (x < width - 1) ? x + 1 : x;
+            dst_it[x][3] = row1[x][3]; // Dst.a = Src.a
             for (std::ptrdiff_t i = 0; i < 3; ++i)
             {
                 bits32f p[9];
-
-                p[1] = src_loc[loc10][i];
-                p[4] = src_loc[loc11][i];
-                p[7] = src_loc[loc12][i];
-
-                if (x == 0)
-                {
-                    p[0] = p[1];
-                    p[3] = p[4];
-                    p[6] = p[7];
-                }
-                else
-                {
-                    p[0] = src_loc[loc00][i];
-                    p[3] = src_loc[loc01][i];
-                    p[6] = src_loc[loc02][i];
-                }
-
-                if (x == (src_view.width()) - 1)
-                {
-                    p[2] = p[1];
-                    p[5] = p[4];
-                    p[8] = p[7];
-                }
-                else
-                {
-                    p[2] = src_loc[loc20][i];
-                    p[5] = src_loc[loc21][i];
-                    p[8] = src_loc[loc22][i];
-                }
-                process_channel(p, (*dst_it)[i], filter);
+                p[0] = row0[left][i];
+                p[1] = row0[x][i];
+                p[2] = row0[right][i];
+                p[3] = row1[left][i];
+                p[4] = row1[x][i];
+                p[5] = row1[right][i];
+                p[6] = row2[left][i];
+                p[7] = row2[x][i];
+                p[8] = row2[right][i];
+                process_channel(p, dst_it[x][i], filter);
             }
-            ++dst_it;
-            ++src_loc.x();
         }
-        // carrige-return
-        src_loc += point2<std::ptrdiff_t>(-src_view.width(), 1);
     }
+}
 
-    // bottom row
-    // src_loc = src_view.xy_at(0,src_view.height()-1);
-    for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
-    {
-        (*dst_it)[3] = src_loc[loc11][3]; // Dst.a = Src.a
-        for (std::ptrdiff_t i = 0; i < 3; ++i)
-        {
-            bits32f p[9];
-
-            p[1] = src_loc[loc10][i];
-            p[4] = src_loc[loc11][i];
-
-            if (x == 0)
-            {
-                p[0] = p[1];
-                p[3] = p[4];
-            }
-            else
-            {
-                p[0] = src_loc[loc00][i];
-                p[3] = src_loc[loc01][i];
-            }
-
-            if (x == (src_view.width()) - 1)
-            {
-                p[2] = p[1];
-                p[5] = p[4];
-            }
-            else
-            {
-                p[2] = src_loc[loc20][i];
-                p[5] = src_loc[loc21][i];
-            }
-
-            p[6] = p[0];
-            p[7] = p[1];
-            p[8] = p[2];
-            process_channel(p, (*dst_it)[i], filter);
-        }
-        ++src_loc.x();
-        ++dst_it;
-    }
+template<typename Src, typename Dst, typename Filter>
+void apply_convolution_3x3(Src const& src_view, Dst& dst_view, Filter const& filter)
+{
+    detail::for_each_band(src_view.height(), src_view.width(), [&](std::size_t begin, std::size_t end) {
+        apply_convolution_3x3(src_view,
+                              dst_view,
+                              filter,
+                              static_cast<std::ptrdiff_t>(begin),
+                              static_cast<std::ptrdiff_t>(end));
+    });
 }
 
 template<typename Src, typename Filter>
@@ -404,9 +322,24 @@ template<typename Src>
 void apply_filter(Src& src, agg_stack_blur const& op, double scale_factor)
 {
     premultiply_alpha(src);
-    agg::rendering_buffer buf(src.bytes(), src.width(), src.height(), src.row_size());
-    agg::pixfmt_rgba32_pre pixf(buf);
-    agg::stack_blur_rgba32(pixf, op.rx * scale_factor, op.ry * scale_factor);
+    unsigned const rx = static_cast<unsigned>(op.rx * scale_factor);
+    unsigned const ry = static_cast<unsigned>(op.ry * scale_factor);
+    // the horizontal pass only reads within a row and the vertical pass within
+    // a column, so they are run on bands of rows and bands of columns respectively
+    using pixfmt_type = agg::pixfmt_rgba32_pre;
+    detail::for_each_band(src.height(), src.width(), [&](std::size_t begin, std::size_t end) {
+        agg::rendering_buffer buf(src.bytes() + begin * src.row_size(), src.width(), end - begin, src.row_size());
+        pixfmt_type pixf(buf);
+        agg::stack_blur_rgba32(pixf, rx, 0);
+    });
+    detail::for_each_band(src.width(), src.height(), [&](std::size_t begin, std::size_t end) {
+        agg::rendering_buffer buf(src.bytes() + begin * pixfmt_type::pix_width,
+                                  end - begin,
+                                  src.height(),
+                                  src.row_size());
+        pixfmt_type pixf(buf);
+        agg::stack_blur_rgba32(pixf, 0, ry);
+    });
 }
 
 inline double channel_delta(double source, double match)
@@ -424,398 +357,534 @@ inline uint8_t apply_alpha_shift(double source, double match, double alpha)
     return static_cast<uint8_t>(std::floor((source * 255.0) + .5));
 }
 
-template<typename Src>
-void apply_filter(Src& src, color_to_alpha const& op, double /*scale_factor*/)
+namespace detail {
+
+using rgba8_row = boost::gil::rgba8_view_t::x_iterator;
+
+inline void premultiply_row(rgba8_row row, std::ptrdiff_t width)
+{
+    std::uint32_t* pixels = reinterpret_cast<std::uint32_t*>(&row[0]);
+    if (!simd::premultiply_rgba8(pixels, static_cast<std::size_t>(width)))
+    {
+        agg::rendering_buffer buf(reinterpret_cast<agg::int8u*>(pixels),
+                                  static_cast<unsigned>(width),
+                                  1,
+                                  static_cast<int>(width * 4));
+        agg::pixfmt_rgba32 pixf(buf);
+        pixf.premultiply();
+    }
+}
+
+inline void color_to_alpha_row(rgba8_row row, std::ptrdiff_t width, color_to_alpha const& op, bool premultiplied)
 {
     using namespace boost::gil;
-    bool premultiplied = src.get_premultiplied();
-    rgba8_view_t src_view = rgba8_view(src);
     double cr = static_cast<double>(op.color.red()) / 255.0;
     double cg = static_cast<double>(op.color.green()) / 255.0;
     double cb = static_cast<double>(op.color.blue()) / 255.0;
-    for (std::ptrdiff_t y = 0; y < src_view.height(); ++y)
+    for (std::ptrdiff_t x = 0; x < width; ++x)
+    {
+        uint8_t& r = get_color(row[x], red_t());
+        uint8_t& g = get_color(row[x], green_t());
+        uint8_t& b = get_color(row[x], blue_t());
+        uint8_t& a = get_color(row[x], alpha_t());
+        double sr = static_cast<double>(r) / 255.0;
+        double sg = static_cast<double>(g) / 255.0;
+        double sb = static_cast<double>(b) / 255.0;
+        double sa = static_cast<double>(a) / 255.0;
+        // demultiply
+        if (sa <= 0.0)
+        {
+            r = g = b = 0;
+            continue;
+        }
+        else if (premultiplied)
+        {
+            sr /= sa;
+            sg /= sa;
+            sb /= sa;
+        }
+        // get that maximum color difference
+        double xa = std::max(channel_delta(sr, cr), std::max(channel_delta(sg, cg), channel_delta(sb, cb)));
+        if (xa > 0)
+        {
+            // apply difference to each channel, returning premultiplied
+            // TODO - experiment with difference in hsl color space
+            r = apply_alpha_shift(sr, cr, xa);
+            g = apply_alpha_shift(sg, cg, xa);
+            b = apply_alpha_shift(sb, cb, xa);
+            // combine new alpha with original
+            xa *= sa;
+            a = static_cast<uint8_t>(std::floor((xa * 255.0) + .5));
+            // all color values must be <= alpha
+            if (r > a)
+                r = a;
+            if (g > a)
+                g = a;
+            if (b > a)
+                b = a;
+        }
+        else
+        {
+            r = g = b = a = 0;
+        }
+    }
+}
+
+// colour for every alpha value
+using colorize_lut = std::array<agg::rgba8, 256>;
+
+inline void colorize_alpha_row(rgba8_row row, std::ptrdiff_t width, colorize_lut const& lut)
+{
+    using namespace boost::gil;
+    for (std::ptrdiff_t x = 0; x < width; ++x)
     {
-        rgba8_view_t::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
-        for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
+        uint8_t& r = get_color(row[x], red_t());
+        uint8_t& g = get_color(row[x], green_t());
+        uint8_t& b = get_color(row[x], blue_t());
+        uint8_t& a = get_color(row[x], alpha_t());
+        if (a > 0)
         {
-            uint8_t& r = get_color(src_it[x], red_t());
-            uint8_t& g = get_color(src_it[x], green_t());
-            uint8_t& b = get_color(src_it[x], blue_t());
-            uint8_t& a = get_color(src_it[x], alpha_t());
-            double sr = static_cast<double>(r) / 255.0;
-            double sg = static_cast<double>(g) / 255.0;
-            double sb = static_cast<double>(b) / 255.0;
-            double sa = static_cast<double>(a) / 255.0;
-            // demultiply
-            if (sa <= 0.0)
+            agg::rgba8 const& c = lut[a];
+            a = (c.a * a + 255) >> 8;
+            r = (c.r * a + 255) >> 8;
+            g = (c.g * a + 255) >> 8;
+            b = (c.b * a + 255) >> 8;
+        }
+    }
+}
+
+inline void scale_hsla_row(rgba8_row row, std::ptrdiff_t width, scale_hsla const& transform, bool premultiplied)
+{
+    using namespace boost::gil;
+    bool tinting = !transform.is_identity();
+    bool set_alpha = !transform.is_alpha_identity();
+    for (std::ptrdiff_t x = 0; x < width; ++x)
+    {
+        uint8_t& r = get_color(row[x], red_t());
+        uint8_t& g = get_color(row[x], green_t());
+        uint8_t& b = get_color(row[x], blue_t());
+        uint8_t& a = get_color(row[x], alpha_t());
+        double r2 = static_cast<double>(r) / 255.0;
+        double g2 = static_cast<double>(g) / 255.0;
+        double b2 = static_cast<double>(b) / 255.0;
+        double a2 = static_cast<double>(a) / 255.0;
+        // demultiply
+        if (a2 <= 0.0)
+        {
+            r = g = b = 0;
+            continue;
+        }
+        else if (premultiplied)
+        {
+            r2 /= a2;
+            g2 /= a2;
+            b2 /= a2;
+        }
+
+        if (set_alpha)
+        {
+            a2 = transform.a0 + (a2 * (transform.a1 - transform.a0));
+            if (a2 <= 0)
             {
-                r = g = b = 0;
+                r = g = b = a = 0;
                 continue;
             }
-            else if (premultiplied)
+            else if (a2 > 1)
             {
-                sr /= sa;
-                sg /= sa;
-                sb /= sa;
+                a2 = 1;
+                a = 255;
             }
-            // get that maximum color difference
-            double xa = std::max(channel_delta(sr, cr), std::max(channel_delta(sg, cg), channel_delta(sb, cb)));
-            if (xa > 0)
+            else
             {
-                // apply difference to each channel, returning premultiplied
-                // TODO - experiment with difference in hsl color space
-                r = apply_alpha_shift(sr, cr, xa);
-                g = apply_alpha_shift(sg, cg, xa);
-                b = apply_alpha_shift(sb, cb, xa);
-                // combine new alpha with original
-                xa *= sa;
-                a = static_cast<uint8_t>(std::floor((xa * 255.0) + .5));
-                // all color values must be <= alpha
-                if (r > a)
-                    r = a;
-                if (g > a)
-                    g = a;
-                if (b > a)
-                    b = a;
+                a = static_cast<uint8_t>(std::floor((a2 * 255.0) + .5));
             }
-            else
+        }
+        if (tinting)
+        {
+            double h;
+            double s;
+            double l;
+            rgb2hsl(r2, g2, b2, h, s, l);
+            double h2 = transform.h0 + (h * (transform.h1 - transform.h0));
+            double s2 = transform.s0 + (s * (transform.s1 - transform.s0));
+            double l2 = transform.l0 + (l * (transform.l1 - transform.l0));
+            if (h2 > 1)
             {
-                r = g = b = a = 0;
+                h2 = 1;
+            }
+            else if (h2 < 0)
+            {
+                h2 = 0;
+            }
+            if (s2 > 1)
+            {
+                s2 = 1;
             }
+            else if (s2 < 0)
+            {
+                s2 = 0;
+            }
+            if (l2 > 1)
+            {
+                l2 = 1;
+            }
+            else if (l2 < 0)
+            {
+                l2 = 0;
+            }
+            hsl2rgb(h2, s2, l2, r2, g2, b2);
         }
+        // premultiply
+        r2 *= a2;
+        g2 *= a2;
+        b2 *= a2;
+        r = static_cast<uint8_t>(std::floor((r2 * 255.0) + .5));
+        g = static_cast<uint8_t>(std::floor((g2 * 255.0) + .5));
+        b = static_cast<uint8_t>(std::floor((b2 * 255.0) + .5));
+        // all color values must be <= alpha
+        if (r > a)
+            r = a;
+        if (g > a)
+            g = a;
+        if (b > a)
+            b = a;
     }
-    // set as premultiplied
-    set_premultiplied_alpha(src, true);
 }
 
-template<typename Src>
-void apply_filter(Src& src, colorize_alpha const& op, double /*scale_factor*/)
+constexpr double color_blind_gamma = 2.2;
+
+// std::pow(c, color_blind_gamma) for every channel value
+inline std::array<double, 256> const& color_blind_gamma_lut()
 {
-    using namespace boost::gil;
-    std::ptrdiff_t size = op.size();
-    if (op.size() == 1)
-    {
-        // no interpolation if only one stop
-        mapnik::filter::color_stop const& stop = op[0];
-        mapnik::color const& c = stop.color;
-        rgba8_view_t src_view = rgba8_view(src);
-        for (std::ptrdiff_t y = 0; y < src_view.height(); ++y)
+    static std::array<double, 256> const lut = [] {
+        std::array<double, 256> values;
+        for (std::size_t i = 0; i < values.size(); ++i)
         {
-            rgba8_view_t::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
-            for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
-            {
-                uint8_t& r = get_color(src_it[x], red_t());
-                uint8_t& g = get_color(src_it[x], green_t());
-                uint8_t& b = get_color(src_it[x], blue_t());
-                uint8_t& a = get_color(src_it[x], alpha_t());
-                if (a > 0)
-                {
-                    a = (c.alpha() * a + 255) >> 8;
-                    r = (c.red() * a + 255) >> 8;
-                    g = (c.green() * a + 255) >> 8;
-                    b = (c.blue() * a + 255) >> 8;
-                }
-            }
+            values[i] = std::pow(static_cast<double>(i), color_blind_gamma);
         }
-        // set as premultiplied
-        set_premultiplied_alpha(src, true);
-    }
-    else if (size > 1)
+        return values;
+    }();
+    return lut;
+}
+
+template<typename ColorBlindFilter>
+void color_blind_row(rgba8_row row, std::ptrdiff_t width, ColorBlindFilter const& op, bool premultiplied)
+{
+    using namespace boost::gil;
+    static constexpr double inv_gamma = 1.0 / color_blind_gamma;
+    std::array<double, 256> const& gamma_lut = color_blind_gamma_lut();
+
+    for (std::ptrdiff_t x = 0; x < width; ++x)
     {
-        // interpolate multiple stops
-        agg::gradient_lut<agg::color_interpolator<agg::rgba8>> grad_lut;
-        double step = 1.0 / (size - 1);
-        double offset = 0.0;
-        for (mapnik::filter::color_stop const& stop : op)
+        uint8_t& r = get_color(row[x], red_t());
+        uint8_t& g = get_color(row[x], green_t());
+        uint8_t& b = get_color(row[x], blue_t());
+        uint8_t& a = get_color(row[x], alpha_t());
+        // demultiply
+        if (a == 0)
         {
-            mapnik::color const& c = stop.color;
-            double stop_offset = stop.offset;
-            if (stop_offset == 0)
-            {
-                stop_offset = offset;
-            }
-            grad_lut.add_color(stop_offset,
-                               agg::rgba(c.red() / 255.0, c.green() / 255.0, c.blue() / 255.0, c.alpha() / 255.0));
-            offset += step;
+            r = g = b = 0;
+            continue;
         }
-        if (grad_lut.build_lut())
+        else if (premultiplied)
         {
-            rgba8_view_t src_view = rgba8_view(src);
-            for (std::ptrdiff_t y = 0; y < src_view.height(); ++y)
-            {
-                rgba8_view_t::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
-                for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
-                {
-                    uint8_t& r = get_color(src_it[x], red_t());
-                    uint8_t& g = get_color(src_it[x], green_t());
-                    uint8_t& b = get_color(src_it[x], blue_t());
-                    uint8_t& a = get_color(src_it[x], alpha_t());
-                    if (a > 0)
-                    {
-                        agg::rgba8 c = grad_lut[a];
-                        a = (c.a * a + 255) >> 8;
-                        r = (c.r * a + 255) >> 8;
-                        g = (c.g * a + 255) >> 8;
-                        b = (c.b * a + 255) >> 8;
-#if 0
-                        // rainbow
-                        r = 0;
-                        g = 0;
-                        b = 0;
-                        if (a < 64)
-                        {
-                            g = a * 4;
-                            b = 255;
-                        }
-                        else if (a >= 64 && a < 128)
-                        {
-                            g = 255;
-                            b = 255 - ((a - 64) * 4);
-                        }
-                        else if (a >= 128 && a < 192)
-                        {
-                            r = (a - 128) * 4;
-                            g = 255;
-                        }
-                        else // >= 192
-                        {
-                            r = 255;
-                            g = 255 - ((a - 192) * 4);
-                        }
-                        r = (r * a + 255) >> 8;
-                        g = (g * a + 255) >> 8;
-                        b = (b * a + 255) >> 8;
-#endif
-                    }
-                }
-            }
+            std::uint32_t cr = (r * 255) / a;
+            std::uint32_t cg = (g * 255) / a;
+            std::uint32_t cb = (b * 255) / a;
+            r = static_cast<uint8_t>((cr > 255) ? 255 : cr);
+            g = static_cast<uint8_t>((cg > 255) ? 255 : cg);
+            b = static_cast<uint8_t>((cb > 255) ? 255 : cb);
         }
-        // set as premultiplied
-        set_premultiplied_alpha(src, true);
+        // Convert source color into XYZ color space
+        double pow_r = gamma_lut[r];
+        double pow_g = gamma_lut[g];
+        double pow_b = gamma_lut[b];
+        double X = (0.412424 * pow_r) + (0.357579 * pow_g) + (0.180464 * pow_b);
+        double Y = (0.212656 * pow_r) + (0.715158 * pow_g) + (0.0721856 * pow_b);
+        double Z = (0.0193324 * pow_r) + (0.119193 * pow_g) + (0.950444 * pow_b);
+        // Convert XYZ into xyY Chromacity Coordinates (xy) and Luminance (Y)
+        double chroma_x = X / (X + Y + Z);
+        double chroma_y = Y / (X + Y + Z);
+        // Generate the "Confusion Line" between the source color and the Confusion Point
+        double m_div = chroma_x - op.x;
+        if (std::abs(m_div) < (std::numeric_limits<double>::epsilon()))
+            continue;
+        double m = (chroma_y - op.y) / (chroma_x - op.x); // slope of Confusion Line
+        double yint = chroma_y - chroma_x * m;            // y-intercept of confusion line (x-intercept = 0.0)
+        // How far the xy coords deviate from the simulation
+        double m_div2 = m - op.m;
+        if (std::abs(m_div2) < (std::numeric_limits<double>::epsilon()))
+            continue;
+        double deviate_x = (op.yint - yint) / (m - op.m);
+        double deviate_y = (m * deviate_x) + yint;
+        // Compute the simulated color's XYZ coords
+        X = deviate_x * Y / deviate_y;
+        Z = (1.0 - (deviate_x + deviate_y)) * Y / deviate_y;
+        // Neutral grey calculated from luminance (in D65)
+        double neutral_X = 0.312713 * Y / 0.329016;
+        double neutral_Z = 0.358271 * Y / 0.329016;
+        // Difference between simulated color and neutral grey
+        double diff_X = neutral_X - X;
+        double diff_Z = neutral_Z - Z;
+        // XYZ->RGB (sRGB:D65)
+        double diff_r = diff_X * 3.2407100 + diff_Z * -0.4985710;
+        double diff_g = diff_X * -0.9692580 + diff_Z * 0.0415557;
+        double diff_b = diff_X * 0.0556352 + diff_Z * 1.0570700;
+        // XYZ->RGB (sRGB:D65)
+        double dr = X * 3.2407100 + Y * -1.537260 + Z * -0.4985710;
+        double dg = X * -0.9692580 + Y * 1.875990 + Z * 0.0415557;
+        double db = X * 0.0556352 + Y * -0.203996 + Z * 1.0570700;
+        // Compensate simulated color towards a neutral fit in RGB space
+        double fit_r = ((dr < 0.0 ? 0.0 : 1.0) - dr) / diff_r;
+        double fit_g = ((dg < 0.0 ? 0.0 : 1.0) - dg) / diff_g;
+        double fit_b = ((db < 0.0 ? 0.0 : 1.0) - db) / diff_b;
+        double adjust =
+          std::max((fit_r > 1.0 || fit_r < 0.0) ? 0.0 : fit_r, (fit_g > 1.0 || fit_g < 0.0) ? 0.0 : fit_g);
+        adjust = std::max((fit_b > 1.0 || fit_b < 0.0) ? 0.0 : fit_b, adjust);
+        // Shift proportional to the greatest shift
+        dr += adjust * diff_r;
+        dg += adjust * diff_g;
+        db += adjust * diff_b;
+        // Apply gamma correction
+        dr = std::pow(dr, inv_gamma);
+        dg = std::pow(dg, inv_gamma);
+        db = std::pow(db, inv_gamma);
+        // Clamp values
+        if (dr < 0.0 || std::isnan(dr))
+            dr = 0.0;
+        if (dr > 255.0)
+            dr = 255.0;
+        if (dg < 0.0 || std::isnan(dg))
+            dg = 0.0;
+        if (dg > 255.0)
+            dg = 255.0;
+        if (db < 0.0 || std::isnan(db))
+            db = 0.0;
+        if (db > 255.0)
+            db = 255.0;
+        // premultiply
+        r = (static_cast<uint8_t>(dr) * a + 255) >> 8;
+        g = (static_cast<uint8_t>(dg) * a + 255) >> 8;
+        b = (static_cast<uint8_t>(db) * a + 255) >> 8;
     }
 }
 
-template<typename Src>
-void apply_filter(Src& src, scale_hsla const& transform, double /*scale_factor*/)
+inline void gray_row(rgba8_row row, std::ptrdiff_t width, bool premultiplied)
 {
     using namespace boost::gil;
-    bool tinting = !transform.is_identity();
-    bool set_alpha = !transform.is_alpha_identity();
-    // todo - filters be able to report if they
-    // should be run to avoid overhead of temp buffer
-    if (tinting || set_alpha)
+    if (!premultiplied)
+        premultiply_row(row, width);
+    for (std::ptrdiff_t x = 0; x < width; ++x)
+    {
+        // formula taken from boost/gil/color_convert.hpp:rgb_to_luminance
+        uint8_t& r = get_color(row[x], red_t());
+        uint8_t& g = get_color(row[x], green_t());
+        uint8_t& b = get_color(row[x], blue_t());
+        uint8_t v = uint8_t((4915 * r + 9667 * g + 1802 * b + 8192) >> 14);
+        r = g = b = v;
+    }
+}
+
+inline void invert_row(rgba8_row row, std::ptrdiff_t width, bool premultiplied)
+{
+    using namespace boost::gil;
+    if (!premultiplied)
+        premultiply_row(row, width);
+    for (std::ptrdiff_t x = 0; x < width; ++x)
+    {
+        // we only work with premultiplied source,
+        // thus all color values must be <= alpha
+        uint8_t a = get_color(row[x], alpha_t());
+        uint8_t& r = get_color(row[x], red_t());
+        uint8_t& g = get_color(row[x], green_t());
+        uint8_t& b = get_color(row[x], blue_t());
+        r = a - r;
+        g = a - g;
+        b = a - b;
+    }
+}
+
+// Per pixel part of a filter, applied to one row of pixels
+using row_filter = std::function<void(rgba8_row, std::ptrdiff_t)>;
+
+// Collects filters that only depend on the pixel itself, so consecutive ones can be
+// applied row by row in a single pass over the image. `premultiplied` follows the
+// alpha state through the collected filters. Returns false for other filters.
+struct pixel_filter_builder
+{
+    std::vector<row_filter>& filters_;
+    bool& premultiplied_;
+    pixel_filter_builder(std::vector<row_filter>& filters, bool& premultiplied)
+        : filters_(filters),
+          premultiplied_(premultiplied)
+    {}
+
+    template<typename T>
+    bool operator()(T const& /*filter*/) const
+    {
+        return false;
+    }
+
+    bool operator()(color_to_alpha const& op) const
     {
-        bool premultiplied = src.get_premultiplied();
-        rgba8_view_t src_view = rgba8_view(src);
-        for (std::ptrdiff_t y = 0; y < src_view.height(); ++y)
+        bool premultiplied = premultiplied_;
+        filters_.emplace_back([op, premultiplied](rgba8_row row, std::ptrdiff_t width) {
+            color_to_alpha_row(row, width, op, premultiplied);
+        });
+        premultiplied_ = true;
+        return true;
+    }
+
+    bool operator()(colorize_alpha const& op) const
+    {
+        colorize_lut lut;
+        if (op.size() == 1)
+        {
+            // no interpolation if only one stop
+            mapnik::color const& c = op[0].color;
+            lut.fill(agg::rgba8(c.red(), c.green(), c.blue(), c.alpha()));
+            add_colorize(lut);
+        }
+        else if (op.size() > 1)
         {
-            rgba8_view_t::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
-            for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
+            // interpolate multiple stops
+            agg::gradient_lut<agg::color_interpolator<agg::rgba8>> grad_lut;
+            double step = 1.0 / (op.size() - 1);
+            double offset = 0.0;
+            for (mapnik::filter::color_stop const& stop : op)
             {
-                uint8_t& r = get_color(src_it[x], red_t());
-                uint8_t& g = get_color(src_it[x], green_t());
-                uint8_t& b = get_color(src_it[x], blue_t());
-                uint8_t& a = get_color(src_it[x], alpha_t());
-                double r2 = static_cast<double>(r) / 255.0;
-                double g2 = static_cast<double>(g) / 255.0;
-                double b2 = static_cast<double>(b) / 255.0;
-                double a2 = static_cast<double>(a) / 255.0;
-                // demultiply
-                if (a2 <= 0.0)
-                {
-                    r = g = b = 0;
-                    continue;
-                }
-                else if (premultiplied)
+                mapnik::color const& c = stop.color;
+                double stop_offset = stop.offset;
+                if (stop_offset == 0)
                 {
-                    r2 /= a2;
-                    g2 /= a2;
-                    b2 /= a2;
+                    stop_offset = offset;
                 }
-
-                if (set_alpha)
-                {
-                    a2 = transform.a0 + (a2 * (transform.a1 - transform.a0));
-                    if (a2 <= 0)
-                    {
-                        r = g = b = a = 0;
-                        continue;
-                    }
-                    else if (a2 > 1)
-                    {
-                        a2 = 1;
-                        a = 255;
-                    }
-                    else
-                    {
-                        a = static_cast<uint8_t>(std::floor((a2 * 255.0) + .5));
-                    }
-                }
-                if (tinting)
+                grad_lut.add_color(stop_offset,
+                                   agg::rgba(c.red() / 255.0, c.green() / 255.0, c.blue() / 255.0, c.alpha() / 255.0));
+                offset += step;
+            }
+            if (grad_lut.build_lut())
+            {
+                for (std::size_t i = 0; i < lut.size(); ++i)
                 {
-                    double h;
-                    double s;
-                    double l;
-                    rgb2hsl(r2, g2, b2, h, s, l);
-                    double h2 = transform.h0 + (h * (transform.h1 - transform.h0));
-                    double s2 = transform.s0 + (s * (transform.s1 - transform.s0));
-                    double l2 = transform.l0 + (l * (transform.l1 - transform.l0));
-                    if (h2 > 1)
-                    {
-                        h2 = 1;
-                    }
-                    else if (h2 < 0)
-                    {
-                        h2 = 0;
-                    }
-                    if (s2 > 1)
-                    {
-                        s2 = 1;
-                    }
-                    else if (s2 < 0)
-                    {
-                        s2 = 0;
-                    }
-                    if (l2 > 1)
-                    {
-                        l2 = 1;
-                    }
-                    else if (l2 < 0)
-                    {
-                        l2 = 0;
-                    }
-                    hsl2rgb(h2, s2, l2, r2, g2, b2);
+                    lut[i] = grad_lut[static_cast<unsigned>(i)];
                 }
-                // premultiply
-                r2 *= a2;
-                g2 *= a2;
-                b2 *= a2;
-                r = static_cast<uint8_t>(std::floor((r2 * 255.0) + .5));
-                g = static_cast<uint8_t>(std::floor((g2 * 255.0) + .5));
-                b = static_cast<uint8_t>(std::floor((b2 * 255.0) + .5));
-                // all color values must be <= alpha
-                if (r > a)
-                    r = a;
-                if (g > a)
-                    g = a;
-                if (b > a)
-                    b = a;
+                add_colorize(lut);
             }
         }
-        // set as premultiplied
-        set_premultiplied_alpha(src, true);
+        if (!op.empty())
+            premultiplied_ = true;
+        return true;
     }
-}
 
-template<typename Src, typename ColorBlindFilter>
-void apply_color_blind_filter(Src& src, ColorBlindFilter const& op)
-{
-    using namespace boost::gil;
-    rgba8_view_t src_view = rgba8_view(src);
-    bool premultiplied = src.get_premultiplied();
+    bool operator()(scale_hsla const& op) const
+    {
+        if (!op.is_identity() || !op.is_alpha_identity())
+        {
+            bool premultiplied = premultiplied_;
+            filters_.emplace_back([op, premultiplied](rgba8_row row, std::ptrdiff_t width) {
+                scale_hsla_row(row, width, op, premultiplied);
+            });
+            premultiplied_ = true;
+        }
+        return true;
+    }
+
+    bool operator()(color_blind_protanope const& op) const { return add_color_blind(op); }
+    bool operator()(color_blind_deuteranope const& op) const { return add_color_blind(op); }
+    bool operator()(color_blind_tritanope const& op) const { return add_color_blind(op); }
 
-    static constexpr double gamma = 2.2;
-    static constexpr double inv_gamma = 1.0 / gamma;
+    bool operator()(gray const& /*op*/) const
+    {
+        bool premultiplied = premultiplied_;
+        filters_.emplace_back([premultiplied](rgba8_row row, std::ptrdiff_t width) {
+            gray_row(row, width, premultiplied);
+        });
+        premultiplied_ = true;
+        return true;
+    }
 
-    for (std::ptrdiff_t y = 0; y < src_view.height(); ++y)
+    bool operator()(invert const& /*op*/) const
     {
-        rgba8_view_t::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
-        for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
+        bool premultiplied = premultiplied_;
+        filters_.emplace_back([premultiplied](rgba8_row row, std::ptrdiff_t width) {
+            invert_row(row, width, premultiplied);
+        });
+        premultiplied_ = true;
+        return true;
+    }
+
+  private:
+    void add_colorize(colorize_lut const& lut) const
+    {
+        filters_.emplace_back([lut](rgba8_row row, std::ptrdiff_t width) { colorize_alpha_row(row, width, lut); });
+    }
+
+    template<typename ColorBlindFilter>
+    bool add_color_blind(ColorBlindFilter const& op) const
+    {
+        bool premultiplied = premultiplied_;
+        filters_.emplace_back([op, premultiplied](rgba8_row row, std::ptrdiff_t width) {
+            color_blind_row(row, width, op, premultiplied);
+        });
+        premultiplied_ = true;
+        return true;
+    }
+};
+
+template<typename Src>
+void apply_row_filters(Src& src, std::vector<row_filter> const& filters)
+{
+    if (filters.empty())
+        return;
+    boost::gil::rgba8_view_t src_view = rgba8_view(src);
+    std::ptrdiff_t const width = src_view.width();
+    for_each_band(src_view.height(), width, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t y = begin; y < end; ++y)
         {
-            uint8_t& r = get_color(src_it[x], red_t());
-            uint8_t& g = get_color(src_it[x], green_t());
-            uint8_t& b = get_color(src_it[x], blue_t());
-            uint8_t& a = get_color(src_it[x], alpha_t());
-            // demultiply
-            if (a == 0)
-            {
-                r = g = b = 0;
-                continue;
-            }
-            else if (premultiplied)
+            rgba8_row row = src_view.row_begin(static_cast<std::ptrdiff_t>(y));
+            for (row_filter const& filter : filters)
             {
-                std::uint32_t cr = (r * 255) / a;
-                std::uint32_t cg = (g * 255) / a;
-                std::uint32_t cb = (b * 255) / a;
-                r = static_cast<uint8_t>((cr > 255) ? 255 : cr);
-                g = static_cast<uint8_t>((cg > 255) ? 255 : cg);
-                b = static_cast<uint8_t>((cb > 255) ? 255 : cb);
+                filter(row, width);
             }
-            // Convert source color into XYZ color space
-            double pow_r = std::pow(r, gamma);
-            double pow_g = std::pow(g, gamma);
-            double pow_b = std::pow(b, gamma);
-            double X = (0.412424 * pow_r) + (0.357579 * pow_g) + (0.180464 * pow_b);
-            double Y = (0.212656 * pow_r) + (0.715158 * pow_g) + (0.0721856 * pow_b);
-            double Z = (0.0193324 * pow_r) + (0.119193 * pow_g) + (0.950444 * pow_b);
-            // Convert XYZ into xyY Chromacity Coordinates (xy) and Luminance (Y)
-            double chroma_x = X / (X + Y + Z);
-            double chroma_y = Y / (X + Y + Z);
-            // Generate the "Confusion Line" between the source color and the Confusion Point
-            double m_div = chroma_x - op.x;
-            if (std::abs(m_div) < (std::numeric_limits<double>::epsilon()))
-                continue;
-            double m = (chroma_y - op.y) / (chroma_x - op.x); // slope of Confusion Line
-            double yint = chroma_y - chroma_x * m;            // y-intercept of confusion line (x-intercept = 0.0)
-            // How far the xy coords deviate from the simulation
-            double m_div2 = m - op.m;
-            if (std::abs(m_div2) < (std::numeric_limits<double>::epsilon()))
-                continue;
-            double deviate_x = (op.yint - yint) / (m - op.m);
-            double deviate_y = (m * deviate_x) + yint;
-            // Compute the simulated color's XYZ coords
-            X = deviate_x * Y / deviate_y;
-            Z = (1.0 - (deviate_x + deviate_y)) * Y / deviate_y;
-            // Neutral grey calculated from luminance (in D65)
-            double neutral_X = 0.312713 * Y / 0.329016;
-            double neutral_Z = 0.358271 * Y / 0.329016;
-            // Difference between simulated color and neutral grey
-            double diff_X = neutral_X - X;
-            double diff_Z = neutral_Z - Z;
-            // XYZ->RGB (sRGB:D65)
-            double diff_r = diff_X * 3.2407100 + diff_Z * -0.4985710;
-            double diff_g = diff_X * -0.9692580 + diff_Z * 0.0415557;
-            double diff_b = diff_X * 0.0556352 + diff_Z * 1.0570700;
-            // XYZ->RGB (sRGB:D65)
-            double dr = X * 3.2407100 + Y * -1.537260 + Z * -0.4985710;
-            double dg = X * -0.9692580 + Y * 1.875990 + Z * 0.0415557;
-            double db = X * 0.0556352 + Y * -0.203996 + Z * 1.0570700;
-            // Compensate simulated color towards a neutral fit in RGB space
-            double fit_r = ((dr < 0.0 ? 0.0 : 1.0) - dr) / diff_r;
-            double fit_g = ((dg < 0.0 ? 0.0 : 1.0) - dg) / diff_g;
-            double fit_b = ((db < 0.0 ? 0.0 : 1.0) - db) / diff_b;
-            double adjust =
-              std::max((fit_r > 1.0 || fit_r < 0.0) ? 0.0 : fit_r, (fit_g > 1.0 || fit_g < 0.0) ? 0.0 : fit_g);
-            adjust = std::max((fit_b > 1.0 || fit_b < 0.0) ? 0.0 : fit_b, adjust);
-            // Shift proportional to the greatest shift
-            dr += adjust * diff_r;
-            dg += adjust * diff_g;
-            db += adjust * diff_b;
-            // Apply gamma correction
-            dr = std::pow(dr, inv_gamma);
-            dg = std::pow(dg, inv_gamma);
-            db = std::pow(db, inv_gamma);
-            // Clamp values
-            if (dr < 0.0 || std::isnan(dr))
-                dr = 0.0;
-            if (dr > 255.0)
-                dr = 255.0;
-            if (dg < 0.0 || std::isnan(dg))
-                dg = 0.0;
-            if (dg > 255.0)
-                dg = 255.0;
-            if (db < 0.0 || std::isnan(db))
-                db = 0.0;
-            if (db > 255.0)
-                db = 255.0;
-            // premultiply
-            r = (static_cast<uint8_t>(dr) * a + 255) >> 8;
-            g = (static_cast<uint8_t>(dg) * a + 255) >> 8;
-            b = (static_cast<uint8_t>(db) * a + 255) >> 8;
         }
-    }
-    // set as premultiplied
-    set_premultiplied_alpha(src, true);
+    });
+}
+
+template<typename Src, typename Filter>
+void apply_pixel_filter(Src& src, Filter const& op)
+{
+    std::vector<row_filter> filters;
+    bool premultiplied = src.get_premultiplied();
+    pixel_filter_builder(filters, premultiplied)(op);
+    apply_row_filters(src, filters);
+    set_premultiplied_alpha(src, premultiplied);
+}
+
+} // namespace detail
+
+template<typename Src>
+void apply_filter(Src& src, color_to_alpha const& op, double /*scale_factor*/)
+{
+    detail::apply_pixel_filter(src, op);
+}
+
+template<typename Src>
+void apply_filter(Src& src, colorize_alpha const& op, double /*scale_factor*/)
+{
+    detail::apply_pixel_filter(src, op);
+}
+
+template<typename Src>
+void apply_filter(Src& src, scale_hsla const& transform, double /*scale_factor*/)
+{
+    detail::apply_pixel_filter(src, transform);
+}
+
+template<typename Src, typename ColorBlindFilter>
+void apply_color_blind_filter(Src& src, ColorBlindFilter const& op)
+{
+    detail::apply_pixel_filter(src, op);
 }
 
 template<typename Src>
@@ -837,57 +906,42 @@ void apply_filter(Src& src, color_blind_tritanope const& op, double /*scale_fact
 }
 
 template<typename Src>
-void apply_filter(Src& src, gray const& /*op*/, double /*scale_factor*/)
+void apply_filter(Src& src, gray const& op, double /*scale_factor*/)
 {
-    premultiply_alpha(src);
-    using namespace boost::gil;
-
-    rgba8_view_t src_view = rgba8_view(src);
-
-    for (std::ptrdiff_t y = 0; y < src_view.height(); ++y)
-    {
-        rgba8_view_t::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
-        for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
-        {
-            // formula taken from boost/gil/color_convert.hpp:rgb_to_luminance
-            uint8_t& r = get_color(src_it[x], red_t());
-            uint8_t& g = get_color(src_it[x], green_t());
-            uint8_t& b = get_color(src_it[x], blue_t());
-            uint8_t v = uint8_t((4915 * r + 9667 * g + 1802 * b + 8192) >> 14);
-            r = g = b = v;
-        }
-    }
+    detail::apply_pixel_filter(src, op);
 }
 
 template<typename Src, typename Dst>
 void x_gradient_impl(Src const& src_view, Dst const& dst_view)
 {
-    for (std::ptrdiff_t y = 0; y < src_view.height(); ++y)
-    {
-        typename Src::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
-        typename Dst::x_iterator dst_it = dst_view.row_begin(static_cast<long>(y));
+    detail::for_each_band(src_view.height(), src_view.width(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t y = begin; y < end; ++y)
+        {
+            typename Src::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
+            typename Dst::x_iterator dst_it = dst_view.row_begin(static_cast<long>(y));
 
-        dst_it[0][0] = 128 + (src_it[0][0] - src_it[1][0]) / 2;
-        dst_it[0][1] = 128 + (src_it[0][1] - src_it[1][1]) / 2;
-        dst_it[0][2] = 128 + (src_it[0][2] - src_it[1][2]) / 2;
+            dst_it[0][0] = 128 + (src_it[0][0] - src_it[1][0]) / 2;
+            dst_it[0][1] = 128 + (src_it[0][1] - src_it[1][1]) / 2;
+            dst_it[0][2] = 128 + (src_it[0][2] - src_it[1][2]) / 2;
 
-        dst_it[dst_view.width() - 1][0] =
-          128 + (src_it[(src_view.width()) - 2][0] - src_it[(src_view.width()) - 1][0]) / 2;
-        dst_it[dst_view.width() - 1][1] =
-          128 + (src_it[(src_view.width()) - 2][1] - src_it[(src_view.width()) - 1][1]) / 2;
-        dst_it[dst_view.width() - 1][2] =
-          128 + (src_it[(src_view.width()) - 2][2] - src_it[(src_view.width()) - 1][2]) / 2;
+            dst_it[dst_view.width() - 1][0] =
+              128 + (src_it[(src_view.width()) - 2][0] - src_it[(src_view.width()) - 1][0]) / 2;
+            dst_it[dst_view.width() - 1][1] =
+              128 + (src_it[(src_view.width()) - 2][1] - src_it[(src_view.width()) - 1][1]) / 2;
+            dst_it[dst_view.width() - 1][2] =
+              128 + (src_it[(src_view.width()) - 2][2] - src_it[(src_view.width()) - 1][2]) / 2;
 
-        dst_it[0][3] = dst_it[(src_view.width()) - 1][3] = 255;
+            dst_it[0][3] = dst_it[(src_view.width()) - 1][3] = 255;
 
-        for (std::ptrdiff_t x = 1; x < src_view.width() - 1; ++x)
-        {
-            dst_it[x][0] = 128 + (src_it[x - 1][0] - src_it[x + 1][0]) / 2;
-            dst_it[x][1] = 128 + (src_it[x - 1][1] - src_it[x + 1][1]) / 2;
-            dst_it[x][2] = 128 + (src_it[x - 1][2] - src_it[x + 1][2]) / 2;
-            dst_it[x][3] = 255;
+            for (std::ptrdiff_t x = 1; x < src_view.width() - 1; ++x)
+            {
+                dst_it[x][0] = 128 + (src_it[x - 1][0] - src_it[x + 1][0]) / 2;
+                dst_it[x][1] = 128 + (src_it[x - 1][1] - src_it[x + 1][1]) / 2;
+                dst_it[x][2] = 128 + (src_it[x - 1][2] - src_it[x + 1][2]) / 2;
+                dst_it[x][3] = 255;
+            }
         }
-    }
+    });
 }
 
 template<typename Src>
@@ -907,29 +961,9 @@ void apply_filter(Src& src, y_gradient const& /*op*/, double /*scale_factor*/)
 }
 
 template<typename Src>
-void apply_filter(Src& src, invert const& /*op*/, double /*scale_factor*/)
+void apply_filter(Src& src, invert const& op, double /*scale_factor*/)
 {
-    premultiply_alpha(src);
-    using namespace boost::gil;
-
-    rgba8_view_t src_view = rgba8_view(src);
-
-    for (std::ptrdiff_t y = 0; y < src_view.height(); ++y)
-    {
-        rgba8_view_t::x_iterator src_it = src_view.row_begin(static_cast<long>(y));
-        for (std::ptrdiff_t x = 0; x < src_view.width(); ++x)
-        {
-            // we only work with premultiplied source,
-            // thus all color values must be <= alpha
-            uint8_t a = get_color(src_it[x], alpha_t());
-            uint8_t& r = get_color(src_it[x], red_t());
-            uint8_t& g = get_color(src_it[x], green_t());
-            uint8_t& b = get_color(src_it[x], blue_t());
-            r = a - r;
-            g = a - g;
-            b = a - b;
-        }
-    }
+    detail::apply_pixel_filter(src, op);
 }
 
 template<typename Src>
@@ -969,6 +1003,29 @@ struct filter_radius_visitor
     }
 };
 
+// Applies `filters` in order, with the same result as applying each of them through
+// filter_visitor. Runs of consecutive per pixel filters are fused into a single pass.
+template<typename Src>
+void apply_filters(Src& src, std::vector<filter_type> const& filters, double scale_factor = 1.0)
+{
+    std::vector<detail::row_filter> pending;
+    bool premultiplied = src.get_premultiplied();
+    detail::pixel_filter_builder builder(pending, premultiplied);
+    filter_visitor<Src> visitor(src, scale_factor);
+    for (filter_type const& filter_tag : filters)
+    {
+        if (util::apply_visitor(builder, filter_tag))
+            continue;
+        detail::apply_row_filters(src, pending);
+        pending.clear();
+        set_premultiplied_alpha(src, premultiplied);
+        util::apply_visitor(visitor, filter_tag);
+        premultiplied = src.get_premultiplied();
+    }
+    detail::apply_row_filters(src, pending);
+    set_premultiplied_alpha(src, premultiplied);
+}
+
 template<typename Src>
 void filter_image(Src& src, std::string const& filter, double scale_factor = 1)
 {
@@ -977,11 +1034,7 @@ void filter_image(Src& src, std::string const& filter, double scale_factor = 1)
     {
         throw std::runtime_error("Failed to parse filter argument in filter_image: '" + filter + "'");
     }
-    filter_visitor<Src> visitor(src, scale_factor);
-    for (filter_type const& filter_tag : filter_vector)
-    {
-        util::apply_visitor(visitor, filter_tag);
-    }
+    apply_filters(src, filter_vector, scale_factor);
 }
 
 template<typename Src>
@@ -993,11 +1046,7 @@ Src filter_image(Src const& src, std::string const& filter, double scale_factor
         throw std::runtime_error("Failed to parse filter argument in filter_image: '" + filter + "'");
     }
     Src new_src(src);
-    filter_visitor<Src> visitor(new_src, scale_factor);
-    for (filter_type const& filter_tag : filter_vector)
-    {
-        util::apply_visitor(visitor, filter_tag);
-    }
+    apply_filters(new_src, filter_vector, scale_factor);
     return new_src;
 }
 
@@ -33,6 +33,8 @@
 // stl
 #include <string>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace mapnik {
 
@@ -59,6 +61,14 @@ struct MAPNIK_DECL image_reader : private util::noncopyable
     virtual std::optional<box2d<double>> bounding_box() const = 0;
     virtual void read(unsigned x, unsigned y, image_rgba8& image) = 0;
     virtual image_any read(unsigned x, unsigned y, unsigned width, unsigned height) = 0;
+    // Sizes of the reduced resolution versions stored with the image, largest first
+    virtual std::vector<std::pair<unsigned, unsigned>> overviews() const { return {}; }
+    // Read from overview `index` - 1 from now on, 0 selects the full resolution image.
+    virtual void select_overview(unsigned index)
+    {
+        if (index > 0)
+            throw image_reader_exception("image_reader: no overview " + std::to_string(index));
+    }
     virtual ~image_reader() {}
 };
 
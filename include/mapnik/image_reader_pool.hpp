@@ -0,0 +1,117 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_IMAGE_READER_POOL_HPP
+#define MAPNIK_IMAGE_READER_POOL_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/warning.hpp>
+#include <mapnik/image_reader.hpp>
+#include <mapnik/util/fs.hpp>
+#include <mapnik/util/singleton.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#endif
+
+namespace mapnik {
+
+// Process wide pool of open image readers keyed by file and format. Creating a
+// reader opens the file and parses its headers, a borrowed reader is used by one
+// thread at a time and goes back to the pool when released. Idle readers of a
+// file whose modification time or size changed are closed instead of reused.
+// The pool keeps at most `capacity` idle readers, least recently used are closed
+// first. Each of them holds its file open, the capacity counts against the
+// process limit of open file descriptors.
+class MAPNIK_DECL image_reader_pool : public singleton<image_reader_pool, CreateUsingNew>,
+                                      private util::noncopyable
+{
+    friend class CreateUsingNew<image_reader_pool>;
+
+  public:
+    struct MAPNIK_DECL releaser
+    {
+        std::string key;
+        std::optional<util::file_stamp> stamp; // readers of files that can't be stat'ed aren't pooled
+        void operator()(image_reader* reader) const;
+    };
+    using reader_ptr = std::unique_ptr<image_reader, releaser>;
+
+    static constexpr std::size_t default_capacity = 32;
+
+    explicit image_reader_pool(std::size_t capacity);
+
+    // Idle reader for `file`, or a new one from get_image_reader(file, format).
+    reader_ptr borrow(std::string const& file, std::string const& format);
+
+    void set_capacity(std::size_t capacity);
+    void clear();
+
+    std::size_t capacity() const;
+    std::size_t size() const; // idle readers
+    std::size_t hits() const { return hits_.load(); }
+    std::size_t misses() const { return misses_.load(); }
+    std::size_t evictions() const { return evictions_.load(); }
+
+  private:
+    struct entry
+    {
+        std::string key;
+        util::file_stamp stamp; // of the file when the reader was created
+        std::unique_ptr<image_reader> reader;
+    };
+    using list_type = std::list<entry>;
+
+    image_reader_pool();
+    void release(std::string const& key, util::file_stamp const& stamp, std::unique_ptr<image_reader> reader);
+    void shrink();
+
+#ifdef MAPNIK_THREADSAFE
+    mutable std::mutex pool_mutex_;
+#endif
+    std::size_t capacity_;
+    list_type entries_; // most recently released first
+    std::unordered_multimap<std::string, list_type::iterator> index_;
+    std::atomic<std::size_t> hits_;
+    std::atomic<std::size_t> misses_;
+    std::atomic<std::size_t> evictions_;
+};
+
+MAPNIK_DISABLE_WARNING_PUSH
+MAPNIK_DISABLE_WARNING_ATTRIBUTES
+extern template class MAPNIK_DECL singleton<image_reader_pool, CreateUsingNew>;
+MAPNIK_DISABLE_WARNING_POP
+
+} // namespace mapnik
+
+#endif // MAPNIK_IMAGE_READER_POOL_HPP
@@ -0,0 +1,84 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_IMAGE_SIMD_HPP
+#define MAPNIK_IMAGE_SIMD_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/image_compositing.hpp>
+
+// stl
+#include <cstddef>
+#include <cstdint>
+
+namespace mapnik {
+namespace simd {
+
+// Vectorized kernels for whole image rgba8 operations, selected at runtime from
+// the instruction sets supported by the CPU. They reproduce the integer arithmetic
+// of the AGG scalar code bit for bit.
+enum class instruction_set : std::uint8_t { scalar, sse41, avx2 };
+
+// Best instruction set supported by this CPU and build
+MAPNIK_DECL instruction_set detect_instruction_set();
+
+// Instruction set used by the kernels, defaults to detect_instruction_set().
+// Requests above the detected instruction set are lowered to it.
+MAPNIK_DECL instruction_set active_instruction_set();
+MAPNIK_DECL void set_instruction_set(instruction_set isa);
+
+// The kernels operate on `count` contiguous pixels. They return false without
+// touching the pixels when no vector code path is available, callers then fall
+// back to the scalar AGG implementation.
+MAPNIK_DECL bool premultiply_rgba8(std::uint32_t* pixels, std::size_t count);
+MAPNIK_DECL bool demultiply_rgba8(std::uint32_t* pixels, std::size_t count);
+MAPNIK_DECL bool apply_opacity_rgba8(std::uint32_t* pixels, std::size_t count, float opacity);
+
+// Premultiplied `src` blended onto `dst` like agg::comp_op_adaptor_rgba_pre
+// with the given cover. Only src-over, multiply, screen and dst-out are vectorized.
+MAPNIK_DECL bool can_composite_rgba8(composite_mode_e mode);
+MAPNIK_DECL bool composite_rgba8(std::uint32_t* dst,
+                                 std::uint32_t const* src,
+                                 std::size_t count,
+                                 composite_mode_e mode,
+                                 unsigned cover);
+
+// Number of leading pixels equal to pixels[0], used to find runs of one color.
+// Always available, the scalar loop is used without vector support.
+MAPNIK_DECL std::size_t equal_run_rgba8(std::uint32_t const* pixels, std::size_t count);
+
+// Index of the `palette` entry with the smallest sum of squared channel differences
+// to `color`. Ties go to `hint`, then to the closest entry below it, then to the
+// closest entry above it, which is what the neighbour search of the quantizers finds
+// around the sorted position `hint` of the color. Returns false without vector
+// support or for palettes of more than 1024 entries.
+MAPNIK_DECL bool nearest_rgba8(std::uint32_t const* palette,
+                               std::size_t count,
+                               std::uint32_t color,
+                               std::size_t hint,
+                               std::size_t& index);
+
+} // namespace simd
+} // namespace mapnik
+
+#endif // MAPNIK_IMAGE_SIMD_HPP
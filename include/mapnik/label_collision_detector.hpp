@@ -76,12 +76,9 @@ class label_collision_detector2 : util::noncopyable
 
     bool has_placement(box2d<double> const& box)
     {
-        tree_t::query_iterator itr = tree_.query_in_box(box);
-        tree_t::query_iterator end = tree_.query_end();
-        for (; itr != end; ++itr)
+        if (!tree_.visit_in_box(box, [&](box2d<double> const& other) { return !other.intersects(box); }))
         {
-            if (itr->get().intersects(box))
-                return false;
+            return false;
         }
         tree_.insert(box, box);
         return true;
@@ -104,15 +101,7 @@ class label_collision_detector3 : util::noncopyable
 
     bool has_placement(box2d<double> const& box)
     {
-        tree_t::query_iterator itr = tree_.query_in_box(box);
-        tree_t::query_iterator end = tree_.query_end();
-
-        for (; itr != end; ++itr)
-        {
-            if (itr->get().intersects(box))
-                return false;
-        }
-        return true;
+        return tree_.visit_in_box(box, [&](box2d<double> const& other) { return !other.intersects(box); });
     }
 
     void insert(box2d<double> const& box) { tree_.insert(box, box); }
@@ -152,16 +141,7 @@ class label_collision_detector4 : util::noncopyable
 
     bool has_placement(box2d<double> const& box)
     {
-        tree_t::query_iterator tree_itr = tree_.query_in_box(box);
-        tree_t::query_iterator tree_end = tree_.query_end();
-
-        for (; tree_itr != tree_end; ++tree_itr)
-        {
-            if (tree_itr->get().box.intersects(box))
-                return false;
-        }
-
-        return true;
+        return tree_.visit_in_box(box, [&](label const& lbl) { return !lbl.box.intersects(box); });
     }
 
     bool has_placement(box2d<double> const& box, double margin)
@@ -171,17 +151,7 @@ class label_collision_detector4 : util::noncopyable
              ? box2d<double>(box.minx() - margin, box.miny() - margin, box.maxx() + margin, box.maxy() + margin)
              : box);
 
-        tree_t::query_iterator tree_itr = tree_.query_in_box(margin_box);
-        tree_t::query_iterator tree_end = tree_.query_end();
-
-        for (; tree_itr != tree_end; ++tree_itr)
-        {
-            if (tree_itr->get().box.intersects(margin_box))
-            {
-                return false;
-            }
-        }
-        return true;
+        return tree_.visit_in_box(margin_box, [&](label const& lbl) { return !lbl.box.intersects(margin_box); });
     }
 
     bool has_placement(box2d<double> const& box,
@@ -205,19 +175,9 @@ class label_collision_detector4 : util::noncopyable
              ? box2d<double>(box.minx() - margin, box.miny() - margin, box.maxx() + margin, box.maxy() + margin)
              : box);
 
-        tree_t::query_iterator tree_itr = tree_.query_in_box(repeat_box);
-        tree_t::query_iterator tree_end = tree_.query_end();
-
-        for (; tree_itr != tree_end; ++tree_itr)
-        {
-            if (tree_itr->get().box.intersects(margin_box) ||
-                (text == tree_itr->get().text && tree_itr->get().box.intersects(repeat_box)))
-            {
-                return false;
-            }
-        }
-
-        return true;
+        return tree_.visit_in_box(repeat_box, [&](label const& lbl) {
+            return !(lbl.box.intersects(margin_box) || (text == lbl.text && lbl.box.intersects(repeat_box)));
+        });
     }
 
     void insert(box2d<double> const& box)
@@ -182,6 +182,17 @@ class MAPNIK_DECL layer
      */
     bool cache_features() const;
 
+    /*!
+     * @param query_ahead Set whether this layer's datasource may be queried on the
+     * thread pool ahead of rendering when the map sets `query-threads`.
+     */
+    void set_query_ahead(bool query_ahead);
+
+    /*!
+     * @return whether this layer's datasource may be queried ahead of rendering
+     */
+    bool query_ahead() const;
+
     /*!
      * @param column Set the field rendering of this layer is grouped by.
      */
@@ -242,6 +253,7 @@ class MAPNIK_DECL layer
     bool queryable_;
     bool clear_label_cache_;
     bool cache_features_;
+    bool query_ahead_;
     std::string group_by_;
     std::optional<sort_by_type> sort_by_;
     std::vector<std::string> styles_;
@@ -0,0 +1,136 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_MARKER_SPRITE_CACHE_HPP
+#define MAPNIK_MARKER_SPRITE_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/warning.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/marker.hpp>
+#include <mapnik/svg/svg_group.hpp>
+#include <mapnik/util/lru_cache.hpp>
+#include <mapnik/util/singleton.hpp>
+
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore_agg.hpp>
+#include "agg_trans_affine.h"
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace mapnik {
+
+// SVG marker rasterized into a premultiplied bitmap, pixel (0, 0) of `image`
+// is at (x, y) relative to the integer part of the marker position.
+struct marker_sprite
+{
+    image_rgba8 image;
+    int x;
+    int y;
+
+    std::size_t size() const { return image.size(); }
+};
+
+using marker_sprite_ptr = std::shared_ptr<marker_sprite const>;
+
+struct marker_sprite_key
+{
+    // `tr` is the marker transform with its translation rounded to subpixel steps,
+    // only the fractional part of the translation is kept.
+    marker_sprite_key(svg_path_ptr const& marker,
+                      svg::group const& group_attrs,
+                      agg::trans_affine const& tr,
+                      double gamma,
+                      int gamma_method);
+
+    svg_path_ptr marker;       // held so that the address can't be reused by another marker
+    std::vector<double> style; // attributes a markers symbolizer can override
+    double sx;
+    double shy;
+    double shx;
+    double sy;
+    int dx; // subpixel offset, in 1 / marker_sprite_cache::subpixel_steps
+    int dy;
+    double gamma;
+    int gamma_method;
+
+    bool operator==(marker_sprite_key const& rhs) const
+    {
+        return marker == rhs.marker && sx == rhs.sx && shy == rhs.shy && shx == rhs.shx && sy == rhs.sy &&
+               dx == rhs.dx && dy == rhs.dy && gamma == rhs.gamma && gamma_method == rhs.gamma_method &&
+               style == rhs.style;
+    }
+};
+
+struct marker_sprite_key_hash
+{
+    std::size_t operator()(marker_sprite_key const& key) const;
+};
+
+struct marker_sprite_cost
+{
+    std::size_t operator()(marker_sprite_key const&, marker_sprite const& sprite) const { return sprite.size(); }
+};
+
+using marker_sprite_lru = util::lru_cache<marker_sprite_key, marker_sprite, marker_sprite_key_hash, marker_sprite_cost>;
+
+// Upper bound of the distance the strokes of `group_attrs` reach outside the
+// bounding box of the marker, once transformed by `tr`.
+MAPNIK_DECL double marker_stroke_extent(svg::group const& group_attrs, agg::trans_affine const& tr);
+
+// Process wide LRU cache of rasterized SVG markers, bounded by their size in
+// bytes. Placements of a marker that only differ by translation are blitted
+// from one sprite instead of rasterizing the SVG again, positions are rounded
+// to 1 / subpixel_steps of a pixel. Sprites are rendered at full opacity, the
+// symbolizer opacity is applied when they are blitted. A capacity of 0, the
+// default, disables the cache.
+class MAPNIK_DECL marker_sprite_cache : public marker_sprite_lru,
+                                        public singleton<marker_sprite_cache, CreateUsingNew>
+{
+    friend class CreateUsingNew<marker_sprite_cache>;
+
+  public:
+    static constexpr std::size_t default_capacity = 0;
+    static constexpr int subpixel_steps = 4;
+    static constexpr unsigned max_sprite_size = 512; // larger markers are rendered directly
+
+    explicit marker_sprite_cache(std::size_t capacity);
+
+  private:
+    marker_sprite_cache();
+};
+
+MAPNIK_DISABLE_WARNING_PUSH
+MAPNIK_DISABLE_WARNING_ATTRIBUTES
+extern template class MAPNIK_DECL
+  util::lru_cache<marker_sprite_key, marker_sprite, marker_sprite_key_hash, marker_sprite_cost>;
+extern template class MAPNIK_DECL singleton<marker_sprite_cache, CreateUsingNew>;
+MAPNIK_DISABLE_WARNING_POP
+
+} // namespace mapnik
+
+#endif // MAPNIK_MARKER_SPRITE_CACHE_HPP
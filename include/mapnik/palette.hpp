@@ -124,6 +124,9 @@ class MAPNIK_DECL rgba_palette : private util::noncopyable
     inline std::vector<rgb>& palette() { return rgb_pal_; }
     inline std::vector<unsigned>& alpha_table() { return alpha_pal_; }
 
+    // Index of the closest palette color. Palette colors are found in a hash table,
+    // other colors are searched without caching so a palette can be shared by
+    // concurrent encoders; callers remapping whole images keep their own cache.
     unsigned char quantize(unsigned c) const;
 
     bool valid() const;
@@ -134,7 +137,9 @@ class MAPNIK_DECL rgba_palette : private util::noncopyable
 
   private:
     std::vector<rgba> sorted_pal_;
-    mutable rgba_hash_table color_hashmap_;
+    // sorted_pal_ packed like image pixels for the vector search
+    std::vector<std::uint32_t> packed_pal_;
+    rgba_hash_table color_hashmap_;
 
     unsigned colors_;
     std::vector<rgb> rgb_pal_;
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_PNG_ENCODER_HPP
+#define MAPNIK_PNG_ENCODER_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/palette.hpp>
+
+// stl
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace mapnik {
+
+struct png_options;
+
+// Selects how png files are written. `libpng` goes through png_write_png, the
+// others use the built in writer and differ in the deflate implementation.
+enum class png_encoder : std::uint8_t { libpng, zlib, libdeflate };
+
+MAPNIK_DECL bool png_encoder_available(png_encoder encoder);
+
+// Returns the PNG_FILTER_* flag with the smallest sum of absolute filtered bytes
+// over a sample of rows, used for the whole image when `f=auto` is requested.
+MAPNIK_DECL int select_png_filter(std::uint8_t const* data,
+                                  std::ptrdiff_t stride,
+                                  std::size_t row_bytes,
+                                  unsigned height,
+                                  unsigned bytes_per_pixel);
+
+// Writes rgba8 rows `stride` bytes apart, the alpha channel is dropped when
+// opts.trans_mode == 0. With opts.chunks > 1 the zlib encoder filters and
+// deflates the image in parallel on the thread pool.
+MAPNIK_DECL void encode_png_rgba8(std::ostream& out,
+                                  std::uint8_t const* data,
+                                  std::ptrdiff_t stride,
+                                  unsigned width,
+                                  unsigned height,
+                                  png_options const& opts);
+
+// Writes `color_depth` bit palette indexes, same arguments as the paletted save_as_png
+MAPNIK_DECL void encode_png_palette(std::ostream& out,
+                                    std::vector<rgb> const& palette,
+                                    image_gray8 const& image,
+                                    unsigned width,
+                                    unsigned height,
+                                    unsigned color_depth,
+                                    std::vector<unsigned> const& alpha,
+                                    png_options const& opts);
+
+} // namespace mapnik
+
+#endif // MAPNIK_PNG_ENCODER_HPP
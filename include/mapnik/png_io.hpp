@@ -28,6 +28,8 @@
 #include <mapnik/octree.hpp>
 #include <mapnik/hextree.hpp>
 #include <mapnik/image.hpp>
+#include <mapnik/image_simd.hpp>
+#include <mapnik/png_encoder.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -57,6 +59,10 @@ struct png_options
     double gamma;
     bool paletted;
     bool use_hextree;
+    bool auto_filter; // pick one filter per image, see select_png_filter
+    png_encoder encoder;
+    int chunks; // parallel deflate streams, zlib encoder only
+    int sample; // most pixels inserted into the hextree, 0 for all
 
     png_options()
         : colors(256),
@@ -66,7 +72,11 @@ struct png_options
           trans_mode(-1),
           gamma(-1),
           paletted(true),
-          use_hextree(true)
+          use_hextree(true),
+          auto_filter(false),
+          encoder(png_encoder::libpng),
+          chunks(1),
+          sample(0)
     {}
 };
 
@@ -88,6 +98,15 @@ template<typename T1, typename T2>
 void save_as_png(T1& file, T2 const& image, png_options const& opts)
 
 {
+    std::uint8_t const* data = reinterpret_cast<std::uint8_t const*>(image.get_row(0));
+    std::ptrdiff_t const stride =
+      image.height() > 1 ? reinterpret_cast<std::uint8_t const*>(image.get_row(1)) - data : 0;
+    if (opts.encoder != png_encoder::libpng)
+    {
+        encode_png_rgba8(file, data, stride, image.width(), image.height(), opts);
+        return;
+    }
+
     png_voidp error_ptr = 0;
     png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, error_ptr, 0, 0);
 
@@ -101,7 +120,10 @@ void save_as_png(T1& file, T2 const& image, png_options const& opts)
     mask = png_get_asm_flagmask(PNG_SELECT_READ | PNG_SELECT_WRITE);
     png_set_asm_flags(png_ptr, flags | mask);
 #endif
-    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, opts.filters);
+    png_set_filter(png_ptr,
+                   PNG_FILTER_TYPE_BASE,
+                   opts.auto_filter ? select_png_filter(data, stride, image.width() * 4u, image.height(), 4)
+                                    : opts.filters);
     png_infop info_ptr = png_create_info_struct(png_ptr);
     if (!info_ptr)
     {
@@ -269,6 +291,12 @@ void save_as_png(T& file,
                  std::vector<unsigned> const& alpha,
                  png_options const& opts)
 {
+    if (opts.encoder != png_encoder::libpng)
+    {
+        encode_png_palette(file, palette, image, width, height, color_depth, alpha, opts);
+        return;
+    }
+
     png_voidp error_ptr = 0;
     png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, error_ptr, 0, 0);
 
@@ -284,7 +312,11 @@ void save_as_png(T& file,
     mask = png_get_asm_flagmask(PNG_SELECT_READ | PNG_SELECT_WRITE);
     png_set_asm_flags(png_ptr, flags | mask);
 #endif
-    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, opts.filters);
+    png_set_filter(png_ptr,
+                   PNG_FILTER_TYPE_BASE,
+                   opts.auto_filter
+                     ? select_png_filter(image.get_row(0), image.row_size(), (width * color_depth + 7) / 8, height, 1)
+                     : opts.filters);
     png_infop info_ptr = png_create_info_struct(png_ptr);
     if (!info_ptr)
     {
@@ -571,6 +603,51 @@ void save_as_png8_oct(T1& file, T2 const& image, png_options const& opts)
     }
 }
 
+// Maps rows of rgba8 pixels to palette indexes. Runs of one color are found with
+// simd::equal_run_rgba8 and quantized once, other pixels go through a small direct
+// mapped cache in front of the quantizer.
+template<typename T>
+class palette_remapper
+{
+    static constexpr unsigned cache_bits = 12;
+
+  public:
+    explicit palette_remapper(T const& quantizer)
+        : quantizer_(quantizer),
+          keys_(1u << cache_bits, 0),
+          indexes_(1u << cache_bits, -1)
+    {}
+
+    void remap(std::uint32_t const* row, unsigned width, std::uint8_t* out)
+    {
+        unsigned x = 0;
+        while (x < width)
+        {
+            std::uint32_t const val = row[x];
+            std::uint8_t const index = lookup(val);
+            std::size_t const run = simd::equal_run_rgba8(row + x, width - x);
+            std::fill(out + x, out + x + run, index);
+            x += static_cast<unsigned>(run);
+        }
+    }
+
+  private:
+    std::uint8_t lookup(std::uint32_t val)
+    {
+        std::size_t const slot = (val * 0x9e3779b1u) >> (32 - cache_bits);
+        if (indexes_[slot] < 0 || keys_[slot] != val)
+        {
+            keys_[slot] = val;
+            indexes_[slot] = static_cast<std::int16_t>(quantizer_.quantize(val));
+        }
+        return static_cast<std::uint8_t>(indexes_[slot]);
+    }
+
+    T const& quantizer_;
+    std::vector<std::uint32_t> keys_;
+    std::vector<std::int16_t> indexes_;
+};
+
 template<typename T1, typename T2, typename T3>
 void save_as_png8(T1& file,
                   T2 const& image,
@@ -581,6 +658,7 @@ void save_as_png8(T1& file,
 {
     unsigned width = image.width();
     unsigned height = image.height();
+    palette_remapper<T3> remapper(tree);
 
     if (palette.size() > 16)
     {
@@ -588,12 +666,7 @@ void save_as_png8(T1& file,
         image_gray8 reduced_image(width, height);
         for (unsigned y = 0; y < height; ++y)
         {
-            mapnik::image_rgba8::pixel_type const* row = image.get_row(y);
-            mapnik::image_gray8::pixel_type* row_out = reduced_image.get_row(y);
-            for (unsigned x = 0; x < width; ++x)
-            {
-                row_out[x] = tree.quantize(row[x]);
-            }
+            remapper.remap(image.get_row(y), width, reduced_image.get_row(y));
         }
         save_as_png(file, palette, reduced_image, width, height, 8, alpha_table, opts);
     }
@@ -612,14 +685,14 @@ void save_as_png8(T1& file,
         unsigned image_width = ((width + 7) >> 1) & ~3U; // 4-bit image, round up to 32-bit boundary
         unsigned image_height = height;
         image_gray8 reduced_image(image_width, image_height);
+        std::vector<std::uint8_t> indexes(width);
         for (unsigned y = 0; y < height; ++y)
         {
-            mapnik::image_rgba8::pixel_type const* row = image.get_row(y);
             mapnik::image_gray8::pixel_type* row_out = reduced_image.get_row(y);
-            std::uint8_t index = 0;
+            remapper.remap(image.get_row(y), width, indexes.data());
             for (unsigned x = 0; x < width; ++x)
             {
-                index = tree.quantize(row[x]);
+                std::uint8_t index = indexes[x];
                 if (x % 2 == 0)
                 {
                     index = index << 4;
@@ -650,13 +723,41 @@ void save_as_png8_hex(T1& file, T2 const& image, png_options const& opts)
             tree.setGamma(opts.gamma);
         }
 
-        for (unsigned y = 0; y < height; ++y)
+        std::size_t const pixels = std::size_t(width) * height;
+        if (opts.sample > 0 && pixels > static_cast<std::size_t>(opts.sample))
         {
-            typename T2::pixel_type const* row = image.get_row(y);
-            for (unsigned x = 0; x < width; ++x)
+            // every step-th pixel, the step must not divide the width or the same
+            // columns would be sampled on every row. Holes are recorded for all
+            // pixels so transparent areas keep their palette entry.
+            std::size_t step = (pixels + opts.sample - 1) / opts.sample;
+            while (width % step == 0)
             {
-                unsigned val = row[x];
-                tree.insert(mapnik::rgba(U2RED(val), U2GREEN(val), U2BLUE(val), U2ALPHA(val)));
+                ++step;
+            }
+            std::size_t index = 0;
+            for (unsigned y = 0; y < height; ++y)
+            {
+                typename T2::pixel_type const* row = image.get_row(y);
+                for (unsigned x = 0; x < width; ++x, ++index)
+                {
+                    unsigned val = row[x];
+                    if (index % step == 0 || tree.is_hole(U2ALPHA(val)))
+                    {
+                        tree.insert(mapnik::rgba(U2RED(val), U2GREEN(val), U2BLUE(val), U2ALPHA(val)));
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (unsigned y = 0; y < height; ++y)
+            {
+                typename T2::pixel_type const* row = image.get_row(y);
+                for (unsigned x = 0; x < width; ++x)
+                {
+                    unsigned val = row[x];
+                    tree.insert(mapnik::rgba(U2RED(val), U2GREEN(val), U2BLUE(val), U2ALPHA(val)));
+                }
             }
         }
 
@@ -29,6 +29,7 @@
 #include <mapnik/geometry/point.hpp>
 #include <mapnik/projection.hpp>
 // stl
+#include <string>
 #include <vector>
 
 namespace mapnik {
@@ -56,6 +57,10 @@ class MAPNIK_DECL proj_transform : private util::noncopyable
     bool forward(box2d<double>& box, std::size_t points) const;
     bool backward(box2d<double>& box, std::size_t points) const;
     std::string definition() const;
+    // projection params the transform was created with, unlike definition() they
+    // tell every pair of projections apart
+    std::string const& source_params() const;
+    std::string const& dest_params() const;
 
   private:
     PJ_CONTEXT* ctx_ = nullptr;
@@ -65,6 +70,8 @@ class MAPNIK_DECL proj_transform : private util::noncopyable
     bool is_source_equal_dest_;
     bool wgs84_to_merc_;
     bool merc_to_wgs84_;
+    std::string source_params_;
+    std::string dest_params_;
 };
 
 } // namespace mapnik
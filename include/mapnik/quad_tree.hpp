@@ -28,32 +28,42 @@
 #include <mapnik/util/noncopyable.hpp>
 
 // stl
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <new>
+#include <utility>
 #include <vector>
 #include <type_traits>
 
 #include <cstring>
 
 namespace mapnik {
+
+// Quad tree with its nodes stored in one vector and linked by index, queried
+// without recursion. compact() puts the nodes in depth first order once loaded,
+// bulk_load() builds them in that order.
 template<typename T0, typename T1 = box2d<double>>
 class quad_tree : util::noncopyable
 {
     using value_type = T0;
     using bbox_type = T1;
+    using index_type = std::int32_t;
+    static constexpr index_type npos = -1;
+
     struct node
     {
         using cont_type = std::vector<T0>;
         using iterator = typename cont_type::iterator;
         using const_iterator = typename cont_type::const_iterator;
         bbox_type extent_;
+        index_type children_[4];
         cont_type cont_;
-        node* children_[4];
 
         explicit node(bbox_type const& ext)
             : extent_(ext)
         {
-            std::fill(children_, children_ + 4, nullptr);
+            std::fill(children_, children_ + 4, npos);
         }
 
         bbox_type const& extent() const { return extent_; }
@@ -71,17 +81,14 @@ class quad_tree : util::noncopyable
             int _count = 0;
             for (int i = 0; i < 4; ++i)
             {
-                if (children_[i])
+                if (children_[i] != npos)
                     ++_count;
             }
             return _count;
         }
-        ~node() {}
     };
 
-    using nodes_type = std::vector<std::unique_ptr<node>>;
-    using cont_type = typename node::cont_type;
-    using node_data_iterator = typename cont_type::iterator;
+    using nodes_type = std::vector<node>;
 
   public:
     using iterator = typename nodes_type::iterator;
@@ -93,40 +100,127 @@ class quad_tree : util::noncopyable
         : max_depth_(max_depth),
           ratio_(ratio),
           query_result_(),
-          nodes_()
+          nodes_(),
+          root_(0)
     {
-        nodes_.push_back(std::make_unique<node>(ext));
-        root_ = nodes_[0].get();
+        nodes_.emplace_back(ext);
     }
 
     void insert(value_type const& data, bbox_type const& box)
     {
-        unsigned int depth = 0;
-        do_insert_data(data, box, root_, depth);
+        index_type n = root_;
+        for (unsigned int depth = 1; depth < max_depth_; ++depth)
+        {
+            bbox_type ext[4];
+            split_box(nodes_[n].extent_, ext);
+            int i = 0;
+            while (i < 4 && !ext[i].contains(box))
+            {
+                ++i;
+            }
+            if (i == 4)
+            {
+                break;
+            }
+            if (nodes_[n].children_[i] == npos)
+            {
+                nodes_.emplace_back(ext[i]);
+                nodes_[n].children_[i] = static_cast<index_type>(nodes_.size() - 1);
+            }
+            n = nodes_[n].children_[i];
+        }
+        nodes_[n].cont_.push_back(data);
+    }
+
+    // Replace the items of the tree with the (value, box) pairs in [first, last).
+    // Items are sorted into the quadrants of each node top down instead of
+    // descending from the root one by one. The tree gets the nodes and items
+    // insert() followed by compact() would give.
+    template<typename Iterator>
+    void bulk_load(Iterator first, Iterator last)
+    {
+        std::vector<std::pair<value_type, bbox_type>> items;
+        for (; first != last; ++first)
+        {
+            items.emplace_back(first->first, first->second);
+        }
+        std::vector<std::size_t> order(items.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::vector<std::size_t> scratch(items.size());
+        clear();
+        load_node(root_, 1, items, order.data(), order.data() + order.size(), scratch.data());
     }
 
     query_iterator query_in_box(bbox_type const& box)
     {
         query_result_.clear();
-        query_node(box, query_result_, root_);
+        visit_in_box(box, [this](value_type& val) {
+            query_result_.push_back(std::ref(val));
+            return true;
+        });
         return query_result_.begin();
     }
 
     query_iterator query_end() { return query_result_.end(); }
 
+    // Call f(value) for the items of every node intersecting `box`, in the order
+    // of query_in_box(), until f returns false. Returns false if f stopped the visit.
+    template<typename F>
+    bool visit_in_box(bbox_type const& box, F&& f)
+    {
+        stack_.clear();
+        stack_.push_back(root_);
+        while (!stack_.empty())
+        {
+            node& n = nodes_[stack_.back()];
+            stack_.pop_back();
+            if (!box.intersects(n.extent_))
+            {
+                continue;
+            }
+            for (value_type& val : n.cont_)
+            {
+                if (!f(val))
+                {
+                    return false;
+                }
+            }
+            for (int k = 3; k >= 0; --k)
+            {
+                if (n.children_[k] != npos)
+                {
+                    stack_.push_back(n.children_[k]);
+                }
+            }
+        }
+        return true;
+    }
+
     const_iterator begin() const { return nodes_.begin(); }
 
     const_iterator end() const { return nodes_.end(); }
 
     void clear()
     {
-        bbox_type ext = root_->extent_;
+        bbox_type ext = nodes_[root_].extent_;
         nodes_.clear();
-        nodes_.push_back(std::make_unique<node>(ext));
-        root_ = nodes_[0].get();
+        nodes_.emplace_back(ext);
+        root_ = 0;
+    }
+
+    // Store the reachable nodes in depth first order, the order queries visit them
+    void compact()
+    {
+        nodes_type nodes;
+        nodes.reserve(nodes_.size());
+        root_ = compact_node(root_, nodes);
+        nodes_.swap(nodes);
     }
 
-    bbox_type const& extent() const { return root_->extent_; }
+    bbox_type const& extent() const { return nodes_[root_].extent_; }
 
     int count() const { return count_nodes(root_); }
 
@@ -151,48 +245,80 @@ class quad_tree : util::noncopyable
     }
 
   private:
-
-    void query_node(bbox_type const& box, result_type& result, node* node_) const
+    index_type compact_node(index_type index, nodes_type& nodes)
     {
-        if (node_)
+        index_type const result = static_cast<index_type>(nodes.size());
+        nodes.emplace_back(nodes_[index].extent_);
+        nodes.back().cont_ = std::move(nodes_[index].cont_);
+        for (int k = 0; k < 4; ++k)
         {
-            bbox_type const& node_extent = node_->extent();
-            if (box.intersects(node_extent))
+            if (nodes_[index].children_[k] != npos)
             {
-                for (auto& n : *node_)
-                {
-                    result.push_back(std::ref(n));
-                }
-                for (int k = 0; k < 4; ++k)
-                {
-                    query_node(box, result, node_->children_[k]);
-                }
+                index_type const child = compact_node(nodes_[index].children_[k], nodes);
+                nodes[result].children_[k] = child;
             }
         }
+        return result;
     }
 
-    void do_insert_data(value_type const& data, bbox_type const& box, node* n, unsigned int& depth)
+    // Sort the items in [begin, end) by the child of node `n` they fit in, keeping
+    // their order, store the ones fitting no child and load the children.
+    void load_node(index_type n,
+                   unsigned int depth,
+                   std::vector<std::pair<value_type, bbox_type>> const& items,
+                   std::size_t* begin,
+                   std::size_t* end,
+                   std::size_t* scratch)
     {
-        if (++depth < max_depth_)
+        bbox_type ext[4];
+        auto quadrant = [&](std::size_t item) {
+            int i = 0;
+            while (i < 4 && !ext[i].contains(items[item].second))
+            {
+                ++i;
+            }
+            return i;
+        };
+        std::size_t offsets[6] = {0, 0, 0, 0, 0, 0}; // items of the node, then of each child
+        if (depth < max_depth_)
         {
-            bbox_type const& node_extent = n->extent();
-            bbox_type ext[4];
-            split_box(node_extent, ext);
-            for (int i = 0; i < 4; ++i)
+            split_box(nodes_[n].extent_, ext);
+            for (std::size_t* p = begin; p != end; ++p)
             {
-                if (ext[i].contains(box))
-                {
-                    if (!n->children_[i])
-                    {
-                        nodes_.push_back(std::make_unique<node>(ext[i]));
-                        n->children_[i] = nodes_.back().get();
-                    }
-                    do_insert_data(data, box, n->children_[i], depth);
-                    return;
-                }
+                int const i = quadrant(*p);
+                ++offsets[i == 4 ? 1 : i + 2];
+            }
+            for (int i = 1; i < 6; ++i)
+            {
+                offsets[i] += offsets[i - 1];
+            }
+            std::size_t next[5] = {offsets[0], offsets[1], offsets[2], offsets[3], offsets[4]};
+            for (std::size_t* p = begin; p != end; ++p)
+            {
+                int const i = quadrant(*p);
+                scratch[next[i == 4 ? 0 : i + 1]++] = *p;
+            }
+            std::copy(scratch, scratch + (end - begin), begin);
+        }
+        else
+        {
+            std::fill(offsets + 1, offsets + 6, static_cast<std::size_t>(end - begin));
+        }
+        nodes_[n].cont_.reserve(offsets[1]);
+        for (std::size_t* p = begin; p != begin + offsets[1]; ++p)
+        {
+            nodes_[n].cont_.push_back(items[*p].first);
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+            if (offsets[k + 2] > offsets[k + 1])
+            {
+                nodes_.emplace_back(ext[k]);
+                index_type const child = static_cast<index_type>(nodes_.size() - 1);
+                nodes_[n].children_[k] = child;
+                load_node(child, depth + 1, items, begin + offsets[k + 1], begin + offsets[k + 2], scratch);
             }
         }
-        n->cont_.push_back(data);
     }
 
     void split_box(bbox_type const& node_extent, bbox_type* ext)
@@ -210,21 +336,21 @@ class quad_tree : util::noncopyable
         ext[3] = bbox_type(hix - width * ratio_, hiy - height * ratio_, hix, hiy);
     }
 
-    void trim_tree(node*& n)
+    void trim_tree(index_type& n)
     {
-        if (n)
+        if (n != npos)
         {
             for (int i = 0; i < 4; ++i)
             {
-                trim_tree(n->children_[i]);
+                trim_tree(nodes_[n].children_[i]);
             }
-            if (n->num_subnodes() == 1 && n->cont_.size() == 0)
+            if (nodes_[n].num_subnodes() == 1 && nodes_[n].cont_.size() == 0)
             {
                 for (int i = 0; i < 4; ++i)
                 {
-                    if (n->children_[i])
+                    if (nodes_[n].children_[i] != npos)
                     {
-                        n = n->children_[i];
+                        n = nodes_[n].children_[i];
                         break;
                     }
                 }
@@ -232,79 +358,74 @@ class quad_tree : util::noncopyable
         }
     }
 
-    int count_nodes(node const* n) const
+    int count_nodes(index_type n) const
     {
-        if (!n)
+        if (n == npos)
             return 0;
         else
         {
             int _count = 1;
             for (int i = 0; i < 4; ++i)
             {
-                _count += count_nodes(n->children_[i]);
+                _count += count_nodes(nodes_[n].children_[i]);
             }
             return _count;
         }
     }
 
-    void count_items(node const* n, int& _count) const
+    void count_items(index_type n, int& _count) const
     {
-        if (n)
+        if (n != npos)
         {
-            _count += n->cont_.size();
+            _count += nodes_[n].cont_.size();
             for (int i = 0; i < 4; ++i)
             {
-                count_items(n->children_[i], _count);
+                count_items(nodes_[n].children_[i], _count);
             }
         }
     }
 
-    int subnode_offset(node const* n) const
+    int subnode_offset(index_type n) const
     {
         int offset = 0;
         for (int i = 0; i < 4; i++)
         {
-            if (n->children_[i])
+            index_type const child = nodes_[n].children_[i];
+            if (child != npos)
             {
-                offset += sizeof(bbox_type) + (n->children_[i]->cont_.size() * sizeof(value_type)) + 3 * sizeof(int);
-                offset += subnode_offset(n->children_[i]);
+                offset += sizeof(bbox_type) + (nodes_[child].cont_.size() * sizeof(value_type)) + 3 * sizeof(int);
+                offset += subnode_offset(child);
             }
         }
         return offset;
     }
 
     template<typename OutputStream>
-    void write_node(OutputStream& out, node const* n) const
+    void write_node(OutputStream& out, index_type index) const
     {
-        if (n)
+        if (index != npos)
         {
-            int offset = subnode_offset(n);
-            int shape_count = n->cont_.size();
+            node const& n = nodes_[index];
+            int offset = subnode_offset(index);
+            int shape_count = n.cont_.size();
             int recsize = sizeof(bbox_type) + 3 * sizeof(int) + shape_count * sizeof(value_type);
             std::unique_ptr<char[]> node_record(new char[recsize]);
             std::memset(node_record.get(), 0, recsize);
             std::memcpy(node_record.get(), &offset, 4);
-            std::memcpy(node_record.get() + 4, &n->extent_, sizeof(bbox_type));
+            std::memcpy(node_record.get() + 4, &n.extent_, sizeof(bbox_type));
             std::memcpy(node_record.get() + 4 + sizeof(bbox_type), &shape_count, 4);
             for (int i = 0; i < shape_count; ++i)
             {
                 memcpy(node_record.get() + 8 + sizeof(bbox_type) + i * sizeof(value_type),
-                       &(n->cont_[i]),
+                       &(n.cont_[i]),
                        sizeof(value_type));
             }
-            int num_subnodes = 0;
-            for (int i = 0; i < 4; ++i)
-            {
-                if (n->children_[i])
-                {
-                    ++num_subnodes;
-                }
-            }
+            int num_subnodes = n.num_subnodes();
             std::memcpy(node_record.get() + 8 + sizeof(bbox_type) + shape_count * sizeof(value_type), &num_subnodes, 4);
             out.write(node_record.get(), recsize);
-            for (int i = 0; i < 4; ++i)
+            for (int k = 0; k < 4; ++k)
             {
-                write_node(out, n->children_[i]);
+                write_node(out, n.children_[k]);
             }
         }
     }
@@ -313,7 +434,8 @@ class quad_tree : util::noncopyable
     double const ratio_;
     result_type query_result_;
     nodes_type nodes_;
-    node* root_;
+    std::vector<index_type> stack_; // visit_in_box() work list
+    index_type root_;
 };
 } // namespace mapnik
 
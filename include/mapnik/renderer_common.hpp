@@ -33,6 +33,8 @@
 // fwd declarations to speed up compile
 namespace mapnik {
 class label_collision_detector4;
+class glyph_cache;
+class geometry_cache;
 class Map;
 class request;
 //  class attributes;
@@ -80,6 +82,10 @@ struct renderer_common : private util::noncopyable
     box2d<double> query_extent_;
     view_transform t_;
     detector_ptr detector_;
+    // shared rasterized glyphs, nullptr unless the map sets `glyph-cache`
+    glyph_cache* glyph_cache_;
+    // converted geometries of the current layer, nullptr unless the map sets `geometry-cache`
+    std::shared_ptr<geometry_cache> geometry_cache_;
 
   protected:
     // it's desirable to keep this class implicitly noncopyable to prevent
@@ -0,0 +1,248 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_RENDERER_COMMON_GEOMETRY_CACHE_HPP
+#define MAPNIK_RENDERER_COMMON_GEOMETRY_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/attribute.hpp>
+#include <mapnik/simplify.hpp>
+#include <mapnik/symbolizer_base.hpp>
+#include <mapnik/symbolizer_enumerations.hpp>
+#include <mapnik/vertex_processor.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/renderer_common/apply_vertex_converter.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore_agg.hpp>
+#include "agg_basics.h"
+#include "agg_trans_affine.h"
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mapnik {
+
+class layer;
+
+// Everything the converter chain up to (and including) smoothing depends on,
+// the stages that follow (offset, dash, stroke) are applied to the cached paths.
+struct MAPNIK_DECL geometry_cache_key
+{
+    enum clip_type : unsigned { no_clip, clip_line, clip_poly };
+
+    geometry_cache_key(feature_impl const& feature,
+                       clip_type clip,
+                       box2d<double> const& clip_box,
+                       agg::trans_affine const& affine_trans,
+                       symbolizer_base const& sym,
+                       attributes const& vars);
+
+    bool operator==(geometry_cache_key const& rhs) const
+    {
+        return feature_id == rhs.feature_id && geometry_type == rhs.geometry_type && clip == rhs.clip &&
+               clip_box == rhs.clip_box && affine_trans.is_equal(rhs.affine_trans, 0.0) &&
+               simplify_tolerance == rhs.simplify_tolerance && simplify_algorithm == rhs.simplify_algorithm &&
+               smooth == rhs.smooth && smooth_algorithm == rhs.smooth_algorithm;
+    }
+
+    value_integer feature_id;
+    unsigned geometry_type;
+    clip_type clip;
+    box2d<double> clip_box; // empty unless clipped
+    agg::trans_affine affine_trans;
+    value_double simplify_tolerance;
+    simplify_algorithm_e simplify_algorithm; // radial_distance unless simplified
+    value_double smooth;
+    smooth_algorithm_enum smooth_algorithm; // SMOOTH_ALGORITHM_BASIC unless smoothed
+};
+
+struct geometry_cache_key_hash
+{
+    std::size_t operator()(geometry_cache_key const& key) const;
+};
+
+// Vertices of one geometry part as they came out of the converter chain
+struct geometry_cache_path
+{
+    unsigned type;
+    std::vector<agg::vertex_d> vertices;
+};
+
+// Replays a geometry_cache_path as a vertex source
+class geometry_cache_adapter
+{
+  public:
+    explicit geometry_cache_adapter(geometry_cache_path const& path)
+        : path_(path),
+          pos_(0)
+    {}
+
+    void rewind(unsigned) { pos_ = 0; }
+
+    unsigned vertex(double* x, double* y)
+    {
+        if (pos_ == path_.vertices.size())
+            return agg::path_cmd_stop;
+        agg::vertex_d const& v = path_.vertices[pos_++];
+        *x = v.x;
+        *y = v.y;
+        return v.cmd;
+    }
+
+    unsigned type() const { return path_.type; }
+
+  private:
+    geometry_cache_path const& path_;
+    std::size_t pos_;
+};
+
+// Geometries of the features of one layer, clipped, transformed to screen
+// coordinates, simplified and smoothed. Styles of the layer (casing and fill of
+// a road, fill and outline of a polygon) render the same features with the same
+// converters, the geometry is converted once and replayed for the others.
+// Features are identified by their id, which must be unique within the layer.
+// Paths are only kept for layers whose styles share one featureset
+// (`cache-features`, `group-by` or `sort-by`): otherwise every style queries the
+// datasource again and nothing guarantees an id names the same feature in each
+// query. Enabled by the `geometry-cache` map parameter. Bounded by the bytes held
+// by the cached paths, once full further geometries aren't cached.
+class MAPNIK_DECL geometry_cache : private util::noncopyable
+{
+  public:
+    using paths_type = std::vector<geometry_cache_path>;
+    using paths_ptr = std::shared_ptr<paths_type const>;
+
+    static constexpr std::size_t default_capacity = 16 * 1024 * 1024;
+
+    explicit geometry_cache(std::size_t capacity = default_capacity);
+
+    paths_ptr find(geometry_cache_key const& key);
+    paths_ptr insert(geometry_cache_key const& key, paths_type&& paths);
+    void clear();
+    // clears the cache and enables it if the styles of `lay` share a featureset
+    void start_layer(layer const& lay);
+
+    bool enabled() const { return enabled_; }
+    std::size_t capacity() const { return capacity_; }
+    std::size_t bytes() const { return bytes_; }
+    std::size_t hits() const { return hits_; }
+    std::size_t misses() const { return misses_; }
+
+  private:
+    std::size_t capacity_;
+    std::size_t bytes_;
+    bool enabled_;
+    std::unordered_map<geometry_cache_key, paths_ptr, geometry_cache_key_hash> paths_;
+    std::size_t hits_;
+    std::size_t misses_;
+};
+
+namespace detail {
+
+template<typename F>
+struct geometry_cache_forwarder
+{
+    template<typename Path>
+    void add_path(Path& path)
+    {
+        f(path);
+    }
+
+    F& f;
+};
+
+struct geometry_cache_recorder
+{
+    template<typename Path>
+    void add_path(Path& path)
+    {
+        geometry_cache_path result{static_cast<unsigned>(path.type()), {}};
+        path.rewind(0);
+        double x;
+        double y;
+        unsigned cmd;
+        while (!agg::is_stop(cmd = path.vertex(&x, &y)))
+        {
+            result.vertices.emplace_back(x, y, cmd);
+        }
+        paths.push_back(std::move(result));
+    }
+
+    geometry_cache::paths_type& paths;
+};
+
+template<typename Converter, typename Processor>
+void apply_vertex_processor(Converter& converter, Processor& proc, feature_impl const& feature)
+{
+    using apply_vertex_converter_type = apply_vertex_converter<Converter, Processor>;
+    using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
+    apply_vertex_converter_type apply(converter, proc);
+    mapnik::util::apply_visitor(vertex_processor_type(apply), feature.get_geometry());
+}
+
+} // namespace detail
+
+// Runs the geometry of `feature` through `converter` and calls `f` with every
+// path it produces. With an enabled cache the paths of an earlier run with the key
+// returned by `make_key` are replayed instead.
+template<typename KeyFunc, typename Converter, typename F>
+void apply_geometry_cache(geometry_cache* cache,
+                          KeyFunc&& make_key,
+                          Converter& converter,
+                          feature_impl const& feature,
+                          F&& f)
+{
+    if (cache == nullptr || !cache->enabled())
+    {
+        detail::geometry_cache_forwarder<F> forwarder{f};
+        detail::apply_vertex_processor(converter, forwarder, feature);
+        return;
+    }
+    geometry_cache_key const key = make_key();
+    geometry_cache::paths_ptr paths = cache->find(key);
+    if (!paths)
+    {
+        geometry_cache::paths_type result;
+        detail::geometry_cache_recorder recorder{result};
+        detail::apply_vertex_processor(converter, recorder, feature);
+        paths = cache->insert(key, std::move(result));
+    }
+    for (geometry_cache_path const& path : *paths)
+    {
+        geometry_cache_adapter adapter(path);
+        f(adapter);
+    }
+}
+
+} // namespace mapnik
+
+#endif // MAPNIK_RENDERER_COMMON_GEOMETRY_CACHE_HPP
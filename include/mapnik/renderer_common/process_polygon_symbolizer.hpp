@@ -27,14 +27,16 @@
 #include <mapnik/vertex_converters.hpp>
 #include <mapnik/vertex_processor.hpp>
 #include <mapnik/symbolizer.hpp>
+#include <mapnik/resolved_symbolizer.hpp>
 
 #include <mapnik/feature.hpp>
-#include <mapnik/renderer_common/apply_vertex_converter.hpp>
+#include <mapnik/renderer_common/geometry_cache.hpp>
 
 namespace mapnik {
 
 template<typename vertex_converter_type, typename rasterizer_type, typename F>
 void render_polygon_symbolizer(polygon_symbolizer const& sym,
+                               polygon_symbolizer_properties const& props,
                                mapnik::feature_impl& feature,
                                proj_transform const& prj_trans,
                                renderer_common& common,
@@ -43,19 +45,19 @@ void render_polygon_symbolizer(polygon_symbolizer const& sym,
                                F fill_func)
 {
     agg::trans_affine tr;
-    auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
-    if (transform)
-        evaluate_transform(tr, feature, common.vars_, *transform, common.scale_factor_);
+    if (props.geometry_transform)
+        evaluate_transform(tr, feature, common.vars_, props.geometry_transform, common.scale_factor_);
 
-    value_bool clip = get<value_bool, keys::clip>(sym, feature, common.vars_);
-    value_double simplify_tolerance = get<value_double, keys::simplify_tolerance>(sym, feature, common.vars_);
-    value_double smooth = get<value_double, keys::smooth>(sym, feature, common.vars_);
-    value_double opacity = get<value_double, keys::fill_opacity>(sym, feature, common.vars_);
+    value_bool clip = props.clip.get(feature, common.vars_);
+    value_double simplify_tolerance = props.simplify_tolerance.get(feature, common.vars_);
+    value_double smooth = props.smooth.get(feature, common.vars_);
+    value_double opacity = props.fill_opacity.get(feature, common.vars_);
 
     vertex_converter_type
       converter(clip_box, sym, common.t_, prj_trans, tr, feature, common.vars_, common.scale_factor_);
 
-    if (prj_trans.equal() && clip)
+    bool const clip_poly = prj_trans.equal() && clip;
+    if (clip_poly)
         converter.template set<clip_poly_tag>();
     converter.template set<transform_tag>(); // always transform
     converter.template set<affine_transform_tag>();
@@ -64,12 +66,16 @@ void render_polygon_symbolizer(polygon_symbolizer const& sym,
     if (smooth > 0.0)
         converter.template set<smooth_tag>(); // optional smooth converter
 
-    using apply_vertex_converter_type = detail::apply_vertex_converter<vertex_converter_type, rasterizer_type>;
-    using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
-    apply_vertex_converter_type apply(converter, ras);
-    mapnik::util::apply_visitor(vertex_processor_type(apply), feature.get_geometry());
+    auto make_key = [&] {
+        geometry_cache_key::clip_type const clip_type =
+          clip_poly ? geometry_cache_key::clip_poly : geometry_cache_key::no_clip;
+        return geometry_cache_key(feature, clip_type, clip_box, tr, sym, common.vars_);
+    };
+    apply_geometry_cache(common.geometry_cache_.get(), make_key, converter, feature, [&](auto& path) {
+        ras.add_path(path);
+    });
 
-    color const& fill = get<mapnik::color, keys::fill>(sym, feature, common.vars_);
+    color const fill = props.fill.get(feature, common.vars_);
     fill_func(fill, opacity);
 }
 
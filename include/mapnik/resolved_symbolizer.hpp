@@ -0,0 +1,138 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_RESOLVED_SYMBOLIZER_HPP
+#define MAPNIK_RESOLVED_SYMBOLIZER_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/symbolizer_default_values.hpp>
+#include <mapnik/symbolizer_enumerations.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <unordered_map>
+
+namespace mapnik {
+
+// True if evaluating the property value requires feature attributes or the geometry type.
+// Global attributes (@name) are constant during a render and don't make a value feature dependent.
+MAPNIK_DECL bool is_feature_dependent(symbolizer_base::value_type const& val);
+
+// A symbolizer property resolved once per render. Constant values (including expressions
+// which only reference global attributes) are extracted up front, feature dependent
+// expressions are kept and evaluated by get().
+template<typename T, keys key>
+class resolved_property
+{
+  public:
+    void resolve(symbolizer_base const& sym, feature_impl const& feature, attributes const& vars)
+    {
+        expr_ = nullptr;
+        auto itr = sym.properties.find(key);
+        if (itr == sym.properties.end())
+        {
+            value_ = symbolizer_default<T, key>::value();
+        }
+        else if (is_feature_dependent(itr->second))
+        {
+            expr_ = &itr->second;
+        }
+        else
+        {
+            value_ = util::apply_visitor(extract_value<T>(feature, vars), itr->second);
+        }
+    }
+
+    T get(feature_impl const& feature, attributes const& vars) const
+    {
+        if (expr_ == nullptr)
+            return value_;
+        return util::apply_visitor(extract_value<T>(feature, vars), *expr_);
+    }
+
+    bool constant() const { return expr_ == nullptr; }
+
+  private:
+    T value_ = T();
+    symbolizer_base::value_type const* expr_ = nullptr;
+};
+
+// Properties read by the line and polygon symbolizer renderers. They reference the
+// expressions of the symbolizer they were resolved from, which must outlive them.
+struct MAPNIK_DECL line_symbolizer_properties
+{
+    line_symbolizer_properties(symbolizer_base const& sym, feature_impl const& feature, attributes const& vars);
+
+    resolved_property<color, keys::stroke> stroke;
+    resolved_property<value_double, keys::stroke_gamma> stroke_gamma;
+    resolved_property<gamma_method_enum, keys::stroke_gamma_method> stroke_gamma_method;
+    resolved_property<composite_mode_e, keys::comp_op> comp_op;
+    resolved_property<value_bool, keys::clip> clip;
+    resolved_property<value_double, keys::stroke_width> stroke_width;
+    resolved_property<value_double, keys::stroke_opacity> stroke_opacity;
+    resolved_property<value_double, keys::offset> offset;
+    resolved_property<value_double, keys::simplify_tolerance> simplify_tolerance;
+    resolved_property<value_double, keys::smooth> smooth;
+    resolved_property<line_rasterizer_enum, keys::line_rasterizer> line_rasterizer;
+    resolved_property<line_join_enum, keys::stroke_linejoin> stroke_linejoin;
+    resolved_property<line_cap_enum, keys::stroke_linecap> stroke_linecap;
+    transform_type geometry_transform;
+    bool has_dasharray;
+};
+
+struct MAPNIK_DECL polygon_symbolizer_properties
+{
+    polygon_symbolizer_properties(symbolizer_base const& sym, feature_impl const& feature, attributes const& vars);
+
+    resolved_property<color, keys::fill> fill;
+    resolved_property<value_double, keys::fill_opacity> fill_opacity;
+    resolved_property<value_double, keys::gamma> gamma;
+    resolved_property<gamma_method_enum, keys::gamma_method> gamma_method;
+    resolved_property<composite_mode_e, keys::comp_op> comp_op;
+    resolved_property<value_bool, keys::clip> clip;
+    resolved_property<value_double, keys::simplify_tolerance> simplify_tolerance;
+    resolved_property<value_double, keys::smooth> smooth;
+    transform_type geometry_transform;
+};
+
+// Per renderer cache of resolved properties keyed by symbolizer address. Symbolizers are
+// resolved on first use, the cache must be cleared whenever the styles may have changed.
+class MAPNIK_DECL resolved_symbolizer_cache : private util::noncopyable
+{
+  public:
+    line_symbolizer_properties const&
+      get(line_symbolizer const& sym, feature_impl const& feature, attributes const& vars);
+    polygon_symbolizer_properties const&
+      get(polygon_symbolizer const& sym, feature_impl const& feature, attributes const& vars);
+    void clear();
+    std::size_t size() const;
+
+  private:
+    std::unordered_map<symbolizer_base const*, line_symbolizer_properties> lines_;
+    std::unordered_map<symbolizer_base const*, polygon_symbolizer_properties> polygons_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_RESOLVED_SYMBOLIZER_HPP
@@ -25,6 +25,7 @@
 
 // mapnik
 #include <mapnik/rule.hpp>
+#include <mapnik/filter_program.hpp>
 #include <mapnik/util/noncopyable.hpp>
 
 // stl
@@ -37,16 +38,21 @@ class rule_cache : private util::noncopyable
 {
   public:
     using rule_ptrs = std::vector<rule const*>;
+    using filter_indices = std::vector<std::uint32_t>;
     rule_cache()
         : if_rules_(),
           else_rules_(),
-          also_rules_()
+          also_rules_(),
+          if_filters_(),
+          program_()
     {}
 
     rule_cache(rule_cache&& rhs) // move ctor
         : if_rules_(std::move(rhs.if_rules_)),
           else_rules_(std::move(rhs.else_rules_)),
-          also_rules_(std::move(rhs.also_rules_))
+          also_rules_(std::move(rhs.also_rules_)),
+          if_filters_(std::move(rhs.if_filters_)),
+          program_(std::move(rhs.program_))
     {}
 
     rule_cache& operator=(rule_cache&& rhs) // move assign
@@ -54,6 +60,8 @@ class rule_cache : private util::noncopyable
         std::swap(if_rules_, rhs.if_rules_);
         std::swap(else_rules_, rhs.else_rules_);
         std::swap(also_rules_, rhs.also_rules_);
+        std::swap(if_filters_, rhs.if_filters_);
+        std::swap(program_, rhs.program_);
         return *this;
     }
 
@@ -70,6 +78,7 @@ class rule_cache : private util::noncopyable
         else
         {
             if_rules_.push_back(&r);
+            if_filters_.push_back(program_.add(r.get_filter()));
         }
     }
 
@@ -79,10 +88,17 @@ class rule_cache : private util::noncopyable
 
     rule_ptrs const& get_also_rules() const { return also_rules_; }
 
+    // compiled filters of the `if` rules, in the same order
+    filter_indices const& get_if_filters() const { return if_filters_; }
+
+    filter_program const& get_filter_program() const { return program_; }
+
   private:
     rule_ptrs if_rules_;
     rule_ptrs else_rules_;
     rule_ptrs also_rules_;
+    filter_indices if_filters_;
+    filter_program program_;
 };
 
 } // namespace mapnik
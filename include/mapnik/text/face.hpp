@@ -39,6 +39,8 @@ extern "C" {
 
 MAPNIK_DISABLE_WARNING_POP
 
+struct hb_font_t;
+
 // stl
 #include <memory>
 #include <string>
@@ -49,12 +51,16 @@ namespace mapnik {
 class MAPNIK_DECL font_face : util::noncopyable
 {
   public:
-    font_face(FT_Face face);
+    font_face(FT_Face face, std::string const& file_name);
 
     std::string family_name() const { return std::string(face_->family_name); }
 
     std::string style_name() const { return std::string(face_->style_name); }
 
+    // Font file and face index, identifies the face across face managers
+    // which may map the same face name to different files.
+    std::string const& id() const { return id_; }
+
     FT_Face get_face() const { return face_; }
 
     bool set_character_sizes(double size);
@@ -62,6 +68,9 @@ class MAPNIK_DECL font_face : util::noncopyable
 
     bool glyph_dimensions(glyph_info& glyph) const;
 
+    // HarfBuzz font for shaping at the unscaled size, created on first use
+    hb_font_t* hb_font();
+
     inline bool is_color() const { return color_font_; }
 
     ~font_face();
@@ -70,7 +79,9 @@ class MAPNIK_DECL font_face : util::noncopyable
     bool init_color_font();
 
     FT_Face face_;
+    std::string const id_;
     bool const color_font_;
+    hb_font_t* hb_font_;
 };
 using face_ptr = std::shared_ptr<font_face>;
 
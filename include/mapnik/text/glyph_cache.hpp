@@ -0,0 +1,115 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_TEXT_GLYPH_CACHE_HPP
+#define MAPNIK_TEXT_GLYPH_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/warning.hpp>
+#include <mapnik/util/lru_cache.hpp>
+#include <mapnik/util/singleton.hpp>
+
+// stl
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mapnik {
+
+// 8 bit coverage bitmap of a rasterized glyph, positioned like FT_BitmapGlyph
+struct glyph_bitmap
+{
+    int left;
+    int top;
+    unsigned width;
+    unsigned rows;
+    std::vector<unsigned char> buffer;
+};
+
+using glyph_bitmap_ptr = std::shared_ptr<glyph_bitmap const>;
+
+struct glyph_cache_key
+{
+    std::string face; // font_face::id()
+    unsigned glyph_index;
+    std::int64_t size; // 26.6
+    std::int64_t xx;   // 16.16 transform
+    std::int64_t xy;
+    std::int64_t yx;
+    std::int64_t yy;
+    unsigned subpixel_x;
+    unsigned subpixel_y;
+    std::int64_t halo_radius; // 26.6 stroke radius, 0 for the plain glyph
+
+    bool operator==(glyph_cache_key const& rhs) const
+    {
+        return glyph_index == rhs.glyph_index && size == rhs.size && xx == rhs.xx && xy == rhs.xy && yx == rhs.yx &&
+               yy == rhs.yy && subpixel_x == rhs.subpixel_x && subpixel_y == rhs.subpixel_y &&
+               halo_radius == rhs.halo_radius && face == rhs.face;
+    }
+};
+
+struct glyph_cache_key_hash
+{
+    std::size_t operator()(glyph_cache_key const& key) const;
+};
+
+// bytes held by a cache entry
+struct glyph_cache_cost
+{
+    std::size_t operator()(glyph_cache_key const& key, glyph_bitmap const& bitmap) const;
+};
+
+using glyph_lru = util::lru_cache<glyph_cache_key, glyph_bitmap, glyph_cache_key_hash, glyph_cache_cost>;
+
+// Process wide LRU cache of rasterized glyphs shared by the agg and grid text
+// renderers of all threads, bounded by the number of stored bytes. Glyph
+// origins are snapped to 1/subpixel_steps of a pixel. Enabled per map with
+// the `glyph-cache` parameter.
+class MAPNIK_DECL glyph_cache : public glyph_lru,
+                                public singleton<glyph_cache, CreateUsingNew>
+{
+    friend class CreateUsingNew<glyph_cache>;
+
+  public:
+    static constexpr unsigned subpixel_steps = 4;
+    static constexpr std::size_t default_capacity = 16 * 1024 * 1024;
+
+    explicit glyph_cache(std::size_t capacity);
+
+  private:
+    glyph_cache();
+};
+
+MAPNIK_DISABLE_WARNING_PUSH
+MAPNIK_DISABLE_WARNING_ATTRIBUTES
+extern template class MAPNIK_DECL
+  util::lru_cache<glyph_cache_key, glyph_bitmap, glyph_cache_key_hash, glyph_cache_cost>;
+extern template class MAPNIK_DECL singleton<glyph_cache, CreateUsingNew>;
+MAPNIK_DISABLE_WARNING_POP
+
+} // namespace mapnik
+
+#endif // MAPNIK_TEXT_GLYPH_CACHE_HPP
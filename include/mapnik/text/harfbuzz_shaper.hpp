@@ -29,12 +29,17 @@
 #include <mapnik/text/face.hpp>
 #include <mapnik/text/font_feature_settings.hpp>
 #include <mapnik/text/itemizer.hpp>
+#include <mapnik/text/shaping_cache.hpp>
 #include <mapnik/safe_cast.hpp>
 #include <mapnik/font_engine_freetype.hpp>
 
 // stl
 #include <list>
+#include <memory>
+#include <optional>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -217,6 +222,29 @@ static hb_language_t script_to_language(hb_script_t script)
     }
 }
 
+// Cache key of the line [start, end) of `text`. Faces are identified by font file
+// and face index since face objects belong to a single face manager.
+inline shaping_cache_key make_shaping_key(value_unicode_string const& text,
+                                          unsigned start,
+                                          unsigned end,
+                                          std::vector<text_itemizer::format_run_t const*> const& runs,
+                                          std::vector<face_set_ptr> const& face_sets,
+                                          std::optional<std::string> const& lang)
+{
+    std::string formats = lang ? *lang : std::string();
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        formats += '|';
+        formats += std::to_string(runs[i]->start) + '-' + std::to_string(runs[i]->end);
+        for (auto const& face : *face_sets[i])
+        {
+            formats += ':' + face->id();
+        }
+        formats += '#' + runs[i]->data->ff_settings.to_string();
+    }
+    return shaping_cache_key{text, start, end, std::move(formats)};
+}
+
 } // namespace detail
 
 struct harfbuzz_shaper
@@ -234,22 +262,91 @@ struct harfbuzz_shaper
         if (!length)
             return;
 
-        std::list<text_item> const& list = itemizer.itemize(start, end);
+        // format runs of this line and their faces
+        std::vector<text_itemizer::format_run_t const*> runs;
+        std::vector<face_set_ptr> face_sets;
+        for (auto const& run : itemizer.format_runs())
+        {
+            if (run.start < end && run.end > start)
+            {
+                runs.push_back(&run);
+                face_sets.push_back(font_manager.get_face_set(run.data->face_name, run.data->fontset));
+            }
+        }
+
+        // repeated labels are itemized and shaped once
+        shaping_cache& cache = shaping_cache::instance();
+        shaping_cache_key key;
+        shaped_line_ptr shaped;
+        bool const use_cache = cache.capacity() > 0;
+        if (use_cache)
+        {
+            key = detail::make_shaping_key(itemizer.text(), start, end, runs, face_sets, lang);
+            shaped = cache.find(key);
+        }
+        if (!shaped)
+        {
+            shaped_line glyphs = shape(itemizer, start, end, runs, face_sets, lang);
+            shaped = use_cache ? cache.insert(key, std::move(glyphs))
+                               : std::make_shared<shaped_line const>(std::move(glyphs));
+        }
 
         line.reserve(length);
+        double max_glyph_height = 0;
+        for (auto const& shaped_glyph : *shaped)
+        {
+            evaluated_format_properties_ptr const& format = runs[shaped_glyph.run]->data;
+            double size = format->text_size * scale_factor;
+            glyph_info g(shaped_glyph.glyph_index, shaped_glyph.char_index, format);
+            g.face = *(face_sets[shaped_glyph.run]->begin() + shaped_glyph.face);
+            g.unscaled_ymin = shaped_glyph.unscaled_ymin;
+            g.unscaled_ymax = shaped_glyph.unscaled_ymax;
+            g.unscaled_advance = shaped_glyph.unscaled_advance;
+            g.unscaled_line_height = shaped_glyph.unscaled_line_height;
+            g.scale_multiplier = g.face->get_face()->units_per_EM > 0 ? (size / g.face->get_face()->units_per_EM)
+                                                                      : (size / 2048.0);
+            g.offset.set(shaped_glyph.x_offset * g.scale_multiplier, shaped_glyph.y_offset * g.scale_multiplier);
+            double tmp_height = g.height();
+            if (g.face->is_color())
+            {
+                tmp_height = g.ymax();
+            }
+            if (tmp_height > max_glyph_height)
+                max_glyph_height = tmp_height;
+            width_map[shaped_glyph.char_index] += g.advance();
+            line.add_glyph(std::move(g), scale_factor);
+        }
+        line.update_max_char_height(max_glyph_height);
+    }
 
-        auto hb_buffer_deleter = [](hb_buffer_t* buffer) {
-            hb_buffer_destroy(buffer);
+  private:
+    static shaped_line shape(text_itemizer& itemizer,
+                             unsigned start,
+                             unsigned end,
+                             std::vector<text_itemizer::format_run_t const*> const& runs,
+                             std::vector<face_set_ptr> const& face_sets,
+                             std::optional<std::string> const& lang)
+    {
+        shaped_line result;
+        std::list<text_item> const& list = itemizer.itemize(start, end);
+
+        struct hb_buffer_deleter
+        {
+            void operator()(hb_buffer_t* buffer) const { hb_buffer_destroy(buffer); }
         };
-        std::unique_ptr<hb_buffer_t, decltype(hb_buffer_deleter)> const buffer(hb_buffer_create(), hb_buffer_deleter);
-        hb_buffer_pre_allocate(buffer.get(), safe_cast<int>(length));
+        thread_local std::unique_ptr<hb_buffer_t, hb_buffer_deleter> const buffer(hb_buffer_create());
+        hb_buffer_pre_allocate(buffer.get(), safe_cast<int>(end - start));
         mapnik::value_unicode_string const& text = itemizer.text();
         for (auto const& text_item : list)
         {
-            face_set_ptr face_set = font_manager.get_face_set(text_item.format_->face_name, text_item.format_->fontset);
-            double size = text_item.format_->text_size * scale_factor;
-            face_set->set_unscaled_character_sizes();
-            std::size_t num_faces = face_set->size();
+            unsigned run = 0;
+            while (run + 1 < runs.size() && runs[run]->end <= text_item.start)
+            {
+                ++run;
+            }
+            font_face_set& face_set = *face_sets[run];
+            face_set.set_unscaled_character_sizes();
+            std::size_t num_faces = face_set.size();
 
             font_feature_settings const& ff_settings = text_item.format_->ff_settings;
             int ff_count = safe_cast<int>(ff_settings.count());
@@ -257,7 +354,7 @@ struct harfbuzz_shaper
             // rendering information for a single glyph
             struct glyph_face_info
             {
-                face_ptr face;
+                unsigned face;
                 hb_glyph_info_t glyph;
                 hb_glyph_position_t position;
             };
@@ -268,8 +365,9 @@ struct harfbuzz_shaper
             std::vector<std::vector<glyph_face_info>> glyphinfos;
 
             glyphinfos.resize(text.length());
-            for (auto const& face : *face_set)
+            for (auto const& face : face_set)
             {
+                unsigned face_index = static_cast<unsigned>(pos);
                 ++pos;
                 hb_buffer_clear_contents(buffer.get());
                 hb_buffer_add_utf16(buffer.get(),
@@ -280,7 +378,6 @@ struct harfbuzz_shaper
                 hb_buffer_set_direction(buffer.get(),
                                         (text_item.dir == UBIDI_RTL) ? HB_DIRECTION_RTL : HB_DIRECTION_LTR);
 
-                hb_font_t* font(hb_ft_font_create(face->get_face(), nullptr));
                 auto script = detail::_icu_script_to_script(text_item.script);
                 hb_language_t hb_lang;
                 if (lang)
@@ -302,14 +399,7 @@ struct harfbuzz_shaper
                 }
                 hb_buffer_set_script(buffer.get(), script);
 
-                // https://github.com/mapnik/test-data-visual/pull/25
-#if HB_VERSION_MAJOR > 0
-#if HB_VERSION_ATLEAST(1, 0, 5)
-                hb_ft_font_set_load_flags(font, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING);
-#endif
-#endif
-                hb_shape(font, buffer.get(), ff_settings.get_features(), ff_count);
-                hb_font_destroy(font);
+                hb_shape(face->hb_font(), buffer.get(), ff_settings.get_features(), ff_count);
 
                 unsigned num_glyphs = hb_buffer_get_length(buffer.get());
                 hb_glyph_info_t* glyphs = hb_buffer_get_glyph_infos(buffer.get(), &num_glyphs);
@@ -342,7 +432,7 @@ struct harfbuzz_shaper
                     {
                         glyphinfos.resize(cluster + 1);
                     }
-                    current_clusters[cluster].push_back({face, glyphs[i], positions[i]});
+                    current_clusters[cluster].push_back({face_index, glyphs[i], positions[i]});
                 }
                 for (unsigned cluster_id = 0; cluster_id < current_clusters.size(); ++cluster_id)
                 {
@@ -383,7 +473,6 @@ struct harfbuzz_shaper
                     // Try next font in fontset
                     continue;
                 }
-                double max_glyph_height = 0;
                 for (auto const& c_id : clusters)
                 {
                     auto const& c = glyphinfos[c_id];
@@ -392,35 +481,28 @@ struct harfbuzz_shaper
                         auto const& gpos = info.position;
                         auto const& glyph = info.glyph;
                         unsigned char_index = glyph.cluster;
+                        unsigned glyph_face = info.glyph.codepoint != 0 ? info.face : face_index;
                         glyph_info g(glyph.codepoint, char_index, text_item.format_);
-                        if (info.glyph.codepoint != 0)
-                            g.face = info.face;
-                        else
-                            g.face = face;
-                        if (g.face->glyph_dimensions(g))
+                        if ((*(face_set.begin() + glyph_face))->glyph_dimensions(g))
                         {
-                            g.scale_multiplier = g.face->get_face()->units_per_EM > 0
-                                                   ? (size / g.face->get_face()->units_per_EM)
-                                                   : (size / 2048.0);
-                            // Overwrite default advance with better value provided by HarfBuzz
-                            g.unscaled_advance = gpos.x_advance;
-                            g.offset.set(gpos.x_offset * g.scale_multiplier, gpos.y_offset * g.scale_multiplier);
-                            double tmp_height = g.height();
-                            if (g.face->is_color())
-                            {
-                                tmp_height = g.ymax();
-                            }
-                            if (tmp_height > max_glyph_height)
-                                max_glyph_height = tmp_height;
-                            width_map[char_index] += g.advance();
-                            line.add_glyph(std::move(g), scale_factor);
+                            // advance and offsets provided by HarfBuzz
+                            result.push_back({glyph.codepoint,
+                                              char_index,
+                                              run,
+                                              glyph_face,
+                                              g.unscaled_ymin,
+                                              g.unscaled_ymax,
+                                              static_cast<double>(gpos.x_advance),
+                                              g.unscaled_line_height,
+                                              static_cast<double>(gpos.x_offset),
+                                              static_cast<double>(gpos.y_offset)});
                         }
                     }
                 }
-                line.update_max_char_height(max_glyph_height);
                 break; // When we reach this point the current font had all glyphs.
             }
         }
+        return result;
     }
 };
 } // namespace mapnik
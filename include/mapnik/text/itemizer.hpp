@@ -75,17 +75,6 @@ struct MAPNIK_DECL text_item : util::noncopyable
 class MAPNIK_DECL text_itemizer : util::noncopyable
 {
   public:
-    text_itemizer();
-    void add_text(value_unicode_string const& str, evaluated_format_properties_ptr const& format);
-    std::list<text_item> const& itemize(unsigned start = 0, unsigned end = 0);
-    void clear();
-    value_unicode_string const& text() const { return text_; }
-    // Returns the start and end position of a certain line.
-    // Only forced line breaks with \n characters are handled here.
-    std::pair<unsigned, unsigned> line(unsigned i) const;
-    unsigned num_lines() const;
-
-  private:
     template<typename T>
     struct run : util::noncopyable
     {
@@ -99,9 +88,23 @@ class MAPNIK_DECL text_itemizer : util::noncopyable
         T data;
     };
     using format_run_t = run<evaluated_format_properties_ptr const&>;
+    using format_run_list = std::list<format_run_t>;
+
+    text_itemizer();
+    void add_text(value_unicode_string const& str, evaluated_format_properties_ptr const& format);
+    std::list<text_item> const& itemize(unsigned start = 0, unsigned end = 0);
+    void clear();
+    value_unicode_string const& text() const { return text_; }
+    // Returns the start and end position of a certain line.
+    // Only forced line breaks with \n characters are handled here.
+    std::pair<unsigned, unsigned> line(unsigned i) const;
+    unsigned num_lines() const;
+    // Format runs added by add_text(), sorted by char index
+    format_run_list const& format_runs() const { return format_runs_; }
+
+  private:
     using direction_run_t = run<UBiDiDirection>;
     using script_run_t = run<UScriptCode>;
-    using format_run_list = std::list<format_run_t>;
     using script_run_list = std::list<script_run_t>;
     using direction_run_list = std::list<direction_run_t>;
     value_unicode_string text_;
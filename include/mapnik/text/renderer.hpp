@@ -30,6 +30,7 @@
 #include <mapnik/util/noncopyable.hpp>
 #include <mapnik/pixel_position.hpp>
 #include <mapnik/text/color_font_renderer.hpp>
+#include <mapnik/text/glyph_cache.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -61,6 +62,10 @@ struct glyph_t
     rotation rot;
     double size;
     box2d<double> bbox;
+    // set instead of `image` when the bitmap is looked up in the glyph cache
+    glyph_info const* info = nullptr;
+    FT_Matrix matrix{};
+    FT_Vector pen{};
     glyph_t(FT_Glyph image_,
             detail::evaluated_format_properties const& properties_,
             pixel_position const& pos_,
@@ -95,12 +100,22 @@ class text_renderer : private util::noncopyable
 
     void set_stroker(stroker_ptr stroker) { stroker_ = stroker; }
 
+    void set_glyph_cache(glyph_cache* cache) { glyph_cache_ = cache; }
+
     void set_transform(agg::trans_affine const& transform);
     void set_halo_transform(agg::trans_affine const& halo_transform);
 
   protected:
     using glyph_vector = std::vector<glyph_t>;
     void prepare_glyphs(glyph_positions const& positions);
+    // Bitmap of a cached glyph transformed by `matrix` and moved to `start`, stroked
+    // when `halo_radius` > 0. Returns nullptr if the glyph couldn't be rasterized.
+    glyph_bitmap_ptr cached_bitmap(glyph_t const& glyph,
+                                   FT_Matrix const& matrix,
+                                   FT_Vector const& start,
+                                   double halo_radius,
+                                   int& left,
+                                   int& top);
     halo_rasterizer_e rasterizer_;
     composite_mode_e comp_op_;
     composite_mode_e halo_comp_op_;
@@ -109,6 +124,7 @@ class text_renderer : private util::noncopyable
     stroker_ptr stroker_;
     agg::trans_affine transform_;
     agg::trans_affine halo_transform_;
+    glyph_cache* glyph_cache_;
 };
 
 template<typename T>
@@ -128,7 +144,7 @@ class agg_text_renderer : public text_renderer
     pixmap_type& pixmap_;
 
     template<std::size_t PixelWidth>
-    void render_halo(unsigned char* buffer,
+    void render_halo(unsigned char const* buffer,
                      unsigned width,
                      unsigned height,
                      unsigned rgba,
@@ -151,7 +167,7 @@ class grid_text_renderer : public text_renderer
     pixmap_type& pixmap_;
 
     template<std::size_t PixelWidth>
-    void render_halo_id(unsigned char* buffer,
+    void render_halo_id(unsigned char const* buffer,
                         unsigned width,
                         unsigned height,
                         mapnik::value_integer feature_id,
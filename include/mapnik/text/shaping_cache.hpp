@@ -0,0 +1,116 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_TEXT_SHAPING_CACHE_HPP
+#define MAPNIK_TEXT_SHAPING_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/warning.hpp>
+#include <mapnik/value/types.hpp>
+#include <mapnik/util/lru_cache.hpp>
+#include <mapnik/util/singleton.hpp>
+
+// stl
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <unicode/unistr.h>
+MAPNIK_DISABLE_WARNING_POP
+
+namespace mapnik {
+
+// Glyph of a shaped line in font units. Faces are referred to by position so
+// the result can be reused with the faces of any face manager.
+struct shaped_glyph
+{
+    unsigned glyph_index;
+    unsigned char_index;
+    unsigned run;  // format run of the line
+    unsigned face; // face in the face set of the format run
+    double unscaled_ymin;
+    double unscaled_ymax;
+    double unscaled_advance;
+    double unscaled_line_height;
+    double x_offset;
+    double y_offset;
+};
+
+using shaped_line = std::vector<shaped_glyph>;
+using shaped_line_ptr = std::shared_ptr<shaped_line const>;
+
+struct shaping_cache_key
+{
+    value_unicode_string text;
+    unsigned start;
+    unsigned end;
+    std::string formats; // language, format runs with their faces and font features
+
+    bool operator==(shaping_cache_key const& rhs) const
+    {
+        return start == rhs.start && end == rhs.end && formats == rhs.formats && text == rhs.text;
+    }
+};
+
+struct shaping_cache_key_hash
+{
+    std::size_t operator()(shaping_cache_key const& key) const;
+};
+
+struct shaping_cache_cost
+{
+    std::size_t operator()(shaping_cache_key const&, shaped_line const&) const { return 1; }
+};
+
+using shaping_lru = util::lru_cache<shaping_cache_key, shaped_line, shaping_cache_key_hash, shaping_cache_cost>;
+
+// Process wide LRU cache of shaped text lines, bounded by the number of lines.
+// Shaping happens at the unscaled font size, so lines are shared between text
+// sizes and scale factors. A capacity of 0 disables the cache.
+class MAPNIK_DECL shaping_cache : public shaping_lru,
+                                  public singleton<shaping_cache, CreateUsingNew>
+{
+    friend class CreateUsingNew<shaping_cache>;
+
+  public:
+    static constexpr std::size_t default_capacity = 8192;
+
+    explicit shaping_cache(std::size_t capacity);
+
+  private:
+    shaping_cache();
+};
+
+MAPNIK_DISABLE_WARNING_PUSH
+MAPNIK_DISABLE_WARNING_ATTRIBUTES
+extern template class MAPNIK_DECL
+  util::lru_cache<shaping_cache_key, shaped_line, shaping_cache_key_hash, shaping_cache_cost>;
+extern template class MAPNIK_DECL singleton<shaping_cache, CreateUsingNew>;
+MAPNIK_DISABLE_WARNING_POP
+
+} // namespace mapnik
+
+#endif // MAPNIK_TEXT_SHAPING_CACHE_HPP
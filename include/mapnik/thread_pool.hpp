@@ -0,0 +1,169 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_THREAD_POOL_HPP
+#define MAPNIK_THREAD_POOL_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/warning.hpp>
+#include <mapnik/util/singleton.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#ifdef MAPNIK_THREADSAFE
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace mapnik {
+
+// Fixed size pool of worker threads shared by the renderers. Without
+// MAPNIK_THREADSAFE tasks are executed immediately on the calling thread.
+class MAPNIK_DECL thread_pool : public singleton<thread_pool, CreateUsingNew>,
+                                private util::noncopyable
+{
+    friend class CreateUsingNew<thread_pool>;
+
+  public:
+    explicit thread_pool(std::size_t num_threads);
+    ~thread_pool();
+
+    std::size_t size() const;
+
+    template<typename F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& f)
+    {
+        using result_type = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(f));
+        std::future<result_type> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    // Execute one queued task on the calling thread, returns false if the queue was empty.
+    bool run_pending_task();
+
+    // Block until `f` is ready. Queued tasks are executed while waiting, so it is
+    // safe to wait from inside a task running on this pool.
+    template<typename T>
+    T get(std::future<T>& f)
+    {
+        wait(f);
+        return f.get();
+    }
+
+    template<typename Future>
+    void wait(Future const& f)
+    {
+        while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            if (!run_pending_task())
+            {
+                f.wait_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    // Split [0, count) into contiguous ranges of at least `grain` elements, one per
+    // worker plus one for the calling thread, and call f(begin, end) for each range.
+    // Returns once every range is done, the first exception thrown is rethrown.
+    template<typename F>
+    void parallel_for(std::size_t count, std::size_t grain, F const& f)
+    {
+        std::size_t ranges = std::min(size() + 1, count / std::max(grain, std::size_t(1)));
+        if (ranges <= 1)
+        {
+            if (count > 0)
+                f(std::size_t(0), count);
+            return;
+        }
+        std::size_t const step = count / ranges;
+        std::size_t const remainder = count % ranges;
+        std::vector<std::future<void>> futures;
+        futures.reserve(ranges - 1);
+        std::size_t begin = step + (remainder > 0 ? 1 : 0);
+        std::size_t const first_end = begin;
+        for (std::size_t i = 1; i < ranges; ++i)
+        {
+            std::size_t end = begin + step + (i < remainder ? 1 : 0);
+            futures.push_back(submit([&f, begin, end]() { f(begin, end); }));
+            begin = end;
+        }
+        std::exception_ptr error;
+        try
+        {
+            f(std::size_t(0), first_end);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        for (auto& future : futures)
+        {
+            wait(future);
+            try
+            {
+                future.get();
+            }
+            catch (...)
+            {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+  private:
+    thread_pool();
+    void enqueue(std::function<void()>&& task);
+    void work();
+    std::deque<std::function<void()>> tasks_;
+#ifdef MAPNIK_THREADSAFE
+    std::vector<std::thread> workers_;
+    std::mutex queue_mutex_;
+    std::condition_variable cond_;
+#endif
+    bool stop_;
+};
+
+MAPNIK_DISABLE_WARNING_PUSH
+MAPNIK_DISABLE_WARNING_ATTRIBUTES
+extern template class MAPNIK_DECL singleton<thread_pool, CreateUsingNew>;
+MAPNIK_DISABLE_WARNING_POP
+
+} // namespace mapnik
+
+#endif // MAPNIK_THREAD_POOL_HPP
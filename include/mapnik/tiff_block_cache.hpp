@@ -0,0 +1,99 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_TIFF_BLOCK_CACHE_HPP
+#define MAPNIK_TIFF_BLOCK_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/warning.hpp>
+#include <mapnik/util/lru_cache.hpp>
+#include <mapnik/util/fs.hpp>
+#include <mapnik/util/singleton.hpp>
+
+// stl
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mapnik {
+
+// Decoded pixels of one TIFF tile or strip
+using tiff_block = std::vector<std::uint8_t>;
+using tiff_block_ptr = std::shared_ptr<tiff_block const>;
+
+struct tiff_block_key
+{
+    std::string filename;
+    util::file_stamp stamp; // blocks of an older version of the file are never found
+    unsigned directory;     // IFD
+    unsigned block;         // tile or strip index
+    bool rgba;              // expanded to rgba8 rather than decoded as stored
+
+    bool operator==(tiff_block_key const& rhs) const
+    {
+        return block == rhs.block && directory == rhs.directory && rgba == rhs.rgba && stamp == rhs.stamp &&
+               filename == rhs.filename;
+    }
+};
+
+struct tiff_block_key_hash
+{
+    std::size_t operator()(tiff_block_key const& key) const;
+};
+
+struct tiff_block_cost
+{
+    std::size_t operator()(tiff_block_key const&, tiff_block const& block) const { return block.size(); }
+};
+
+using tiff_block_lru = util::lru_cache<tiff_block_key, tiff_block, tiff_block_key_hash, tiff_block_cost>;
+
+// Process wide LRU cache of decoded TIFF blocks, bounded by their size in bytes.
+// Neighbouring metatiles read overlapping regions of the same raster, blocks
+// are decompressed once and shared between readers. A capacity of 0 disables
+// the cache.
+class MAPNIK_DECL tiff_block_cache : public tiff_block_lru,
+                                     public singleton<tiff_block_cache, CreateUsingNew>
+{
+    friend class CreateUsingNew<tiff_block_cache>;
+
+  public:
+    static constexpr std::size_t default_capacity = 64 << 20;
+
+    explicit tiff_block_cache(std::size_t capacity);
+
+  private:
+    tiff_block_cache();
+};
+
+MAPNIK_DISABLE_WARNING_PUSH
+MAPNIK_DISABLE_WARNING_ATTRIBUTES
+extern template class MAPNIK_DECL util::lru_cache<tiff_block_key, tiff_block, tiff_block_key_hash, tiff_block_cost>;
+extern template class MAPNIK_DECL singleton<tiff_block_cache, CreateUsingNew>;
+MAPNIK_DISABLE_WARNING_POP
+
+} // namespace mapnik
+
+#endif // MAPNIK_TIFF_BLOCK_CACHE_HPP
@@ -27,6 +27,8 @@
 #include <mapnik/config.hpp>
 
 // stl
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -44,6 +46,18 @@ MAPNIK_DECL std::string dirname(std::string const& value);
 MAPNIK_DECL std::string basename(std::string const& value);
 MAPNIK_DECL std::vector<std::string> list_directory(std::string const& value);
 
+// Last modification time and size of a file, tells versions of a file apart
+struct file_stamp
+{
+    std::int64_t mtime;
+    std::uintmax_t size;
+
+    bool operator==(file_stamp const& rhs) const { return mtime == rhs.mtime && size == rhs.size; }
+};
+
+// empty if the file can't be stat'ed
+MAPNIK_DECL std::optional<file_stamp> stamp(std::string const& value);
+
 } // namespace util
 } // namespace mapnik
 
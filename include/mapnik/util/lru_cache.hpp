@@ -0,0 +1,185 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_UTIL_LRU_CACHE_HPP
+#define MAPNIK_UTIL_LRU_CACHE_HPP
+
+// mapnik
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#endif
+
+namespace mapnik {
+namespace util {
+
+// Least recently used cache of immutable shared values, bounded by the sum of
+// Cost()(key, value) over its entries. Values are handed out as shared
+// pointers so evicted entries stay valid for their current users. A value
+// costing more than the capacity is returned without being stored, a capacity
+// of 0 disables the cache.
+template<typename Key, typename Value, typename Hash, typename Cost>
+class lru_cache : private noncopyable
+{
+  public:
+    using key_type = Key;
+    using value_type = Value;
+    using value_ptr = std::shared_ptr<Value const>;
+
+    explicit lru_cache(std::size_t capacity)
+        : capacity_(capacity),
+          cost_(0),
+          hits_(0),
+          misses_(0),
+          evictions_(0)
+    {}
+
+    value_ptr find(Key const& key)
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+        auto itr = index_.find(key);
+        if (itr == index_.end())
+        {
+            ++misses_;
+            return value_ptr();
+        }
+        entries_.splice(entries_.begin(), entries_, itr->second);
+        ++hits_;
+        return itr->second->second;
+    }
+
+    // Insert `value` unless `key` is already cached, returns the cached value.
+    value_ptr insert(Key const& key, Value&& value)
+    {
+        std::size_t const cost = Cost()(key, value);
+        auto result = std::make_shared<Value const>(std::move(value));
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+        auto itr = index_.find(key);
+        if (itr != index_.end())
+        {
+            // created concurrently by another thread
+            entries_.splice(entries_.begin(), entries_, itr->second);
+            return itr->second->second;
+        }
+        if (capacity_ == 0 || cost > capacity_)
+        {
+            return result;
+        }
+        entries_.emplace_front(key, result);
+        index_.emplace(key, entries_.begin());
+        cost_ += cost;
+        shrink();
+        return result;
+    }
+
+    void set_capacity(std::size_t capacity)
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+        capacity_ = capacity;
+        shrink();
+    }
+
+    void clear()
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+        index_.clear();
+        entries_.clear();
+        cost_ = 0;
+    }
+
+    std::size_t capacity() const
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+        return capacity_;
+    }
+
+    // Total cost of the cached values
+    std::size_t cost() const
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+        return cost_;
+    }
+
+    // Number of cached values
+    std::size_t size() const
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+        return entries_.size();
+    }
+
+    std::size_t hits() const { return hits_.load(); }
+    std::size_t misses() const { return misses_.load(); }
+    std::size_t evictions() const { return evictions_.load(); }
+
+  private:
+    using list_type = std::list<std::pair<Key, value_ptr>>;
+
+    void shrink()
+    {
+        while (cost_ > capacity_ && !entries_.empty())
+        {
+            auto const& last = entries_.back();
+            cost_ -= Cost()(last.first, *last.second);
+            index_.erase(last.first);
+            entries_.pop_back();
+            ++evictions_;
+        }
+    }
+
+#ifdef MAPNIK_THREADSAFE
+    mutable std::mutex cache_mutex_;
+#endif
+    std::size_t capacity_;
+    std::size_t cost_;
+    list_type entries_; // most recently used first
+    std::unordered_map<Key, typename list_type::iterator, Hash> index_;
+    std::atomic<std::size_t> hits_;
+    std::atomic<std::size_t> misses_;
+    std::atomic<std::size_t> evictions_;
+};
+
+} // namespace util
+} // namespace mapnik
+
+#endif // MAPNIK_UTIL_LRU_CACHE_HPP
@@ -29,8 +29,14 @@
 #include <mapnik/query.hpp>
 #include <mapnik/geom_util.hpp>
 // stl
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <type_traits>
+#include <algorithm>
 #include <cstring>
+#include <limits>
+#include <vector>
 
 using mapnik::box2d;
 using mapnik::query;
@@ -45,6 +51,13 @@ struct index_record
     box2d<float> box;
 };
 
+// Read-only view of a complete index held in memory (e.g. a memory mapped .index file)
+struct index_buffer
+{
+    char const* data;
+    std::size_t size;
+};
+
 template<typename InputStream>
 bool check_spatial_index(InputStream& in)
 {
@@ -54,6 +67,11 @@ bool check_spatial_index(InputStream& in)
     return (std::strncmp(header, "mapnik-index", 12) == 0);
 }
 
+inline bool check_spatial_index(index_buffer const& in)
+{
+    return in.size >= 16 && std::strncmp(in.data, "mapnik-index", 12) == 0;
+}
+
 template<typename Value, typename Filter, typename InputStream, typename BBox = box2d<double>>
 class spatial_index
 {
@@ -189,6 +207,82 @@ void spatial_index<Value, Filter, InputStream, BBox>::read_envelope(InputStream&
     in.read(reinterpret_cast<char*>(&envelope), sizeof(envelope));
 }
 
+// Traverses the index in place without copying it or seeking a stream. Nodes are stored
+// in pre-order with the children immediately following their parent's items, so
+// a single forward scan visits the tree: rejected nodes skip their whole subtree,
+// accepted ones fall through to their first child.
+template<typename Value, typename Filter, typename BBox>
+class spatial_index<Value, Filter, index_buffer, BBox>
+{
+    using bbox_type = BBox;
+
+  public:
+    static void query(Filter const& filter, index_buffer const& in, std::vector<Value>& pos)
+    {
+        query_impl(filter, in, pos, std::numeric_limits<std::size_t>::max());
+    }
+
+    static bbox_type bounding_box(index_buffer const& in)
+    {
+        static_assert(std::is_standard_layout<Value>::value,
+                      "Values stored in quad-tree must be standard layout type");
+        if (!check_spatial_index(in) || in.size < 16 + 4 + sizeof(bbox_type))
+            throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+        bbox_type box;
+        std::memcpy(&box, in.data + 16 + 4, sizeof(bbox_type));
+        return box;
+    }
+
+    static void query_first_n(Filter const& filter, index_buffer const& in, std::vector<Value>& pos, std::size_t count)
+    {
+        query_impl(filter, in, pos, count);
+    }
+
+  private:
+    spatial_index();
+
+    static std::uint32_t read_ndr_integer(char const* b)
+    {
+        return (b[0] & 0xff) | (b[1] & 0xff) << 8 | (b[2] & 0xff) << 16 | static_cast<std::uint32_t>(b[3] & 0xff) << 24;
+    }
+
+    static void query_impl(Filter const& filter, index_buffer const& in, std::vector<Value>& results, std::size_t count)
+    {
+        static_assert(std::is_standard_layout<Value>::value,
+                      "Values stored in quad-tree must be standard layout type");
+        if (!check_spatial_index(in))
+            throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+        constexpr std::size_t header_size = 4 + sizeof(bbox_type) + 4;
+        std::size_t pos = 16;
+        std::size_t const end = in.size;
+        while (pos < end && results.size() < count)
+        {
+            if (end - pos < header_size)
+                throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+            char const* node = in.data + pos;
+            std::size_t offset = read_ndr_integer(node);
+            bbox_type node_ext;
+            std::memcpy(&node_ext, node + 4, sizeof(bbox_type));
+            std::size_t num_shapes = read_ndr_integer(node + 4 + sizeof(bbox_type));
+            std::size_t items_size = num_shapes * sizeof(Value);
+            if (end - pos - header_size < items_size + 4)
+                throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+            pos += header_size;
+            if (!filter.pass(node_ext))
+            {
+                // skip items, number of children and the subtree
+                pos += items_size + 4 + offset;
+                continue;
+            }
+            std::size_t num = std::min(num_shapes, count - results.size());
+            std::size_t first = results.size();
+            results.resize(first + num);
+            std::memcpy(static_cast<void*>(results.data() + first), in.data + pos, num * sizeof(Value));
+            pos += items_size + 4;
+        }
+    }
+};
+
 } // namespace util
 } // namespace mapnik
 
@@ -28,6 +28,10 @@
 #include <mapnik/config.hpp>
 #include <mapnik/geometry/box2d.hpp>
 
+// stl
+#include <cstddef>
+#include <optional>
+
 namespace mapnik {
 
 class raster;
@@ -50,6 +54,8 @@ MAPNIK_DECL void reproject_and_scale_raster(raster& target,
                                             unsigned mesh_size,
                                             scaling_method_e scaling_method);
 
+// Target rows are rendered in parallel bands of at least `band_rows` rows,
+// a target lower than two bands is rendered on the calling thread.
 template<typename T>
 MAPNIK_DECL void warp_image(T& target,
                             T const& source,
@@ -61,7 +67,8 @@ MAPNIK_DECL void warp_image(T& target,
                             unsigned mesh_size,
                             scaling_method_e scaling_method,
                             double filter_factor,
-                            std::optional<double> const& nodata_value);
+                            std::optional<double> const& nodata_value,
+                            std::size_t band_rows = 64);
 } // namespace mapnik
 
 #endif // MAPNIK_WARP_HPP
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_WARP_MESH_CACHE_HPP
+#define MAPNIK_WARP_MESH_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/warning.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/util/lru_cache.hpp>
+#include <mapnik/util/singleton.hpp>
+
+// stl
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace mapnik {
+
+// Source pixel grid of warp_image() reprojected into the target projection,
+// mesh point (i, j) is at (xs(i, j), ys(i, j)).
+struct warp_mesh
+{
+    warp_mesh(std::size_t nx, std::size_t ny)
+        : xs(nx, ny, false),
+          ys(nx, ny, false)
+    {}
+
+    std::size_t size() const { return xs.width() * xs.height(); }
+
+    image_gray64f xs;
+    image_gray64f ys;
+};
+
+using warp_mesh_ptr = std::shared_ptr<warp_mesh const>;
+
+struct warp_mesh_key
+{
+    std::string source_crs; // proj_transform::source_params()
+    std::string dest_crs;   // proj_transform::dest_params()
+    box2d<double> source_ext;
+    std::size_t width;
+    std::size_t height;
+    unsigned mesh_size;
+
+    bool operator==(warp_mesh_key const& rhs) const
+    {
+        return width == rhs.width && height == rhs.height && mesh_size == rhs.mesh_size &&
+               source_ext == rhs.source_ext && source_crs == rhs.source_crs && dest_crs == rhs.dest_crs;
+    }
+};
+
+struct warp_mesh_key_hash
+{
+    std::size_t operator()(warp_mesh_key const& key) const;
+};
+
+struct warp_mesh_cost
+{
+    std::size_t operator()(warp_mesh_key const&, warp_mesh const& mesh) const { return mesh.size(); }
+};
+
+using warp_mesh_lru = util::lru_cache<warp_mesh_key, warp_mesh, warp_mesh_key_hash, warp_mesh_cost>;
+
+// Process wide LRU cache of reprojected meshes, bounded by the total number of
+// mesh points. Tiles of a raster pyramid are warped into every target tile they
+// overlap, the mesh only depends on the source tile so it is projected once.
+// A capacity of 0 disables the cache.
+class MAPNIK_DECL warp_mesh_cache : public warp_mesh_lru,
+                                    public singleton<warp_mesh_cache, CreateUsingNew>
+{
+    friend class CreateUsingNew<warp_mesh_cache>;
+
+  public:
+    static constexpr std::size_t default_capacity = 1 << 20;
+
+    explicit warp_mesh_cache(std::size_t capacity);
+
+  private:
+    warp_mesh_cache();
+};
+
+MAPNIK_DISABLE_WARNING_PUSH
+MAPNIK_DISABLE_WARNING_ATTRIBUTES
+extern template class MAPNIK_DECL util::lru_cache<warp_mesh_key, warp_mesh, warp_mesh_key_hash, warp_mesh_cost>;
+extern template class MAPNIK_DECL singleton<warp_mesh_cache, CreateUsingNew>;
+MAPNIK_DISABLE_WARNING_POP
+
+} // namespace mapnik
+
+#endif // MAPNIK_WARP_MESH_CACHE_HPP
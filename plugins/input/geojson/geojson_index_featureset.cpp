@@ -62,11 +62,22 @@ geojson_index_featureset::geojson_index_featureset(std::string const& filename,
         throw std::runtime_error("Can't open " + filename);
 #endif
     std::string indexname = filename + ".index";
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+    auto const index = mapnik::mapped_memory_cache::instance().find(indexname, true);
+    if (!index)
+        throw mapnik::datasource_exception("GeoJSON Plugin: can't open index file " + indexname);
+    mapnik::util::index_buffer buffer{static_cast<char const*>((*index)->get_address()), (*index)->get_size()};
+    mapnik::util::spatial_index<value_type,
+                                mapnik::bounding_box_filter<float>,
+                                mapnik::util::index_buffer,
+                                mapnik::box2d<float>>::query(filter, buffer, positions_);
+#else
     std::ifstream index(indexname.c_str(), std::ios::binary);
     if (!index)
         throw mapnik::datasource_exception("GeoJSON Plugin: can't open index file " + indexname);
     mapnik::util::spatial_index<value_type, mapnik::bounding_box_filter<float>, std::ifstream, mapnik::box2d<float>>::
       query(filter, index, positions_);
+#endif
 
     positions_.erase(std::remove_if(positions_.begin(),
                                     positions_.end(),
@@ -28,6 +28,7 @@
 #include <mapnik/view_transform.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_reader.hpp>
+#include <mapnik/image_reader_pool.hpp>
 #include <mapnik/boolean.hpp>
 
 #include "raster_featureset.hpp"
@@ -133,7 +134,7 @@ raster_datasource::raster_datasource(parameters const& params)
 
         try
         {
-            std::unique_ptr<image_reader> reader(mapnik::get_image_reader(filename_, format_));
+            auto reader = mapnik::image_reader_pool::instance().borrow(filename_, format_);
             if (reader.get())
             {
                 width_ = reader->width();
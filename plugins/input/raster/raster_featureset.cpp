@@ -26,6 +26,7 @@
 #include <mapnik/raster.hpp>
 #include <mapnik/view_transform.hpp>
 #include <mapnik/image_reader.hpp>
+#include <mapnik/image_reader_pool.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/feature_factory.hpp>
 #include <mapnik/util/variant.hpp>
@@ -57,7 +58,8 @@ raster_featureset<LookupPolicy>::raster_featureset(LookupPolicy const& policy,
       bbox_(q.get_bbox()),
       curIter_(policy_.begin()),
       endIter_(policy_.end()),
-      filter_factor_(q.get_filter_factor())
+      filter_factor_(q.get_filter_factor()),
+      resolution_(q.resolution())
 {}
 
 template<typename LookupPolicy>
@@ -73,13 +75,17 @@ feature_ptr raster_featureset<LookupPolicy>::next()
 
         try
         {
-            std::unique_ptr<image_reader> reader(mapnik::get_image_reader(curIter_->file(), curIter_->format()));
+            auto reader = mapnik::image_reader_pool::instance().borrow(curIter_->file(), curIter_->format());
 
             MAPNIK_LOG_DEBUG(raster) << "raster_featureset: Reader=" << curIter_->format() << "," << curIter_->file()
                                      << ",size(" << curIter_->width() << "," << curIter_->height() << ")";
 
             if (reader.get())
             {
+                if (policy_.use_overviews())
+                {
+                    select_overview(*reader);
+                }
                 int image_width = policy_.img_width(reader->width());
                 int image_height = policy_.img_height(reader->height());
 
@@ -150,6 +156,39 @@ feature_ptr raster_featureset<LookupPolicy>::next()
     return feature_ptr();
 }
 
+// Read from the smallest overview which still has the resolution of the query,
+// same as gdal_featureset::find_best_overview
+template<typename LookupPolicy>
+void raster_featureset<LookupPolicy>::select_overview(image_reader& reader) const
+{
+    auto const overviews = reader.overviews();
+    if (overviews.empty())
+        return;
+    double const ideal_width = extent_.width() * std::get<0>(resolution_) * filter_factor_;
+    double const ideal_height = extent_.height() * std::get<1>(resolution_) * filter_factor_;
+    unsigned current_width = reader.width();
+    unsigned current_height = reader.height();
+    unsigned best = 0;
+    for (unsigned i = 0; i < overviews.size(); ++i)
+    {
+        unsigned const overview_width = overviews[i].first;
+        unsigned const overview_height = overviews[i].second;
+        if ((overview_width < current_width || overview_height < current_height) && ideal_width <= overview_width &&
+            ideal_height <= overview_height)
+        {
+            current_width = overview_width;
+            current_height = overview_height;
+            best = i + 1;
+        }
+    }
+    if (best > 0)
+    {
+        MAPNIK_LOG_DEBUG(raster) << "raster_featureset: Overview=" << best << " size(" << current_width << ","
+                                 << current_height << ")";
+        reader.select_overview(best);
+    }
+}
+
 std::string tiled_multi_file_policy::interpolate(std::string const& pattern, int x, int y) const
 {
     // TODO: make from some sort of configurable interpolation
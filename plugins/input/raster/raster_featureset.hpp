@@ -29,6 +29,7 @@
 // mapnik
 #include <mapnik/feature.hpp>
 #include <mapnik/debug.hpp>
+#include <mapnik/image_reader.hpp>
 
 // stl
 #include <vector>
@@ -97,6 +98,8 @@ class single_file_policy
     inline int img_height(int reader_height) const { return reader_height; }
 
     inline box2d<double> transform(box2d<double>&) const { return box2d<double>(0, 0, 0, 0); }
+
+    inline bool use_overviews() const { return true; }
 };
 
 class tiled_file_policy
@@ -157,6 +160,8 @@ class tiled_file_policy
 
     inline box2d<double> transform(box2d<double>&) const { return box2d<double>(0, 0, 0, 0); }
 
+    inline bool use_overviews() const { return true; }
+
   private:
 
     std::vector<raster_info> infos_;
@@ -235,6 +240,9 @@ class tiled_multi_file_policy
 
     inline int img_height(int) const { return image_height_; }
 
+    // every file is a tile of the full image
+    inline bool use_overviews() const { return false; }
+
     inline box2d<double> transform(box2d<double>& box) const
     {
         int x_offset = int(std::floor(box.minx() / tile_size_));
@@ -263,6 +271,8 @@ class raster_featureset : public mapnik::Featureset
     mapnik::feature_ptr next();
 
   private:
+    void select_overview(mapnik::image_reader& reader) const;
+
     LookupPolicy policy_;
     mapnik::value_integer feature_id_;
     mapnik::context_ptr ctx_;
@@ -271,6 +281,7 @@ class raster_featureset : public mapnik::Featureset
     iterator_type curIter_;
     iterator_type endIter_;
     double filter_factor_;
+    mapnik::query::resolution_type resolution_;
 };
 
 #endif // RASTER_FEATURESET_HPP
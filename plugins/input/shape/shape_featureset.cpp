@@ -87,7 +87,7 @@ feature_ptr shape_featureset<filterT>::next()
         if (type == shape_io::shape_null)
             continue;
 
-        feature_ptr feature(feature_factory::create(ctx_, feature_id));
+        feature_ptr feature(feature_factory::create_transient(ctx_, feature_id));
         switch (type)
         {
             case shape_io::shape_point:
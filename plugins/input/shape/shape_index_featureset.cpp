@@ -67,11 +67,12 @@ shape_index_featureset<filterT>::shape_index_featureset(filterT const& filter,
     if (index)
     {
 #if defined(MAPNIK_MEMORY_MAPPED_FILE)
+        auto buffer = index->get().file().buffer();
         mapnik::util::spatial_index<mapnik::detail::node,
                                     filterT,
-                                    boost::interprocess::ibufferstream,
+                                    mapnik::util::index_buffer,
                                     mapnik::box2d<typename filterT::value_type>>::query(filter,
-                                                                                        index->get().file(),
+                                                                                        {buffer.first, buffer.second},
                                                                                         positions_);
 #else
         mapnik::util::spatial_index<mapnik::detail::node,
@@ -117,7 +118,7 @@ feature_ptr shape_index_featureset<filterT>::next()
         shape_file::record_type record(shape_ptr_->reclength_ * 2);
         shape_ptr_->shp().read_record(record);
         int type = record.read_ndr_integer();
-        feature_ptr feature(feature_factory::create(ctx_, feature_id));
+        feature_ptr feature(feature_factory::create_transient(ctx_, feature_id));
 
         switch (type)
         {
@@ -0,0 +1,227 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_HTTP_CONNECTION_POOL_HPP
+#define MAPNIK_HTTP_CONNECTION_POOL_HPP
+
+// boost
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core.hpp>
+#if defined(MAPNIK_HAS_OPENSSL)
+#include <boost/asio/ssl.hpp>
+#endif
+// stl
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace mapnik {
+
+// Persistent HTTP/1.1 connection. Each connection owns the io_context its stream
+// is bound to, so it can be handed over between the short-lived worker threads
+// of the tiles featuresets. The borrowing thread runs `ioc` until the worker is done.
+struct http_connection_base
+{
+    boost::asio::io_context ioc{1};
+    bool connected = false;
+    std::size_t requests = 0;
+    std::chrono::steady_clock::time_point last_used;
+};
+
+struct plain_connection : http_connection_base
+{
+    using stream_type = boost::beast::tcp_stream;
+
+    plain_connection() { reset(); }
+
+    boost::beast::tcp_stream& lowest_layer() { return *stream; }
+
+    // discard the current socket and start over with an unconnected stream
+    void reset()
+    {
+        stream.emplace(boost::asio::make_strand(ioc.get_executor()));
+        connected = false;
+        requests = 0;
+    }
+
+    std::optional<stream_type> stream;
+};
+
+#if defined(MAPNIK_HAS_OPENSSL)
+struct ssl_connection : http_connection_base
+{
+    using stream_type = boost::asio::ssl::stream<boost::beast::tcp_stream>;
+
+    explicit ssl_connection(boost::asio::ssl::context& ctx)
+        : ctx_(ctx)
+    {
+        reset();
+    }
+
+    boost::beast::tcp_stream& lowest_layer() { return boost::beast::get_lowest_layer(*stream); }
+
+    // TLS state can't be reused once the session failed, always start with a new stream
+    void reset()
+    {
+        stream.emplace(boost::asio::make_strand(ioc.get_executor()), ctx_);
+        connected = false;
+        requests = 0;
+    }
+
+    std::optional<stream_type> stream;
+
+  private:
+    boost::asio::ssl::context& ctx_;
+};
+#endif
+
+struct http_pool_options
+{
+    // maximum number of idle connections kept per host, 0 disables keep-alive
+    std::size_t max_idle = 8;
+    // idle connections older than this are closed instead of being reused
+    std::chrono::seconds idle_timeout{30};
+    // connections are retired after this many requests
+    std::size_t max_requests = 1000;
+};
+
+// Process wide pool of idle keep-alive connections keyed by "scheme://host:port"
+template<typename Connection>
+class http_connection_pool
+{
+  public:
+    using connection_ptr = std::unique_ptr<Connection>;
+
+    static http_connection_pool& instance()
+    {
+        static http_connection_pool pool;
+        return pool;
+    }
+
+    void set_options(std::string const& key, http_pool_options const& options)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        host_entry& entry = hosts_[key];
+        entry.options = options;
+        trim(entry, std::chrono::steady_clock::now());
+    }
+
+    http_pool_options options(std::string const& key) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itr = hosts_.find(key);
+        if (itr != hosts_.end())
+            return itr->second.options;
+        return http_pool_options{};
+    }
+
+    // Returns the most recently used idle connection for `key`, or nullptr
+    connection_ptr acquire(std::string const& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itr = hosts_.find(key);
+        if (itr != hosts_.end())
+        {
+            host_entry& entry = itr->second;
+            trim(entry, std::chrono::steady_clock::now());
+            if (!entry.idle.empty())
+            {
+                connection_ptr conn = std::move(entry.idle.back());
+                entry.idle.pop_back();
+                ++hits_;
+                return conn;
+            }
+        }
+        ++misses_;
+        return connection_ptr();
+    }
+
+    // Hand a connection back, it's dropped (closed) if it can't be kept alive
+    void release(std::string const& key, connection_ptr conn)
+    {
+        if (!conn || !conn->connected)
+            return;
+        auto now = std::chrono::steady_clock::now();
+        conn->last_used = now;
+        std::lock_guard<std::mutex> lock(mutex_);
+        host_entry& entry = hosts_[key];
+        if (conn->requests >= entry.options.max_requests)
+            return;
+        entry.idle.push_back(std::move(conn));
+        trim(entry, now);
+    }
+
+    std::size_t idle(std::string const& key) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itr = hosts_.find(key);
+        return itr != hosts_.end() ? itr->second.idle.size() : 0;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : hosts_)
+        {
+            entry.second.idle.clear();
+        }
+    }
+
+    std::size_t hits() const { return hits_.load(); }
+    std::size_t misses() const { return misses_.load(); }
+
+  private:
+    struct host_entry
+    {
+        http_pool_options options;
+        std::deque<connection_ptr> idle; // oldest first
+    };
+
+    static void trim(host_entry& entry, std::chrono::steady_clock::time_point now)
+    {
+        while (!entry.idle.empty() && (entry.idle.size() > entry.options.max_idle ||
+                                       now - entry.idle.front()->last_used >= entry.options.idle_timeout))
+        {
+            entry.idle.pop_front();
+        }
+    }
+
+    http_connection_pool()
+        : hits_(0),
+          misses_(0)
+    {}
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, host_entry> hosts_;
+    std::atomic<std::size_t> hits_;
+    std::atomic<std::size_t> misses_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_HTTP_CONNECTION_POOL_HPP
@@ -83,7 +83,7 @@ mapnik::feature_ptr mvt_io::mvt_layer::next_feature()
     {
         protozero::data_view const d(features_.at(feature_index_));
         protozero::pbf_reader f(d);
-        mapnik::feature_ptr feature = mapnik::feature_factory::create(io_.context_, feature_index_);
+        mapnik::feature_ptr feature = mapnik::feature_factory::create_transient(io_.context_, feature_index_);
         ++feature_index_;
         mvt_message::geom_type geometry_type = mvt_message::geom_type::unknown;
         bool has_geometry = false;
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_PMTILES_DIRECTORY_CACHE_HPP
+#define MAPNIK_PMTILES_DIRECTORY_CACHE_HPP
+
+// stl
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mapnik {
+
+struct entryv3
+{
+    std::uint64_t tile_id;
+    std::uint64_t offset;
+    std::uint32_t length;
+    std::uint32_t run_length;
+
+    entryv3()
+        : tile_id(0),
+          offset(0),
+          length(0),
+          run_length(0)
+    {}
+
+    entryv3(std::uint64_t _tile_id, std::uint64_t _offset, std::uint32_t _length, std::uint32_t _run_length)
+        : tile_id(_tile_id),
+          offset(_offset),
+          length(_length),
+          run_length(_run_length)
+    {}
+};
+
+// Bounded LRU of deserialized PMTiles directories keyed by directory offset.
+// Shared by all pmtiles_source instances opened on the same file with the
+// same capacity, for as long as one of them is alive.
+class pmtiles_directory_cache
+{
+  public:
+    using directory_type = std::shared_ptr<std::vector<entryv3> const>;
+    static constexpr std::size_t default_capacity = 64;
+
+    explicit pmtiles_directory_cache(std::size_t capacity = default_capacity)
+        : capacity_(capacity),
+          hits_(0),
+          misses_(0),
+          evictions_(0)
+    {}
+
+    static std::shared_ptr<pmtiles_directory_cache> get(std::string const& file_name, std::size_t capacity)
+    {
+        static std::mutex mutex;
+        static std::map<std::pair<std::string, std::size_t>, std::weak_ptr<pmtiles_directory_cache>> caches;
+        std::lock_guard<std::mutex> lock(mutex);
+        // drop the caches of files no longer opened
+        for (auto itr = caches.begin(); itr != caches.end();)
+        {
+            if (itr->second.expired())
+                itr = caches.erase(itr);
+            else
+                ++itr;
+        }
+        auto& entry = caches[{file_name, capacity}];
+        std::shared_ptr<pmtiles_directory_cache> cache = entry.lock();
+        if (!cache)
+        {
+            cache = std::make_shared<pmtiles_directory_cache>(capacity);
+            entry = cache;
+        }
+        return cache;
+    }
+
+    template<typename Loader>
+    directory_type find(std::uint64_t offset, Loader&& load)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto itr = index_.find(offset);
+            if (itr != index_.end())
+            {
+                ++hits_;
+                entries_.splice(entries_.begin(), entries_, itr->second);
+                return itr->second->second;
+            }
+        }
+        ++misses_;
+        // decompress outside the lock, concurrent misses on the same
+        // directory may both load it but only one is kept
+        directory_type dir = std::make_shared<std::vector<entryv3> const>(load());
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itr = index_.find(offset);
+        if (itr != index_.end())
+        {
+            return itr->second->second;
+        }
+        if (capacity_ == 0)
+        {
+            return dir;
+        }
+        entries_.emplace_front(offset, dir);
+        index_.emplace(offset, entries_.begin());
+        while (entries_.size() > capacity_)
+        {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+            ++evictions_;
+        }
+        return dir;
+    }
+
+    void set_capacity(std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        while (entries_.size() > capacity_)
+        {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+            ++evictions_;
+        }
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+    }
+
+    std::size_t capacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    std::size_t hits() const { return hits_.load(); }
+    std::size_t misses() const { return misses_.load(); }
+    std::size_t evictions() const { return evictions_.load(); }
+
+  private:
+    using list_type = std::list<std::pair<std::uint64_t, directory_type>>;
+    std::size_t capacity_;
+    list_type entries_;
+    std::unordered_map<std::uint64_t, list_type::iterator> index_;
+    mutable std::mutex mutex_;
+    std::atomic<std::size_t> hits_;
+    std::atomic<std::size_t> misses_;
+    std::atomic<std::size_t> evictions_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_PMTILES_DIRECTORY_CACHE_HPP
@@ -27,8 +27,10 @@
 #include <mapnik/util/mapped_memory_file.hpp>
 #include <mapnik/datasource.hpp>
 #include "tiles_source.hpp"
+#include "pmtiles_directory_cache.hpp"
 // stl
 #include <iostream>
+#include <memory>
 #include <tuple>
 #include <fstream>
 
@@ -39,27 +41,6 @@ namespace mapnik {
 
 enum class tile_type : std::uint8_t { UNKNOWN = 0x00, MVT = 0x01, PNG = 0x02, JPEG = 0x03, WEBP = 0x04, AVIF = 0x05 };
 
-struct entryv3
-{
-    std::uint64_t tile_id;
-    std::uint64_t offset;
-    std::uint32_t length;
-    std::uint32_t run_length;
-
-    entryv3()
-        : tile_id(0),
-          offset(0),
-          length(0),
-          run_length(0)
-    {}
-
-    entryv3(std::uint64_t _tile_id, std::uint64_t _offset, std::uint32_t _length, std::uint32_t _run_length)
-        : tile_id(_tile_id),
-          offset(_offset),
-          length(_length),
-          run_length(_run_length)
-    {}
-};
 namespace {
 struct varint_too_long_exception : std::exception
 {
@@ -385,9 +366,13 @@ class pmtiles_source : public tiles_source,
 
   public:
 
-    pmtiles_source() {}
-    pmtiles_source(std::string const& file_name)
-        : mapped_memory_file(file_name)
+    pmtiles_source()
+        : directory_cache_(std::make_shared<pmtiles_directory_cache>())
+    {}
+    pmtiles_source(std::string const& file_name,
+                   std::size_t directory_cache_size = pmtiles_directory_cache::default_capacity)
+        : mapped_memory_file(file_name),
+          directory_cache_(pmtiles_directory_cache::get(file_name, directory_cache_size))
     {
         if (!is_good())
         {
@@ -443,6 +428,10 @@ class pmtiles_source : public tiles_source,
     inline bool is_good() const { return file_.good(); }
     inline bool is_raster() const { return type_ != tile_type::MVT; }
 
+    pmtiles_directory_cache const& directory_cache() const { return *directory_cache_; }
+    std::size_t directory_cache_hits() const { return directory_cache_->hits(); }
+    std::size_t directory_cache_misses() const { return directory_cache_->misses(); }
+
   private:
     std::uint64_t root_dir_offset_;
     std::uint64_t root_dir_length_;
@@ -456,6 +445,22 @@ class pmtiles_source : public tiles_source,
     compression_type internal_compression_;
     compression_type tile_compression_ = compression_type::UNKNOWN;
     tile_type type_;
+    std::shared_ptr<pmtiles_directory_cache> directory_cache_;
+
+    std::vector<entryv3> read_directory(std::uint64_t dir_offset, std::uint64_t dir_length) const
+    {
+        std::string decompressed_dir;
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+        std::string_view buffer{file_.buffer().first + dir_offset, static_cast<std::size_t>(dir_length)};
+#else
+        std::string buffer;
+        buffer.resize(dir_length);
+        file_.seekg(dir_offset, std::ios::beg);
+        file_.read(buffer.data(), dir_length);
+#endif
+        mapnik::vector_tile_impl::zlib_decompress(buffer.data(), buffer.size(), decompressed_dir);
+        return deserialize_directory(decompressed_dir);
+    }
 
     std::pair<std::uint64_t, std::uint32_t> get_tile_position(std::uint8_t z, std::uint32_t x, std::uint32_t y) const
     {
@@ -466,18 +471,9 @@ class pmtiles_source : public tiles_source,
             std::uint64_t dir_length = root_dir_length_;
             for (std::size_t depth = 0; depth < 4; ++depth)
             {
-                std::string decompressed_dir;
-#if defined(MAPNIK_MEMORY_MAPPED_FILE)
-                std::string_view buffer{file_.buffer().first + dir_offset, static_cast<std::size_t>(dir_length)};
-#else
-                std::string buffer;
-                buffer.resize(dir_length);
-                file_.seekg(dir_offset, std::ios::beg);
-                file_.read(buffer.data(), dir_length);
-#endif
-                mapnik::vector_tile_impl::zlib_decompress(buffer.data(), buffer.size(), decompressed_dir);
-                auto dir_entries = deserialize_directory(decompressed_dir);
-                auto entry = find_tile(dir_entries, tile_id);
+                auto dir_entries =
+                  directory_cache_->find(dir_offset, [&]() { return read_directory(dir_offset, dir_length); });
+                auto entry = find_tile(*dir_entries, tile_id);
                 if (entry.length > 0)
                 {
                     if (entry.run_length > 0)
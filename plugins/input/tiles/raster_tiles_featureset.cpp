@@ -55,8 +55,9 @@ raster_tiles_featureset::raster_tiles_featureset(std::string const& tiles_locati
                                                  int xmax,
                                                  int ymin,
                                                  int ymax,
-                                                 std::unordered_map<std::string, std::string>& tiles_cache,
+                                                 std::shared_ptr<mapnik::tiles_cache> tiles_cache,
                                                  std::size_t max_threads,
+                                                 std::size_t directory_cache_size,
                                                  std::size_t datasource_hash,
                                                  double filter_factor)
     : tiles_location_(tiles_location),
@@ -67,11 +68,12 @@ raster_tiles_featureset::raster_tiles_featureset(std::string const& tiles_locati
       xmax_(xmax),
       ymin_(ymin),
       ymax_(ymax),
-      tiles_cache_(tiles_cache),
+      tiles_cache_(std::move(tiles_cache)),
       QUEUE_SIZE_((xmax - xmin + 1) * (ymax - ymin + 1)),
       queue_(QUEUE_SIZE_),
       stash_(ioc_, targets_, queue_),
       max_threads_(max_threads),
+      directory_cache_size_(directory_cache_size),
       datasource_hash_(datasource_hash),
       filter_factor_(filter_factor)
 {
@@ -169,14 +171,15 @@ mapnik::feature_ptr raster_tiles_featureset::next()
             {
                 ++num_tiles_;
                 auto datasource_key = (boost::format("%1%-%2%-%3%-%4%") % datasource_hash_ % zoom_ % x % y).str();
-                auto itr = tiles_cache_.find(datasource_key);
-                if (itr == tiles_cache_.end())
+                auto buffer = tiles_cache_->find(datasource_key);
+                if (!buffer)
                 {
                     stash_.targets().emplace_back(zoom_, x, y);
                 }
                 else
                 {
-                    std::string buffer = itr->second;
+                    // hold on to the cached bytes, the shared cache may evict them in the meantime
+                    cached_tiles_.emplace(datasource_key, std::move(buffer));
                     stash_.push_async(tile_data(zoom_, x, y));
                 }
             }
@@ -192,7 +195,8 @@ mapnik::feature_ptr raster_tiles_featureset::next()
             if (local_file_)
             {
                 workers_.emplace_back([this, reporting_work] {
-                    std::unique_ptr<mapnik::tiles_source> source = mapnik::tiles_source::get_source(tiles_location_);
+                    std::unique_ptr<mapnik::tiles_source> source =
+                      mapnik::tiles_source::get_source(tiles_location_, directory_cache_size_);
                     if (source)
                     {
                         while (!done_)
@@ -211,19 +215,14 @@ mapnik::feature_ptr raster_tiles_featureset::next()
             else if (ssl_)
             {
                 workers_.emplace_back([this, reporting_work] {
-                    boost::asio::io_context ioc;
-                    std::make_shared<worker_ssl>(ioc, ssl_ctx_, host_, port_, tiles_location_, stash_, std::ref(done_))
-                      ->run();
-                    ioc.run();
+                    xyz_tiles::fetch_tiles_ssl(host_, port_, tiles_location_, stash_, done_);
                 });
             }
 #endif
             else
             {
                 workers_.emplace_back([this, reporting_work] {
-                    boost::asio::io_context ioc;
-                    std::make_shared<worker>(ioc, host_, port_, tiles_location_, stash_, std::ref(done_))->run();
-                    ioc.run();
+                    xyz_tiles::fetch_tiles(host_, port_, tiles_location_, stash_, done_);
                 });
             }
         }
@@ -238,11 +237,12 @@ mapnik::feature_ptr raster_tiles_featureset::next()
             ++consumed_count_;
             auto datasource_key =
               (boost::format("%1%-%2%-%3%-%4%") % datasource_hash_ % tile.zoom % tile.x % tile.y).str();
-            auto itr = tiles_cache_.find(datasource_key);
-            if (itr != tiles_cache_.end())
+            auto itr = cached_tiles_.find(datasource_key);
+            if (itr != cached_tiles_.end())
             {
-                auto buffer = itr->second;
-                return next_feature(buffer, tile.x, tile.y, datasource_key);
+                auto buffer = std::move(itr->second);
+                cached_tiles_.erase(itr);
+                return next_feature(*buffer, tile.x, tile.y, datasource_key);
             }
             else if (tile.data)
             {
@@ -250,8 +250,8 @@ mapnik::feature_ptr raster_tiles_featureset::next()
                 {
                     continue;
                 }
-                tiles_cache_.emplace(datasource_key, *tile.data);
-                return next_feature(*tile.data, tile.x, tile.y, datasource_key);
+                auto buffer = tiles_cache_->insert(datasource_key, std::move(*tile.data));
+                return next_feature(*buffer, tile.x, tile.y, datasource_key);
             }
         }
         if (consumed_count_ == num_tiles_)
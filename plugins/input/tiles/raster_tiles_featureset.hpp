@@ -28,6 +28,7 @@
 #include <mapnik/feature.hpp>
 #include <mapnik/datasource.hpp>
 #include "xyz_tiles.hpp"
+#include "tiles_cache.hpp"
 
 class raster_tiles_featureset : public mapnik::Featureset
 {
@@ -40,8 +41,9 @@ class raster_tiles_featureset : public mapnik::Featureset
                             int xmax,
                             int ymin,
                             int ymax,
-                            std::unordered_map<std::string, std::string>& vector_tile_cache,
+                            std::shared_ptr<mapnik::tiles_cache> tiles_cache,
                             std::size_t max_threads,
+                            std::size_t directory_cache_size,
                             std::size_t datasource_hash,
                             double filter_factor);
 
@@ -53,16 +55,14 @@ class raster_tiles_featureset : public mapnik::Featureset
     std::string tiles_location_;
     mapnik::context_ptr context_;
     boost::asio::io_context ioc_;
-#if defined(MAPNIK_HAS_OPENSSL)
-    boost::asio::ssl::context ssl_ctx_{boost::asio::ssl::context::tlsv12_client};
-#endif
     mapnik::box2d<double> extent_;
     int zoom_;
     int xmin_;
     int xmax_;
     int ymin_;
     int ymax_;
-    std::unordered_map<std::string, std::string>& tiles_cache_;
+    std::shared_ptr<mapnik::tiles_cache> tiles_cache_;
+    std::unordered_map<std::string, mapnik::tiles_cache::buffer_type> cached_tiles_;
     std::size_t const QUEUE_SIZE_;
     queue_type queue_;
     std::vector<std::thread> workers_;
@@ -73,6 +73,7 @@ class raster_tiles_featureset : public mapnik::Featureset
     std::size_t num_tiles_{0};
     std::size_t consumed_count_{0};
     std::size_t max_threads_;
+    std::size_t directory_cache_size_;
     std::size_t datasource_hash_;
     double filter_factor_;
     bool first_ = true;
@@ -0,0 +1,165 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_TILES_CACHE_HPP
+#define MAPNIK_TILES_CACHE_HPP
+
+// stl
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace mapnik {
+
+// LRU cache of tile bytes shared by the featuresets and renderer threads of the
+// datasources using it: the process wide instance() or a datasource's own one
+// (`tile-cache-size`). The cache is bounded by the number of stored bytes (keys
+// included), buffers are shared so evicting an entry never invalidates a tile
+// which is still being decoded.
+class tiles_cache
+{
+  public:
+    using buffer_type = std::shared_ptr<std::string const>;
+    static constexpr std::size_t default_capacity = 64 * 1024 * 1024;
+
+    explicit tiles_cache(std::size_t capacity = default_capacity)
+        : capacity_(capacity),
+          bytes_(0),
+          hits_(0),
+          misses_(0),
+          evictions_(0)
+    {}
+
+    static std::shared_ptr<tiles_cache> const& instance()
+    {
+        static std::shared_ptr<tiles_cache> const cache = std::make_shared<tiles_cache>();
+        return cache;
+    }
+
+    buffer_type find(std::string const& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itr = index_.find(key);
+        if (itr == index_.end())
+        {
+            ++misses_;
+            return buffer_type();
+        }
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, itr->second);
+        return itr->second->second;
+    }
+
+    // Insert `data` unless `key` is already cached, returns the cached buffer.
+    // Buffers larger than the capacity are returned without being stored.
+    buffer_type insert(std::string const& key, std::string&& data)
+    {
+        buffer_type buffer = std::make_shared<std::string const>(std::move(data));
+        std::size_t cost = key.size() + buffer->size();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itr = index_.find(key);
+        if (itr != index_.end())
+        {
+            entries_.splice(entries_.begin(), entries_, itr->second);
+            return itr->second->second;
+        }
+        if (cost > capacity_)
+        {
+            return buffer;
+        }
+        entries_.emplace_front(key, buffer);
+        index_.emplace(key, entries_.begin());
+        bytes_ += cost;
+        shrink();
+        return buffer;
+    }
+
+    void set_capacity(std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        shrink();
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+
+    std::size_t capacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    std::size_t bytes() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    std::size_t hits() const { return hits_.load(); }
+    std::size_t misses() const { return misses_.load(); }
+    std::size_t evictions() const { return evictions_.load(); }
+
+  private:
+    using list_type = std::list<std::pair<std::string, buffer_type>>;
+
+    void shrink()
+    {
+        while (bytes_ > capacity_ && !entries_.empty())
+        {
+            auto const& entry = entries_.back();
+            bytes_ -= entry.first.size() + entry.second->size();
+            index_.erase(entry.first);
+            entries_.pop_back();
+            ++evictions_;
+        }
+    }
+
+    std::size_t capacity_;
+    std::size_t bytes_;
+    list_type entries_; // most recently used first
+    std::unordered_map<std::string, list_type::iterator> index_;
+    mutable std::mutex mutex_;
+    std::atomic<std::size_t> hits_;
+    std::atomic<std::size_t> misses_;
+    std::atomic<std::size_t> evictions_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_TILES_CACHE_HPP
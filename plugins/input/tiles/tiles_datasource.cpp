@@ -195,7 +195,14 @@ void tiles_datasource::init(mapnik::parameters const& params)
         }
         if (database_path_.ends_with(".pmtiles"))
         {
-            source_ptr_ = std::make_shared<mapnik::pmtiles_source>(database_path_);
+            // number of deserialized directories kept, shared with the other
+            // datasources opening the same file with the same size
+            auto dir_cache_size = params.get<mapnik::value_integer>("directory-cache-size");
+            if (dir_cache_size && *dir_cache_size >= 0)
+            {
+                directory_cache_size_ = static_cast<std::size_t>(*dir_cache_size);
+            }
+            source_ptr_ = std::make_shared<mapnik::pmtiles_source>(database_path_, directory_cache_size_);
         }
         else if (database_path_.ends_with(".mbtiles"))
         {
@@ -254,6 +261,45 @@ void tiles_datasource::init(mapnik::parameters const& params)
     maxzoom_ = *params.get<mapnik::value_integer>("maxzoom", maxzoom_);
     // overwrite default max_threads
     max_threads_ = *params.get<mapnik::value_integer>("max-threads", max_threads_);
+    // a datasource with its own tile cache limit in bytes gets a cache of its
+    // own, the others share the process wide one
+    auto tile_cache_size = params.get<mapnik::value_integer>("tile-cache-size");
+    if (tile_cache_size && *tile_cache_size >= 0)
+    {
+        tiles_cache_ = std::make_shared<mapnik::tiles_cache>(static_cast<std::size_t>(*tile_cache_size));
+    }
+    else
+    {
+        tiles_cache_ = mapnik::tiles_cache::instance();
+    }
+    // store vector tiles decompressed (faster) or as fetched (smaller)
+    cache_decompressed_ = *params.get<mapnik::boolean_type>("tile-cache-decompressed", cache_decompressed_);
+    // keep-alive limits for the HTTP connections fetching remote tiles
+    if (url_template_)
+    {
+        // negative values keep the defaults
+        mapnik::http_pool_options options;
+        auto max_idle = params.get<mapnik::value_integer>("max-idle-connections");
+        if (max_idle && *max_idle >= 0)
+        {
+            options.max_idle = static_cast<std::size_t>(*max_idle);
+        }
+        auto idle_timeout = params.get<mapnik::value_integer>("idle-timeout");
+        if (idle_timeout && *idle_timeout >= 0)
+        {
+            options.idle_timeout = std::chrono::seconds(*idle_timeout);
+        }
+        auto max_requests = params.get<mapnik::value_integer>("max-requests");
+        if (max_requests && *max_requests >= 0)
+        {
+            options.max_requests = static_cast<std::size_t>(*max_requests);
+        }
+        if (!*params.get<mapnik::boolean_type>("keep-alive", true))
+        {
+            options.max_idle = 0;
+        }
+        xyz_tiles::set_pool_options(*url_template_, options);
+    }
 }
 
 mapnik::context_ptr tiles_datasource::get_context_with_attributes() const
@@ -303,23 +349,11 @@ std::int64_t scale_to_zoom(double scale, std::int64_t minzoom, std::int64_t maxz
 }
 } // namespace
 
-std::unordered_map<std::string, std::string>& tiles_datasource::tile_cache()
-{
-    static thread_local std::unordered_map<std::string, std::string> tiles_cache;
-    return tiles_cache;
-}
-
 mapnik::featureset_ptr tiles_datasource::features(mapnik::query const& q) const
 {
 #ifdef MAPNIK_STATS
     mapnik::progress_timer __stats__(std::clog, "tiles_datasource::features");
 #endif
-    auto& tiles_cache = tile_cache();
-    if (tiles_cache.size() > 64)
-    {
-        tiles_cache.clear();
-    }
-
     if (q.get_bbox().intersects(extent_))
     {
         mapnik::box2d<double> bbox = q.get_bbox().intersect(extent_);
@@ -337,7 +371,9 @@ mapnik::featureset_ptr tiles_datasource::features(mapnik::query const& q) const
                                      (tile_count / mapnik::EARTH_CIRCUMFERENCE));
 
         std::string source_location = url_template_ ? *url_template_ : database_path_;
-        auto datasource_hash = std::hash<std::string>{}(source_location);
+        // tiles cached as fetched must not be mistaken for decompressed ones
+        auto datasource_hash =
+          std::hash<std::string>{}(cache_decompressed_ ? source_location : source_location + "#raw");
 
         if (is_vector_ && layer_name_)
         {
@@ -350,10 +386,12 @@ mapnik::featureset_ptr tiles_datasource::features(mapnik::query const& q) const
                                                              ymax,
                                                              bbox,
                                                              *layer_name_,
-                                                             tiles_cache,
+                                                             tiles_cache_,
                                                              max_threads_,
+                                                             directory_cache_size_,
                                                              datasource_hash,
-                                                             tile_compression_);
+                                                             tile_compression_,
+                                                             cache_decompressed_);
         }
         else
         {
@@ -365,8 +403,9 @@ mapnik::featureset_ptr tiles_datasource::features(mapnik::query const& q) const
                                                              xmax,
                                                              ymin,
                                                              ymax,
-                                                             tiles_cache,
+                                                             tiles_cache_,
                                                              max_threads_,
+                                                             directory_cache_size_,
                                                              datasource_hash,
                                                              q.get_filter_factor());
         }
@@ -395,7 +434,8 @@ mapnik::featureset_ptr tiles_datasource::features_at_point(mapnik::coord2d const
     auto query_bbox = mapnik::box2d<double>{x0, y0, x1, y1};
 
     std::string source_location = url_template_ ? *url_template_ : database_path_;
-    auto datasource_hash = std::hash<std::string>{}(source_location);
+    // tiles cached as fetched must not be mistaken for decompressed ones
+    auto datasource_hash = std::hash<std::string>{}(cache_decompressed_ ? source_location : source_location + "#raw");
 
     if (is_vector_ && layer_name_)
     {
@@ -408,10 +448,12 @@ mapnik::featureset_ptr tiles_datasource::features_at_point(mapnik::coord2d const
                                                          tile_y,
                                                          query_bbox,
                                                          *layer_name_,
-                                                         tile_cache(),
+                                                         tiles_cache_,
                                                          max_threads_,
+                                                         directory_cache_size_,
                                                          datasource_hash,
-                                                         tile_compression_);
+                                                         tile_compression_,
+                                                         cache_decompressed_);
     }
     return mapnik::featureset_ptr();
 }
@@ -32,6 +32,8 @@
 #include <mapnik/feature_layer_desc.hpp>
 #include <mapnik/datasource_plugin.hpp>
 #include "tiles_source.hpp"
+#include "pmtiles_directory_cache.hpp"
+#include "tiles_cache.hpp"
 // boost
 #include <boost/json.hpp>
 // stl
@@ -70,7 +72,7 @@ class tiles_datasource : public mapnik::datasource
     std::string database_path_;
     std::shared_ptr<mapnik::tiles_source> source_ptr_;
     std::optional<std::string> url_template_;
-    static std::unordered_map<std::string, std::string>& tile_cache();
+    std::shared_ptr<mapnik::tiles_cache> tiles_cache_;
 
   public:
     mapnik::box2d<double> extent_;
@@ -78,6 +80,8 @@ class tiles_datasource : public mapnik::datasource
     std::int64_t maxzoom_ = 14;
     mapnik::compression_type tile_compression_ = mapnik::compression_type::NONE;
     std::size_t max_threads_ = 4;
+    std::size_t directory_cache_size_ = mapnik::pmtiles_directory_cache::default_capacity;
+    bool cache_decompressed_ = true;
     std::optional<std::string> layer_name_;
     mapnik::layer_descriptor desc_;
     bool is_vector_ = false;
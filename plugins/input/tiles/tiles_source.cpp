@@ -26,11 +26,11 @@
 
 namespace mapnik {
 
-std::unique_ptr<tiles_source> tiles_source::get_source(std::string const& filename)
+std::unique_ptr<tiles_source> tiles_source::get_source(std::string const& filename, std::size_t directory_cache_size)
 {
     if (filename.ends_with(".pmtiles"))
     {
-        return std::make_unique<mapnik::pmtiles_source>(filename);
+        return std::make_unique<mapnik::pmtiles_source>(filename, directory_cache_size);
     }
     else if (filename.ends_with(".mbtiles"))
     {
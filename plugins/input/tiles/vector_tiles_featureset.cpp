@@ -37,10 +37,12 @@ vector_tiles_featureset::vector_tiles_featureset(std::string const& tiles_locati
                                                  int ymax,
                                                  mapnik::box2d<double> const& extent,
                                                  std::string const& layer,
-                                                 std::unordered_map<std::string, std::string>& tiles_cache,
+                                                 std::shared_ptr<mapnik::tiles_cache> tiles_cache,
                                                  std::size_t max_threads,
+                                                 std::size_t directory_cache_size,
                                                  std::size_t datasource_hash,
-                                                 mapnik::compression_type tile_compression)
+                                                 mapnik::compression_type tile_compression,
+                                                 bool cache_decompressed)
     : tiles_location_(tiles_location),
       context_(ctx),
       zoom_(zoom),
@@ -51,13 +53,15 @@ vector_tiles_featureset::vector_tiles_featureset(std::string const& tiles_locati
       extent_(extent),
       layer_(layer),
       vector_tile_(nullptr),
-      tiles_cache_(tiles_cache),
+      tiles_cache_(std::move(tiles_cache)),
       QUEUE_SIZE_((xmax - xmin + 1) * (ymax - ymin + 1)),
       queue_(QUEUE_SIZE_),
       stash_(ioc_, targets_, queue_),
       max_threads_(max_threads),
+      directory_cache_size_(directory_cache_size),
       datasource_hash_(datasource_hash),
-      tile_compression_(tile_compression)
+      tile_compression_(tile_compression),
+      cache_decompressed_(cache_decompressed)
 {
     try
     {
@@ -134,14 +138,15 @@ bool vector_tiles_featureset::next_tile()
             {
                 ++num_tiles_;
                 auto datasource_key = (boost::format("%1%-%2%-%3%-%4%") % datasource_hash_ % zoom_ % x % y).str();
-                auto itr = tiles_cache_.find(datasource_key);
-                if (itr == tiles_cache_.end())
+                auto buffer = tiles_cache_->find(datasource_key);
+                if (!buffer)
                 {
                     stash_.targets().emplace_back(zoom_, x, y);
                 }
                 else
                 {
-                    std::string buffer = itr->second;
+                    // hold on to the cached bytes, the shared cache may evict them in the meantime
+                    cached_tiles_.emplace(datasource_key, std::move(buffer));
                     stash_.push_async(tile_data(zoom_, x, y));
                 }
             }
@@ -156,7 +161,8 @@ bool vector_tiles_featureset::next_tile()
             if (local_file_)
             {
                 workers_.emplace_back([this, reporting_work] {
-                    std::unique_ptr<mapnik::tiles_source> source = mapnik::tiles_source::get_source(tiles_location_);
+                    std::unique_ptr<mapnik::tiles_source> source =
+                      mapnik::tiles_source::get_source(tiles_location_, directory_cache_size_);
                     if (source)
                     {
                         while (!done_)
@@ -175,19 +181,14 @@ bool vector_tiles_featureset::next_tile()
             else if (ssl_)
             {
                 workers_.emplace_back([this, reporting_work] {
-                    boost::asio::io_context ioc;
-                    std::make_shared<worker_ssl>(ioc, ssl_ctx_, host_, port_, tiles_location_, stash_, std::ref(done_))
-                      ->run();
-                    ioc.run();
+                    xyz_tiles::fetch_tiles_ssl(host_, port_, tiles_location_, stash_, done_);
                 });
             }
 #endif
             else
             {
                 workers_.emplace_back([this, reporting_work] {
-                    boost::asio::io_context ioc;
-                    std::make_shared<worker>(ioc, host_, port_, tiles_location_, stash_, std::ref(done_))->run();
-                    ioc.run();
+                    xyz_tiles::fetch_tiles(host_, port_, tiles_location_, stash_, done_);
                 });
             }
         }
@@ -203,26 +204,25 @@ bool vector_tiles_featureset::next_tile()
             auto datasource_key =
               (boost::format("%1%-%2%-%3%-%4%") % datasource_hash_ % tile.zoom % tile.x % tile.y).str();
 
-            auto itr = tiles_cache_.find(datasource_key);
-            if (itr != tiles_cache_.end())
+            auto itr = cached_tiles_.find(datasource_key);
+            if (itr != cached_tiles_.end())
             {
-                auto buffer = itr->second;
+                std::string buffer = cache_decompressed_ ? *itr->second : decompress(*itr->second);
+                cached_tiles_.erase(itr);
                 vector_tile_.reset(new mvt_io(std::move(buffer), context_, tile.x, tile.y, zoom_, layer_));
                 return true;
             }
             else if (tile.data && !tile.data->empty())
             {
-                std::string decompressed;
-                if (tile_compression_ == mapnik::compression_type::GZIP)
+                std::string decompressed = decompress(*tile.data);
+                if (cache_decompressed_)
                 {
-                    mapnik::vector_tile_impl::zlib_decompress((*tile.data).data(), (*tile.data).size(), decompressed);
+                    tiles_cache_->insert(datasource_key, std::string(decompressed));
                 }
-                else if (tile_compression_ == mapnik::compression_type::NONE)
+                else
                 {
-                    decompressed = {(*tile.data).data(), (*tile.data).size()};
+                    tiles_cache_->insert(datasource_key, std::move(*tile.data));
                 }
-
-                tiles_cache_.emplace(datasource_key, decompressed);
                 vector_tile_.reset(new mvt_io(std::move(decompressed), context_, tile.x, tile.y, zoom_, layer_));
                 return true;
             }
@@ -232,3 +232,17 @@ bool vector_tiles_featureset::next_tile()
     }
     return false;
 }
+
+std::string vector_tiles_featureset::decompress(std::string const& data) const
+{
+    std::string decompressed;
+    if (tile_compression_ == mapnik::compression_type::GZIP)
+    {
+        mapnik::vector_tile_impl::zlib_decompress(data.data(), data.size(), decompressed);
+    }
+    else if (tile_compression_ == mapnik::compression_type::NONE)
+    {
+        decompressed = data;
+    }
+    return decompressed;
+}
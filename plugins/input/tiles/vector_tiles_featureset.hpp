@@ -30,6 +30,7 @@
 #include "xyz_tiles.hpp"
 #include "mvt_io.hpp"
 #include "tiles_source.hpp"
+#include "tiles_cache.hpp"
 
 class vector_tiles_featureset : public mapnik::Featureset
 {
@@ -43,10 +44,12 @@ class vector_tiles_featureset : public mapnik::Featureset
                             int ymax,
                             mapnik::box2d<double> const& extent,
                             std::string const& layer,
-                            std::unordered_map<std::string, std::string>& tiles_cache,
+                            std::shared_ptr<mapnik::tiles_cache> tiles_cache,
                             std::size_t max_threads,
+                            std::size_t directory_cache_size,
                             std::size_t datasource_hash,
-                            mapnik::compression_type);
+                            mapnik::compression_type,
+                            bool cache_decompressed = true);
 
     virtual ~vector_tiles_featureset();
     mapnik::feature_ptr next();
@@ -57,9 +60,6 @@ class vector_tiles_featureset : public mapnik::Featureset
     std::string tiles_location_;
     mapnik::context_ptr context_;
     boost::asio::io_context ioc_;
-#if defined(MAPNIK_HAS_OPENSSL)
-    boost::asio::ssl::context ssl_ctx_{boost::asio::ssl::context::tlsv12_client};
-#endif
     int zoom_;
     int xmin_;
     int xmax_;
@@ -68,7 +68,8 @@ class vector_tiles_featureset : public mapnik::Featureset
     mapnik::box2d<double> extent_;
     std::string const layer_;
     std::unique_ptr<mvt_io> vector_tile_;
-    std::unordered_map<std::string, std::string>& tiles_cache_;
+    std::shared_ptr<mapnik::tiles_cache> tiles_cache_;
+    std::unordered_map<std::string, mapnik::tiles_cache::buffer_type> cached_tiles_;
     std::size_t const QUEUE_SIZE_;
     queue_type queue_;
     std::vector<std::thread> workers_;
@@ -79,9 +80,12 @@ class vector_tiles_featureset : public mapnik::Featureset
     std::size_t num_tiles_{0};
     std::size_t consumed_count_{0};
     std::size_t max_threads_;
+    std::size_t directory_cache_size_;
     std::size_t datasource_hash_;
     mapnik::compression_type tile_compression_ = mapnik::compression_type::NONE;
+    bool cache_decompressed_;
     bool next_tile();
+    std::string decompress(std::string const& data) const;
     bool first_ = true;
     bool ssl_ = false;
     bool local_file_ = true;
@@ -26,6 +26,7 @@
 // mapnik
 #include <mapnik/version.hpp>
 #include <mapnik/debug.hpp>
+#include "http_connection_pool.hpp"
 // boost
 #include <boost/url.hpp>
 #include <boost/beast/core.hpp>
@@ -291,19 +292,20 @@ class worker : public std::enable_shared_from_this<worker>
     std::string host_;
     std::string port_;
     std::string url_template_;
-    boost::asio::strand<boost::asio::io_context::executor_type> ex_;
+    mapnik::plain_connection& conn_;
     tcp::resolver resolver_;
-    beast::tcp_stream stream_;
     beast::flat_buffer buffer_;
     http::request<http::empty_body> req_;
     http::response<http::string_body> res_;
     zxy tile_;
+    bool pending_ = false; // tile_ was taken from the stash but not received yet
+    bool reused_ = false;  // pooled connection which hasn't answered a request yet
     std::atomic<bool>& done_;
 
   public:
     worker(worker&&) = default;
 
-    explicit worker(boost::asio::io_context& ioc,
+    explicit worker(mapnik::plain_connection& conn,
                     std::string const& host,
                     std::string const& port,
                     std::string const& url_template,
@@ -313,20 +315,30 @@ class worker : public std::enable_shared_from_this<worker>
           host_(host),
           port_(port),
           url_template_(url_template),
-          ex_(boost::asio::make_strand(ioc.get_executor())),
-          resolver_(ex_),
-          stream_(ex_),
+          conn_(conn),
+          resolver_(conn.ioc.get_executor()),
           done_(done)
     {
         req_.version(11); // HTTP 1.1
         req_.method(http::verb::get);
         req_.set(http::field::user_agent, USER_AGENT_STRING);
+        req_.keep_alive(true);
     }
 
     // Start the asynchronous operation
     void run()
     {
         req_.set(http::field::host, host_);
+        if (conn_.connected)
+        {
+            reused_ = true;
+            return next_request();
+        }
+        connect();
+    }
+
+    void connect()
+    {
         resolver_.async_resolve(host_, port_, beast::bind_front_handler(&worker::on_resolve, shared_from_this()));
     }
 
@@ -338,9 +350,9 @@ class worker : public std::enable_shared_from_this<worker>
             return fail(ec, "resolve");
         }
         // Set a timeout on the operation
-        stream_.expires_after(std::chrono::seconds(10));
+        conn_.lowest_layer().expires_after(std::chrono::seconds(10));
         // Make the connection on the IP address we get from a lookup
-        stream_.async_connect(results, beast::bind_front_handler(&worker::on_connect, shared_from_this()));
+        conn_.lowest_layer().async_connect(results, beast::bind_front_handler(&worker::on_connect, shared_from_this()));
     }
 
     void on_connect(beast::error_code ec, tcp::resolver::results_type::endpoint_type)
@@ -350,20 +362,28 @@ class worker : public std::enable_shared_from_this<worker>
             done_.store(true);
             return fail(ec, "connect");
         }
+        conn_.connected = true;
+        if (pending_)
+            return send();
+        next_request();
+    }
+
+    void next_request()
+    {
         auto zxy = stash_.get_zxy();
         if (!zxy)
         {
-            // Work is done, gracefully close the socket
-            stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
-            // not_connected happens sometimes so don't bother reporting it.
-            if (ec && ec != beast::errc::not_connected)
-            {
-                return fail(ec, "shutdown");
-                // If we get here then the connection is closed gracefully
-            }
+            // Work is done, keep the connection open for the pool
+            conn_.lowest_layer().expires_never();
             return;
         }
         tile_ = *zxy;
+        pending_ = true;
+        send();
+    }
+
+    void send()
+    {
         auto url =
           boost::urls::format(url_template_,
                               {{"z", std::get<0>(tile_)}, {"x", std::get<1>(tile_)}, {"y", std::get<2>(tile_)}});
@@ -372,24 +392,25 @@ class worker : public std::enable_shared_from_this<worker>
         if (!url.query().empty())
             target += "?" + url.query();
         req_.target(target);
-        // std::cerr << "\e[41m target:" << url.path() << " thread:" << std::this_thread::get_id() <<"\e[0m" <<
-        // std::endl;
-        stream_.expires_after(std::chrono::seconds(10));
+        conn_.lowest_layer().expires_after(std::chrono::seconds(10));
         // Send the HTTP request to the remote host
-        http::async_write(stream_, req_, beast::bind_front_handler(&worker::on_write, shared_from_this()));
+        http::async_write(*conn_.stream, req_, beast::bind_front_handler(&worker::on_write, shared_from_this()));
     }
+
     void on_write(beast::error_code ec, std::size_t bytes_transferred)
     {
         boost::ignore_unused(bytes_transferred);
 
         if (ec)
         {
-            done_.store(true);
-            return fail(ec, "write");
+            return retry(ec, "write");
         }
         res_ = {};
-        stream_.expires_after(std::chrono::seconds(10));
-        http::async_read(stream_, buffer_, res_, beast::bind_front_handler(&worker::on_read, shared_from_this()));
+        conn_.lowest_layer().expires_after(std::chrono::seconds(10));
+        http::async_read(*conn_.stream,
+                         buffer_,
+                         res_,
+                         beast::bind_front_handler(&worker::on_read, shared_from_this()));
     }
 
     void on_read(beast::error_code ec, std::size_t bytes_transferred)
@@ -397,9 +418,11 @@ class worker : public std::enable_shared_from_this<worker>
         boost::ignore_unused(bytes_transferred);
         if (ec)
         {
-            done_.store(true);
-            return fail(ec, "read");
+            return retry(ec, "read");
         }
+        pending_ = false;
+        reused_ = false;
+        ++conn_.requests;
         if (res_.result_int() == 200)
         {
             stash_.push_async(
@@ -410,28 +433,40 @@ class worker : public std::enable_shared_from_this<worker>
             stash_.push_async(tile_data(std::get<0>(tile_), std::get<1>(tile_), std::get<2>(tile_)));
         }
 
-        auto zxy = stash_.get_zxy();
-        if (!zxy)
+        if (!res_.keep_alive())
         {
-            stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
-            if (ec && ec != beast::errc::not_connected)
-            {
-                return fail(ec, "shutdown");
-            }
-            return;
+            // server closes the connection, reconnect for the remaining tiles
+            close();
+            auto zxy = stash_.get_zxy();
+            if (!zxy)
+                return;
+            tile_ = *zxy;
+            pending_ = true;
+            return connect();
         }
-        tile_ = *zxy;
-        auto url =
-          boost::urls::format(url_template_,
-                              {{"z", std::get<0>(tile_)}, {"x", std::get<1>(tile_)}, {"y", std::get<2>(tile_)}});
+        next_request();
+    }
 
-        std::string target = url.path();
-        if (!url.query().empty())
-            target += "?" + url.query();
-        req_.target(target);
-        // std::cerr << "\e[41m target:" << url.path() << " thread:" << std::this_thread::get_id() <<"\e[0m" <<
-        // std::endl;
-        http::async_write(stream_, req_, beast::bind_front_handler(&worker::on_write, shared_from_this()));
+    // A pooled connection may have been closed by the server while idle,
+    // reconnect once and resend the pending request.
+    void retry(beast::error_code ec, char const* what)
+    {
+        close();
+        if (reused_)
+        {
+            reused_ = false;
+            return connect();
+        }
+        done_.store(true);
+        fail(ec, what);
+    }
+
+    void close()
+    {
+        beast::error_code ec;
+        conn_.lowest_layer().socket().shutdown(tcp::socket::shutdown_both, ec);
+        conn_.reset();
+        buffer_.clear();
     }
 };
 
@@ -442,20 +477,20 @@ class worker_ssl : public std::enable_shared_from_this<worker_ssl>
     std::string host_;
     std::string port_;
     std::string url_template_;
-    boost::asio::strand<boost::asio::io_context::executor_type> ex_;
+    mapnik::ssl_connection& conn_;
     tcp::resolver resolver_;
-    boost::asio::ssl::stream<beast::tcp_stream> stream_;
     beast::flat_buffer buffer_;
     http::request<http::empty_body> req_;
     http::response<http::string_body> res_;
     zxy tile_;
+    bool pending_ = false; // tile_ was taken from the stash but not received yet
+    bool reused_ = false;  // pooled connection which hasn't answered a request yet
     std::atomic<bool>& done_;
 
   public:
     worker_ssl(worker_ssl&&) = default;
 
-    explicit worker_ssl(boost::asio::io_context& ioc,
-                        boost::asio::ssl::context& ctx,
+    explicit worker_ssl(mapnik::ssl_connection& conn,
                         std::string const& host,
                         std::string const& port,
                         std::string const& url_template,
@@ -465,29 +500,39 @@ class worker_ssl : public std::enable_shared_from_this<worker_ssl>
           host_(host),
           port_(port),
           url_template_(url_template),
-          ex_(boost::asio::make_strand(ioc.get_executor())),
-          resolver_(ex_),
-          stream_(ex_, ctx),
+          conn_(conn),
+          resolver_(conn.ioc.get_executor()),
           done_(done)
     {
         req_.version(11); // HTTP 1.1
         req_.method(http::verb::get);
         req_.set(http::field::user_agent, USER_AGENT_STRING);
+        req_.keep_alive(true);
     }
 
     // Start the asynchronous operation
     void run()
     {
         req_.set(http::field::host, host_);
+        if (conn_.connected)
+        {
+            reused_ = true;
+            return next_request();
+        }
+        connect();
+    }
 
+    void connect()
+    {
         // SSL
         beast::error_code ec{};
-        if (!SSL_set_tlsext_host_name(stream_.native_handle(), host_.c_str()))
+        if (!SSL_set_tlsext_host_name(conn_.stream->native_handle(), host_.c_str()))
         {
             ec.assign(static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category());
+            done_.store(true);
             return fail(ec, "SSL_set_tlsext_host_name");
         }
-        stream_.set_verify_callback(boost::asio::ssl::host_name_verification(host_));
+        conn_.stream->set_verify_callback(boost::asio::ssl::host_name_verification(host_));
 
         resolver_.async_resolve(host_, port_, beast::bind_front_handler(&worker_ssl::on_resolve, shared_from_this()));
     }
@@ -500,11 +545,10 @@ class worker_ssl : public std::enable_shared_from_this<worker_ssl>
             return fail(ec, "resolve");
         }
         // Set a timeout on the operation
-        beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(10));
+        conn_.lowest_layer().expires_after(std::chrono::seconds(10));
         // Make the connection on the IP address we get from a lookup
-        beast::get_lowest_layer(stream_).async_connect(
-          results,
-          beast::bind_front_handler(&worker_ssl::on_connect, shared_from_this()));
+        conn_.lowest_layer().async_connect(results,
+                                           beast::bind_front_handler(&worker_ssl::on_connect, shared_from_this()));
     }
     void on_connect(beast::error_code ec, tcp::resolver::results_type::endpoint_type)
     {
@@ -514,8 +558,9 @@ class worker_ssl : public std::enable_shared_from_this<worker_ssl>
             return fail(ec, "connect");
         }
         // SSL handshake
-        stream_.async_handshake(boost::asio::ssl::stream_base::client,
-                                beast::bind_front_handler(&worker_ssl::on_handshake, shared_from_this()));
+        conn_.lowest_layer().expires_after(std::chrono::seconds(10));
+        conn_.stream->async_handshake(boost::asio::ssl::stream_base::client,
+                                      beast::bind_front_handler(&worker_ssl::on_handshake, shared_from_this()));
     }
 
     void on_handshake(beast::error_code ec)
@@ -525,18 +570,28 @@ class worker_ssl : public std::enable_shared_from_this<worker_ssl>
             done_.store(true);
             return fail(ec, "connect");
         }
+        conn_.connected = true;
+        if (pending_)
+            return send();
+        next_request();
+    }
 
+    void next_request()
+    {
         auto zxy = stash_.get_zxy();
         if (!zxy)
         {
-            beast::get_lowest_layer(stream_).socket().shutdown(tcp::socket::shutdown_both, ec);
-            if (ec && ec != beast::errc::not_connected)
-            {
-                return fail(ec, "shutdown");
-            }
+            // Work is done, keep the connection open for the pool
+            conn_.lowest_layer().expires_never();
             return;
         }
         tile_ = *zxy;
+        pending_ = true;
+        send();
+    }
+
+    void send()
+    {
         auto url =
           boost::urls::format(url_template_,
                               {{"z", std::get<0>(tile_)}, {"x", std::get<1>(tile_)}, {"y", std::get<2>(tile_)}});
@@ -545,21 +600,24 @@ class worker_ssl : public std::enable_shared_from_this<worker_ssl>
         if (!url.query().empty())
             target += "?" + url.query();
         req_.target(target);
-        // std::cerr << "\e[46m target:" << target << " thread:" << std::this_thread::get_id() <<"\e[0m" << std::endl;
-        beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(10));
-        http::async_write(stream_, req_, beast::bind_front_handler(&worker_ssl::on_write, shared_from_this()));
+        conn_.lowest_layer().expires_after(std::chrono::seconds(10));
+        http::async_write(*conn_.stream, req_, beast::bind_front_handler(&worker_ssl::on_write, shared_from_this()));
     }
+
     void on_write(beast::error_code ec, std::size_t bytes_transferred)
     {
         boost::ignore_unused(bytes_transferred);
         if (ec)
         {
-            done_.store(true);
-            return fail(ec, "write");
+            return retry(ec, "write");
         }
         // Receive the HTTP response
         res_ = {};
-        http::async_read(stream_, buffer_, res_, beast::bind_front_handler(&worker_ssl::on_read, shared_from_this()));
+        conn_.lowest_layer().expires_after(std::chrono::seconds(10));
+        http::async_read(*conn_.stream,
+                         buffer_,
+                         res_,
+                         beast::bind_front_handler(&worker_ssl::on_read, shared_from_this()));
     }
 
     void on_read(beast::error_code ec, std::size_t bytes_transferred)
@@ -568,9 +626,11 @@ class worker_ssl : public std::enable_shared_from_this<worker_ssl>
 
         if (ec)
         {
-            done_.store(true);
-            return fail(ec, "read");
+            return retry(ec, "read");
         }
+        pending_ = false;
+        reused_ = false;
+        ++conn_.requests;
         if (res_.result_int() == 200)
         {
             stash_.push_async(
@@ -580,30 +640,131 @@ class worker_ssl : public std::enable_shared_from_this<worker_ssl>
         {
             stash_.push_async(tile_data(std::get<0>(tile_), std::get<1>(tile_), std::get<2>(tile_)));
         }
-        auto zxy = stash_.get_zxy();
-        if (!zxy)
+
+        if (!res_.keep_alive())
         {
-            beast::get_lowest_layer(stream_).socket().shutdown(tcp::socket::shutdown_both, ec);
-            if (ec && ec != beast::errc::not_connected)
-            {
-                return fail(ec, "shutdown");
-            }
-            return;
+            // server closes the connection, reconnect for the remaining tiles
+            close();
+            auto zxy = stash_.get_zxy();
+            if (!zxy)
+                return;
+            tile_ = *zxy;
+            pending_ = true;
+            return connect();
         }
-        tile_ = *zxy;
-        auto url =
-          boost::urls::format(url_template_,
-                              {{"z", std::get<0>(tile_)}, {"x", std::get<1>(tile_)}, {"y", std::get<2>(tile_)}});
-        std::string target = url.path();
-        if (!url.query().empty())
-            target += "?" + url.query();
-        req_.target(target);
-        // std::cerr << "\e[45m target:" << target << " thread:" << std::this_thread::get_id() <<"\e[0m" << std::endl;
-        beast::get_lowest_layer(stream_).expires_after(std::chrono::seconds(10));
+        next_request();
+    }
+
+    // A pooled connection may have been closed by the server while idle,
+    // reconnect once and resend the pending request.
+    void retry(beast::error_code ec, char const* what)
+    {
+        close();
+        if (reused_)
+        {
+            reused_ = false;
+            return connect();
+        }
+        done_.store(true);
+        fail(ec, what);
+    }
 
-        http::async_write(stream_, req_, beast::bind_front_handler(&worker_ssl::on_write, shared_from_this()));
+    void close()
+    {
+        beast::error_code ec;
+        conn_.lowest_layer().socket().shutdown(tcp::socket::shutdown_both, ec);
+        conn_.reset();
+        buffer_.clear();
     }
 };
 
 #endif // MAPNIK_HAS_OPENSSL
+
+namespace xyz_tiles {
+
+inline std::string pool_key(std::string const& scheme, std::string const& host, std::string const& port)
+{
+    return scheme + "://" + host + ":" + port;
+}
+
+// Fetch tiles from the stash over a pooled keep-alive connection, runs on the calling thread
+inline void fetch_tiles(std::string const& host,
+                        std::string const& port,
+                        std::string const& url_template,
+                        tiles_stash& stash,
+                        std::atomic<bool>& done)
+{
+    using pool_type = mapnik::http_connection_pool<mapnik::plain_connection>;
+    std::string const key = pool_key("http", host, port);
+    pool_type::connection_ptr conn = pool_type::instance().acquire(key);
+    if (!conn)
+    {
+        conn = std::make_unique<mapnik::plain_connection>();
+    }
+    conn->ioc.restart();
+    std::make_shared<worker>(*conn, host, port, url_template, stash, done)->run();
+    conn->ioc.run();
+    pool_type::instance().release(key, std::move(conn));
+}
+
+#if defined(MAPNIK_HAS_OPENSSL)
+
+inline boost::asio::ssl::context& ssl_context()
+{
+    static boost::asio::ssl::context ctx{boost::asio::ssl::context::tlsv12_client};
+    return ctx;
+}
+
+inline void fetch_tiles_ssl(std::string const& host,
+                            std::string const& port,
+                            std::string const& url_template,
+                            tiles_stash& stash,
+                            std::atomic<bool>& done)
+{
+    using pool_type = mapnik::http_connection_pool<mapnik::ssl_connection>;
+    std::string const key = pool_key("https", host, port);
+    pool_type::connection_ptr conn = pool_type::instance().acquire(key);
+    if (!conn)
+    {
+        conn = std::make_unique<mapnik::ssl_connection>(ssl_context());
+    }
+    conn->ioc.restart();
+    std::make_shared<worker_ssl>(*conn, host, port, url_template, stash, done)->run();
+    conn->ioc.run();
+    pool_type::instance().release(key, std::move(conn));
+}
+
+#endif // MAPNIK_HAS_OPENSSL
+
+// Apply keep-alive limits to the connection pool serving `url_template`
+inline void set_pool_options(std::string const& url_template, mapnik::http_pool_options const& options)
+{
+    try
+    {
+        boost::urls::url url = boost::urls::format(url_template, {{"z", 0}, {"x", 0}, {"y", 0}});
+        std::string host = url.host();
+        if (url.scheme() == "https")
+        {
+#if defined(MAPNIK_HAS_OPENSSL)
+            std::string port = url.port().empty() ? "443" : std::string(url.port());
+            mapnik::http_connection_pool<mapnik::ssl_connection>::instance().set_options(pool_key("https", host, port),
+                                                                                          options);
+#endif
+        }
+        else if (url.scheme() == "http")
+        {
+            std::string port = url.port().empty() ? "80" : std::string(url.port());
+            mapnik::http_connection_pool<mapnik::plain_connection>::instance().set_options(
+              pool_key("http", host, port),
+              options);
+        }
+    }
+    catch (std::exception const& ex)
+    {
+        MAPNIK_LOG_ERROR(tiles) << "Tiles Plugin: " << ex.what();
+    }
+}
+
+} // namespace xyz_tiles
+
 #endif // XYZ_FEATURESET_HPP
@@ -28,6 +28,7 @@
 #include <mapnik/debug.hpp>
 #include <mapnik/layer.hpp>
 #include <mapnik/label_collision_detector.hpp>
+#include <mapnik/renderer_common/geometry_cache.hpp>
 #include <mapnik/feature_type_style.hpp>
 #include <mapnik/marker.hpp>
 #include <mapnik/marker_cache.hpp>
@@ -70,7 +71,8 @@ agg_renderer<T0, T1>::agg_renderer(Map const& m, T0& pixmap, double scale_factor
       ras_ptr(std::make_unique<rasterizer>()),
       gamma_method_(gamma_method_enum::GAMMA_POWER),
       gamma_(1.0),
-      common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor)
+      common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor),
+      resolved_symbolizers_()
 {
     setup(m, pixmap);
 }
@@ -90,7 +92,8 @@ agg_renderer<T0, T1>::agg_renderer(Map const& m,
       ras_ptr(std::make_unique<rasterizer>()),
       gamma_method_(gamma_method_enum::GAMMA_POWER),
       gamma_(1.0),
-      common_(m, req, vars, offset_x, offset_y, req.width(), req.height(), scale_factor)
+      common_(m, req, vars, offset_x, offset_y, req.width(), req.height(), scale_factor),
+      resolved_symbolizers_()
 {
     setup(m, pixmap);
 }
@@ -109,7 +112,8 @@ agg_renderer<T0, T1>::agg_renderer(Map const& m,
       ras_ptr(std::make_unique<rasterizer>()),
       gamma_method_(gamma_method_enum::GAMMA_POWER),
       gamma_(1.0),
-      common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor, detector)
+      common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor, detector),
+      resolved_symbolizers_()
 {
     setup(m, pixmap);
 }
@@ -217,10 +221,18 @@ void agg_renderer<T0, T1>::start_layer_processing(layer const& lay, box2d<double
     MAPNIK_LOG_DEBUG(agg_renderer) << "agg_renderer: -- datasource=" << lay.datasource().get();
     MAPNIK_LOG_DEBUG(agg_renderer) << "agg_renderer: -- query_extent=" << query_extent;
 
+    // symbolizers are resolved once per layer, styles may change between renders
+    resolved_symbolizers_.clear();
+
     if (lay.clear_label_cache())
     {
         common_.detector_->clear();
     }
+    // feature ids are only unique within a layer
+    if (common_.geometry_cache_)
+    {
+        common_.geometry_cache_->start_layer(lay);
+    }
 
     common_.query_extent_ = query_extent;
     auto&& maximum_extent = lay.maximum_extent();
@@ -320,11 +332,7 @@ void agg_renderer<T0, T1>::end_style_processing(feature_type_style const& st)
         if (st.image_filters().size() > 0)
         {
             blend_from = true;
-            mapnik::filter::filter_visitor<buffer_type> visitor(current_buffer, common_.scale_factor_);
-            for (mapnik::filter::filter_type const& filter_tag : st.image_filters())
-            {
-                util::apply_visitor(visitor, filter_tag);
-            }
+            mapnik::filter::apply_filters(current_buffer, st.image_filters(), common_.scale_factor_);
             mapnik::premultiply_alpha(current_buffer);
         }
         if (st.comp_op())
@@ -353,11 +361,7 @@ void agg_renderer<T0, T1>::end_style_processing(feature_type_style const& st)
     if (st.direct_image_filters().size() > 0)
     {
         // apply any 'direct' image filters
-        mapnik::filter::filter_visitor<buffer_type> visitor(previous_buffer, common_.scale_factor_);
-        for (mapnik::filter::filter_type const& filter_tag : st.direct_image_filters())
-        {
-            util::apply_visitor(visitor, filter_tag);
-        }
+        mapnik::filter::apply_filters(previous_buffer, st.direct_image_filters(), common_.scale_factor_);
         mapnik::premultiply_alpha(previous_buffer);
     }
     MAPNIK_LOG_DEBUG(agg_renderer) << "agg_renderer: End processing style";
@@ -74,7 +74,9 @@ struct thunk_renderer<image_rgba8> : render_thunk_list_dispatch
                src_over,
                common.scale_factor_,
                common.font_manager_.get_stroker())
-    {}
+    {
+        tex_.set_glyph_cache(common.glyph_cache_);
+    }
 
     virtual void operator()(vector_marker_render_thunk const& thunk)
     {
@@ -29,8 +29,9 @@
 #include <mapnik/symbolizer.hpp>
 #include <mapnik/vertex_converters.hpp>
 #include <mapnik/vertex_processor.hpp>
+#include <mapnik/resolved_symbolizer.hpp>
 #include <mapnik/renderer_common/clipping_extent.hpp>
-#include <mapnik/renderer_common/apply_vertex_converter.hpp>
+#include <mapnik/renderer_common/geometry_cache.hpp>
 #include <mapnik/geometry/geometry_type.hpp>
 
 #include <mapnik/warning.hpp>
@@ -53,10 +54,13 @@ MAPNIK_DISABLE_WARNING_POP
 
 namespace mapnik {
 
-template<typename Symbolizer, typename Rasterizer, typename Feature>
-void set_join_caps_aa(Symbolizer const& sym, Rasterizer& ras, Feature& feature, attributes const& vars)
+template<typename Rasterizer>
+void set_join_caps_aa(line_symbolizer_properties const& props,
+                      Rasterizer& ras,
+                      feature_impl const& feature,
+                      attributes const& vars)
 {
-    line_join_enum const join = get<line_join_enum, keys::stroke_linejoin>(sym, feature, vars);
+    line_join_enum const join = props.stroke_linejoin.get(feature, vars);
     switch (join)
     {
         case line_join_enum::MITER_JOIN:
@@ -72,7 +76,7 @@ void set_join_caps_aa(Symbolizer const& sym, Rasterizer& ras, Feature& feature,
             ras.line_join(agg::outline_no_join);
     }
 
-    line_cap_enum const cap = get<line_cap_enum, keys::stroke_linecap>(sym, feature, vars);
+    line_cap_enum const cap = props.stroke_linecap.get(feature, vars);
     switch (cap)
     {
         case line_cap_enum::BUTT_CAP:
@@ -92,14 +96,15 @@ void agg_renderer<T0, T1>::process(line_symbolizer const& sym,
                                    proj_transform const& prj_trans)
 
 {
-    color const& col = get<color, keys::stroke>(sym, feature, common_.vars_);
+    line_symbolizer_properties const& props = resolved_symbolizers_.get(sym, feature, common_.vars_);
+    color const col = props.stroke.get(feature, common_.vars_);
     unsigned const r = col.red();
     unsigned const g = col.green();
     unsigned const b = col.blue();
     unsigned const a = col.alpha();
 
-    double gamma = get<value_double, keys::stroke_gamma>(sym, feature, common_.vars_);
-    gamma_method_enum gamma_method = get<gamma_method_enum, keys::stroke_gamma_method>(sym, feature, common_.vars_);
+    double gamma = props.stroke_gamma.get(feature, common_.vars_);
+    gamma_method_enum gamma_method = props.stroke_gamma_method.get(feature, common_.vars_);
     ras_ptr->reset();
 
     if (gamma != gamma_ || gamma_method != gamma_method_)
@@ -122,24 +127,22 @@ void agg_renderer<T0, T1>::process(line_symbolizer const& sym,
     using renderer_base = agg::renderer_base<pixfmt_comp_type>;
 
     pixfmt_comp_type pixf(buf);
-    pixf.comp_op(static_cast<agg::comp_op_e>(get<composite_mode_e, keys::comp_op>(sym, feature, common_.vars_)));
+    pixf.comp_op(static_cast<agg::comp_op_e>(props.comp_op.get(feature, common_.vars_)));
     renderer_base renb(pixf);
 
     agg::trans_affine tr;
-    auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
-    if (transform)
-        evaluate_transform(tr, feature, common_.vars_, *transform, common_.scale_factor_);
+    if (props.geometry_transform)
+        evaluate_transform(tr, feature, common_.vars_, props.geometry_transform, common_.scale_factor_);
 
     box2d<double> clip_box = clipping_extent(common_);
 
-    value_bool const clip = get<value_bool, keys::clip>(sym, feature, common_.vars_);
-    value_double const width = get<value_double, keys::stroke_width>(sym, feature, common_.vars_);
-    value_double const opacity = get<value_double, keys::stroke_opacity>(sym, feature, common_.vars_);
-    value_double const offset = get<value_double, keys::offset>(sym, feature, common_.vars_);
-    value_double const simplify_tolerance = get<value_double, keys::simplify_tolerance>(sym, feature, common_.vars_);
-    value_double const smooth = get<value_double, keys::smooth>(sym, feature, common_.vars_);
-    line_rasterizer_enum const rasterizer_e =
-      get<line_rasterizer_enum, keys::line_rasterizer>(sym, feature, common_.vars_);
+    value_bool const clip = props.clip.get(feature, common_.vars_);
+    value_double const width = props.stroke_width.get(feature, common_.vars_);
+    value_double const opacity = props.stroke_opacity.get(feature, common_.vars_);
+    value_double const offset = props.offset.get(feature, common_.vars_);
+    value_double const simplify_tolerance = props.simplify_tolerance.get(feature, common_.vars_);
+    value_double const smooth = props.smooth.get(feature, common_.vars_);
+    line_rasterizer_enum const rasterizer_e = props.line_rasterizer.get(feature, common_.vars_);
     if (clip)
     {
         double pad_per_pixel = static_cast<double>(common_.query_extent_.width() / common_.width_);
@@ -150,6 +153,34 @@ void agg_renderer<T0, T1>::process(line_symbolizer const& sym,
         clip_box.pad(padding);
     }
 
+    // the stroke independent part of the converter chain, see geometry_cache
+    using geometry_converter_type =
+      vertex_converter<clip_line_tag, clip_poly_tag, transform_tag, affine_transform_tag, simplify_tag, smooth_tag>;
+    geometry_converter_type
+      converter(clip_box, sym, common_.t_, prj_trans, tr, feature, common_.vars_, common_.scale_factor_);
+    geometry_cache_key::clip_type clip_type = geometry_cache_key::no_clip;
+    if (clip)
+    {
+        geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
+        if (type == geometry::geometry_types::Polygon || type == geometry::geometry_types::MultiPolygon)
+        {
+            converter.template set<clip_poly_tag>();
+            clip_type = geometry_cache_key::clip_poly;
+        }
+        else if (type == geometry::geometry_types::LineString || type == geometry::geometry_types::MultiLineString)
+        {
+            converter.template set<clip_line_tag>();
+            clip_type = geometry_cache_key::clip_line;
+        }
+    }
+    converter.set<transform_tag>();        // always transform
+    converter.set<affine_transform_tag>(); // optional affine transform
+    if (simplify_tolerance > 0.0)
+        converter.set<simplify_tag>(); // optional simplify converter
+    if (smooth > 0.0)
+        converter.set<smooth_tag>(); // optional smooth converter
+    auto make_key = [&] { return geometry_cache_key(feature, clip_type, clip_box, tr, sym, common_.vars_); };
+
     if (rasterizer_e == line_rasterizer_enum::RASTERIZER_FAST)
     {
         using renderer_type = agg::renderer_outline_aa<renderer_base>;
@@ -158,76 +189,28 @@ void agg_renderer<T0, T1>::process(line_symbolizer const& sym,
         renderer_type ren(renb, profile);
         ren.color(agg::rgba8_pre(r, g, b, int(a * opacity)));
         rasterizer_type ras(ren);
-        set_join_caps_aa(sym, ras, feature, common_.vars_);
-
-        using vertex_converter_type = vertex_converter<clip_line_tag,
-                                                       clip_poly_tag,
-                                                       transform_tag,
-                                                       affine_transform_tag,
-                                                       simplify_tag,
-                                                       smooth_tag,
-                                                       offset_transform_tag>;
-        vertex_converter_type
-          converter(clip_box, sym, common_.t_, prj_trans, tr, feature, common_.vars_, common_.scale_factor_);
-        if (clip)
-        {
-            geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
-            if (type == geometry::geometry_types::Polygon || type == geometry::geometry_types::MultiPolygon)
-                converter.template set<clip_poly_tag>();
-            else if (type == geometry::geometry_types::LineString || type == geometry::geometry_types::MultiLineString)
-                converter.template set<clip_line_tag>();
-        }
-        converter.set<transform_tag>(); // always transform
+        set_join_caps_aa(props, ras, feature, common_.vars_);
+
+        vertex_converter<offset_transform_tag>
+          stroke_converter(clip_box, sym, common_.t_, prj_trans, tr, feature, common_.vars_, common_.scale_factor_);
         if (std::fabs(offset) > 0.0)
-            converter.set<offset_transform_tag>(); // parallel offset
-        converter.set<affine_transform_tag>();     // optional affine transform
-        if (simplify_tolerance > 0.0)
-            converter.set<simplify_tag>(); // optional simplify converter
-        if (smooth > 0.0)
-            converter.set<smooth_tag>(); // optional smooth converter
-
-        using apply_vertex_converter_type = detail::apply_vertex_converter<vertex_converter_type, rasterizer_type>;
-        using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
-        apply_vertex_converter_type apply(converter, ras);
-        mapnik::util::apply_visitor(vertex_processor_type(apply), feature.get_geometry());
+            stroke_converter.set<offset_transform_tag>(); // parallel offset
+        apply_geometry_cache(common_.geometry_cache_.get(), make_key, converter, feature, [&](auto& path) {
+            stroke_converter.apply(path, ras);
+        });
     }
     else
     {
-        using vertex_converter_type = vertex_converter<clip_line_tag,
-                                                       clip_poly_tag,
-                                                       transform_tag,
-                                                       affine_transform_tag,
-                                                       simplify_tag,
-                                                       smooth_tag,
-                                                       offset_transform_tag,
-                                                       dash_tag,
-                                                       stroke_tag>;
-        vertex_converter_type
-          converter(clip_box, sym, common_.t_, prj_trans, tr, feature, common_.vars_, common_.scale_factor_);
-        if (clip)
-        {
-            geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
-            if (type == geometry::geometry_types::Polygon || type == geometry::geometry_types::MultiPolygon)
-                converter.template set<clip_poly_tag>();
-            else if (type == geometry::geometry_types::LineString || type == geometry::geometry_types::MultiLineString)
-                converter.template set<clip_line_tag>();
-        }
-        converter.set<transform_tag>(); // always transform
+        vertex_converter<offset_transform_tag, dash_tag, stroke_tag>
+          stroke_converter(clip_box, sym, common_.t_, prj_trans, tr, feature, common_.vars_, common_.scale_factor_);
         if (std::fabs(offset) > 0.0)
-            converter.set<offset_transform_tag>(); // parallel offset
-        converter.set<affine_transform_tag>();     // optional affine transform
-        if (simplify_tolerance > 0.0)
-            converter.set<simplify_tag>(); // optional simplify converter
-        if (smooth > 0.0)
-            converter.set<smooth_tag>(); // optional smooth converter
-        if (has_key(sym, keys::stroke_dasharray))
-            converter.set<dash_tag>();
-        converter.set<stroke_tag>(); // always stroke
-
-        using apply_vertex_converter_type = detail::apply_vertex_converter<vertex_converter_type, rasterizer>;
-        using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
-        apply_vertex_converter_type apply(converter, *ras_ptr);
-        mapnik::util::apply_visitor(vertex_processor_type(apply), feature.get_geometry());
+            stroke_converter.set<offset_transform_tag>(); // parallel offset
+        if (props.has_dasharray)
+            stroke_converter.set<dash_tag>();
+        stroke_converter.set<stroke_tag>(); // always stroke
+        apply_geometry_cache(common_.geometry_cache_.get(), make_key, converter, feature, [&](auto& path) {
+            stroke_converter.apply(path, *ras_ptr);
+        });
 
         using renderer_type = agg::renderer_scanline_aa_solid<renderer_base>;
         renderer_type ren(renb);
@@ -25,6 +25,7 @@
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
 #include <mapnik/agg_render_marker.hpp>
+#include <mapnik/marker_sprite_cache.hpp>
 #include <mapnik/svg/svg_renderer_agg.hpp>
 #include <mapnik/svg/svg_storage.hpp>
 #include <mapnik/svg/svg_path_adapter.hpp>
@@ -67,10 +68,12 @@ struct agg_markers_renderer_context : markers_renderer_context
         : buf_(buf),
           pixf_(buf_),
           renb_(pixf_),
-          ras_(ras)
+          ras_(ras),
+          comp_op_(get<composite_mode_e, keys::comp_op>(sym, feature, vars)),
+          gamma_(get<value_double, keys::gamma>(sym, feature, vars)),
+          gamma_method_(get<gamma_method_enum, keys::gamma_method>(sym, feature, vars))
     {
-        auto comp_op = get<composite_mode_e, keys::comp_op>(sym, feature, vars);
-        pixf_.comp_op(static_cast<agg::comp_op_e>(comp_op));
+        pixf_.comp_op(static_cast<agg::comp_op_e>(comp_op_));
     }
 
     virtual void render_marker(svg_path_ptr const& src,
@@ -79,6 +82,12 @@ struct agg_markers_renderer_context : markers_renderer_context
                                markers_dispatch_params const& params,
                                agg::trans_affine const& marker_tr)
     {
+        // paths are composited one by one, a sprite only gives the same result with src-over
+        if (comp_op_ == src_over && marker_sprite_cache::instance().capacity() > 0 &&
+            render_sprite(src, path, group_attrs, params, marker_tr))
+        {
+            return;
+        }
         SvgRenderer svg_renderer(path, group_attrs);
         render_vector_marker(svg_renderer,
                              ras_,
@@ -98,10 +107,77 @@ struct agg_markers_renderer_context : markers_renderer_context
     }
 
   private:
+    // Blit the marker from its cached sprite, false if it's too large for a sprite
+    bool render_sprite(svg_path_ptr const& src,
+                       svg_path_adapter& path,
+                       svg::group const& group_attrs,
+                       markers_dispatch_params const& params,
+                       agg::trans_affine const& marker_tr)
+    {
+        constexpr int steps = marker_sprite_cache::subpixel_steps;
+        agg::trans_affine tr = marker_tr;
+        if (params.snap_to_pixels)
+        {
+            tr.tx = std::floor(tr.tx + .5);
+            tr.ty = std::floor(tr.ty + .5);
+        }
+        else
+        {
+            tr.tx = std::floor(tr.tx * steps + .5) / steps;
+            tr.ty = std::floor(tr.ty * steps + .5) / steps;
+        }
+        double const x = std::floor(tr.tx);
+        double const y = std::floor(tr.ty);
+        marker_sprite_cache& cache = marker_sprite_cache::instance();
+        marker_sprite_key const key(src, group_attrs, tr, gamma_, static_cast<int>(gamma_method_));
+        marker_sprite_ptr sprite = cache.find(key);
+        if (!sprite)
+        {
+            tr.tx -= x;
+            tr.ty -= y;
+            box2d<double> extent = src->bounding_box() * tr;
+            // antialiasing covers the pixels around the edges
+            extent.pad(marker_stroke_extent(group_attrs, tr) + 1.0);
+            int const x0 = static_cast<int>(std::floor(extent.minx()));
+            int const y0 = static_cast<int>(std::floor(extent.miny()));
+            int const width = static_cast<int>(std::ceil(extent.maxx())) - x0;
+            int const height = static_cast<int>(std::ceil(extent.maxy())) - y0;
+            if (width <= 0 || height <= 0 || width > static_cast<int>(marker_sprite_cache::max_sprite_size) ||
+                height > static_cast<int>(marker_sprite_cache::max_sprite_size))
+            {
+                return false;
+            }
+            marker_sprite result{image_rgba8(width, height, true, true), x0, y0};
+            agg::rendering_buffer buf(result.image.bytes(), width, height, result.image.row_size());
+            pixfmt_type pixf(buf);
+            pixf.comp_op(agg::comp_op_src_over);
+            renderer_base renb(pixf);
+            RasterizerType ras;
+            ras.clip_box(0, 0, width, height);
+            RasterizerType* ras_ptr = &ras;
+            set_gamma_method(ras_ptr, gamma_, gamma_method_);
+            tr.translate(-x0, -y0);
+            SvgRenderer svg_renderer(path, group_attrs);
+            render_vector_marker(svg_renderer, ras, renb, src->bounding_box(), tr, 1.0, false);
+            sprite = cache.insert(key, std::move(result));
+        }
+        render_raster_marker(renb_,
+                             ras_,
+                             sprite->image,
+                             agg::trans_affine_translation(x + sprite->x, y + sprite->y),
+                             params.opacity,
+                             1.0,
+                             false);
+        return true;
+    }
+
     BufferType& buf_;
     pixfmt_type pixf_;
     renderer_base renb_;
     RasterizerType& ras_;
+    composite_mode_e comp_op_;
+    double gamma_;
+    gamma_method_enum gamma_method_;
 };
 
 } // namespace detail
@@ -54,10 +54,10 @@ void agg_renderer<T0, T1>::process(polygon_symbolizer const& sym,
     using vertex_converter_type =
       vertex_converter<clip_poly_tag, transform_tag, affine_transform_tag, simplify_tag, smooth_tag>;
 
+    polygon_symbolizer_properties const& props = resolved_symbolizers_.get(sym, feature, common_.vars_);
     ras_ptr->reset();
-    double const gamma = get<value_double>(sym, keys::gamma, feature, common_.vars_, 1.0);
-    gamma_method_enum gamma_method =
-      get<gamma_method_enum>(sym, keys::gamma_method, feature, common_.vars_, gamma_method_enum::GAMMA_POWER);
+    double const gamma = props.gamma.get(feature, common_.vars_);
+    gamma_method_enum gamma_method = props.gamma_method.get(feature, common_.vars_);
     if (gamma != gamma_ || gamma_method != gamma_method_)
     {
         set_gamma_method(ras_ptr, gamma, gamma_method);
@@ -74,6 +74,7 @@ void agg_renderer<T0, T1>::process(polygon_symbolizer const& sym,
     box2d<double> clip_box = clipping_extent(common_);
     render_polygon_symbolizer<vertex_converter_type>(
       sym,
+      props,
       feature,
       prj_trans,
       common_,
@@ -91,8 +92,7 @@ void agg_renderer<T0, T1>::process(polygon_symbolizer const& sym,
           using renderer_base = agg::renderer_base<pixfmt_comp_type>;
           using renderer_type = agg::renderer_scanline_aa_solid<renderer_base>;
           pixfmt_comp_type pixf(buf);
-          pixf.comp_op(
-            static_cast<agg::comp_op_e>(get<composite_mode_e>(sym, keys::comp_op, feature, common_.vars_, src_over)));
+          pixf.comp_op(static_cast<agg::comp_op_e>(props.comp_op.get(feature, common_.vars_)));
           renderer_base renb(pixf);
           renderer_type ren(renb);
           ren.color(agg::rgba8_pre(r, g, b, int(a * opacity)));
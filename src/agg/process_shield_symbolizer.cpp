@@ -71,6 +71,7 @@ void agg_renderer<T0, T1>::process(shield_symbolizer const& sym,
                               halo_comp_op,
                               common_.scale_factor_,
                               common_.font_manager_.get_stroker());
+    ren.set_glyph_cache(common_.glyph_cache_);
 
     double const opacity = get<double>(sym, keys::opacity, feature, common_.vars_, 1.0);
 
@@ -71,6 +71,7 @@ void agg_renderer<T0, T1>::process(text_symbolizer const& sym,
                               halo_comp_op,
                               common_.scale_factor_,
                               common_.font_manager_.get_stroker());
+    ren.set_glyph_cache(common_.glyph_cache_);
 
     auto const halo_transform = get_optional<transform_type>(sym, keys::halo_transform);
     if (halo_transform)
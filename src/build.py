@@ -80,6 +80,9 @@ if '-DHAVE_PNG' in env['CPPDEFINES']:
    lib_env['LIBS'].append('png')
    enabled_imaging_libraries.append('png_reader.cpp')
 
+if '-DHAVE_LIBDEFLATE' in env['CPPDEFINES']:
+   lib_env['LIBS'].append('deflate')
+
 if '-DMAPNIK_USE_PROJ' in env['CPPDEFINES']:
    lib_env['LIBS'].append('proj')
    lib_env['LIBS'].append('sqlite3')
@@ -181,6 +184,7 @@ source = Split(
     conversions_string.cpp
     image_copy.cpp
     image_compositing.cpp
+    image_simd.cpp
     image_scaling.cpp
     datasource_cache.cpp
     datasource_cache_static.cpp
@@ -196,9 +200,12 @@ source = Split(
     expression.cpp
     transform_expression.cpp
     transform_expression_grammar_x3.cpp
+    feature_arena.cpp
     feature_kv_iterator.cpp
+    feature_query_cache.cpp
     feature_style_processor.cpp
     feature_type_style.cpp
+    filter_program.cpp
     dasharray_parser.cpp
     font_engine_freetype.cpp
     font_set.cpp
@@ -207,6 +214,7 @@ source = Split(
     path_expression_grammar_x3.cpp
     parse_path.cpp
     image_reader.cpp
+    image_reader_pool.cpp
     cairo_io.cpp
     image.cpp
     image_view.cpp
@@ -216,6 +224,7 @@ source = Split(
     image_util.cpp
     image_util_jpeg.cpp
     image_util_png.cpp
+    png_encoder.cpp
     image_util_tiff.cpp
     image_util_webp.cpp
     layer.cpp
@@ -223,6 +232,7 @@ source = Split(
     load_map.cpp
     palette.cpp
     marker_helpers.cpp
+    marker_sprite_cache.cpp
     plugin.cpp
     rule.cpp
     save_map.cpp
@@ -242,6 +252,8 @@ source = Split(
     raster_colorizer.cpp
     mapped_memory_cache.cpp
     marker_cache.cpp
+    thread_pool.cpp
+    tiff_block_cache.cpp
     css/css_color_grammar_x3.cpp
     css/css_grammar_x3.cpp
     svg/svg_parser.cpp
@@ -250,13 +262,16 @@ source = Split(
     svg/svg_transform_parser.cpp
     svg/svg_path_grammar_x3.cpp
     warp.cpp
+    warp_mesh_cache.cpp
     vertex_cache.cpp
     vertex_adapters.cpp
     text/font_library.cpp
+    text/glyph_cache.cpp
     text/text_layout.cpp
     text/text_line.cpp
     text/itemizer.cpp
     text/scrptrun.cpp
+    text/shaping_cache.cpp
     text/face.cpp
     text/glyph_positions.cpp
     text/placement_finder.cpp
@@ -284,10 +299,12 @@ source = Split(
     config_error.cpp
     color_factory.cpp
     renderer_common.cpp
+    resolved_symbolizer.cpp
     renderer_common/render_group_symbolizer.cpp
     renderer_common/render_markers_symbolizer.cpp
     renderer_common/render_pattern.cpp
     renderer_common/render_thunk_extractor.cpp
+    renderer_common/geometry_cache.cpp
     renderer_common/pattern_alignment.cpp
     util/math.cpp
     util/mapped_memory_file.cpp
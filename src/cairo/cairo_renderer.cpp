@@ -34,6 +34,7 @@
 #include <mapnik/attribute.hpp>
 #include <mapnik/request.hpp>
 #include <mapnik/label_collision_detector.hpp>
+#include <mapnik/renderer_common/geometry_cache.hpp>
 #include <mapnik/marker.hpp>
 #include <mapnik/marker_cache.hpp>
 #include <mapnik/feature_type_style.hpp>
@@ -58,6 +59,7 @@ cairo_renderer<T>::cairo_renderer(Map const& m,
       m_(m),
       context_(cairo),
       common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor),
+      resolved_symbolizers_(),
       face_manager_(common_.shared_font_library_),
       style_level_compositing_(false)
 {
@@ -76,6 +78,7 @@ cairo_renderer<T>::cairo_renderer(Map const& m,
       m_(m),
       context_(cairo),
       common_(m, req, vars, offset_x, offset_y, req.width(), req.height(), scale_factor),
+      resolved_symbolizers_(),
       face_manager_(common_.shared_font_library_),
       style_level_compositing_(false)
 
@@ -94,6 +97,7 @@ cairo_renderer<T>::cairo_renderer(Map const& m,
       m_(m),
       context_(cairo),
       common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor, detector),
+      resolved_symbolizers_(),
       face_manager_(common_.shared_font_library_),
       style_level_compositing_(false)
 
@@ -184,10 +188,18 @@ void cairo_renderer<T>::start_layer_processing(layer const& lay, box2d<double> c
     MAPNIK_LOG_DEBUG(cairo_renderer) << "cairo_renderer: -- datasource=" << lay.datasource().get();
     MAPNIK_LOG_DEBUG(cairo_renderer) << "cairo_renderer: -- query_extent=" << query_extent;
 
+    // symbolizers are resolved once per layer, styles may change between renders
+    resolved_symbolizers_.clear();
+
     if (lay.clear_label_cache())
     {
         common_.detector_->clear();
     }
+    // feature ids are only unique within a layer
+    if (common_.geometry_cache_)
+    {
+        common_.geometry_cache_->start_layer(lay);
+    }
     common_.query_extent_ = query_extent;
 
     if (lay.comp_op() || lay.get_opacity() < 1.0)
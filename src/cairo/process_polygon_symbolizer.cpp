@@ -38,11 +38,12 @@ void cairo_renderer<T>::process(polygon_symbolizer const& sym,
 {
     using vertex_converter_type =
       vertex_converter<clip_poly_tag, transform_tag, affine_transform_tag, simplify_tag, smooth_tag>;
+    polygon_symbolizer_properties const& props = resolved_symbolizers_.get(sym, feature, common_.vars_);
     cairo_save_restore guard(context_);
-    composite_mode_e comp_op = get<composite_mode_e, keys::comp_op>(sym, feature, common_.vars_);
-    context_.set_operator(comp_op);
+    context_.set_operator(props.comp_op.get(feature, common_.vars_));
 
     render_polygon_symbolizer<vertex_converter_type>(sym,
+                                                     props,
                                                      feature,
                                                      prj_trans,
                                                      common_,
@@ -21,6 +21,7 @@
  *****************************************************************************/
 
 // mapnik
+#include <mapnik/boolean.hpp>
 #include <mapnik/debug.hpp>
 #include <mapnik/datasource.hpp>
 #include <mapnik/datasource_cache.hpp>
@@ -41,6 +42,7 @@ MAPNIK_DISABLE_WARNING_POP
 
 // stl
 #include <algorithm>
+#include <exception>
 #include <map>
 #include <stdexcept>
 
@@ -56,10 +58,138 @@ bool is_input_plugin(std::string const& filename)
     return boost::algorithm::ends_with(filename, std::string(".input"));
 }
 
+namespace {
+
+// parameters serialized with their value types, so "1" and 1 give different keys
+struct shared_key_appender
+{
+    std::string& key;
+
+    void operator()(value_null) const {}
+    void operator()(std::string const& val) const { key += val; }
+    void operator()(value_bool val) const { key += val ? '1' : '0'; }
+    template<typename T>
+    void operator()(T val) const
+    {
+        key.append(reinterpret_cast<char const*>(&val), sizeof(val));
+    }
+};
+
+std::string shared_key(parameters const& params)
+{
+    std::string key;
+    for (auto const& kv : params)
+    {
+        key += kv.first;
+        key += '\0';
+        key += static_cast<char>(kv.second.which());
+        util::apply_visitor(shared_key_appender{key}, kv.second);
+        key += '\0';
+    }
+    return key;
+}
+
+} // namespace
+
 datasource_cache::datasource_cache() {}
 datasource_cache::~datasource_cache() {}
 
 datasource_ptr datasource_cache::create(parameters const& params)
+{
+    auto const shared = params.get<mapnik::boolean_type>("shared");
+    if (shared && *shared)
+    {
+        return create_shared(params);
+    }
+    return create_datasource(params);
+}
+
+datasource_ptr datasource_cache::create_shared(parameters const& params)
+{
+    std::string const key = shared_key(params);
+    std::promise<datasource_ptr> promise;
+    std::shared_future<datasource_ptr> pending;
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+#endif
+        auto itr = shared_.find(key);
+        if (itr != shared_.end())
+        {
+            if (datasource_ptr ds = itr->second.lock())
+            {
+                return ds;
+            }
+            shared_.erase(itr);
+        }
+        auto pending_itr = pending_.find(key);
+        if (pending_itr != pending_.end())
+        {
+            pending = pending_itr->second;
+        }
+        else
+        {
+            pending_.emplace(key, promise.get_future().share());
+        }
+    }
+    if (pending.valid())
+    {
+        // another thread is creating it, get() rethrows its exception
+        return pending.get();
+    }
+
+    datasource_ptr ds;
+    try
+    {
+        ds = create_datasource(params);
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+#endif
+        pending_.erase(key);
+        throw;
+    }
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+#endif
+        // forget the datasources nothing holds anymore
+        std::erase_if(shared_, [](auto const& kv) { return kv.second.expired(); });
+        shared_[key] = ds;
+        pending_.erase(key);
+    }
+    promise.set_value(ds);
+    return ds;
+}
+
+bool datasource_cache::release_shared(parameters const& params)
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+#endif
+    return shared_.erase(shared_key(params)) > 0;
+}
+
+void datasource_cache::clear_shared()
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+#endif
+    shared_.clear();
+}
+
+std::size_t datasource_cache::shared_size() const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+#endif
+    return std::count_if(shared_.begin(), shared_.end(), [](auto const& kv) { return !kv.second.expired(); });
+}
+
+datasource_ptr datasource_cache::create_datasource(parameters const& params)
 {
     auto const type = params.get<std::string>("type");
     if (!type.has_value())
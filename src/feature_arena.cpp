@@ -0,0 +1,90 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/feature_arena.hpp>
+
+// stl
+#include <algorithm>
+#include <cstdint>
+
+namespace mapnik {
+
+namespace {
+thread_local feature_arena::scope* current_scope = nullptr;
+}
+
+feature_arena::feature_arena()
+    : blocks_(),
+      ptr_(nullptr),
+      space_(0),
+      allocated_(0)
+{}
+
+feature_arena::~feature_arena() {}
+
+void* feature_arena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(ptr_) % alignment) % alignment;
+    if (ptr_ == nullptr || padding + bytes > space_)
+    {
+        // oversized requests get a block of their own
+        std::size_t size = std::max(block_size, bytes + alignment);
+        blocks_.emplace_back(new std::byte[size]);
+        ptr_ = blocks_.back().get();
+        space_ = size;
+        padding = (alignment - reinterpret_cast<std::uintptr_t>(ptr_) % alignment) % alignment;
+    }
+    void* result = ptr_ + padding;
+    ptr_ += padding + bytes;
+    space_ -= padding + bytes;
+    allocated_ += bytes;
+    return result;
+}
+
+feature_arena::scope::scope(bool enabled, std::size_t capacity)
+    : arena_(enabled ? std::make_shared<feature_arena>() : nullptr),
+      capacity_(capacity),
+      previous_(current_scope)
+{
+    current_scope = this;
+}
+
+feature_arena::scope::~scope()
+{
+    current_scope = previous_;
+}
+
+std::shared_ptr<feature_arena> feature_arena::current()
+{
+    scope* s = current_scope;
+    if (s == nullptr || !s->arena_)
+        return nullptr;
+    if (s->arena_->allocated() >= s->capacity_)
+    {
+        // the previous arena is released together with the last of its features
+        s->arena_ = std::make_shared<feature_arena>();
+    }
+    return s->arena_;
+}
+
+} // namespace mapnik
@@ -0,0 +1,186 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/feature_query_cache.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/memory_datasource.hpp>
+
+// stl
+#include <algorithm>
+
+namespace mapnik {
+
+namespace {
+
+// Datasources filled in code (memory datasources, python) don't describe their
+// features through their parameters and are only shared with themselves.
+bool same_data(datasource const& lhs, datasource const& rhs)
+{
+    if (&lhs == &rhs)
+        return true;
+    std::optional<std::string> type = lhs.params().get<std::string>("type");
+    if (!type || *type == memory_datasource::name())
+        return false;
+    return lhs == rhs;
+}
+
+bool answers(query const& cached, query const& q)
+{
+    return cached.resolution() == q.resolution() && cached.scale_denominator() == q.scale_denominator() &&
+           cached.get_filter_factor() == q.get_filter_factor() &&
+           cached.get_unbuffered_bbox() == q.get_unbuffered_bbox() && cached.get_bbox().contains(q.get_bbox()) &&
+           std::includes(cached.property_names().begin(),
+                         cached.property_names().end(),
+                         q.property_names().begin(),
+                         q.property_names().end()) &&
+           cached.variables() == q.variables();
+}
+
+} // namespace
+
+feature_query_cache::feature_query_cache()
+    : entries_(),
+      hits_(0),
+      misses_(0)
+{}
+
+feature_query_cache::lookup feature_query_cache::find(datasource const& ds, query const& q) const
+{
+    lookup result{nullptr, q.get_bbox(), false};
+    if (ds.type() != datasource::Vector)
+    {
+        return result;
+    }
+    for (std::shared_ptr<entry> const& e : entries_)
+    {
+        if (same_data(*e->ds, ds) && answers(e->q, q))
+        {
+            result.source = e;
+            result.filter = !(e->q.get_bbox() == q.get_bbox());
+            // prefer an exact match, it needs no filtering
+            if (!result.filter)
+                break;
+        }
+    }
+    return result;
+}
+
+feature_query_cache::lookup feature_query_cache::reserve(datasource_ptr const& ds, query const& q)
+{
+    lookup result = find(*ds, q);
+    if (result.source)
+    {
+        ++hits_;
+        ++result.source->readers;
+        return result;
+    }
+    ++misses_;
+    result = make_lookup(ds, q, result_type());
+    if (ds->type() == datasource::Vector)
+    {
+        entries_.push_back(result.source);
+    }
+    return result;
+}
+
+void feature_query_cache::release(lookup const& l)
+{
+    entry& e = *l.source;
+    if (e.readers > 1)
+    {
+        --e.readers;
+        return;
+    }
+    e.readers = 0;
+    e.features = result_type();
+    std::vector<box2d<double>>().swap(e.envelopes);
+    entries_.erase(std::remove(entries_.begin(), entries_.end(), l.source), entries_.end());
+}
+
+void feature_query_cache::clear()
+{
+    entries_.clear();
+}
+
+feature_query_cache::lookup
+  feature_query_cache::make_lookup(datasource_ptr const& ds, query const& q, result_type features)
+{
+    return lookup{std::make_shared<entry>(entry{ds, q, std::move(features), {}, 1}), q.get_bbox(), false};
+}
+
+std::shared_ptr<feature_query_cache::feature_list const> feature_query_cache::collect(featureset_ptr const& features)
+{
+    std::shared_ptr<feature_list> list = std::make_shared<feature_list>();
+    if (features)
+    {
+        feature_ptr feature;
+        while ((feature = features->next()))
+        {
+            list->push_back(std::move(feature));
+        }
+    }
+    return list;
+}
+
+feature_query_cache::result_type feature_query_cache::make_ready(std::shared_ptr<feature_list const> features)
+{
+    std::promise<std::shared_ptr<feature_list const>> promise;
+    promise.set_value(std::move(features));
+    return promise.get_future().share();
+}
+
+std::shared_ptr<featureset_buffer> feature_query_cache::features(lookup const& l)
+{
+    entry& source = *l.source;
+    feature_list const& features = *source.features.get();
+    std::shared_ptr<featureset_buffer> buffer = std::make_shared<featureset_buffer>();
+    if (!l.filter)
+    {
+        for (feature_ptr const& feature : features)
+        {
+            buffer->push(feature);
+        }
+        return buffer;
+    }
+    if (source.envelopes.size() != features.size())
+    {
+        source.envelopes.clear();
+        source.envelopes.reserve(features.size());
+        for (feature_ptr const& feature : features)
+        {
+            source.envelopes.push_back(feature->envelope());
+        }
+    }
+    for (std::size_t i = 0; i < features.size(); ++i)
+    {
+        // features without geometry were not selected by their extent
+        box2d<double> const& envelope = source.envelopes[i];
+        if (!envelope.valid() || envelope.intersects(l.bbox))
+        {
+            buffer->push(features[i]);
+        }
+    }
+    return buffer;
+}
+
+} // namespace mapnik
@@ -0,0 +1,313 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/filter_program.hpp>
+#include <mapnik/expression_node.hpp>
+#include <mapnik/util/variant.hpp>
+#include <mapnik/util/geometry_to_ds_type.hpp>
+
+// stl
+#include <algorithm>
+#include <cstdio>
+
+namespace mapnik {
+
+struct filter_compiler
+{
+    using opcode = filter_program::opcode;
+    using instruction = filter_program::instruction;
+
+    explicit filter_compiler(filter_program& program)
+        : program_(program)
+    {}
+
+    std::uint32_t constant(std::string const& key, value&& val) const
+    {
+        auto itr = program_.keys_.find(key);
+        if (itr != program_.keys_.end())
+            return itr->second;
+        program_.constants_.push_back(std::move(val));
+        return program_.emit(key, {opcode::constant, 0, 0, std::uint32_t(program_.constants_.size() - 1), nullptr});
+    }
+
+    std::uint32_t operator()(value_null) const { return constant("null", value_null()); }
+
+    std::uint32_t operator()(value_bool val) const { return constant(val ? "true" : "false", val); }
+
+    std::uint32_t operator()(value_integer val) const { return constant("i:" + std::to_string(val), val); }
+
+    std::uint32_t operator()(value_double val) const
+    {
+        // exact representation, 0.1 and 0.10000000000000001 are different constants
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "d:%a", val);
+        return constant(buf, val);
+    }
+
+    std::uint32_t operator()(value_unicode_string const& str) const
+    {
+        std::string utf8;
+        str.toUTF8String(utf8);
+        return constant("s:" + utf8, str);
+    }
+
+    std::uint32_t operator()(attribute const& attr) const
+    {
+        return named(opcode::attribute, "a:", attr.name(), program_.attribute_names_);
+    }
+
+    std::uint32_t operator()(global_attribute const& attr) const
+    {
+        return named(opcode::global_attribute, "g:", attr.name, program_.global_names_);
+    }
+
+    std::uint32_t operator()(geometry_type_attribute const&) const
+    {
+        return program_.emit("geometry_type", {opcode::geometry_type, 0, 0, 0, nullptr});
+    }
+
+    std::uint32_t operator()(unary_node<tags::negate> const& x) const { return unary(opcode::negate, x.expr); }
+    std::uint32_t operator()(unary_node<tags::logical_not> const& x) const
+    {
+        return unary(opcode::logical_not, x.expr);
+    }
+    std::uint32_t operator()(binary_node<tags::plus> const& x) const { return binary(opcode::plus, x); }
+    std::uint32_t operator()(binary_node<tags::minus> const& x) const { return binary(opcode::minus, x); }
+    std::uint32_t operator()(binary_node<tags::mult> const& x) const { return binary(opcode::mult, x); }
+    std::uint32_t operator()(binary_node<tags::div> const& x) const { return binary(opcode::div, x); }
+    std::uint32_t operator()(binary_node<tags::mod> const& x) const { return binary(opcode::mod, x); }
+    std::uint32_t operator()(binary_node<tags::less> const& x) const { return binary(opcode::less, x); }
+    std::uint32_t operator()(binary_node<tags::less_equal> const& x) const { return binary(opcode::less_equal, x); }
+    std::uint32_t operator()(binary_node<tags::greater> const& x) const { return binary(opcode::greater, x); }
+    std::uint32_t operator()(binary_node<tags::greater_equal> const& x) const
+    {
+        return binary(opcode::greater_equal, x);
+    }
+    std::uint32_t operator()(binary_node<tags::equal_to> const& x) const { return binary(opcode::equal_to, x); }
+    std::uint32_t operator()(binary_node<tags::not_equal_to> const& x) const { return binary(opcode::not_equal_to, x); }
+    std::uint32_t operator()(binary_node<tags::logical_and> const& x) const { return binary(opcode::logical_and, x); }
+    std::uint32_t operator()(binary_node<tags::logical_or> const& x) const { return binary(opcode::logical_or, x); }
+
+    std::uint32_t operator()(regex_match_node const& x) const
+    {
+        std::uint32_t arg = util::apply_visitor(*this, x.expr);
+        return program_.emit(key(opcode::regex_match, arg, 0) + x.to_string(),
+                             {opcode::regex_match, arg, 0, 0, &x});
+    }
+
+    std::uint32_t operator()(regex_replace_node const& x) const
+    {
+        std::uint32_t arg = util::apply_visitor(*this, x.expr);
+        return program_.emit(key(opcode::regex_replace, arg, 0) + x.to_string(),
+                             {opcode::regex_replace, arg, 0, 0, &x});
+    }
+
+    // std::function targets can't be compared, calls are only shared when they're the same AST node
+    std::uint32_t operator()(unary_function_call const& call) const
+    {
+        std::uint32_t arg = util::apply_visitor(*this, call.arg);
+        return program_.emit(key(opcode::unary_function, arg, 0) + pointer_key(&call),
+                             {opcode::unary_function, arg, 0, 0, &call});
+    }
+
+    std::uint32_t operator()(binary_function_call const& call) const
+    {
+        std::uint32_t arg1 = util::apply_visitor(*this, call.arg1);
+        std::uint32_t arg2 = util::apply_visitor(*this, call.arg2);
+        return program_.emit(key(opcode::binary_function, arg1, arg2) + pointer_key(&call),
+                             {opcode::binary_function, arg1, arg2, 0, &call});
+    }
+
+  private:
+    static std::string key(opcode op, std::uint32_t left, std::uint32_t right)
+    {
+        return std::to_string(static_cast<int>(op)) + "(" + std::to_string(left) + "," + std::to_string(right) + ")";
+    }
+
+    static std::string pointer_key(void const* ptr)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%p", ptr);
+        return buf;
+    }
+
+    std::uint32_t named(opcode op, char const* prefix, std::string const& name, std::vector<std::string>& names) const
+    {
+        std::string k = prefix + name;
+        auto itr = program_.keys_.find(k);
+        if (itr != program_.keys_.end())
+            return itr->second;
+        names.push_back(name);
+        return program_.emit(k, {op, 0, 0, std::uint32_t(names.size() - 1), nullptr});
+    }
+
+    std::uint32_t unary(opcode op, expr_node const& expr) const
+    {
+        std::uint32_t arg = util::apply_visitor(*this, expr);
+        return program_.emit(key(op, arg, 0), {op, arg, 0, 0, nullptr});
+    }
+
+    template<typename Node>
+    std::uint32_t binary(opcode op, Node const& x) const
+    {
+        std::uint32_t left = util::apply_visitor(*this, x.left);
+        std::uint32_t right = util::apply_visitor(*this, x.right);
+        return program_.emit(key(op, left, right), {op, left, right, 0, nullptr});
+    }
+
+    filter_program& program_;
+};
+
+std::uint32_t filter_program::add(expression_ptr const& expr)
+{
+    expressions_.push_back(expr);
+    return util::apply_visitor(filter_compiler(*this), *expr);
+}
+
+std::uint32_t filter_program::emit(std::string const& key, instruction const& ins)
+{
+    auto itr = keys_.find(key);
+    if (itr != keys_.end())
+        return itr->second;
+    std::uint32_t index = static_cast<std::uint32_t>(instructions_.size());
+    instructions_.push_back(ins);
+    keys_.emplace(key, index);
+    return index;
+}
+
+filter_program::evaluator::evaluator(filter_program const& program, attributes const& vars)
+    : program_(program),
+      globals_(),
+      attribute_index_(program.attribute_names_.size(), context_type::npos),
+      values_(program.instructions_.size()),
+      stamps_(program.instructions_.size(), 0)
+{
+    globals_.reserve(program.global_names_.size());
+    for (auto const& name : program.global_names_)
+    {
+        auto itr = vars.find(name);
+        globals_.push_back(itr != vars.end() ? itr->second : value());
+    }
+}
+
+void filter_program::evaluator::bind(context_type const& ctx)
+{
+    std::size_t index = 0;
+    for (auto const& name : program_.attribute_names_)
+    {
+        attribute_index_[index++] = ctx.index_of(name);
+    }
+    context_ = &ctx;
+    context_size_ = ctx.size();
+}
+
+void filter_program::evaluator::start(feature_impl const& feature)
+{
+    context_type const& ctx = feature.get_context();
+    // contexts can grow (feature_impl::put_new), re-resolve names when they do
+    if (&ctx != context_ || ctx.size() != context_size_)
+    {
+        bind(ctx);
+    }
+    feature_ = &feature;
+    if (++generation_ == 0)
+    {
+        // wrapped around, invalidate everything
+        std::fill(stamps_.begin(), stamps_.end(), 0);
+        generation_ = 1;
+    }
+}
+
+value const& filter_program::evaluator::eval(std::uint32_t index)
+{
+    instruction const& ins = program_.instructions_[index];
+    switch (ins.op)
+    {
+        case opcode::constant:
+            return program_.constants_[ins.data];
+        case opcode::attribute:
+            return feature_->get(attribute_index_[ins.data]);
+        case opcode::global_attribute:
+            return globals_[ins.data];
+        default:
+            break;
+    }
+    if (stamps_[index] != generation_)
+    {
+        values_[index] = compute(ins);
+        stamps_[index] = generation_;
+    }
+    return values_[index];
+}
+
+value filter_program::evaluator::compute(instruction const& ins)
+{
+    switch (ins.op)
+    {
+        case opcode::geometry_type:
+            return static_cast<value_integer>(util::to_ds_type(feature_->get_geometry()));
+        case opcode::negate:
+            return make_op<tags::negate>::type()(eval(ins.left));
+        case opcode::plus:
+            return make_op<tags::plus>::type()(eval(ins.left), eval(ins.right));
+        case opcode::minus:
+            return make_op<tags::minus>::type()(eval(ins.left), eval(ins.right));
+        case opcode::mult:
+            return make_op<tags::mult>::type()(eval(ins.left), eval(ins.right));
+        case opcode::div:
+            return make_op<tags::div>::type()(eval(ins.left), eval(ins.right));
+        case opcode::mod:
+            return make_op<tags::mod>::type()(eval(ins.left), eval(ins.right));
+        case opcode::less:
+            return make_op<tags::less>::type()(eval(ins.left), eval(ins.right));
+        case opcode::less_equal:
+            return make_op<tags::less_equal>::type()(eval(ins.left), eval(ins.right));
+        case opcode::greater:
+            return make_op<tags::greater>::type()(eval(ins.left), eval(ins.right));
+        case opcode::greater_equal:
+            return make_op<tags::greater_equal>::type()(eval(ins.left), eval(ins.right));
+        case opcode::equal_to:
+            return make_op<tags::equal_to>::type()(eval(ins.left), eval(ins.right));
+        case opcode::not_equal_to:
+            return make_op<tags::not_equal_to>::type()(eval(ins.left), eval(ins.right));
+        case opcode::logical_not:
+            return !eval(ins.left).to_bool();
+        case opcode::logical_and:
+            return eval(ins.left).to_bool() && eval(ins.right).to_bool();
+        case opcode::logical_or:
+            return eval(ins.left).to_bool() || eval(ins.right).to_bool();
+        case opcode::regex_match:
+            return static_cast<regex_match_node const*>(ins.node)->apply(eval(ins.left));
+        case opcode::regex_replace:
+            return static_cast<regex_replace_node const*>(ins.node)->apply(eval(ins.left));
+        case opcode::unary_function:
+            return static_cast<unary_function_call const*>(ins.node)->fun(eval(ins.left));
+        case opcode::binary_function:
+            return static_cast<binary_function_call const*>(ins.node)->fun(eval(ins.left), eval(ins.right));
+        default:
+            break;
+    }
+    return value();
+}
+
+} // namespace mapnik
@@ -130,6 +130,31 @@ std::vector<std::string> list_directory(std::string const& dir)
     return listing;
 }
 
+std::optional<file_stamp> stamp(std::string const& filepath)
+{
+#ifdef _WIN32
+    fs::path path(mapnik::utf8_to_utf16(filepath));
+#else
+    fs::path path(filepath);
+#endif
+    error_code ec;
+    auto const mtime = fs::last_write_time(path, ec);
+    if (ec)
+    {
+        return std::nullopt;
+    }
+    auto const size = fs::file_size(path, ec);
+    if (ec)
+    {
+        return std::nullopt;
+    }
+#ifdef USE_BOOST_FILESYSTEM
+    return file_stamp{static_cast<std::int64_t>(mtime), size};
+#else
+    return file_stamp{static_cast<std::int64_t>(mtime.time_since_epoch().count()), size};
+#endif
+}
+
 } // end namespace util
 
 } // end namespace mapnik
@@ -33,6 +33,7 @@
 #include <mapnik/debug.hpp>
 #include <mapnik/layer.hpp>
 #include <mapnik/label_collision_detector.hpp>
+#include <mapnik/renderer_common/geometry_cache.hpp>
 #include <mapnik/feature_type_style.hpp>
 #include <mapnik/marker.hpp>
 #include <mapnik/marker_cache.hpp>
@@ -65,7 +66,8 @@ grid_renderer<T>::grid_renderer(Map const& m, T& pixmap, double scale_factor, un
     : feature_style_processor<grid_renderer>(m, scale_factor),
       pixmap_(pixmap),
       ras_ptr(new grid_rasterizer),
-      common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor)
+      common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor),
+      resolved_symbolizers_()
 {
     setup(m);
 }
@@ -81,7 +83,8 @@ grid_renderer<T>::grid_renderer(Map const& m,
     : feature_style_processor<grid_renderer>(m, scale_factor),
       pixmap_(pixmap),
       ras_ptr(new grid_rasterizer),
-      common_(m, req, vars, offset_x, offset_y, req.width(), req.height(), scale_factor)
+      common_(m, req, vars, offset_x, offset_y, req.width(), req.height(), scale_factor),
+      resolved_symbolizers_()
 {
     setup(m);
 }
@@ -118,10 +121,18 @@ void grid_renderer<T>::start_layer_processing(layer const& lay, box2d<double> co
     MAPNIK_LOG_DEBUG(grid_renderer) << "grid_renderer: datasource=" << lay.datasource().get();
     MAPNIK_LOG_DEBUG(grid_renderer) << "grid_renderer: query_extent = " << query_extent;
 
+    // symbolizers are resolved once per layer, styles may change between renders
+    resolved_symbolizers_.clear();
+
     if (lay.clear_label_cache())
     {
         common_.detector_->clear();
     }
+    // feature ids are only unique within a layer
+    if (common_.geometry_cache_)
+    {
+        common_.geometry_cache_->start_layer(lay);
+    }
     common_.query_extent_ = query_extent;
     auto&& maximum_extent = lay.maximum_extent();
     if (maximum_extent.has_value())
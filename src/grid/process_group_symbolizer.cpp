@@ -69,7 +69,9 @@ struct thunk_renderer : render_thunk_list_dispatch
           common_(common),
           feature_(feature),
           tex_(pixmap, src_over, common.scale_factor_)
-    {}
+    {
+        tex_.set_glyph_cache(common.glyph_cache_);
+    }
 
     virtual void operator()(vector_marker_render_thunk const& thunk)
     {
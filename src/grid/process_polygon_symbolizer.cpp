@@ -58,11 +58,13 @@ void grid_renderer<T>::process(polygon_symbolizer const& sym,
     using vertex_converter_type =
       vertex_converter<clip_poly_tag, transform_tag, affine_transform_tag, simplify_tag, smooth_tag>;
 
+    polygon_symbolizer_properties const& props = resolved_symbolizers_.get(sym, feature, common_.vars_);
     ras_ptr->reset();
 
     grid_rendering_buffer buf(pixmap_.raw_data(), common_.width_, common_.height_, common_.width_);
 
     render_polygon_symbolizer<vertex_converter_type>(sym,
+                                                     props,
                                                      feature,
                                                      prj_trans,
                                                      common_,
@@ -71,6 +71,7 @@ void grid_renderer<T>::process(shield_symbolizer const& sym,
     double opacity = get<double>(sym, keys::opacity, feature, common_.vars_, 1.0);
 
     grid_text_renderer<T> ren(pixmap_, comp_op, common_.scale_factor_);
+    ren.set_glyph_cache(common_.glyph_cache_);
 
     placements_list const& placements = helper.get();
     value_integer feature_id = feature.id();
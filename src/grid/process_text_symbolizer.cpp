@@ -62,6 +62,7 @@ void grid_renderer<T>::process(text_symbolizer const& sym,
     composite_mode_e comp_op = get<composite_mode_e>(sym, keys::comp_op, feature, common_.vars_, src_over);
 
     grid_text_renderer<T> ren(pixmap_, comp_op, common_.scale_factor_);
+    ren.set_glyph_cache(common_.glyph_cache_);
 
     auto halo_transform = get_optional<transform_type>(sym, keys::halo_transform);
     if (halo_transform)
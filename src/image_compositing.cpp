@@ -24,6 +24,7 @@
 #include <mapnik/image_compositing.hpp>
 #include <mapnik/image.hpp>
 #include <mapnik/image_any.hpp>
+#include <mapnik/image_simd.hpp>
 #include <mapnik/safe_cast.hpp>
 #include <mapnik/util/const_rendering_buffer.hpp>
 
@@ -46,6 +47,10 @@ MAPNIK_DISABLE_WARNING_PUSH
 #include "agg_color_rgba.h"
 MAPNIK_DISABLE_WARNING_POP
 
+// stl
+#include <algorithm>
+#include <cstddef>
+
 namespace mapnik {
 
 using comp_op_lookup_type = boost::bimap<composite_mode_e, std::string>;
@@ -116,6 +121,29 @@ to premultiply the background color used out of bounds.
 
 */
 
+namespace {
+
+// Blends the part of `src` overlapping `dst` at (dx, dy) with the vectorized kernels,
+// covering the same area as agg::renderer_base::blend_from
+bool composite_simd(image_rgba8& dst, image_rgba8 const& src, composite_mode_e mode, unsigned cover, int dx, int dy)
+{
+    if (&dst == &src || !simd::can_composite_rgba8(mode))
+    {
+        return false;
+    }
+    std::ptrdiff_t const x0 = std::max<std::ptrdiff_t>(0, dx);
+    std::ptrdiff_t const y0 = std::max<std::ptrdiff_t>(0, dy);
+    std::ptrdiff_t const x1 = std::min<std::ptrdiff_t>(dst.width(), static_cast<std::ptrdiff_t>(src.width()) + dx);
+    std::ptrdiff_t const y1 = std::min<std::ptrdiff_t>(dst.height(), static_cast<std::ptrdiff_t>(src.height()) + dy);
+    for (std::ptrdiff_t y = y0; y < y1 && x0 < x1; ++y)
+    {
+        simd::composite_rgba8(dst.get_row(y) + x0, src.get_row(y - dy) + (x0 - dx), x1 - x0, mode, cover);
+    }
+    return true;
+}
+
+} // namespace
+
 template<>
 MAPNIK_DECL void
   composite(image_rgba8& dst, image_rgba8 const& src, composite_mode_e mode, float opacity, int dx, int dy)
@@ -146,8 +174,13 @@ MAPNIK_DECL void
         throw std::runtime_error("DESTINATION MUST BE PREMULTIPLIED FOR COMPOSITING!");
     }
 #endif
+    agg::cover_type const cover = safe_cast<agg::cover_type>(255 * opacity);
+    if (composite_simd(dst, src, mode, cover, dx, dy))
+    {
+        return;
+    }
     renderer_type ren(pixf);
-    ren.blend_from(pixf_mask, 0, dx, dy, safe_cast<agg::cover_type>(255 * opacity));
+    ren.blend_from(pixf_mask, 0, dx, dy, cover);
 }
 
 template<>
@@ -0,0 +1,167 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/image_reader_pool.hpp>
+
+// stl
+#include <exception>
+#include <iterator>
+
+namespace mapnik {
+
+template class singleton<image_reader_pool, CreateUsingNew>;
+
+void image_reader_pool::releaser::operator()(image_reader* reader) const
+{
+    std::unique_ptr<image_reader> ptr(reader);
+    // a reader released while unwinding may have been left half way through a read
+    if (stamp && std::uncaught_exceptions() == 0)
+    {
+        image_reader_pool::instance().release(key, *stamp, std::move(ptr));
+    }
+}
+
+image_reader_pool::image_reader_pool()
+    : image_reader_pool(default_capacity)
+{}
+
+image_reader_pool::image_reader_pool(std::size_t capacity)
+    : capacity_(capacity),
+      hits_(0),
+      misses_(0),
+      evictions_(0)
+{}
+
+image_reader_pool::reader_ptr image_reader_pool::borrow(std::string const& file, std::string const& format)
+{
+    std::string key = format + ':' + file;
+    std::optional<util::file_stamp> const stamp = util::stamp(file);
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+#endif
+        auto range = index_.equal_range(key);
+        for (auto itr = range.first; itr != range.second;)
+        {
+            if (stamp && itr->second->stamp == *stamp)
+            {
+                std::unique_ptr<image_reader> reader = std::move(itr->second->reader);
+                entries_.erase(itr->second);
+                index_.erase(itr);
+                ++hits_;
+                return reader_ptr(reader.release(), releaser{std::move(key), stamp});
+            }
+            // the file was replaced or modified since this reader parsed it
+            entries_.erase(itr->second);
+            itr = index_.erase(itr);
+            ++evictions_;
+        }
+        ++misses_;
+    }
+    std::unique_ptr<image_reader> reader(get_image_reader(file, format));
+    if (!reader)
+    {
+        return reader_ptr();
+    }
+    return reader_ptr(reader.release(), releaser{std::move(key), stamp});
+}
+
+void image_reader_pool::release(std::string const& key,
+                                util::file_stamp const& stamp,
+                                std::unique_ptr<image_reader> reader)
+{
+    try
+    {
+        // borrowers get the full resolution image
+        reader->select_overview(0);
+    }
+    catch (...)
+    {
+        return;
+    }
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+#endif
+    if (capacity_ == 0)
+    {
+        return;
+    }
+    entries_.push_front(entry{key, stamp, std::move(reader)});
+    index_.emplace(key, entries_.begin());
+    shrink();
+}
+
+void image_reader_pool::set_capacity(std::size_t capacity)
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+#endif
+    capacity_ = capacity;
+    shrink();
+}
+
+void image_reader_pool::clear()
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+#endif
+    index_.clear();
+    entries_.clear();
+}
+
+std::size_t image_reader_pool::capacity() const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+#endif
+    return capacity_;
+}
+
+std::size_t image_reader_pool::size() const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+#endif
+    return entries_.size();
+}
+
+void image_reader_pool::shrink()
+{
+    while (entries_.size() > capacity_)
+    {
+        auto last = std::prev(entries_.end());
+        auto range = index_.equal_range(last->key);
+        for (auto itr = range.first; itr != range.second; ++itr)
+        {
+            if (itr->second == last)
+            {
+                index_.erase(itr);
+                break;
+            }
+        }
+        entries_.pop_back();
+        ++evictions_;
+    }
+}
+
+} // namespace mapnik
@@ -0,0 +1,576 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/image_simd.hpp>
+
+// stl
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+// Kernels are compiled with per function target attributes, so the library itself
+// doesn't require any instruction set beyond the baseline of the build.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MAPNIK_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace mapnik {
+namespace simd {
+
+namespace {
+
+// Scalar versions of the AGG per pixel operations, used for the remainder of
+// each run. Pixels are rgba with red in the lowest byte.
+
+inline std::uint32_t mul_div255(std::uint32_t x, std::uint32_t y)
+{
+    return (x * y + 255) >> 8;
+}
+
+inline std::uint32_t pack(std::uint32_t r, std::uint32_t g, std::uint32_t b, std::uint32_t a)
+{
+    return (r & 0xff) | ((g & 0xff) << 8) | ((b & 0xff) << 16) | ((a & 0xff) << 24);
+}
+
+[[maybe_unused]] inline std::uint32_t premultiply_pixel(std::uint32_t p)
+{
+    std::uint32_t a = p >> 24;
+    return pack(mul_div255(p & 0xff, a), mul_div255((p >> 8) & 0xff, a), mul_div255((p >> 16) & 0xff, a), a);
+}
+
+[[maybe_unused]] inline std::uint32_t demultiply_pixel(std::uint32_t p)
+{
+    std::uint32_t a = p >> 24;
+    if (a == 255)
+        return p;
+    if (a == 0)
+        return 0;
+    std::uint32_t r = std::min(255u, ((p & 0xff) * 255) / a);
+    std::uint32_t g = std::min(255u, (((p >> 8) & 0xff) * 255) / a);
+    std::uint32_t b = std::min(255u, (((p >> 16) & 0xff) * 255) / a);
+    return pack(r, g, b, a);
+}
+
+[[maybe_unused]] inline std::uint32_t apply_opacity_pixel(std::uint32_t p, float opacity)
+{
+    std::uint32_t a = static_cast<std::uint32_t>((p >> 24) * opacity);
+    return (p & 0x00ffffff) | (a << 24);
+}
+
+// Ordering key of nearest_rgba8, the distance above the tie breaking rank:
+// 0 for the hint, 1.. below it and nearest_above.. above it.
+constexpr std::size_t nearest_max = 1024;
+constexpr int nearest_above = 1024;
+constexpr int nearest_shift = 11;
+
+[[maybe_unused]] inline int nearest_key(std::uint32_t p, std::uint32_t c, std::size_t i, std::size_t hint)
+{
+    int const dr = int(p & 0xff) - int(c & 0xff);
+    int const dg = int((p >> 8) & 0xff) - int((c >> 8) & 0xff);
+    int const db = int((p >> 16) & 0xff) - int((c >> 16) & 0xff);
+    int const da = int(p >> 24) - int(c >> 24);
+    int const rank = i < hint ? int(hint - i) : i > hint ? nearest_above + int(i - hint) : 0;
+    return ((dr * dr + dg * dg + db * db + da * da) << nearest_shift) + rank;
+}
+
+template<composite_mode_e Mode>
+[[maybe_unused]] std::uint32_t blend_pixel(std::uint32_t s, std::uint32_t d, unsigned cover)
+{
+    std::uint32_t sr = s & 0xff;
+    std::uint32_t sg = (s >> 8) & 0xff;
+    std::uint32_t sb = (s >> 16) & 0xff;
+    std::uint32_t sa = s >> 24;
+    if (cover < 255)
+    {
+        sr = mul_div255(sr, cover);
+        sg = mul_div255(sg, cover);
+        sb = mul_div255(sb, cover);
+        sa = mul_div255(sa, cover);
+    }
+    std::uint32_t dr = d & 0xff;
+    std::uint32_t dg = (d >> 8) & 0xff;
+    std::uint32_t db = (d >> 16) & 0xff;
+    std::uint32_t da = d >> 24;
+    if constexpr (Mode == src_over)
+    {
+        std::uint32_t s1a = 255 - sa;
+        return pack(sr + mul_div255(dr, s1a),
+                    sg + mul_div255(dg, s1a),
+                    sb + mul_div255(db, s1a),
+                    sa + mul_div255(da, s1a));
+    }
+    else if constexpr (Mode == multiply)
+    {
+        if (sa == 0)
+            return d;
+        std::uint32_t s1a = 255 - sa;
+        std::uint32_t d1a = 255 - da;
+        return pack((sr * dr + sr * d1a + dr * s1a + 255) >> 8,
+                    (sg * dg + sg * d1a + dg * s1a + 255) >> 8,
+                    (sb * db + sb * d1a + db * s1a + 255) >> 8,
+                    sa + da - mul_div255(sa, da));
+    }
+    else if constexpr (Mode == screen)
+    {
+        if (sa == 0)
+            return d;
+        return pack(sr + dr - mul_div255(sr, dr),
+                    sg + dg - mul_div255(sg, dg),
+                    sb + db - mul_div255(sb, db),
+                    sa + da - mul_div255(sa, da));
+    }
+    else
+    {
+        static_assert(Mode == dst_out, "unsupported composite mode");
+        std::uint32_t s1a = 255 - sa;
+        return pack((dr * s1a + 8) >> 8, (dg * s1a + 8) >> 8, (db * s1a + 8) >> 8, (da * s1a + 8) >> 8);
+    }
+}
+
+#ifdef MAPNIK_SIMD_X86
+
+namespace sse41 {
+
+#define MAPNIK_SIMD_FUNC inline __attribute__((target("sse4.1")))
+
+using vec = __m128i;
+using vecf = __m128;
+constexpr std::size_t lanes = 4;
+
+MAPNIK_SIMD_FUNC vec load(std::uint32_t const* p)
+{
+    return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+}
+MAPNIK_SIMD_FUNC void store(std::uint32_t* p, vec v)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+MAPNIK_SIMD_FUNC vec set1(int x)
+{
+    return _mm_set1_epi32(x);
+}
+MAPNIK_SIMD_FUNC vec setzero()
+{
+    return _mm_setzero_si128();
+}
+MAPNIK_SIMD_FUNC vec and_(vec a, vec b)
+{
+    return _mm_and_si128(a, b);
+}
+MAPNIK_SIMD_FUNC vec or_(vec a, vec b)
+{
+    return _mm_or_si128(a, b);
+}
+MAPNIK_SIMD_FUNC vec add32(vec a, vec b)
+{
+    return _mm_add_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec sub32(vec a, vec b)
+{
+    return _mm_sub_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec mullo16(vec a, vec b)
+{
+    return _mm_mullo_epi16(a, b);
+}
+MAPNIK_SIMD_FUNC vec mullo32(vec a, vec b)
+{
+    return _mm_mullo_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec min32(vec a, vec b)
+{
+    return _mm_min_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec cmpeq32(vec a, vec b)
+{
+    return _mm_cmpeq_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec cmpgt32(vec a, vec b)
+{
+    return _mm_cmpgt_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC int hmin32(vec v)
+{
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+MAPNIK_SIMD_FUNC vec iota()
+{
+    return _mm_setr_epi32(0, 1, 2, 3);
+}
+MAPNIK_SIMD_FUNC vec select(vec mask, vec a, vec b)
+{
+    return _mm_blendv_epi8(b, a, mask);
+}
+MAPNIK_SIMD_FUNC bool all_set(vec mask)
+{
+    return _mm_movemask_epi8(mask) == 0xffff;
+}
+MAPNIK_SIMD_FUNC vec shr8(vec v)
+{
+    return _mm_srli_epi32(v, 8);
+}
+MAPNIK_SIMD_FUNC vec shr16(vec v)
+{
+    return _mm_srli_epi32(v, 16);
+}
+MAPNIK_SIMD_FUNC vec shr24(vec v)
+{
+    return _mm_srli_epi32(v, 24);
+}
+MAPNIK_SIMD_FUNC vec shl8(vec v)
+{
+    return _mm_slli_epi32(v, 8);
+}
+MAPNIK_SIMD_FUNC vec shl16(vec v)
+{
+    return _mm_slli_epi32(v, 16);
+}
+MAPNIK_SIMD_FUNC vec shl24(vec v)
+{
+    return _mm_slli_epi32(v, 24);
+}
+MAPNIK_SIMD_FUNC vecf to_float(vec v)
+{
+    return _mm_cvtepi32_ps(v);
+}
+MAPNIK_SIMD_FUNC vec truncate(vecf v)
+{
+    return _mm_cvttps_epi32(v);
+}
+MAPNIK_SIMD_FUNC vecf set1f(float x)
+{
+    return _mm_set1_ps(x);
+}
+MAPNIK_SIMD_FUNC vecf mulf(vecf a, vecf b)
+{
+    return _mm_mul_ps(a, b);
+}
+MAPNIK_SIMD_FUNC vecf divf(vecf a, vecf b)
+{
+    return _mm_div_ps(a, b);
+}
+
+#include "image_simd_kernels.hpp"
+
+#undef MAPNIK_SIMD_FUNC
+
+} // namespace sse41
+
+namespace avx2 {
+
+#define MAPNIK_SIMD_FUNC inline __attribute__((target("avx2")))
+
+using vec = __m256i;
+using vecf = __m256;
+constexpr std::size_t lanes = 8;
+
+MAPNIK_SIMD_FUNC vec load(std::uint32_t const* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+}
+MAPNIK_SIMD_FUNC void store(std::uint32_t* p, vec v)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+MAPNIK_SIMD_FUNC vec set1(int x)
+{
+    return _mm256_set1_epi32(x);
+}
+MAPNIK_SIMD_FUNC vec setzero()
+{
+    return _mm256_setzero_si256();
+}
+MAPNIK_SIMD_FUNC vec and_(vec a, vec b)
+{
+    return _mm256_and_si256(a, b);
+}
+MAPNIK_SIMD_FUNC vec or_(vec a, vec b)
+{
+    return _mm256_or_si256(a, b);
+}
+MAPNIK_SIMD_FUNC vec add32(vec a, vec b)
+{
+    return _mm256_add_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec sub32(vec a, vec b)
+{
+    return _mm256_sub_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec mullo16(vec a, vec b)
+{
+    return _mm256_mullo_epi16(a, b);
+}
+MAPNIK_SIMD_FUNC vec mullo32(vec a, vec b)
+{
+    return _mm256_mullo_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec min32(vec a, vec b)
+{
+    return _mm256_min_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec cmpeq32(vec a, vec b)
+{
+    return _mm256_cmpeq_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC vec cmpgt32(vec a, vec b)
+{
+    return _mm256_cmpgt_epi32(a, b);
+}
+MAPNIK_SIMD_FUNC int hmin32(vec v)
+{
+    __m128i m = _mm_min_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(m);
+}
+MAPNIK_SIMD_FUNC vec iota()
+{
+    return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+}
+MAPNIK_SIMD_FUNC vec select(vec mask, vec a, vec b)
+{
+    return _mm256_blendv_epi8(b, a, mask);
+}
+MAPNIK_SIMD_FUNC bool all_set(vec mask)
+{
+    return _mm256_movemask_epi8(mask) == -1;
+}
+MAPNIK_SIMD_FUNC vec shr8(vec v)
+{
+    return _mm256_srli_epi32(v, 8);
+}
+MAPNIK_SIMD_FUNC vec shr16(vec v)
+{
+    return _mm256_srli_epi32(v, 16);
+}
+MAPNIK_SIMD_FUNC vec shr24(vec v)
+{
+    return _mm256_srli_epi32(v, 24);
+}
+MAPNIK_SIMD_FUNC vec shl8(vec v)
+{
+    return _mm256_slli_epi32(v, 8);
+}
+MAPNIK_SIMD_FUNC vec shl16(vec v)
+{
+    return _mm256_slli_epi32(v, 16);
+}
+MAPNIK_SIMD_FUNC vec shl24(vec v)
+{
+    return _mm256_slli_epi32(v, 24);
+}
+MAPNIK_SIMD_FUNC vecf to_float(vec v)
+{
+    return _mm256_cvtepi32_ps(v);
+}
+MAPNIK_SIMD_FUNC vec truncate(vecf v)
+{
+    return _mm256_cvttps_epi32(v);
+}
+MAPNIK_SIMD_FUNC vecf set1f(float x)
+{
+    return _mm256_set1_ps(x);
+}
+MAPNIK_SIMD_FUNC vecf mulf(vecf a, vecf b)
+{
+    return _mm256_mul_ps(a, b);
+}
+MAPNIK_SIMD_FUNC vecf divf(vecf a, vecf b)
+{
+    return _mm256_div_ps(a, b);
+}
+
+#include "image_simd_kernels.hpp"
+
+#undef MAPNIK_SIMD_FUNC
+
+} // namespace avx2
+
+#endif // MAPNIK_SIMD_X86
+
+std::atomic<instruction_set>& active_isa()
+{
+    static std::atomic<instruction_set> isa(detect_instruction_set());
+    return isa;
+}
+
+} // namespace
+
+instruction_set detect_instruction_set()
+{
+#ifdef MAPNIK_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return instruction_set::avx2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return instruction_set::sse41;
+#endif
+    return instruction_set::scalar;
+}
+
+instruction_set active_instruction_set()
+{
+    return active_isa().load(std::memory_order_relaxed);
+}
+
+void set_instruction_set(instruction_set isa)
+{
+    active_isa().store(std::min(isa, detect_instruction_set()), std::memory_order_relaxed);
+}
+
+bool premultiply_rgba8(std::uint32_t* pixels, std::size_t count)
+{
+    switch (active_instruction_set())
+    {
+#ifdef MAPNIK_SIMD_X86
+        case instruction_set::avx2:
+            avx2::premultiply(pixels, count);
+            return true;
+        case instruction_set::sse41:
+            sse41::premultiply(pixels, count);
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool demultiply_rgba8(std::uint32_t* pixels, std::size_t count)
+{
+    switch (active_instruction_set())
+    {
+#ifdef MAPNIK_SIMD_X86
+        case instruction_set::avx2:
+            avx2::demultiply(pixels, count);
+            return true;
+        case instruction_set::sse41:
+            sse41::demultiply(pixels, count);
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool apply_opacity_rgba8(std::uint32_t* pixels, std::size_t count, float opacity)
+{
+    switch (active_instruction_set())
+    {
+#ifdef MAPNIK_SIMD_X86
+        case instruction_set::avx2:
+            avx2::apply_opacity(pixels, count, opacity);
+            return true;
+        case instruction_set::sse41:
+            sse41::apply_opacity(pixels, count, opacity);
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool can_composite_rgba8(composite_mode_e mode)
+{
+    if (active_instruction_set() == instruction_set::scalar)
+        return false;
+    return mode == src_over || mode == multiply || mode == screen || mode == dst_out;
+}
+
+bool composite_rgba8(std::uint32_t* dst,
+                     std::uint32_t const* src,
+                     std::size_t count,
+                     composite_mode_e mode,
+                     unsigned cover)
+{
+    if (!can_composite_rgba8(mode))
+        return false;
+    switch (active_instruction_set())
+    {
+#ifdef MAPNIK_SIMD_X86
+        case instruction_set::avx2:
+            avx2::composite(dst, src, count, mode, cover);
+            return true;
+        case instruction_set::sse41:
+            sse41::composite(dst, src, count, mode, cover);
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+std::size_t equal_run_rgba8(std::uint32_t const* pixels, std::size_t count)
+{
+    if (count == 0)
+        return 0;
+    switch (active_instruction_set())
+    {
+#ifdef MAPNIK_SIMD_X86
+        case instruction_set::avx2:
+            return avx2::equal_run(pixels, count);
+        case instruction_set::sse41:
+            return sse41::equal_run(pixels, count);
+#endif
+        default:
+            break;
+    }
+    std::size_t i = 1;
+    while (i < count && pixels[i] == pixels[0])
+    {
+        ++i;
+    }
+    return i;
+}
+
+bool nearest_rgba8(std::uint32_t const* palette,
+                   std::size_t count,
+                   std::uint32_t color,
+                   std::size_t hint,
+                   std::size_t& index)
+{
+    if (count == 0 || count > nearest_max)
+        return false;
+    int key;
+    switch (active_instruction_set())
+    {
+#ifdef MAPNIK_SIMD_X86
+        case instruction_set::avx2:
+            key = avx2::nearest(palette, count, color, hint);
+            break;
+        case instruction_set::sse41:
+            key = sse41::nearest(palette, count, color, hint);
+            break;
+#endif
+        default:
+            return false;
+    }
+    int const rank = key & ((1 << nearest_shift) - 1);
+    index = rank >= nearest_above ? hint + (rank - nearest_above) : hint - rank;
+    return true;
+}
+
+} // namespace simd
+} // namespace mapnik
@@ -0,0 +1,287 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// Kernels shared by the instruction sets in image_simd.cpp, no include guard on purpose.
+// Included once per instruction set after the vector primitives (`vec`, `vecf`, `lanes`,
+// load/store, integer and float ops) and MAPNIK_SIMD_FUNC have been defined.
+// Each 32 bit lane holds one pixel, channels are unpacked into separate vectors.
+
+MAPNIK_SIMD_FUNC vec red(vec v)
+{
+    return and_(v, set1(0xff));
+}
+
+MAPNIK_SIMD_FUNC vec green(vec v)
+{
+    return and_(shr8(v), set1(0xff));
+}
+
+MAPNIK_SIMD_FUNC vec blue(vec v)
+{
+    return and_(shr16(v), set1(0xff));
+}
+
+MAPNIK_SIMD_FUNC vec alpha(vec v)
+{
+    return shr24(v);
+}
+
+// truncates every channel to 8 bits like the value_type casts in AGG
+MAPNIK_SIMD_FUNC vec pack(vec r, vec g, vec b, vec a)
+{
+    vec const mask = set1(0xff);
+    return or_(or_(and_(r, mask), shl8(and_(g, mask))), or_(shl16(and_(b, mask)), shl24(and_(a, mask))));
+}
+
+// (x * y + 255) >> 8 for 8 bit operands
+MAPNIK_SIMD_FUNC vec mul_div255(vec x, vec y)
+{
+    return shr8(add32(mullo16(x, y), set1(255)));
+}
+
+MAPNIK_SIMD_FUNC bool all_opaque(vec v)
+{
+    return all_set(cmpeq32(or_(v, set1(0x00ffffff)), set1(-1)));
+}
+
+MAPNIK_SIMD_FUNC void premultiply(std::uint32_t* p, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes)
+    {
+        vec v = load(p + i);
+        if (all_opaque(v))
+            continue;
+        vec a = alpha(v);
+        store(p + i, pack(mul_div255(red(v), a), mul_div255(green(v), a), mul_div255(blue(v), a), a));
+    }
+    for (; i < count; ++i)
+    {
+        p[i] = premultiply_pixel(p[i]);
+    }
+}
+
+// c * 255 / a is below 2^16, so the correctly rounded float quotient truncates
+// to the same value as the integer division in AGG.
+MAPNIK_SIMD_FUNC vec demultiply_channel(vec c, vecf a)
+{
+    return min32(truncate(divf(mulf(to_float(c), set1f(255.0f)), a)), set1(255));
+}
+
+MAPNIK_SIMD_FUNC void demultiply(std::uint32_t* p, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes)
+    {
+        vec v = load(p + i);
+        if (all_opaque(v))
+            continue;
+        vec a = alpha(v);
+        vec transparent = cmpeq32(a, setzero());
+        vecf fa = to_float(or_(a, and_(transparent, set1(1))));
+        vec result = pack(demultiply_channel(red(v), fa),
+                          demultiply_channel(green(v), fa),
+                          demultiply_channel(blue(v), fa),
+                          a);
+        store(p + i, select(transparent, setzero(), result));
+    }
+    for (; i < count; ++i)
+    {
+        p[i] = demultiply_pixel(p[i]);
+    }
+}
+
+MAPNIK_SIMD_FUNC void apply_opacity(std::uint32_t* p, std::size_t count, float opacity)
+{
+    std::size_t i = 0;
+    vecf const factor = set1f(opacity);
+    for (; i + lanes <= count; i += lanes)
+    {
+        vec v = load(p + i);
+        vec a = truncate(mulf(to_float(alpha(v)), factor));
+        store(p + i, or_(and_(v, set1(0x00ffffff)), shl24(a)));
+    }
+    for (; i < count; ++i)
+    {
+        p[i] = apply_opacity_pixel(p[i], opacity);
+    }
+}
+
+// (s.d + s.(1 - da) + d.(1 - sa) + 255) >> 8, the sum doesn't fit 16 bits
+MAPNIK_SIMD_FUNC vec multiply_channel(vec s, vec d, vec s1a, vec d1a)
+{
+    return shr8(add32(add32(mullo16(s, d), mullo16(s, d1a)), add32(mullo16(d, s1a), set1(255))));
+}
+
+// s + d - s.d, also the multiply alpha
+MAPNIK_SIMD_FUNC vec screen_channel(vec s, vec d)
+{
+    return sub32(add32(s, d), mul_div255(s, d));
+}
+
+template<composite_mode_e Mode>
+MAPNIK_SIMD_FUNC vec blend(vec s, vec d, unsigned cover)
+{
+    vec sr = red(s);
+    vec sg = green(s);
+    vec sb = blue(s);
+    vec sa = alpha(s);
+    if (cover < 255)
+    {
+        vec c = set1(static_cast<int>(cover));
+        sr = mul_div255(sr, c);
+        sg = mul_div255(sg, c);
+        sb = mul_div255(sb, c);
+        sa = mul_div255(sa, c);
+    }
+    vec dr = red(d);
+    vec dg = green(d);
+    vec db = blue(d);
+    vec da = alpha(d);
+    vec const base_mask = set1(255);
+    if constexpr (Mode == src_over)
+    {
+        vec s1a = sub32(base_mask, sa);
+        return pack(add32(sr, mul_div255(dr, s1a)),
+                    add32(sg, mul_div255(dg, s1a)),
+                    add32(sb, mul_div255(db, s1a)),
+                    add32(sa, mul_div255(da, s1a)));
+    }
+    else if constexpr (Mode == multiply)
+    {
+        vec s1a = sub32(base_mask, sa);
+        vec d1a = sub32(base_mask, da);
+        vec result = pack(multiply_channel(sr, dr, s1a, d1a),
+                          multiply_channel(sg, dg, s1a, d1a),
+                          multiply_channel(sb, db, s1a, d1a),
+                          screen_channel(sa, da));
+        return select(cmpeq32(sa, setzero()), d, result);
+    }
+    else if constexpr (Mode == screen)
+    {
+        vec result = pack(screen_channel(sr, dr),
+                          screen_channel(sg, dg),
+                          screen_channel(sb, db),
+                          screen_channel(sa, da));
+        return select(cmpeq32(sa, setzero()), d, result);
+    }
+    else
+    {
+        static_assert(Mode == dst_out, "unsupported composite mode");
+        // AGG rounds with base_shift instead of base_mask here
+        vec s1a = sub32(base_mask, sa);
+        vec const round = set1(8);
+        return pack(shr8(add32(mullo16(dr, s1a), round)),
+                    shr8(add32(mullo16(dg, s1a), round)),
+                    shr8(add32(mullo16(db, s1a), round)),
+                    shr8(add32(mullo16(da, s1a), round)));
+    }
+}
+
+template<composite_mode_e Mode>
+MAPNIK_SIMD_FUNC void composite(std::uint32_t* dst, std::uint32_t const* src, std::size_t count, unsigned cover)
+{
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes)
+    {
+        store(dst + i, blend<Mode>(load(src + i), load(dst + i), cover));
+    }
+    for (; i < count; ++i)
+    {
+        dst[i] = blend_pixel<Mode>(src[i], dst[i], cover);
+    }
+}
+
+MAPNIK_SIMD_FUNC void
+  composite(std::uint32_t* dst, std::uint32_t const* src, std::size_t count, composite_mode_e mode, unsigned cover)
+{
+    switch (mode)
+    {
+        case src_over:
+            composite<src_over>(dst, src, count, cover);
+            break;
+        case multiply:
+            composite<multiply>(dst, src, count, cover);
+            break;
+        case screen:
+            composite<screen>(dst, src, count, cover);
+            break;
+        case dst_out:
+            composite<dst_out>(dst, src, count, cover);
+            break;
+        default:
+            break;
+    }
+}
+
+// length of the run of pixels equal to p[0], count > 0
+MAPNIK_SIMD_FUNC std::size_t equal_run(std::uint32_t const* p, std::size_t count)
+{
+    vec const first = set1(static_cast<int>(p[0]));
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes)
+    {
+        if (!all_set(cmpeq32(load(p + i), first)))
+            break;
+    }
+    while (i < count && p[i] == p[0])
+    {
+        ++i;
+    }
+    return i;
+}
+
+// smallest nearest_key of the palette entries, count > 0
+MAPNIK_SIMD_FUNC int nearest(std::uint32_t const* palette, std::size_t count, std::uint32_t color, std::size_t hint)
+{
+    vec const c = set1(static_cast<int>(color));
+    vec const cr = red(c);
+    vec const cg = green(c);
+    vec const cb = blue(c);
+    vec const ca = alpha(c);
+    vec const h = set1(static_cast<int>(hint));
+    vec const step = set1(static_cast<int>(lanes));
+    vec const scale = set1(1 << nearest_shift);
+    vec index = iota();
+    vec best = set1(std::numeric_limits<int>::max());
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes, index = add32(index, step))
+    {
+        vec const p = load(palette + i);
+        vec const dr = sub32(red(p), cr);
+        vec const dg = sub32(green(p), cg);
+        vec const db = sub32(blue(p), cb);
+        vec const da = sub32(alpha(p), ca);
+        vec const dist =
+          add32(add32(mullo32(dr, dr), mullo32(dg, dg)), add32(mullo32(db, db), mullo32(da, da)));
+        vec const below = sub32(h, index);
+        vec const above = add32(sub32(index, h), set1(nearest_above));
+        vec const rank = select(cmpgt32(h, index), below, select(cmpgt32(index, h), above, setzero()));
+        best = min32(best, add32(mullo32(dist, scale), rank));
+    }
+    int key = hmin32(best);
+    for (; i < count; ++i)
+    {
+        key = std::min(key, nearest_key(palette[i], color, i, hint));
+    }
+    return key;
+}
@@ -28,6 +28,7 @@
 #include <mapnik/image_util_webp.hpp>
 #include <mapnik/image.hpp>
 #include <mapnik/image_any.hpp>
+#include <mapnik/image_simd.hpp>
 #include <mapnik/image_view_any.hpp>
 #include <mapnik/image_view.hpp>
 #include <mapnik/palette.hpp>
@@ -488,12 +489,15 @@ struct premultiply_visitor
     {
         if (!data.get_premultiplied())
         {
-            agg::rendering_buffer buffer(data.bytes(),
-                                         safe_cast<unsigned>(data.width()),
-                                         safe_cast<unsigned>(data.height()),
-                                         safe_cast<int>(data.row_size()));
-            agg::pixfmt_rgba32 pixf(buffer);
-            pixf.premultiply();
+            if (!simd::premultiply_rgba8(data.data(), data.width() * data.height()))
+            {
+                agg::rendering_buffer buffer(data.bytes(),
+                                             safe_cast<unsigned>(data.width()),
+                                             safe_cast<unsigned>(data.height()),
+                                             safe_cast<int>(data.row_size()));
+                agg::pixfmt_rgba32 pixf(buffer);
+                pixf.premultiply();
+            }
             data.set_premultiplied(true);
             return true;
         }
@@ -513,12 +517,15 @@ struct demultiply_visitor
     {
         if (data.get_premultiplied())
         {
-            agg::rendering_buffer buffer(data.bytes(),
-                                         safe_cast<unsigned>(data.width()),
-                                         safe_cast<unsigned>(data.height()),
-                                         safe_cast<int>(data.row_size()));
-            agg::pixfmt_rgba32_pre pixf(buffer);
-            pixf.demultiply();
+            if (!simd::demultiply_rgba8(data.data(), data.width() * data.height()))
+            {
+                agg::rendering_buffer buffer(data.bytes(),
+                                             safe_cast<unsigned>(data.width()),
+                                             safe_cast<unsigned>(data.height()),
+                                             safe_cast<int>(data.row_size()));
+                agg::pixfmt_rgba32_pre pixf(buffer);
+                pixf.demultiply();
+            }
             data.set_premultiplied(false);
             return true;
         }
@@ -643,6 +650,10 @@ struct visitor_apply_opacity
     void operator()(image_rgba8& data) const
     {
         using pixel_type = image_rgba8::pixel_type;
+        if (simd::apply_opacity_rgba8(data.data(), data.width() * data.height(), opacity_))
+        {
+            return;
+        }
         for (std::size_t y = 0; y < data.height(); ++y)
         {
             pixel_type* row_to = data.get_row(y);
@@ -85,9 +85,49 @@ void handle_png_options(std::string const& type, png_options& opts)
             else if (*val == "h")
                 opts.use_hextree = true;
         }
-        else if (key == "e" && val && *val == "miniz")
+        else if (key == "e")
         {
-            throw image_writer_exception("miniz support has been removed from Mapnik");
+            if (!val)
+                throw image_writer_exception("invalid encoder parameter: <uninitialised>");
+
+            if (*val == "miniz")
+            {
+                throw image_writer_exception("miniz support has been removed from Mapnik");
+            }
+            else if (*val == "libpng")
+            {
+                opts.encoder = png_encoder::libpng;
+            }
+            else if (*val == "zlib")
+            {
+                opts.encoder = png_encoder::zlib;
+            }
+            else if (*val == "libdeflate")
+            {
+                if (!png_encoder_available(png_encoder::libdeflate))
+                {
+                    throw image_writer_exception("libdeflate support is not enabled in your build of Mapnik");
+                }
+                opts.encoder = png_encoder::libdeflate;
+            }
+            else
+            {
+                throw image_writer_exception("invalid encoder parameter: " + *val);
+            }
+        }
+        else if (key == "j")
+        {
+            if (!val || !mapnik::util::string2int(*val, opts.chunks) || opts.chunks < 1)
+            {
+                throw image_writer_exception("invalid chunks parameter: " + to_string(val));
+            }
+        }
+        else if (key == "sample")
+        {
+            if (!val || !mapnik::util::string2int(*val, opts.sample) || opts.sample < 0)
+            {
+                throw image_writer_exception("invalid sample parameter: " + to_string(val));
+            }
         }
         else if (key == "c")
         {
@@ -164,10 +204,14 @@ void handle_png_options(std::string const& type, png_options& opts)
             // filters = PNG_ALL_FILTERS;
             // filters = PNG_FAST_FILTERS;
             // filters = PNG_FILTER_NONE | PNG_FILTER_SUB | PNG_FILTER_UP | PNG_FILTER_AVG | PNG_FILTER_PAETH;
+            // auto picks one of them per image from a sample of rows
 
             if (!val)
                 throw image_writer_exception("invalid filters parameter: <uninitialised>");
-            if (*val == "no")
+            opts.auto_filter = (*val == "auto");
+            if (opts.auto_filter)
+                opts.filters = PNG_FILTER_NONE;
+            else if (*val == "no")
                 opts.filters = PNG_NO_FILTERS;
             else if (*val == "all")
                 opts.filters = PNG_ALL_FILTERS;
@@ -194,6 +238,14 @@ void handle_png_options(std::string const& type, png_options& opts)
     {
         throw image_writer_exception("invalid compression value: (only -1 through 9 are valid)");
     }
+    if (opts.chunks > 1 && opts.encoder != png_encoder::zlib)
+    {
+        throw image_writer_exception("invalid chunks parameter: parallel compression requires e=zlib");
+    }
+    if (opts.sample > 0 && (!opts.paletted || !opts.use_hextree))
+    {
+        throw image_writer_exception("invalid sample parameter: only available for png8 with m=h");
+    }
 }
 #endif
 
@@ -39,6 +39,7 @@ layer::layer(std::string const& _name, std::string const& _srs)
       queryable_(false),
       clear_label_cache_(false),
       cache_features_(false),
+      query_ahead_(false),
       group_by_(),
       sort_by_(),
       styles_(),
@@ -59,6 +60,7 @@ layer::layer(layer const& rhs)
       queryable_(rhs.queryable_),
       clear_label_cache_(rhs.clear_label_cache_),
       cache_features_(rhs.cache_features_),
+      query_ahead_(rhs.query_ahead_),
       group_by_(rhs.group_by_),
       sort_by_(rhs.sort_by_),
       styles_(rhs.styles_),
@@ -79,6 +81,7 @@ layer::layer(layer&& rhs)
       queryable_(std::move(rhs.queryable_)),
       clear_label_cache_(std::move(rhs.clear_label_cache_)),
       cache_features_(std::move(rhs.cache_features_)),
+      query_ahead_(std::move(rhs.query_ahead_)),
       group_by_(std::move(rhs.group_by_)),
       sort_by_(std::move(rhs.sort_by_)),
       styles_(std::move(rhs.styles_)),
@@ -101,6 +104,7 @@ layer& layer::operator=(layer rhs)
     std::swap(this->queryable_, rhs.queryable_);
     std::swap(this->clear_label_cache_, rhs.clear_label_cache_);
     std::swap(this->cache_features_, rhs.cache_features_);
+    std::swap(this->query_ahead_, rhs.query_ahead_);
     std::swap(this->group_by_, rhs.group_by_);
     std::swap(this->sort_by_, rhs.sort_by_);
     std::swap(this->styles_, rhs.styles_);
@@ -117,8 +121,9 @@ bool layer::operator==(layer const& rhs) const
     return (name_ == rhs.name_) && (srs_ == rhs.srs_) && (minimum_scale_denom_ == rhs.minimum_scale_denom_) &&
            (maximum_scale_denom_ == rhs.maximum_scale_denom_) && (active_ == rhs.active_) &&
            (queryable_ == rhs.queryable_) && (clear_label_cache_ == rhs.clear_label_cache_) &&
-           (cache_features_ == rhs.cache_features_) && (group_by_ == rhs.group_by_) && (sort_by_ == rhs.sort_by_) &&
-           (styles_ == rhs.styles_) && ((ds_ && rhs.ds_) ? *ds_ == *rhs.ds_ : ds_ == rhs.ds_) &&
+           (cache_features_ == rhs.cache_features_) && (query_ahead_ == rhs.query_ahead_) &&
+           (group_by_ == rhs.group_by_) && (sort_by_ == rhs.sort_by_) && (styles_ == rhs.styles_) &&
+           ((ds_ && rhs.ds_) ? *ds_ == *rhs.ds_ : ds_ == rhs.ds_) &&
            (buffer_size_ == rhs.buffer_size_) && (maximum_extent_ == rhs.maximum_extent_) &&
            (comp_op_ == rhs.comp_op_) && (opacity_ == rhs.opacity_);
 }
@@ -287,6 +292,16 @@ bool layer::cache_features() const
     return cache_features_;
 }
 
+void layer::set_query_ahead(bool _query_ahead)
+{
+    query_ahead_ = _query_ahead;
+}
+
+bool layer::query_ahead() const
+{
+    return query_ahead_;
+}
+
 void layer::set_group_by(std::string const& column)
 {
     group_by_ = column;
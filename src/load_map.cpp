@@ -746,6 +746,12 @@ void map_parser::parse_layer(Parent& parent, xml_node const& node)
             lyr.set_cache_features(*cache_features);
         }
 
+        optional<mapnik::boolean_type> query_ahead = node.get_opt_attr<mapnik::boolean_type>("query-ahead");
+        if (query_ahead)
+        {
+            lyr.set_query_ahead(*query_ahead);
+        }
+
         optional<std::string> group_by = node.get_opt_attr<std::string>("group-by");
         if (group_by)
         {
@@ -0,0 +1,148 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/marker_sprite_cache.hpp>
+
+// stl
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+
+namespace mapnik {
+
+template class util::lru_cache<marker_sprite_key, marker_sprite, marker_sprite_key_hash, marker_sprite_cost>;
+template class singleton<marker_sprite_cache, CreateUsingNew>;
+
+namespace {
+
+double pack(agg::rgba8 const& c)
+{
+    return static_cast<std::uint32_t>(c.r) | static_cast<std::uint32_t>(c.g) << 8 |
+           static_cast<std::uint32_t>(c.b) << 16 | static_cast<std::uint32_t>(c.a) << 24;
+}
+
+struct collect_style
+{
+    void operator()(svg::group const& g) const
+    {
+        style.push_back(g.opacity);
+        for (auto const& elem : g.elements)
+        {
+            mapbox::util::apply_visitor(*this, elem);
+        }
+    }
+
+    void operator()(svg::path_attributes const& attr) const
+    {
+        style.push_back(pack(attr.fill_color));
+        style.push_back(pack(attr.stroke_color));
+        style.push_back(attr.fill_opacity);
+        style.push_back(attr.stroke_opacity);
+        style.push_back(attr.stroke_width);
+        style.push_back(attr.fill_flag | attr.stroke_flag << 1 | attr.visibility_flag << 2);
+    }
+
+    std::vector<double>& style;
+};
+
+// upper bound of the factor `tr` scales lengths by
+double scaling(agg::trans_affine const& tr)
+{
+    return std::sqrt(tr.sx * tr.sx + tr.shy * tr.shy + tr.shx * tr.shx + tr.sy * tr.sy);
+}
+
+struct stroke_extent
+{
+    double operator()(svg::group const& g) const
+    {
+        double extent = 0.0;
+        for (auto const& elem : g.elements)
+        {
+            extent = std::max(extent, mapbox::util::apply_visitor(*this, elem));
+        }
+        return extent;
+    }
+
+    double operator()(svg::path_attributes const& attr) const
+    {
+        if (!attr.stroke_flag && attr.stroke_gradient.get_gradient_type() == NO_GRADIENT)
+            return 0.0;
+        // miter joins reach miter_limit half widths, square caps sqrt(2)
+        return 0.5 * attr.stroke_width * std::max(attr.miter_limit, 1.5) * scaling(attr.transform);
+    }
+};
+
+} // namespace
+
+marker_sprite_key::marker_sprite_key(svg_path_ptr const& _marker,
+                                     svg::group const& group_attrs,
+                                     agg::trans_affine const& tr,
+                                     double _gamma,
+                                     int _gamma_method)
+    : marker(_marker),
+      style(),
+      sx(tr.sx),
+      shy(tr.shy),
+      shx(tr.shx),
+      sy(tr.sy),
+      dx(static_cast<int>((tr.tx - std::floor(tr.tx)) * marker_sprite_cache::subpixel_steps)),
+      dy(static_cast<int>((tr.ty - std::floor(tr.ty)) * marker_sprite_cache::subpixel_steps)),
+      gamma(_gamma),
+      gamma_method(_gamma_method)
+{
+    collect_style{style}(group_attrs);
+}
+
+std::size_t marker_sprite_key_hash::operator()(marker_sprite_key const& key) const
+{
+    std::size_t seed = std::hash<svg_storage_type const*>{}(key.marker.get());
+    for (double val : {key.sx, key.shy, key.shx, key.sy, key.gamma})
+    {
+        seed ^= std::hash<double>{}(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    for (int val : {key.dx, key.dy, key.gamma_method})
+    {
+        seed ^= std::hash<int>{}(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    for (double val : key.style)
+    {
+        seed ^= std::hash<double>{}(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+double marker_stroke_extent(svg::group const& group_attrs, agg::trans_affine const& tr)
+{
+    return stroke_extent()(group_attrs) * scaling(tr);
+}
+
+marker_sprite_cache::marker_sprite_cache()
+    : marker_sprite_cache(default_capacity)
+{}
+
+marker_sprite_cache::marker_sprite_cache(std::size_t capacity)
+    : marker_sprite_lru(capacity)
+{}
+
+} // namespace mapnik
@@ -22,6 +22,7 @@
 
 #include <mapnik/palette.hpp>
 #include <mapnik/config_error.hpp>
+#include <mapnik/image_simd.hpp>
 
 // stl
 #include <sstream>
@@ -111,7 +112,7 @@ unsigned char rgba_palette::quantize(unsigned val) const
     if (colors_ == 1 || val == 0)
         return index;
 
-    rgba_hash_table::iterator it = color_hashmap_.find(val);
+    rgba_hash_table::const_iterator it = color_hashmap_.find(val);
     if (it != color_hashmap_.end())
     {
         index = it->second;
@@ -129,6 +130,12 @@ unsigned char rgba_palette::quantize(unsigned val) const
         if (index == sorted_pal_.size())
             index--;
 
+        std::size_t nearest;
+        if (simd::nearest_rgba8(packed_pal_.data(), packed_pal_.size(), val, index, nearest))
+        {
+            return static_cast<unsigned char>(nearest);
+        }
+
         dr = sorted_pal_[index].r - c.r;
         dg = sorted_pal_[index].g - c.g;
         db = sorted_pal_[index].b - c.b;
@@ -174,9 +181,6 @@ unsigned char rgba_palette::quantize(unsigned val) const
                 dist = newdist;
             }
         }
-
-        // Cache found index for the color c into the hashmap.
-        color_hashmap_[val] = index;
     }
 
     return index;
@@ -198,6 +202,7 @@ void rgba_palette::parse(std::string const& pal, palette_type type)
     }
 
     sorted_pal_.clear();
+    packed_pal_.clear();
     rgb_pal_.clear();
     alpha_pal_.clear();
 
@@ -237,6 +242,7 @@ void rgba_palette::parse(std::string const& pal, palette_type type)
     {
         rgba c = sorted_pal_[i];
         unsigned val = c.r | (c.g << 8) | (c.b << 16) | (c.a << 24);
+        packed_pal_.push_back(val);
         if (val != 0)
         {
             color_hashmap_[val] = i;
@@ -0,0 +1,547 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#if defined(HAVE_PNG)
+
+// mapnik
+#include <mapnik/png_encoder.hpp>
+#include <mapnik/png_io.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/thread_pool.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <zlib.h>
+extern "C" {
+#include <png.h>
+}
+#if defined(HAVE_LIBDEFLATE)
+#include <libdeflate.h>
+#endif
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <ostream>
+
+namespace mapnik {
+
+namespace {
+
+// IDAT payloads are split so decoders never need large chunk buffers
+constexpr std::size_t max_idat_size = 1 << 20;
+// smallest input handed to one deflate stream in parallel mode, each
+// stream restarts its Huffman tables so tiny chunks cost compression
+constexpr std::size_t min_deflate_chunk = 1 << 18;
+// bytes of preceding input used as dictionary for a parallel chunk
+constexpr std::size_t deflate_window = 1 << 15;
+// zlib takes 32 bit lengths
+constexpr std::size_t max_deflate_input = 1 << 30;
+// rows sampled per image by select_png_filter
+constexpr unsigned filter_sample_rows = 16;
+
+constexpr std::array<int, 5> filter_flags{PNG_FILTER_NONE,
+                                          PNG_FILTER_SUB,
+                                          PNG_FILTER_UP,
+                                          PNG_FILTER_AVG,
+                                          PNG_FILTER_PAETH};
+
+void put_uint32(std::uint8_t* p, std::uint32_t value)
+{
+    p[0] = static_cast<std::uint8_t>(value >> 24);
+    p[1] = static_cast<std::uint8_t>(value >> 16);
+    p[2] = static_cast<std::uint8_t>(value >> 8);
+    p[3] = static_cast<std::uint8_t>(value);
+}
+
+// Source rows in the layout written to the file
+struct png_rows
+{
+    std::uint8_t const* data;
+    std::ptrdiff_t stride;
+    std::size_t row_bytes;
+    unsigned height;
+    unsigned bpp; // bytes per complete pixel, at least one
+    bool strip_alpha;
+
+    // Rgba rows are converted into `buffer` when the alpha channel is dropped
+    std::uint8_t const* row(unsigned y, std::uint8_t* buffer) const
+    {
+        std::uint8_t const* src = data + static_cast<std::ptrdiff_t>(y) * stride;
+        if (!strip_alpha)
+            return src;
+        for (std::size_t i = 0, j = 0; i < row_bytes; i += 3, j += 4)
+        {
+            buffer[i] = src[j];
+            buffer[i + 1] = src[j + 1];
+            buffer[i + 2] = src[j + 2];
+        }
+        return buffer;
+    }
+};
+
+std::uint8_t paeth_predictor(int a, int b, int c)
+{
+    int const p = a + b - c;
+    int const pa = std::abs(p - a);
+    int const pb = std::abs(p - b);
+    int const pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return static_cast<std::uint8_t>(a);
+    return static_cast<std::uint8_t>(pb <= pc ? b : c);
+}
+
+// Applies filter `type` (0 none, 1 sub, 2 up, 3 average, 4 paeth) to `cur`
+void filter_row(int type,
+                std::uint8_t const* cur,
+                std::uint8_t const* prev,
+                std::size_t size,
+                unsigned bpp,
+                std::uint8_t* out)
+{
+    std::size_t const head = std::min<std::size_t>(bpp, size);
+    switch (type)
+    {
+        case 0:
+            std::copy(cur, cur + size, out);
+            break;
+        case 1:
+            std::copy(cur, cur + head, out);
+            for (std::size_t i = head; i < size; ++i)
+                out[i] = static_cast<std::uint8_t>(cur[i] - cur[i - bpp]);
+            break;
+        case 2:
+            for (std::size_t i = 0; i < size; ++i)
+                out[i] = static_cast<std::uint8_t>(cur[i] - prev[i]);
+            break;
+        case 3:
+            for (std::size_t i = 0; i < head; ++i)
+                out[i] = static_cast<std::uint8_t>(cur[i] - (prev[i] >> 1));
+            for (std::size_t i = head; i < size; ++i)
+                out[i] = static_cast<std::uint8_t>(cur[i] - ((cur[i - bpp] + prev[i]) >> 1));
+            break;
+        default:
+            for (std::size_t i = 0; i < head; ++i)
+                out[i] = static_cast<std::uint8_t>(cur[i] - prev[i]);
+            for (std::size_t i = head; i < size; ++i)
+                out[i] = static_cast<std::uint8_t>(cur[i] - paeth_predictor(cur[i - bpp], prev[i], prev[i - bpp]));
+            break;
+    }
+}
+
+// Same heuristic as libpng: filtered bytes read as signed values, smaller is better
+std::size_t filter_cost(std::uint8_t const* p, std::size_t size)
+{
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        sum += p[i] < 128 ? p[i] : 256 - p[i];
+    }
+    return sum;
+}
+
+// Filters one row at a time, scratch rows are reused between calls
+class row_filter
+{
+  public:
+    explicit row_filter(png_rows const& rows)
+        : rows_(rows),
+          scratch_(rows.row_bytes * 4, 0)
+    {}
+
+    // Writes the filter type byte and row `y` filtered with the cheapest filter in `filters`
+    void filter(unsigned y, int filters, std::uint8_t* out)
+    {
+        std::size_t const size = rows_.row_bytes;
+        std::uint8_t const* cur = rows_.row(y, buffer(0));
+        std::uint8_t const* prev = y > 0 ? rows_.row(y - 1, buffer(1)) : buffer(2);
+        bool const single = (filters & (filters - 1)) == 0;
+        int best = -1;
+        std::size_t best_cost = 0;
+        for (int type = 0; type < static_cast<int>(filter_flags.size()); ++type)
+        {
+            if ((filters & filter_flags[type]) == 0)
+                continue;
+            std::uint8_t* candidate = best < 0 ? out + 1 : buffer(3);
+            filter_row(type, cur, prev, size, rows_.bpp, candidate);
+            std::size_t const cost = single ? 0 : filter_cost(candidate, size);
+            if (best < 0 || cost < best_cost)
+            {
+                if (candidate != out + 1)
+                    std::copy(candidate, candidate + size, out + 1);
+                best = type;
+                best_cost = cost;
+            }
+        }
+        out[0] = static_cast<std::uint8_t>(best);
+    }
+
+    // Adds the cost of every filter type for row `y`
+    void add_costs(unsigned y, std::array<std::size_t, 5>& costs)
+    {
+        std::size_t const size = rows_.row_bytes;
+        std::uint8_t const* cur = rows_.row(y, buffer(0));
+        std::uint8_t const* prev = y > 0 ? rows_.row(y - 1, buffer(1)) : buffer(2);
+        for (std::size_t type = 0; type < costs.size(); ++type)
+        {
+            filter_row(static_cast<int>(type), cur, prev, size, rows_.bpp, buffer(3));
+            costs[type] += filter_cost(buffer(3), size);
+        }
+    }
+
+  private:
+    // 0 and 1 hold converted rows, 2 stays zero for the row above the first one
+    std::uint8_t* buffer(std::size_t index) { return scratch_.data() + index * rows_.row_bytes; }
+
+    png_rows const& rows_;
+    std::vector<std::uint8_t> scratch_;
+};
+
+int select_filter(png_rows const& rows)
+{
+    if (rows.height == 0 || rows.row_bytes == 0)
+        return PNG_FILTER_NONE;
+    unsigned const step = std::max(1u, rows.height / filter_sample_rows);
+    std::array<std::size_t, 5> costs{};
+    row_filter filter(rows);
+    for (unsigned y = 0; y < rows.height; y += step)
+    {
+        filter.add_costs(y, costs);
+    }
+    return filter_flags[std::min_element(costs.begin(), costs.end()) - costs.begin()];
+}
+
+// Every row prefixed with its filter type byte, i.e. the uncompressed IDAT stream
+std::vector<std::uint8_t> filter_rows(png_rows const& rows, int filters, bool parallel)
+{
+    std::size_t const line = rows.row_bytes + 1;
+    std::vector<std::uint8_t> filtered(line * rows.height);
+    auto band = [&](std::size_t y0, std::size_t y1) {
+        row_filter filter(rows);
+        for (std::size_t y = y0; y < y1; ++y)
+        {
+            filter.filter(static_cast<unsigned>(y), filters, filtered.data() + y * line);
+        }
+    };
+    if (parallel)
+    {
+        std::size_t const grain = std::max<std::size_t>(1, min_deflate_chunk / line);
+        thread_pool::instance().parallel_for(rows.height, grain, band);
+    }
+    else
+    {
+        band(0, rows.height);
+    }
+    return filtered;
+}
+
+struct deflate_stream
+{
+    deflate_stream(int level, int window_bits, int strategy)
+    {
+        if (deflateInit2(&strm, level, Z_DEFLATED, window_bits, 8, strategy) != Z_OK)
+        {
+            throw image_writer_exception("png encoder: failed to initialise zlib");
+        }
+    }
+
+    ~deflate_stream() { deflateEnd(&strm); }
+
+    z_stream strm{};
+};
+
+// Compresses `size` bytes and appends the output. Non final chunks end with a
+// sync flush so the next chunk can start on a byte boundary.
+void deflate_append(z_stream& strm,
+                    std::uint8_t const* data,
+                    std::size_t size,
+                    bool finish,
+                    std::vector<std::uint8_t>& out)
+{
+    do
+    {
+        std::size_t const piece = std::min(size, max_deflate_input);
+        int const flush = piece < size ? Z_NO_FLUSH : (finish ? Z_FINISH : Z_SYNC_FLUSH);
+        strm.next_in = const_cast<Bytef*>(data);
+        strm.avail_in = static_cast<uInt>(piece);
+        do
+        {
+            std::size_t const offset = out.size();
+            std::size_t const room = std::max<std::size_t>(deflateBound(&strm, strm.avail_in), 4096);
+            out.resize(offset + room);
+            strm.next_out = out.data() + offset;
+            strm.avail_out = static_cast<uInt>(room);
+            int const ret = deflate(&strm, flush);
+            out.resize(out.size() - strm.avail_out);
+            if (ret == Z_STREAM_ERROR)
+            {
+                throw image_writer_exception("png encoder: deflate failed");
+            }
+        } while (strm.avail_out == 0);
+        data += piece;
+        size -= piece;
+    } while (size > 0);
+}
+
+std::uint32_t adler_checksum(std::uint8_t const* data, std::size_t size)
+{
+    uLong adler = adler32(0L, Z_NULL, 0);
+    while (size > 0)
+    {
+        std::size_t const piece = std::min(size, max_deflate_input);
+        adler = adler32(adler, data, static_cast<uInt>(piece));
+        data += piece;
+        size -= piece;
+    }
+    return static_cast<std::uint32_t>(adler);
+}
+
+// Header deflate() writes for a 32K window, FLEVEL only informs decoders
+void zlib_header(int level, int strategy, std::vector<std::uint8_t>& out)
+{
+    if (level == Z_DEFAULT_COMPRESSION)
+        level = 6;
+    unsigned const flevel = (strategy >= Z_HUFFMAN_ONLY || level < 2) ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3));
+    unsigned header = ((Z_DEFLATED + (7 << 4)) << 8) | (flevel << 6);
+    header += 31 - header % 31;
+    out.push_back(static_cast<std::uint8_t>(header >> 8));
+    out.push_back(static_cast<std::uint8_t>(header & 0xff));
+}
+
+// One zlib stream, split into opts.chunks raw deflate streams compressed on the
+// thread pool for large images. Each chunk is primed with the 32K of input in
+// front of it, the adler32 checksums are combined into the stream trailer.
+std::vector<std::vector<std::uint8_t>> deflate_zlib(std::vector<std::uint8_t> const& input, png_options const& opts)
+{
+    std::size_t const chunks = std::min<std::size_t>(std::max(opts.chunks, 1), input.size() / min_deflate_chunk);
+    if (chunks <= 1)
+    {
+        std::vector<std::vector<std::uint8_t>> output(1);
+        deflate_stream stream(opts.compression, 15, opts.strategy);
+        deflate_append(stream.strm, input.data(), input.size(), true, output.front());
+        return output;
+    }
+    std::vector<std::vector<std::uint8_t>> output(chunks);
+    std::vector<std::uint32_t> checksums(chunks);
+    zlib_header(opts.compression, opts.strategy, output.front());
+    thread_pool::instance().parallel_for(chunks, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            std::size_t const begin = input.size() * i / chunks;
+            std::size_t const end = input.size() * (i + 1) / chunks;
+            deflate_stream stream(opts.compression, -15, opts.strategy);
+            if (begin > 0)
+            {
+                std::size_t const dictionary = std::min(begin, deflate_window);
+                deflateSetDictionary(&stream.strm, input.data() + begin - dictionary, static_cast<uInt>(dictionary));
+            }
+            deflate_append(stream.strm, input.data() + begin, end - begin, i + 1 == chunks, output[i]);
+            checksums[i] = adler_checksum(input.data() + begin, end - begin);
+        }
+    });
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for (std::size_t i = 0; i < chunks; ++i)
+    {
+        std::size_t const length = input.size() * (i + 1) / chunks - input.size() * i / chunks;
+        adler = adler32_combine(adler, checksums[i], static_cast<z_off_t>(length));
+    }
+    std::uint8_t trailer[4];
+    put_uint32(trailer, static_cast<std::uint32_t>(adler));
+    output.back().insert(output.back().end(), trailer, trailer + 4);
+    return output;
+}
+
+#if defined(HAVE_LIBDEFLATE)
+std::vector<std::uint8_t> deflate_libdeflate(std::vector<std::uint8_t> const& input, png_options const& opts)
+{
+    // libdeflate has no strategies, its levels 1-9 roughly match zlib
+    int const level = opts.compression == Z_DEFAULT_COMPRESSION ? 6 : opts.compression;
+    std::unique_ptr<libdeflate_compressor, decltype(&libdeflate_free_compressor)> compressor(
+      libdeflate_alloc_compressor(level),
+      &libdeflate_free_compressor);
+    if (!compressor)
+    {
+        throw image_writer_exception("png encoder: failed to initialise libdeflate");
+    }
+    std::vector<std::uint8_t> output(libdeflate_zlib_compress_bound(compressor.get(), input.size()));
+    std::size_t const size =
+      libdeflate_zlib_compress(compressor.get(), input.data(), input.size(), output.data(), output.size());
+    if (size == 0)
+    {
+        throw image_writer_exception("png encoder: libdeflate compression failed");
+    }
+    output.resize(size);
+    return output;
+}
+#endif
+
+void write_chunk(std::ostream& out, char const* type, std::uint8_t const* data, std::size_t size)
+{
+    std::uint8_t header[8];
+    put_uint32(header, static_cast<std::uint32_t>(size));
+    std::memcpy(header + 4, type, 4);
+    uLong crc = crc32(0L, header + 4, 4);
+    if (size > 0)
+        crc = crc32(crc, data, static_cast<uInt>(size));
+    std::uint8_t trailer[4];
+    put_uint32(trailer, static_cast<std::uint32_t>(crc));
+    out.write(reinterpret_cast<char const*>(header), sizeof(header));
+    out.write(reinterpret_cast<char const*>(data), static_cast<std::streamsize>(size));
+    out.write(reinterpret_cast<char const*>(trailer), sizeof(trailer));
+}
+
+void write_idat(std::ostream& out, std::vector<std::uint8_t> const& data)
+{
+    for (std::size_t offset = 0; offset < data.size(); offset += max_idat_size)
+    {
+        write_chunk(out, "IDAT", data.data() + offset, std::min(max_idat_size, data.size() - offset));
+    }
+}
+
+void write_header(std::ostream& out, unsigned width, unsigned height, int bit_depth, int color_type)
+{
+    static std::uint8_t const signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    out.write(reinterpret_cast<char const*>(signature), sizeof(signature));
+    std::uint8_t ihdr[13];
+    put_uint32(ihdr, width);
+    put_uint32(ihdr + 4, height);
+    ihdr[8] = static_cast<std::uint8_t>(bit_depth);
+    ihdr[9] = static_cast<std::uint8_t>(color_type);
+    ihdr[10] = PNG_COMPRESSION_TYPE_BASE;
+    ihdr[11] = PNG_FILTER_TYPE_BASE;
+    ihdr[12] = PNG_INTERLACE_NONE;
+    write_chunk(out, "IHDR", ihdr, sizeof(ihdr));
+}
+
+void write_image_data(std::ostream& out, png_rows const& rows, png_options const& opts)
+{
+    int filters = opts.auto_filter ? select_filter(rows) : (opts.filters & PNG_ALL_FILTERS);
+    if (filters == 0)
+        filters = PNG_FILTER_NONE;
+    bool const parallel = opts.encoder == png_encoder::zlib && opts.chunks > 1;
+    std::vector<std::uint8_t> const filtered = filter_rows(rows, filters, parallel);
+    if (opts.encoder == png_encoder::libdeflate)
+    {
+#if defined(HAVE_LIBDEFLATE)
+        write_idat(out, deflate_libdeflate(filtered, opts));
+#else
+        throw image_writer_exception("libdeflate support is not enabled in your build of Mapnik");
+#endif
+    }
+    else
+    {
+        for (auto const& chunk : deflate_zlib(filtered, opts))
+        {
+            write_idat(out, chunk);
+        }
+    }
+    write_chunk(out, "IEND", nullptr, 0);
+}
+
+} // namespace
+
+bool png_encoder_available(png_encoder encoder)
+{
+    switch (encoder)
+    {
+        case png_encoder::libdeflate:
+#if defined(HAVE_LIBDEFLATE)
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+int select_png_filter(std::uint8_t const* data,
+                      std::ptrdiff_t stride,
+                      std::size_t row_bytes,
+                      unsigned height,
+                      unsigned bytes_per_pixel)
+{
+    return select_filter(png_rows{data, stride, row_bytes, height, bytes_per_pixel, false});
+}
+
+void encode_png_rgba8(std::ostream& out,
+                      std::uint8_t const* data,
+                      std::ptrdiff_t stride,
+                      unsigned width,
+                      unsigned height,
+                      png_options const& opts)
+{
+    bool const strip_alpha = opts.trans_mode == 0;
+    unsigned const bpp = strip_alpha ? 3 : 4;
+    write_header(out, width, height, 8, strip_alpha ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_RGB_ALPHA);
+    write_image_data(out, png_rows{data, stride, std::size_t(width) * bpp, height, bpp, strip_alpha}, opts);
+}
+
+void encode_png_palette(std::ostream& out,
+                        std::vector<rgb> const& palette,
+                        image_gray8 const& image,
+                        unsigned width,
+                        unsigned height,
+                        unsigned color_depth,
+                        std::vector<unsigned> const& alpha,
+                        png_options const& opts)
+{
+    write_header(out, width, height, static_cast<int>(color_depth), PNG_COLOR_TYPE_PALETTE);
+    std::vector<std::uint8_t> plte;
+    plte.reserve(palette.size() * 3);
+    for (rgb const& c : palette)
+    {
+        plte.push_back(c.r);
+        plte.push_back(c.g);
+        plte.push_back(c.b);
+    }
+    write_chunk(out, "PLTE", plte.data(), plte.size());
+    // truncated after the last non opaque entry like the libpng path
+    std::vector<std::uint8_t> trans(alpha.size());
+    std::size_t trans_size = 0;
+    for (std::size_t i = 0; i < alpha.size(); ++i)
+    {
+        trans[i] = static_cast<std::uint8_t>(alpha[i]);
+        if (alpha[i] < 255)
+            trans_size = i + 1;
+    }
+    if (trans_size > 0)
+    {
+        write_chunk(out, "tRNS", trans.data(), trans_size);
+    }
+    png_rows const rows{image.get_row(0),
+                        static_cast<std::ptrdiff_t>(image.row_size()),
+                        (std::size_t(width) * color_depth + 7) / 8,
+                        height,
+                        1,
+                        false};
+    write_image_data(out, rows, opts);
+}
+
+} // namespace mapnik
+
+#endif // HAVE_PNG
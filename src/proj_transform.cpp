@@ -126,7 +126,9 @@ proj_transform::proj_transform(projection const& source, projection const& dest)
       is_dest_longlat_(false),
       is_source_equal_dest_(false),
       wgs84_to_merc_(false),
-      merc_to_wgs84_(false)
+      merc_to_wgs84_(false),
+      source_params_(source.params()),
+      dest_params_(dest.params())
 {
     is_source_equal_dest_ = (source == dest);
     if (!is_source_equal_dest_)
@@ -552,4 +554,14 @@ std::string proj_transform::definition() const
     return "unknown";
 }
 
+std::string const& proj_transform::source_params() const
+{
+    return source_params_;
+}
+
+std::string const& proj_transform::dest_params() const
+{
+    return dest_params_;
+}
+
 } // namespace mapnik
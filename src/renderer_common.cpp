@@ -26,9 +26,29 @@
 #include <mapnik/request.hpp>
 #include <mapnik/attribute.hpp>
 #include <mapnik/safe_cast.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/boolean.hpp>
+#include <mapnik/text/glyph_cache.hpp>
+#include <mapnik/renderer_common/geometry_cache.hpp>
 
 namespace mapnik {
 
+namespace {
+
+glyph_cache* shared_glyph_cache(Map const& map)
+{
+    bool const enabled = *map.get_extra_parameters().get<boolean_type>("glyph-cache", false);
+    return enabled ? &glyph_cache::instance() : nullptr;
+}
+
+std::shared_ptr<geometry_cache> layer_geometry_cache(Map const& map)
+{
+    bool const enabled = *map.get_extra_parameters().get<boolean_type>("geometry-cache", false);
+    return enabled ? std::make_shared<geometry_cache>() : nullptr;
+}
+
+} // namespace
+
 // copy constructor exclusively for virtual_renderer_common
 renderer_common::renderer_common(renderer_common const& other)
     : width_(other.width_),
@@ -40,7 +60,9 @@ renderer_common::renderer_common(renderer_common const& other)
       font_manager_(other.font_manager_),
       query_extent_(other.query_extent_),
       t_(other.t_),
-      detector_(other.detector_)
+      detector_(other.detector_),
+      glyph_cache_(other.glyph_cache_),
+      geometry_cache_(other.geometry_cache_)
 {}
 
 renderer_common::renderer_common(Map const& map,
@@ -59,7 +81,9 @@ renderer_common::renderer_common(Map const& map,
       font_manager_(font_library_, map.get_font_file_mapping(), map.get_font_memory_cache()),
       query_extent_(),
       t_(t),
-      detector_(detector)
+      detector_(detector),
+      glyph_cache_(shared_glyph_cache(map)),
+      geometry_cache_(layer_geometry_cache(map))
 {}
 
 renderer_common::renderer_common(Map const& m,
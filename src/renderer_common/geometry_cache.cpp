@@ -0,0 +1,136 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/renderer_common/geometry_cache.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/geometry/geometry_type.hpp>
+
+// stl
+#include <functional>
+
+namespace mapnik {
+
+geometry_cache_key::geometry_cache_key(feature_impl const& feature,
+                                       clip_type _clip,
+                                       box2d<double> const& _clip_box,
+                                       agg::trans_affine const& _affine_trans,
+                                       symbolizer_base const& sym,
+                                       attributes const& vars)
+    : feature_id(feature.id()),
+      geometry_type(geometry::geometry_type(feature.get_geometry())),
+      clip(_clip),
+      clip_box(_clip != no_clip ? _clip_box : box2d<double>()),
+      affine_trans(_affine_trans),
+      simplify_tolerance(get<value_double, keys::simplify_tolerance>(sym, feature, vars)),
+      simplify_algorithm(radial_distance),
+      smooth(get<value_double, keys::smooth>(sym, feature, vars)),
+      smooth_algorithm(smooth_algorithm_enum::SMOOTH_ALGORITHM_BASIC)
+{
+    if (simplify_tolerance > 0.0)
+    {
+        simplify_algorithm = get<simplify_algorithm_e, keys::simplify_algorithm>(sym, feature, vars);
+    }
+    if (smooth > 0.0)
+    {
+        smooth_algorithm = get<smooth_algorithm_enum, keys::smooth_algorithm>(sym, feature, vars);
+    }
+}
+
+std::size_t geometry_cache_key_hash::operator()(geometry_cache_key const& key) const
+{
+    std::size_t seed = std::hash<value_integer>{}(key.feature_id);
+    seed ^= std::hash<unsigned>{}(key.geometry_type) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<unsigned>{}(key.clip) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    for (double val : {key.clip_box.minx(), key.clip_box.miny(), key.clip_box.maxx(), key.clip_box.maxy()})
+    {
+        seed ^= std::hash<double>{}(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    double matrix[6];
+    key.affine_trans.store_to(matrix);
+    for (double val : matrix)
+    {
+        seed ^= std::hash<double>{}(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    seed ^= std::hash<double>{}(key.simplify_tolerance) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<unsigned>{}(key.simplify_algorithm) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<double>{}(key.smooth) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<unsigned>{}(static_cast<unsigned>(key.smooth_algorithm)) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+geometry_cache::geometry_cache(std::size_t capacity)
+    : capacity_(capacity),
+      bytes_(0),
+      enabled_(true),
+      hits_(0),
+      misses_(0)
+{}
+
+geometry_cache::paths_ptr geometry_cache::find(geometry_cache_key const& key)
+{
+    auto itr = paths_.find(key);
+    if (itr == paths_.end())
+    {
+        ++misses_;
+        return paths_ptr();
+    }
+    ++hits_;
+    return itr->second;
+}
+
+geometry_cache::paths_ptr geometry_cache::insert(geometry_cache_key const& key, paths_type&& paths)
+{
+    std::size_t bytes = sizeof(geometry_cache_key) + sizeof(paths_ptr) + sizeof(paths_type);
+    for (geometry_cache_path const& path : paths)
+    {
+        bytes += sizeof(geometry_cache_path) + path.vertices.size() * sizeof(agg::vertex_d);
+    }
+    auto result = std::make_shared<paths_type const>(std::move(paths));
+    // styles render the features of a layer one after the other, evicting
+    // wouldn't help the next style so once full geometries just aren't kept
+    if (bytes_ + bytes > capacity_)
+    {
+        return result;
+    }
+    auto itr = paths_.emplace(key, result).first;
+    if (itr->second == result)
+    {
+        bytes_ += bytes;
+    }
+    return itr->second;
+}
+
+void geometry_cache::clear()
+{
+    paths_.clear();
+    bytes_ = 0;
+}
+
+void geometry_cache::start_layer(layer const& lay)
+{
+    clear();
+    enabled_ = lay.cache_features() || !lay.group_by().empty() || lay.sort_by().has_value();
+}
+
+} // namespace mapnik
@@ -0,0 +1,175 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/resolved_symbolizer.hpp>
+#include <mapnik/expression_node.hpp>
+#include <mapnik/feature.hpp>
+
+namespace mapnik {
+
+namespace {
+
+struct expression_uses_feature
+{
+    bool operator()(attribute const&) const { return true; }
+
+    bool operator()(geometry_type_attribute const&) const { return true; }
+
+    template<typename Tag>
+    bool operator()(binary_node<Tag> const& x) const
+    {
+        return util::apply_visitor(*this, x.left) || util::apply_visitor(*this, x.right);
+    }
+
+    template<typename Tag>
+    bool operator()(unary_node<Tag> const& x) const
+    {
+        return util::apply_visitor(*this, x.expr);
+    }
+
+    bool operator()(regex_match_node const& x) const { return util::apply_visitor(*this, x.expr); }
+
+    bool operator()(regex_replace_node const& x) const { return util::apply_visitor(*this, x.expr); }
+
+    bool operator()(unary_function_call const& call) const { return util::apply_visitor(*this, call.arg); }
+
+    bool operator()(binary_function_call const& call) const
+    {
+        return util::apply_visitor(*this, call.arg1) || util::apply_visitor(*this, call.arg2);
+    }
+
+    template<typename T>
+    bool operator()(T const&) const
+    {
+        return false;
+    }
+};
+
+struct value_uses_feature
+{
+    bool operator()(expression_ptr const& expr) const
+    {
+        return expr && util::apply_visitor(expression_uses_feature(), *expr);
+    }
+
+    bool operator()(path_expression_ptr const& expr) const
+    {
+        if (expr)
+        {
+            for (auto const& component : *expr)
+            {
+                if (component.is<attribute>())
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename T>
+    bool operator()(T const&) const
+    {
+        return false;
+    }
+};
+
+template<typename Properties, typename Map>
+Properties const& find_or_resolve(Map& cache,
+                                  symbolizer_base const& sym,
+                                  feature_impl const& feature,
+                                  attributes const& vars)
+{
+    auto itr = cache.find(&sym);
+    if (itr == cache.end())
+    {
+        itr = cache.emplace(&sym, Properties(sym, feature, vars)).first;
+    }
+    return itr->second;
+}
+
+} // namespace
+
+bool is_feature_dependent(symbolizer_base::value_type const& val)
+{
+    return util::apply_visitor(value_uses_feature(), val);
+}
+
+line_symbolizer_properties::line_symbolizer_properties(symbolizer_base const& sym,
+                                                       feature_impl const& feature,
+                                                       attributes const& vars)
+    : geometry_transform(get<transform_type>(sym, keys::geometry_transform)),
+      has_dasharray(has_key(sym, keys::stroke_dasharray))
+{
+    stroke.resolve(sym, feature, vars);
+    stroke_gamma.resolve(sym, feature, vars);
+    stroke_gamma_method.resolve(sym, feature, vars);
+    comp_op.resolve(sym, feature, vars);
+    clip.resolve(sym, feature, vars);
+    stroke_width.resolve(sym, feature, vars);
+    stroke_opacity.resolve(sym, feature, vars);
+    offset.resolve(sym, feature, vars);
+    simplify_tolerance.resolve(sym, feature, vars);
+    smooth.resolve(sym, feature, vars);
+    line_rasterizer.resolve(sym, feature, vars);
+    stroke_linejoin.resolve(sym, feature, vars);
+    stroke_linecap.resolve(sym, feature, vars);
+}
+
+polygon_symbolizer_properties::polygon_symbolizer_properties(symbolizer_base const& sym,
+                                                             feature_impl const& feature,
+                                                             attributes const& vars)
+    : geometry_transform(get<transform_type>(sym, keys::geometry_transform))
+{
+    fill.resolve(sym, feature, vars);
+    fill_opacity.resolve(sym, feature, vars);
+    gamma.resolve(sym, feature, vars);
+    gamma_method.resolve(sym, feature, vars);
+    comp_op.resolve(sym, feature, vars);
+    clip.resolve(sym, feature, vars);
+    simplify_tolerance.resolve(sym, feature, vars);
+    smooth.resolve(sym, feature, vars);
+}
+
+line_symbolizer_properties const&
+  resolved_symbolizer_cache::get(line_symbolizer const& sym, feature_impl const& feature, attributes const& vars)
+{
+    return find_or_resolve<line_symbolizer_properties>(lines_, sym, feature, vars);
+}
+
+polygon_symbolizer_properties const&
+  resolved_symbolizer_cache::get(polygon_symbolizer const& sym, feature_impl const& feature, attributes const& vars)
+{
+    return find_or_resolve<polygon_symbolizer_properties>(polygons_, sym, feature, vars);
+}
+
+void resolved_symbolizer_cache::clear()
+{
+    lines_.clear();
+    polygons_.clear();
+}
+
+std::size_t resolved_symbolizer_cache::size() const
+{
+    return lines_.size() + polygons_.size();
+}
+
+} // namespace mapnik
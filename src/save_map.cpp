@@ -542,6 +542,11 @@ void serialize_layer(ptree& map_node, layer const& lyr, bool explicit_defaults)
         set_attr /*<bool>*/ (layer_node, "cache-features", lyr.cache_features());
     }
 
+    if (lyr.query_ahead() || explicit_defaults)
+    {
+        set_attr /*<bool>*/ (layer_node, "query-ahead", lyr.query_ahead());
+    }
+
     if (lyr.group_by() != "" || explicit_defaults)
     {
         set_attr(layer_node, "group-by", lyr.group_by());
@@ -31,14 +31,18 @@ extern "C" {
 #include FT_GLYPH_H
 #include FT_TRUETYPE_TABLES_H
 }
+#include <harfbuzz/hb.h>
+#include <harfbuzz/hb-ft.h>
 
 MAPNIK_DISABLE_WARNING_POP
 
 namespace mapnik {
 
-font_face::font_face(FT_Face face)
+font_face::font_face(FT_Face face, std::string const& file_name)
     : face_(face),
-      color_font_(init_color_font())
+      id_(file_name + ':' + std::to_string(face->face_index)),
+      color_font_(init_color_font()),
+      hb_font_(nullptr)
 {}
 
 bool font_face::init_color_font()
@@ -101,11 +105,29 @@ bool font_face::glyph_dimensions(glyph_info& glyph) const
 
     return true;
 }
+hb_font_t* font_face::hb_font()
+{
+    if (!hb_font_)
+    {
+        // hb_ft reads the scale once, shaping always happens at the unscaled size
+        set_unscaled_character_sizes();
+        hb_font_ = hb_ft_font_create(face_, nullptr);
+        // https://github.com/mapnik/test-data-visual/pull/25
+#if HB_VERSION_MAJOR > 0
+#if HB_VERSION_ATLEAST(1, 0, 5)
+        hb_ft_font_set_load_flags(hb_font_, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING);
+#endif
+#endif
+    }
+    return hb_font_;
+}
 
 font_face::~font_face()
 {
     MAPNIK_LOG_DEBUG(font_face) << "font_face: Clean up face \"" << family_name() << " " << style_name() << "\"";
 
+    if (hb_font_)
+        hb_font_destroy(hb_font_);
     FT_Done_Face(face_);
 }
 
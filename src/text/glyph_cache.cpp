@@ -0,0 +1,71 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/text/glyph_cache.hpp>
+
+// stl
+#include <functional>
+
+namespace mapnik {
+
+template class util::lru_cache<glyph_cache_key, glyph_bitmap, glyph_cache_key_hash, glyph_cache_cost>;
+template class singleton<glyph_cache, CreateUsingNew>;
+
+namespace {
+
+template<typename T>
+void hash_combine(std::size_t& seed, T const& value)
+{
+    seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+} // namespace
+
+std::size_t glyph_cache_key_hash::operator()(glyph_cache_key const& key) const
+{
+    std::size_t seed = std::hash<std::string>{}(key.face);
+    hash_combine(seed, key.glyph_index);
+    hash_combine(seed, key.size);
+    hash_combine(seed, key.xx);
+    hash_combine(seed, key.xy);
+    hash_combine(seed, key.yx);
+    hash_combine(seed, key.yy);
+    hash_combine(seed, key.subpixel_x * glyph_cache::subpixel_steps + key.subpixel_y);
+    hash_combine(seed, key.halo_radius);
+    return seed;
+}
+
+std::size_t glyph_cache_cost::operator()(glyph_cache_key const& key, glyph_bitmap const& bitmap) const
+{
+    return sizeof(glyph_cache_key) + key.face.size() + sizeof(glyph_bitmap) + bitmap.buffer.size();
+}
+
+glyph_cache::glyph_cache()
+    : glyph_cache(default_capacity)
+{}
+
+glyph_cache::glyph_cache(std::size_t capacity)
+    : glyph_lru(capacity)
+{}
+
+} // namespace mapnik
@@ -32,6 +32,9 @@
 #include <mapnik/image_any.hpp>
 #include <mapnik/agg_rasterizer.hpp>
 
+// stl
+#include <cstring>
+
 namespace mapnik {
 
 text_renderer::text_renderer(halo_rasterizer_e rasterizer,
@@ -46,7 +49,8 @@ text_renderer::text_renderer(halo_rasterizer_e rasterizer,
       glyphs_(),
       stroker_(stroker),
       transform_(),
-      halo_transform_()
+      halo_transform_(),
+      glyph_cache_(nullptr)
 {}
 
 void text_renderer::set_transform(agg::trans_affine const& transform)
@@ -109,6 +113,17 @@ void text_renderer::prepare_glyphs(glyph_positions const& positions)
         pen.x = static_cast<FT_Pos>(pos.x * 64);
         pen.y = static_cast<FT_Pos>(pos.y * 64);
 
+        box2d<double> bbox(0, glyph_pos.glyph.ymin(), glyph_pos.glyph.advance(), glyph_pos.glyph.ymax());
+        if (glyph_cache_ && !glyph.face->is_color())
+        {
+            // rasterized on demand in the final position, see cached_bitmap()
+            glyph_t& cached = glyphs_.emplace_back(nullptr, *glyph.format, pos, glyph_pos.rot, size, bbox);
+            cached.info = &glyph;
+            cached.matrix = matrix;
+            cached.pen = pen;
+            continue;
+        }
+
         FT_Set_Transform(face, &matrix, &pen);
         error = FT_Load_Glyph(face, glyph.glyph_index, load_flags);
         if (error)
@@ -117,28 +132,115 @@ void text_renderer::prepare_glyphs(glyph_positions const& positions)
         error = FT_Get_Glyph(face->glyph, &image);
         if (error)
             continue;
-        box2d<double> bbox(0, glyph_pos.glyph.ymin(), glyph_pos.glyph.advance(), glyph_pos.glyph.ymax());
         glyphs_.emplace_back(image, *glyph.format, pos, glyph_pos.rot, size, bbox);
     }
 }
 
+namespace {
+
+// Split a 26.6 coordinate into whole pixels and a subpixel step of the glyph cache
+unsigned subpixel_step(FT_Pos value, FT_Pos& pixels)
+{
+    constexpr FT_Pos steps = glyph_cache::subpixel_steps;
+    pixels = value >= 0 ? value / 64 : -((63 - value) / 64);
+    FT_Pos step = ((value - pixels * 64) * steps + 32) / 64;
+    if (step == steps)
+    {
+        ++pixels;
+        step = 0;
+    }
+    return static_cast<unsigned>(step);
+}
+
+} // namespace
+
+glyph_bitmap_ptr text_renderer::cached_bitmap(glyph_t const& glyph,
+                                              FT_Matrix const& matrix,
+                                              FT_Vector const& start,
+                                              double halo_radius,
+                                              int& left,
+                                              int& top)
+{
+    FT_Matrix combined = glyph.matrix;
+    FT_Matrix_Multiply(&matrix, &combined);
+    FT_Vector offset = glyph.pen;
+    FT_Vector_Transform(&offset, &matrix);
+    FT_Pos pixels_x;
+    FT_Pos pixels_y;
+    unsigned step_x = subpixel_step(offset.x + start.x, pixels_x);
+    unsigned step_y = subpixel_step(offset.y + start.y, pixels_y);
+
+    face_ptr const& face = glyph.info->face;
+    glyph_cache_key key{face->id(),
+                        glyph.info->glyph_index,
+                        static_cast<std::int64_t>(glyph.size * 64),
+                        combined.xx,
+                        combined.xy,
+                        combined.yx,
+                        combined.yy,
+                        step_x,
+                        step_y,
+                        static_cast<std::int64_t>(halo_radius * 64)};
+    glyph_bitmap_ptr bitmap = glyph_cache_->find(key);
+    if (!bitmap)
+    {
+        FT_Face ft_face = face->get_face();
+        face->set_character_sizes(glyph.size);
+        FT_Vector delta;
+        delta.x = static_cast<FT_Pos>(step_x * 64 / glyph_cache::subpixel_steps);
+        delta.y = static_cast<FT_Pos>(step_y * 64 / glyph_cache::subpixel_steps);
+        FT_Set_Transform(ft_face, &combined, &delta);
+        if (FT_Load_Glyph(ft_face, glyph.info->glyph_index, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING))
+            return glyph_bitmap_ptr();
+        FT_Glyph image;
+        if (FT_Get_Glyph(ft_face->glyph, &image))
+            return glyph_bitmap_ptr();
+        if (key.halo_radius > 0)
+        {
+            stroker_->init(halo_radius);
+            FT_Glyph_Stroke(&image, stroker_->get(), 1);
+        }
+        if (FT_Glyph_To_Bitmap(&image, FT_RENDER_MODE_NORMAL, 0, 1))
+        {
+            FT_Done_Glyph(image);
+            return glyph_bitmap_ptr();
+        }
+        FT_BitmapGlyph bit = reinterpret_cast<FT_BitmapGlyph>(image);
+        glyph_bitmap result{bit->left, bit->top, bit->bitmap.width, bit->bitmap.rows, {}};
+        result.buffer.resize(result.width * result.rows);
+        for (unsigned row = 0; row < result.rows; ++row)
+        {
+            std::memcpy(result.buffer.data() + row * result.width,
+                        bit->bitmap.buffer + row * bit->bitmap.pitch,
+                        result.width);
+        }
+        FT_Done_Glyph(image);
+        bitmap = glyph_cache_->insert(key, std::move(result));
+    }
+    left = bitmap->left + static_cast<int>(pixels_x);
+    top = bitmap->top + static_cast<int>(pixels_y);
+    return bitmap;
+}
+
 template<typename T>
 void composite_bitmap(T& pixmap,
-                      FT_Bitmap* bitmap,
+                      unsigned char const* buffer,
+                      unsigned width,
+                      unsigned rows,
                       unsigned rgba,
                       int x,
                       int y,
                       double opacity,
                       composite_mode_e comp_op)
 {
-    int x_max = x + bitmap->width;
-    int y_max = y + bitmap->rows;
+    int x_max = x + width;
+    int y_max = y + rows;
 
     for (int i = x, p = 0; i < x_max; ++i, ++p)
     {
         for (int j = y, q = 0; j < y_max; ++j, ++q)
         {
-            unsigned gray = bitmap->buffer[q * bitmap->width + p];
+            unsigned gray = buffer[q * width + p];
             if (gray)
             {
                 mapnik::composite_pixel(pixmap, comp_op, i, j, rgba, gray, opacity);
@@ -204,6 +306,40 @@ void agg_text_renderer<T>::render(glyph_positions const& pos)
         // make sure we've got reasonable values.
         if (halo_radius <= 0.0 || halo_radius > 1024.0)
             continue;
+        if (!glyph.image)
+        {
+            bool full = rasterizer_ == halo_rasterizer_enum::HALO_RASTERIZER_FULL;
+            int left, top;
+            glyph_bitmap_ptr bitmap =
+              cached_bitmap(glyph, halo_matrix, start_halo, full ? halo_radius : 0.0, left, top);
+            if (!bitmap)
+                continue;
+            if (full)
+            {
+                composite_bitmap(pixmap_,
+                                 bitmap->buffer.data(),
+                                 bitmap->width,
+                                 bitmap->rows,
+                                 halo_fill,
+                                 left,
+                                 height - top,
+                                 halo_opacity,
+                                 halo_comp_op_);
+            }
+            else
+            {
+                render_halo<1>(bitmap->buffer.data(),
+                               bitmap->width,
+                               bitmap->rows,
+                               halo_fill,
+                               left,
+                               height - top,
+                               halo_radius,
+                               halo_opacity,
+                               halo_comp_op_);
+            }
+            continue;
+        }
         FT_Glyph g;
         error = FT_Glyph_Copy(glyph.image, &g);
         if (!error)
@@ -235,7 +371,9 @@ void agg_text_renderer<T>::render(glyph_positions const& pos)
                     else
                     {
                         composite_bitmap(pixmap_,
-                                         &bit->bitmap,
+                                         bit->bitmap.buffer,
+                                         bit->bitmap.width,
+                                         bit->bitmap.rows,
                                          halo_fill,
                                          bit->left,
                                          height - bit->top,
@@ -290,6 +428,24 @@ void agg_text_renderer<T>::render(glyph_positions const& pos)
         fill = glyph.properties.fill.rgba();
         text_opacity = glyph.properties.text_opacity;
 
+        if (!glyph.image)
+        {
+            int left, top;
+            glyph_bitmap_ptr bitmap = cached_bitmap(glyph, matrix, start, 0.0, left, top);
+            if (bitmap)
+            {
+                composite_bitmap(pixmap_,
+                                 bitmap->buffer.data(),
+                                 bitmap->width,
+                                 bitmap->rows,
+                                 fill,
+                                 left,
+                                 height - top,
+                                 text_opacity,
+                                 comp_op_);
+            }
+            continue;
+        }
         FT_Glyph_Transform(glyph.image, &matrix, &start);
         error = 0;
         if (glyph.image->format != FT_GLYPH_FORMAT_BITMAP)
@@ -310,7 +466,15 @@ void agg_text_renderer<T>::render(glyph_positions const& pos)
             }
             else
             {
-                composite_bitmap(pixmap_, &bit->bitmap, fill, bit->left, height - bit->top, text_opacity, comp_op_);
+                composite_bitmap(pixmap_,
+                                 bit->bitmap.buffer,
+                                 bit->bitmap.width,
+                                 bit->bitmap.rows,
+                                 fill,
+                                 bit->left,
+                                 height - bit->top,
+                                 text_opacity,
+                                 comp_op_);
             }
         }
         FT_Done_Glyph(glyph.image);
@@ -340,6 +504,22 @@ void grid_text_renderer<T>::render(glyph_positions const& pos, value_integer fea
     for (auto& glyph : glyphs_)
     {
         halo_radius = glyph.properties.halo_radius * scale_factor_;
+        if (!glyph.image)
+        {
+            int left, top;
+            glyph_bitmap_ptr bitmap = cached_bitmap(glyph, halo_matrix, start, 0.0, left, top);
+            if (bitmap)
+            {
+                render_halo_id<1>(bitmap->buffer.data(),
+                                  bitmap->width,
+                                  bitmap->rows,
+                                  feature_id,
+                                  left,
+                                  height - top,
+                                  static_cast<int>(halo_radius));
+            }
+            continue;
+        }
         FT_Glyph_Transform(glyph.image, &halo_matrix, &start);
         error = FT_Glyph_To_Bitmap(&glyph.image, FT_RENDER_MODE_NORMAL, 0, 1);
         if (!error)
@@ -375,7 +555,7 @@ void grid_text_renderer<T>::render(glyph_positions const& pos, value_integer fea
 
 template<typename T>
 template<std::size_t PixelWidth>
-void agg_text_renderer<T>::render_halo(unsigned char* buffer,
+void agg_text_renderer<T>::render_halo(unsigned char const* buffer,
                                        unsigned width,
                                        unsigned height,
                                        unsigned rgba,
@@ -453,7 +633,7 @@ void agg_text_renderer<T>::render_halo(unsigned char* buffer,
 
 template<typename T>
 template<std::size_t PixelWidth>
-void grid_text_renderer<T>::render_halo_id(unsigned char* buffer,
+void grid_text_renderer<T>::render_halo_id(unsigned char const* buffer,
                                            unsigned width,
                                            unsigned height,
                                            mapnik::value_integer feature_id,
@@ -0,0 +1,51 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/text/shaping_cache.hpp>
+
+// stl
+#include <functional>
+
+namespace mapnik {
+
+template class util::lru_cache<shaping_cache_key, shaped_line, shaping_cache_key_hash, shaping_cache_cost>;
+template class singleton<shaping_cache, CreateUsingNew>;
+
+std::size_t shaping_cache_key_hash::operator()(shaping_cache_key const& key) const
+{
+    std::size_t seed = static_cast<std::size_t>(key.text.hashCode());
+    seed ^= std::hash<std::string>{}(key.formats) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<unsigned>{}(key.start) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<unsigned>{}(key.end) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+shaping_cache::shaping_cache()
+    : shaping_cache(default_capacity)
+{}
+
+shaping_cache::shaping_cache(std::size_t capacity)
+    : shaping_lru(capacity)
+{}
+
+} // namespace mapnik
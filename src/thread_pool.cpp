@@ -0,0 +1,130 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/thread_pool.hpp>
+
+// stl
+#include <algorithm>
+
+namespace mapnik {
+
+template class singleton<thread_pool, CreateUsingNew>;
+
+thread_pool::thread_pool()
+#ifdef MAPNIK_THREADSAFE
+    : thread_pool(std::max(2u, std::thread::hardware_concurrency()))
+#else
+    : thread_pool(0)
+#endif
+{}
+
+thread_pool::thread_pool(std::size_t num_threads)
+    : tasks_(),
+      stop_(false)
+{
+#ifdef MAPNIK_THREADSAFE
+    workers_.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        workers_.emplace_back(&thread_pool::work, this);
+    }
+#endif
+}
+
+thread_pool::~thread_pool()
+{
+#ifdef MAPNIK_THREADSAFE
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& worker : workers_)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+#endif
+}
+
+std::size_t thread_pool::size() const
+{
+#ifdef MAPNIK_THREADSAFE
+    return workers_.size();
+#else
+    return 0;
+#endif
+}
+
+void thread_pool::enqueue(std::function<void()>&& task)
+{
+#ifdef MAPNIK_THREADSAFE
+    if (!workers_.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cond_.notify_one();
+        return;
+    }
+#endif
+    task();
+}
+
+bool thread_pool::run_pending_task()
+{
+    std::function<void()> task;
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+#endif
+        if (tasks_.empty())
+            return false;
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+    }
+    task();
+    return true;
+}
+
+void thread_pool::work()
+{
+#ifdef MAPNIK_THREADSAFE
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (stop_ && tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+#endif
+}
+
+} // namespace mapnik
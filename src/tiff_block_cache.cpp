@@ -0,0 +1,53 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/tiff_block_cache.hpp>
+
+// stl
+#include <functional>
+
+namespace mapnik {
+
+template class util::lru_cache<tiff_block_key, tiff_block, tiff_block_key_hash, tiff_block_cost>;
+template class singleton<tiff_block_cache, CreateUsingNew>;
+
+std::size_t tiff_block_key_hash::operator()(tiff_block_key const& key) const
+{
+    std::size_t seed = std::hash<std::string>{}(key.filename);
+    seed ^= std::hash<std::int64_t>{}(key.stamp.mtime) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<std::uintmax_t>{}(key.stamp.size) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<unsigned>{}(key.directory) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<unsigned>{}(key.block) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<bool>{}(key.rgba) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+tiff_block_cache::tiff_block_cache()
+    : tiff_block_cache(default_capacity)
+{}
+
+tiff_block_cache::tiff_block_cache(std::size_t capacity)
+    : tiff_block_lru(capacity)
+{}
+
+} // namespace mapnik
@@ -2,6 +2,8 @@
 // mapnik
 #include <mapnik/debug.hpp>
 #include <mapnik/image_reader.hpp>
+#include <mapnik/thread_pool.hpp>
+#include <mapnik/tiff_block_cache.hpp>
 #include <mapnik/util/char_array_buffer.hpp>
 extern "C" {
 #include <tiffio.h>
@@ -21,6 +23,12 @@ MAPNIK_DISABLE_WARNING_POP
 #include <memory>
 #include <fstream>
 #include <algorithm>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace mapnik {
 namespace detail {
@@ -67,10 +75,23 @@ class tiff_reader : public image_reader
         }
     };
 
+    // reduced resolution subfile
+    struct overview
+    {
+        unsigned directory;
+        unsigned width;
+        unsigned height;
+    };
+
   private:
     source_type source_;
     input_stream stream_;
     tiff_ptr tif_;
+    std::string filename_;
+    std::optional<util::file_stamp> stamp_; // of the file when it was opened, its blocks are cached under it
+    char const* data_;
+    std::size_t size_;
+    unsigned directory_;
     int read_method_;
     int rows_per_strip_;
     int tile_width_;
@@ -86,6 +107,7 @@ class tiff_reader : public image_reader
     unsigned compression_;
     bool has_alpha_;
     bool is_tiled_;
+    mutable std::optional<std::vector<overview>> overviews_;
 
   public:
     enum TiffType { generic = 1, stripped, tiled };
@@ -108,11 +130,15 @@ class tiff_reader : public image_reader
     unsigned rows_per_strip() const { return rows_per_strip_; }
     unsigned planar_config() const { return planar_config_; }
     unsigned compression() const { return compression_; }
+    std::vector<std::pair<unsigned, unsigned>> overviews() const final;
+    void select_overview(unsigned index) final;
 
   private:
     tiff_reader(tiff_reader const&);
     tiff_reader& operator=(tiff_reader const&);
     void init();
+    void read_directory(TIFF* tif);
+    std::vector<overview> const& scan_overviews() const;
 
     template<typename ImageData>
     void read_generic(std::size_t x, std::size_t y, ImageData& image);
@@ -126,6 +152,11 @@ class tiff_reader : public image_reader
     template<typename ImageData>
     image_any read_any_gray(std::size_t x, std::size_t y, std::size_t width, std::size_t height);
 
+    template<typename ImageData>
+    std::vector<tiff_block_ptr> read_blocks(TIFF* tif, std::vector<std::pair<std::size_t, std::size_t>> const& origins);
+
+    std::unique_ptr<std::streambuf> open_buffer() const;
+    static tiff_ptr client_open(std::istream& input);
     TIFF* open(std::istream& input);
 };
 
@@ -140,6 +171,11 @@ tiff_reader<T>::tiff_reader(std::string const& filename)
 #endif
 
       tif_(nullptr),
+      filename_(filename),
+      stamp_(util::stamp(filename)),
+      data_(nullptr),
+      size_(0),
+      directory_(0),
       read_method_(generic),
       rows_per_strip_(0),
       tile_width_(0),
@@ -180,6 +216,9 @@ tiff_reader<T>::tiff_reader(char const* data, std::size_t size)
     : source_(data, size),
       stream_(&source_),
       tif_(nullptr),
+      data_(data),
+      size_(size),
+      directory_(0),
       read_method_(generic),
       rows_per_strip_(0),
       tile_width_(0),
@@ -212,6 +251,43 @@ void tiff_reader<T>::init()
     if (!tif)
         throw image_reader_exception("Can't open tiff file");
 
+    read_directory(tif);
+
+    // Try extracting bounding box from geoTIFF tags
+    {
+        std::uint16_t count = 0;
+        double* pixelscale;
+        double* tilepoint;
+        if (TIFFGetField(tif, 33550, &count, &pixelscale) == 1 && count == 3 &&
+            TIFFGetField(tif, 33922, &count, &tilepoint) == 1 && count == 6)
+        {
+            MAPNIK_LOG_DEBUG(tiff_reader)
+              << "PixelScale:" << pixelscale[0] << "," << pixelscale[1] << "," << pixelscale[2];
+            MAPNIK_LOG_DEBUG(tiff_reader) << "TilePoint:" << tilepoint[0] << "," << tilepoint[1] << "," << tilepoint[2];
+            MAPNIK_LOG_DEBUG(tiff_reader) << "          " << tilepoint[3] << "," << tilepoint[4] << "," << tilepoint[5];
+
+            // assuming upper-left
+            double lox = tilepoint[3];
+            double loy = tilepoint[4];
+            double hix = lox + pixelscale[0] * width_;
+            double hiy = loy - pixelscale[1] * height_;
+            bbox_ = box2d<double>{lox, loy, hix, hiy};
+            MAPNIK_LOG_DEBUG(tiff_reader) << "Bounding Box:" << *bbox_;
+        }
+    }
+}
+
+// Image layout of the current directory
+template<typename T>
+void tiff_reader<T>::read_directory(TIFF* tif)
+{
+    directory_ = TIFFCurrentDirectory(tif);
+    read_method_ = generic;
+    rows_per_strip_ = 0;
+    tile_width_ = 0;
+    tile_height_ = 0;
+    has_alpha_ = false;
+
     TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &bps_);
     TIFFGetField(tif, TIFFTAG_SAMPLEFORMAT, &sample_format_);
     TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &photometric_);
@@ -260,28 +336,6 @@ void tiff_reader<T>::init()
             throw image_reader_exception("Unspecified provided for extra samples to tiff reader.");
         }
     }
-    // Try extracting bounding box from geoTIFF tags
-    {
-        std::uint16_t count = 0;
-        double* pixelscale;
-        double* tilepoint;
-        if (TIFFGetField(tif, 33550, &count, &pixelscale) == 1 && count == 3 &&
-            TIFFGetField(tif, 33922, &count, &tilepoint) == 1 && count == 6)
-        {
-            MAPNIK_LOG_DEBUG(tiff_reader)
-              << "PixelScale:" << pixelscale[0] << "," << pixelscale[1] << "," << pixelscale[2];
-            MAPNIK_LOG_DEBUG(tiff_reader) << "TilePoint:" << tilepoint[0] << "," << tilepoint[1] << "," << tilepoint[2];
-            MAPNIK_LOG_DEBUG(tiff_reader) << "          " << tilepoint[3] << "," << tilepoint[4] << "," << tilepoint[5];
-
-            // assuming upper-left
-            double lox = tilepoint[3];
-            double loy = tilepoint[4];
-            double hix = lox + pixelscale[0] * width_;
-            double hiy = loy - pixelscale[1] * height_;
-            bbox_ = box2d<double>{lox, loy, hix, hiy};
-            MAPNIK_LOG_DEBUG(tiff_reader) << "Bounding Box:" << *bbox_;
-        }
-    }
     if (!is_tiled_ && compression_ == COMPRESSION_NONE && planar_config_ == PLANARCONFIG_CONTIG)
     {
         if (height_ > 128 * 1024 * 1024)
@@ -303,6 +357,86 @@ template<typename T>
 tiff_reader<T>::~tiff_reader()
 {}
 
+// Reduced resolution subfiles following the full resolution image, as written by
+// GDAL for internal overviews and Cloud Optimized GeoTIFFs. Masks and subfiles
+// with a different pixel type are skipped.
+template<typename T>
+std::vector<typename tiff_reader<T>::overview> const& tiff_reader<T>::scan_overviews() const
+{
+    if (!overviews_)
+    {
+        std::vector<overview> result;
+        TIFF* tif = tif_.get();
+        if (tif)
+        {
+            while (TIFFReadDirectory(tif) == 1)
+            {
+                std::uint32_t subfile_type = 0;
+                std::uint32_t width = 0;
+                std::uint32_t height = 0;
+                std::uint16_t bps = 1;
+                std::uint16_t sample_format = SAMPLEFORMAT_UINT;
+                std::uint16_t photometric = 0;
+                std::uint16_t bands = 1;
+                TIFFGetField(tif, TIFFTAG_SUBFILETYPE, &subfile_type);
+                TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+                TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+                TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &bps);
+                TIFFGetField(tif, TIFFTAG_SAMPLEFORMAT, &sample_format);
+                TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &photometric);
+                TIFFGetField(tif, TIFFTAG_SAMPLESPERPIXEL, &bands);
+                if ((subfile_type & FILETYPE_REDUCEDIMAGE) != 0 && (subfile_type & FILETYPE_MASK) == 0 &&
+                    width > 0 && height > 0 && width < width_ && height < height_ && bps == bps_ &&
+                    sample_format == sample_format_ && photometric == photometric_ && bands == bands_)
+                {
+                    MAPNIK_LOG_DEBUG(tiff_reader) << "overview: " << width << "x" << height;
+                    result.push_back(overview{static_cast<unsigned>(TIFFCurrentDirectory(tif)), width, height});
+                }
+            }
+            if (TIFFSetDirectory(tif, directory_) == 0)
+            {
+                throw image_reader_exception("TIFF reader: can't read directory " + std::to_string(directory_));
+            }
+        }
+        std::stable_sort(result.begin(), result.end(), [](overview const& a, overview const& b) {
+            return a.width > b.width;
+        });
+        overviews_ = std::move(result);
+    }
+    return *overviews_;
+}
+
+template<typename T>
+std::vector<std::pair<unsigned, unsigned>> tiff_reader<T>::overviews() const
+{
+    std::vector<std::pair<unsigned, unsigned>> sizes;
+    for (auto const& ov : scan_overviews())
+    {
+        sizes.emplace_back(ov.width, ov.height);
+    }
+    return sizes;
+}
+
+template<typename T>
+void tiff_reader<T>::select_overview(unsigned index)
+{
+    std::vector<overview> const& overviews = scan_overviews();
+    if (index > overviews.size())
+    {
+        throw image_reader_exception("TIFF reader: no overview " + std::to_string(index));
+    }
+    unsigned const directory = (index == 0) ? 0 : overviews[index - 1].directory;
+    if (directory != directory_)
+    {
+        TIFF* tif = open(stream_);
+        if (!tif || TIFFSetDirectory(tif, directory) == 0)
+        {
+            throw image_reader_exception("TIFF reader: can't read directory " + std::to_string(directory));
+        }
+        read_directory(tif);
+    }
+}
+
 template<typename T>
 unsigned tiff_reader<T>::width() const
 {
@@ -611,58 +745,50 @@ void tiff_reader<T>::read_tiled(std::size_t x0, std::size_t y0, ImageData& image
     TIFF* tif = open(stream_);
     if (tif)
     {
-        std::uint32_t const tile_size = TIFFTileSize(tif);
-        std::unique_ptr<pixel_type[]> tile(new pixel_type[tile_size]);
         std::size_t const width = image.width();
         std::size_t const height = image.height();
         std::size_t const start_y = (y0 / tile_height_) * tile_height_;
-        std::size_t const end_y = std::min(((y0 + height) / tile_height_ + 1) * tile_height_, height_);
+        std::size_t const end_y = std::min(y0 + height, height_);
         std::size_t const start_x = (x0 / tile_width_) * tile_width_;
-        std::size_t const end_x = std::min(((x0 + width) / tile_width_ + 1) * tile_width_, width_);
-        bool const pick_first_band =
-          (bands_ > 1) && (tile_size / (tile_width_ * tile_height_ * sizeof(pixel_type)) == bands_);
+        std::size_t const end_x = std::min(x0 + width, width_);
+        std::vector<std::pair<std::size_t, std::size_t>> origins;
         for (std::size_t y = start_y; y < end_y; y += tile_height_)
         {
+            for (std::size_t x = start_x; x < end_x; x += tile_width_)
+            {
+                origins.emplace_back(x, y);
+            }
+        }
+        std::vector<tiff_block_ptr> const tiles = read_blocks<ImageData>(tif, origins);
+        for (std::size_t i = 0; i < origins.size(); ++i)
+        {
+            if (!tiles[i])
+                continue;
+            pixel_type const* tile = reinterpret_cast<pixel_type const*>(tiles[i]->data());
+            std::size_t const x = origins[i].first;
+            std::size_t const y = origins[i].second;
             std::size_t const ty0 = std::max(y0, y) - y;
             std::size_t const ty1 = std::min(height + y0, y + tile_height_) - y;
+            std::size_t const tx0 = std::max(x0, x);
+            std::size_t const tx1 = std::min(width + x0, x + tile_width_);
+            std::size_t row_index = y + ty0 - y0;
 
-            for (std::size_t x = start_x; x < end_x; x += tile_width_)
+            if (detail::tiff_reader_traits<ImageData>::reverse)
             {
-                if (!detail::tiff_reader_traits<ImageData>::read_tile(tif, x, y, tile.get(), tile_width_, tile_height_))
-                {
-                    MAPNIK_LOG_DEBUG(tiff_reader)
-                      << "read_tile(...) failed at " << x << "/" << y << " for " << width_ << "/" << height_ << "\n";
-                    break;
-                }
-                if (pick_first_band)
+                for (std::size_t ty = ty0; ty < ty1; ++ty, ++row_index)
                 {
-                    std::uint32_t size = tile_width_ * tile_height_ * sizeof(pixel_type);
-                    for (std::uint32_t n = 0; n < size; ++n)
-                    {
-                        tile[n] = tile[n * bands_];
-                    }
+                    // This is in reverse because the TIFFReadRGBATile reads are inverted
+                    image.set_row(row_index,
+                                  tx0 - x0,
+                                  tx1 - x0,
+                                  &tile[(tile_height_ - ty - 1) * tile_width_ + tx0 - x]);
                 }
-                std::size_t const tx0 = std::max(x0, x);
-                std::size_t const tx1 = std::min(width + x0, x + tile_width_);
-                std::size_t row_index = y + ty0 - y0;
-
-                if (detail::tiff_reader_traits<ImageData>::reverse)
-                {
-                    for (std::size_t ty = ty0; ty < ty1; ++ty, ++row_index)
-                    {
-                        // This is in reverse because the TIFFReadRGBATile reads are inverted
-                        image.set_row(row_index,
-                                      tx0 - x0,
-                                      tx1 - x0,
-                                      &tile[(tile_height_ - ty - 1) * tile_width_ + tx0 - x]);
-                    }
-                }
-                else
+            }
+            else
+            {
+                for (std::size_t ty = ty0; ty < ty1; ++ty, ++row_index)
                 {
-                    for (std::size_t ty = ty0; ty < ty1; ++ty, ++row_index)
-                    {
-                        image.set_row(row_index, tx0 - x0, tx1 - x0, &tile[ty * tile_width_ + tx0 - x]);
-                    }
+                    image.set_row(row_index, tx0 - x0, tx1 - x0, &tile[ty * tile_width_ + tx0 - x]);
                 }
             }
         }
@@ -677,8 +803,6 @@ void tiff_reader<T>::read_stripped(std::size_t x0, std::size_t y0, ImageData& im
     TIFF* tif = open(stream_);
     if (tif)
     {
-        std::uint32_t const strip_size = TIFFStripSize(tif);
-        std::unique_ptr<pixel_type[]> strip(new pixel_type[strip_size]);
         std::size_t const width = image.width();
         std::size_t const height = image.height();
 
@@ -687,28 +811,24 @@ void tiff_reader<T>::read_stripped(std::size_t x0, std::size_t y0, ImageData& im
         std::size_t const tx0{x0};
         std::size_t const tx1{std::min(width + x0, width_)};
 
-        std::size_t row = 0;
-        bool const pick_first_band =
-          (bands_ > 1) && (strip_size / (width_ * rows_per_strip_ * sizeof(pixel_type)) == bands_);
+        std::vector<std::pair<std::size_t, std::size_t>> origins;
         for (std::size_t y = start_y; y < end_y; y += rows_per_strip_)
         {
+            origins.emplace_back(0, y);
+        }
+        std::vector<tiff_block_ptr> const strips = read_blocks<ImageData>(tif, origins);
+        std::size_t row = 0;
+        for (std::size_t i = 0; i < origins.size(); ++i)
+        {
+            std::size_t const y = origins[i].second;
             std::size_t const ty0 = std::max(y0, y) - y;
             std::size_t const ty1 = std::min(end_y, y + rows_per_strip_) - y;
-
-            if (!detail::tiff_reader_traits<ImageData>::read_strip(tif, y, rows_per_strip_, width_, strip.get()))
+            if (!strips[i])
             {
-                MAPNIK_LOG_DEBUG(tiff_reader)
-                  << "TIFFRead(Encoded|RGBA)Strip failed at " << y << " for " << width_ << "/" << height_ << "\n";
-                break;
-            }
-            if (pick_first_band)
-            {
-                std::uint32_t size = width_ * rows_per_strip_ * sizeof(pixel_type);
-                for (std::uint32_t n = 0; n < size; ++n)
-                {
-                    strip[n] = strip[bands_ * n];
-                }
+                row += ty1 - ty0;
+                continue;
             }
+            pixel_type const* strip = reinterpret_cast<pixel_type const*>(strips[i]->data());
 
             if (detail::tiff_reader_traits<ImageData>::reverse)
             {
@@ -730,22 +850,173 @@ void tiff_reader<T>::read_stripped(std::size_t x0, std::size_t y0, ImageData& im
     }
 }
 
+// Decoded tiles or strips starting at `origins`, null where decoding failed.
+// Blocks of raster files are shared through tiff_block_cache, the missing ones
+// are decoded in parallel. TIFF handles aren't thread safe so every range but
+// the first, which runs on the calling thread, opens its own. Blocks of ranges
+// failing to open one are decoded on the calling thread afterwards.
+template<typename T>
+template<typename ImageData>
+std::vector<tiff_block_ptr>
+  tiff_reader<T>::read_blocks(TIFF* tif, std::vector<std::pair<std::size_t, std::size_t>> const& origins)
+{
+    using traits = detail::tiff_reader_traits<ImageData>;
+    using pixel_type = typename traits::pixel_type;
+    constexpr bool rgba = std::is_same_v<ImageData, image_rgba8>;
+
+    std::size_t const block_size = is_tiled_ ? TIFFTileSize(tif) : TIFFStripSize(tif);
+    std::size_t const block_pixels = is_tiled_ ? tile_width_ * tile_height_
+                                               : width_ * std::min(static_cast<std::size_t>(rows_per_strip_), height_);
+    bool const pick_first_band = (bands_ > 1) && (block_size / (block_pixels * sizeof(pixel_type)) == bands_);
+    bool const cached = stamp_.has_value();
+    tiff_block_cache& cache = tiff_block_cache::instance();
+
+    std::vector<tiff_block_key> keys;
+    keys.reserve(origins.size());
+    std::vector<tiff_block_ptr> blocks(origins.size());
+    std::vector<std::size_t> missing;
+    for (std::size_t i = 0; i < origins.size(); ++i)
+    {
+        std::size_t const x = origins[i].first;
+        std::size_t const y = origins[i].second;
+        unsigned const index = is_tiled_ ? TIFFComputeTile(tif, x, y, 0, 0) : TIFFComputeStrip(tif, y, 0);
+        keys.push_back(tiff_block_key{filename_, stamp_.value_or(util::file_stamp{0, 0}), directory_, index, rgba});
+        if (cached)
+        {
+            blocks[i] = cache.find(keys.back());
+        }
+        if (!blocks[i])
+        {
+            missing.push_back(i);
+        }
+    }
+
+    auto decode_block = [&](TIFF* decoder, pixel_type* scratch, std::size_t n) {
+        std::size_t const x = origins[n].first;
+        std::size_t const y = origins[n].second;
+        bool const decoded = is_tiled_ ? traits::read_tile(decoder, x, y, scratch, tile_width_, tile_height_)
+                                       : traits::read_strip(decoder, y, rows_per_strip_, width_, scratch);
+        if (!decoded)
+        {
+            MAPNIK_LOG_DEBUG(tiff_reader) << "TIFFRead(Encoded|RGBA)(Tile|Strip) failed at " << x << "/" << y
+                                          << " for " << width_ << "/" << height_ << "\n";
+            return;
+        }
+        if (pick_first_band)
+        {
+            for (std::size_t k = 0; k < block_pixels; ++k)
+            {
+                scratch[k] = scratch[k * bands_];
+            }
+        }
+        std::uint8_t const* bytes = reinterpret_cast<std::uint8_t const*>(scratch);
+        tiff_block block(bytes, bytes + block_pixels * sizeof(pixel_type));
+        if (cached)
+        {
+            blocks[n] = cache.insert(keys[n], std::move(block));
+        }
+        else
+        {
+            blocks[n] = std::make_shared<tiff_block const>(std::move(block));
+        }
+    };
+    std::size_t const scratch_size = std::max(block_size, block_pixels);
+
+    // ranges which couldn't open their own handle
+    std::vector<std::uint8_t> skipped(missing.size(), 0);
+    auto decode = [&](std::size_t begin, std::size_t end) {
+        std::unique_ptr<std::streambuf> buffer;
+        std::unique_ptr<std::istream> stream;
+        tiff_ptr handle;
+        TIFF* decoder = tif;
+        if (begin > 0)
+        {
+            buffer = open_buffer();
+            if (buffer)
+            {
+                stream = std::make_unique<std::istream>(buffer.get());
+                handle = client_open(*stream);
+            }
+            if (!handle || (directory_ > 0 && TIFFSetDirectory(handle.get(), directory_) == 0))
+            {
+                std::fill(skipped.begin() + begin, skipped.begin() + end, 1);
+                return;
+            }
+            decoder = handle.get();
+        }
+        std::unique_ptr<pixel_type[]> scratch(new pixel_type[scratch_size]);
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            decode_block(decoder, scratch.get(), missing[i]);
+        }
+    };
+    // opening a handle re-reads the directory, so every range decodes a few blocks
+    thread_pool::instance().parallel_for(missing.size(), 4, decode);
+
+    // decode the blocks of the skipped ranges with the handle of the calling thread
+    if (std::find(skipped.begin(), skipped.end(), 1) != skipped.end())
+    {
+        MAPNIK_LOG_DEBUG(tiff_reader) << "tiff_reader: failed to open another handle on " << filename_
+                                      << ", decoding on the calling thread";
+        std::unique_ptr<pixel_type[]> scratch(new pixel_type[scratch_size]);
+        for (std::size_t i = 0; i < missing.size(); ++i)
+        {
+            if (skipped[i])
+            {
+                decode_block(tif, scratch.get(), missing[i]);
+            }
+        }
+    }
+    return blocks;
+}
+
+// Separate view of the source, used for decoding on other threads
+template<typename T>
+std::unique_ptr<std::streambuf> tiff_reader<T>::open_buffer() const
+{
+    if constexpr (std::is_same_v<source_type, mapnik::util::char_array_buffer>)
+    {
+        return std::make_unique<mapnik::util::char_array_buffer>(data_, size_);
+    }
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+    else if constexpr (std::is_same_v<source_type, boost::interprocess::ibufferstream>)
+    {
+        return std::make_unique<boost::interprocess::bufferbuf>(static_cast<char*>(mapped_region_->get_address()),
+                                                                mapped_region_->get_size(),
+                                                                std::ios_base::in);
+    }
+#endif
+    else
+    {
+        auto buffer = std::make_unique<std::filebuf>();
+        if (!buffer->open(filename_, std::ios_base::in | std::ios_base::binary))
+            return nullptr;
+        return buffer;
+    }
+}
+
+template<typename T>
+typename tiff_reader<T>::tiff_ptr tiff_reader<T>::client_open(std::istream& input)
+{
+    return tiff_ptr(TIFFClientOpen("tiff_input_stream",
+                                   "rcm",
+                                   reinterpret_cast<thandle_t>(&input),
+                                   detail::tiff_read_proc,
+                                   detail::tiff_write_proc,
+                                   detail::tiff_seek_proc,
+                                   detail::tiff_close_proc,
+                                   detail::tiff_size_proc,
+                                   detail::tiff_map_proc,
+                                   detail::tiff_unmap_proc),
+                    tiff_closer());
+}
+
 template<typename T>
 TIFF* tiff_reader<T>::open(std::istream& input)
 {
     if (!tif_)
     {
-        tif_ = tiff_ptr(TIFFClientOpen("tiff_input_stream",
-                                       "rcm",
-                                       reinterpret_cast<thandle_t>(&input),
-                                       detail::tiff_read_proc,
-                                       detail::tiff_write_proc,
-                                       detail::tiff_seek_proc,
-                                       detail::tiff_close_proc,
-                                       detail::tiff_size_proc,
-                                       detail::tiff_map_proc,
-                                       detail::tiff_unmap_proc),
-                        tiff_closer());
+        tif_ = client_open(input);
     }
     return tif_.get();
 }
@@ -31,6 +31,8 @@
 #include <mapnik/raster.hpp>
 #include <mapnik/proj_transform.hpp>
 #include <mapnik/safe_cast.hpp>
+#include <mapnik/thread_pool.hpp>
+#include <mapnik/warp_mesh_cache.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -50,6 +52,12 @@ MAPNIK_DISABLE_WARNING_PUSH
 #include "agg_renderer_scanline.h"
 MAPNIK_DISABLE_WARNING_POP
 
+// stl
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
 namespace mapnik {
 
 template<typename T>
@@ -78,6 +86,50 @@ struct pixel_format<image_rgba8>
     using type = agg::pixfmt_custom_blend_rgba<src_blender, agg::rendering_buffer>;
 };
 
+namespace {
+
+// mesh cell projected into target pixels, drawn as one quad
+struct warp_cell
+{
+    double polygon[8];
+    double miny;
+    double maxy;
+};
+
+warp_mesh_ptr reproject_mesh(proj_transform const& prj_trans,
+                             box2d<double> const& source_ext,
+                             std::size_t width,
+                             std::size_t height,
+                             unsigned mesh_size)
+{
+    warp_mesh_key key{prj_trans.source_params(), prj_trans.dest_params(), source_ext, width, height, mesh_size};
+    warp_mesh_cache& cache = warp_mesh_cache::instance();
+    if (warp_mesh_ptr mesh = cache.find(key))
+    {
+        return mesh;
+    }
+
+    view_transform ts(width, height, source_ext);
+    std::size_t mesh_nx = std::ceil(width / double(mesh_size) + 1);
+    std::size_t mesh_ny = std::ceil(height / double(mesh_size) + 1);
+    warp_mesh mesh(mesh_nx, mesh_ny);
+    image_gray64f& xs = mesh.xs;
+    image_gray64f& ys = mesh.ys;
+    for (std::size_t j = 0; j < mesh_ny; ++j)
+    {
+        for (std::size_t i = 0; i < mesh_nx; ++i)
+        {
+            xs(i, j) = std::min(i * mesh_size, width);
+            ys(i, j) = std::min(j * mesh_size, height);
+            ts.backward(&xs(i, j), &ys(i, j));
+        }
+    }
+    prj_trans.backward(xs.data(), ys.data(), nullptr, mesh_nx * mesh_ny);
+    return cache.insert(key, std::move(mesh));
+}
+
+} // namespace
+
 template<typename T>
 MAPNIK_DECL void warp_image(T& target,
                             T const& source,
@@ -89,7 +141,8 @@ MAPNIK_DECL void warp_image(T& target,
                             unsigned mesh_size,
                             scaling_method_e scaling_method,
                             double filter_factor,
-                            std::optional<double> const& nodata_value)
+                            std::optional<double> const& nodata_value,
+                            std::size_t band_rows)
 {
     using image_type = T;
     using pixel_type = typename image_type::pixel_type;
@@ -101,98 +154,124 @@ MAPNIK_DECL void warp_image(T& target,
 
     constexpr std::size_t pixel_size = sizeof(pixel_type);
 
-    view_transform ts(source.width(), source.height(), source_ext);
-    view_transform tt(target.width(), target.height(), target_ext, offset_x, offset_y);
-
-    std::size_t mesh_nx = std::ceil(source.width() / double(mesh_size) + 1);
-    std::size_t mesh_ny = std::ceil(source.height() / double(mesh_size) + 1);
+    if (target.width() == 0 || target.height() == 0)
+    {
+        return;
+    }
 
-    image_gray64f xs(mesh_nx, mesh_ny, false);
-    image_gray64f ys(mesh_nx, mesh_ny, false);
+    view_transform tt(target.width(), target.height(), target_ext, offset_x, offset_y);
 
     // Precalculate reprojected mesh
-    for (std::size_t j = 0; j < mesh_ny; ++j)
+    warp_mesh_ptr mesh = reproject_mesh(prj_trans, source_ext, source.width(), source.height(), mesh_size);
+    image_gray64f const& xs = mesh->xs;
+    image_gray64f const& ys = mesh->ys;
+    std::size_t const mesh_nx = xs.width();
+    std::size_t const mesh_ny = xs.height();
+
+    std::vector<warp_cell> cells;
+    cells.reserve((mesh_nx - 1) * (mesh_ny - 1));
+    for (std::size_t j = 0; j < mesh_ny - 1; ++j)
     {
-        for (std::size_t i = 0; i < mesh_nx; ++i)
+        for (std::size_t i = 0; i < mesh_nx - 1; ++i)
         {
-            xs(i, j) = std::min(i * mesh_size, source.width());
-            ys(i, j) = std::min(j * mesh_size, source.height());
-            ts.backward(&xs(i, j), &ys(i, j));
+            warp_cell cell{{xs(i, j),
+                            ys(i, j),
+                            xs(i + 1, j),
+                            ys(i + 1, j),
+                            xs(i + 1, j + 1),
+                            ys(i + 1, j + 1),
+                            xs(i, j + 1),
+                            ys(i, j + 1)},
+                           0.0,
+                           0.0};
+            double* polygon = cell.polygon;
+            tt.forward(polygon + 0, polygon + 1);
+            tt.forward(polygon + 2, polygon + 3);
+            tt.forward(polygon + 4, polygon + 5);
+            tt.forward(polygon + 6, polygon + 7);
+            cell.miny = std::floor(std::min({polygon[1], polygon[3], polygon[5], polygon[7]}));
+            cell.maxy = std::floor(std::max({polygon[1], polygon[3], polygon[5], polygon[7]}));
+            cells.push_back(cell);
         }
     }
-    prj_trans.backward(xs.data(), ys.data(), nullptr, mesh_nx * mesh_ny);
 
-    agg::rasterizer_scanline_aa<> rasterizer;
-    agg::scanline_bin scanline;
     agg::rendering_buffer buf(target.bytes(), target.width(), target.height(), target.width() * pixel_size);
-    output_pixfmt_type pixf(buf);
-    renderer_base rb(pixf);
-    rasterizer.clip_box(0, 0, target.width(), target.height());
     agg::rendering_buffer buf_tile(const_cast<unsigned char*>(source.bytes()),
                                    source.width(),
                                    source.height(),
                                    source.width() * pixel_size);
 
-    pixfmt_pre pixf_tile(buf_tile);
-
-    using img_accessor_type = agg::image_accessor_clone<pixfmt_pre>;
-    img_accessor_type ia(pixf_tile);
-
-    agg::span_allocator<color_type> sa;
-    // Project mesh cells into target interpolating raster inside each one
-    for (std::size_t j = 0; j < mesh_ny - 1; ++j)
-    {
-        for (std::size_t i = 0; i < mesh_nx - 1; ++i)
+    // Bands of target rows are rendered in parallel. Each band draws every cell
+    // overlapping it in mesh order and only writes its own rows, so pixels on the
+    // seams get the same comp_op_src result as a serial pass.
+    auto render_band = [&](std::size_t y_begin, std::size_t y_end) {
+        agg::rasterizer_scanline_aa<> rasterizer;
+        agg::scanline_bin scanline;
+        output_pixfmt_type pixf(buf);
+        renderer_base rb(pixf);
+        rb.clip_box(0, static_cast<int>(y_begin), target.width() - 1, static_cast<int>(y_end) - 1);
+        rasterizer.clip_box(0, 0, target.width(), target.height());
+
+        pixfmt_pre pixf_tile(buf_tile);
+        using img_accessor_type = agg::image_accessor_clone<pixfmt_pre>;
+        img_accessor_type ia(pixf_tile);
+
+        agg::span_allocator<color_type> sa;
+        agg::image_filter_lut filter;
+        if (scaling_method != SCALING_NEAR)
         {
-            double polygon[8] = {xs(i, j),
-                                 ys(i, j),
-                                 xs(i + 1, j),
-                                 ys(i + 1, j),
-                                 xs(i + 1, j + 1),
-                                 ys(i + 1, j + 1),
-                                 xs(i, j + 1),
-                                 ys(i, j + 1)};
-            tt.forward(polygon + 0, polygon + 1);
-            tt.forward(polygon + 2, polygon + 3);
-            tt.forward(polygon + 4, polygon + 5);
-            tt.forward(polygon + 6, polygon + 7);
+            detail::set_scaling_method(filter, scaling_method, filter_factor);
+        }
 
-            rasterizer.reset();
-            rasterizer.move_to_d(std::floor(polygon[0]), std::floor(polygon[1]));
-            rasterizer.line_to_d(std::floor(polygon[2]), std::floor(polygon[3]));
-            rasterizer.line_to_d(std::floor(polygon[4]), std::floor(polygon[5]));
-            rasterizer.line_to_d(std::floor(polygon[6]), std::floor(polygon[7]));
-
-            std::size_t const x0 = i * mesh_size;
-            std::size_t const y0 = j * mesh_size;
-            std::size_t const x1 = std::min((i + 1) * mesh_size, source.width());
-            std::size_t const y1 = std::min((j + 1) * mesh_size, source.height());
-            agg::trans_affine const tr(polygon, x0, y0, x1, y1);
-            if (tr.is_valid())
+        // Project mesh cells into target interpolating raster inside each one
+        for (std::size_t j = 0; j < mesh_ny - 1; ++j)
+        {
+            for (std::size_t i = 0; i < mesh_nx - 1; ++i)
             {
-                interpolator_type interpolator(tr);
-                if (scaling_method == SCALING_NEAR)
+                warp_cell const& cell = cells[j * (mesh_nx - 1) + i];
+                if (cell.maxy < static_cast<double>(y_begin) || cell.miny >= static_cast<double>(y_end))
                 {
-                    using span_gen_type = typename detail::agg_scaling_traits<image_type>::span_image_filter;
-                    span_gen_type sg(ia, interpolator);
-                    agg::render_scanlines_bin(rasterizer, scanline, rb, sa, sg);
+                    continue;
                 }
-                else
+                double const* polygon = cell.polygon;
+
+                rasterizer.reset();
+                rasterizer.move_to_d(std::floor(polygon[0]), std::floor(polygon[1]));
+                rasterizer.line_to_d(std::floor(polygon[2]), std::floor(polygon[3]));
+                rasterizer.line_to_d(std::floor(polygon[4]), std::floor(polygon[5]));
+                rasterizer.line_to_d(std::floor(polygon[6]), std::floor(polygon[7]));
+
+                std::size_t const x0 = i * mesh_size;
+                std::size_t const y0 = j * mesh_size;
+                std::size_t const x1 = std::min((i + 1) * mesh_size, source.width());
+                std::size_t const y1 = std::min((j + 1) * mesh_size, source.height());
+                agg::trans_affine const tr(polygon, x0, y0, x1, y1);
+                if (tr.is_valid())
                 {
-                    using span_gen_type = typename detail::agg_scaling_traits<image_type>::span_image_resample_affine;
-                    agg::image_filter_lut filter;
-                    detail::set_scaling_method(filter, scaling_method, filter_factor);
-                    std::optional<typename span_gen_type::value_type> nodata;
-                    if (nodata_value)
+                    interpolator_type interpolator(tr);
+                    if (scaling_method == SCALING_NEAR)
+                    {
+                        using span_gen_type = typename detail::agg_scaling_traits<image_type>::span_image_filter;
+                        span_gen_type sg(ia, interpolator);
+                        agg::render_scanlines_bin(rasterizer, scanline, rb, sa, sg);
+                    }
+                    else
                     {
-                        nodata = safe_cast<typename span_gen_type::value_type>(*nodata_value);
+                        using span_gen_type =
+                          typename detail::agg_scaling_traits<image_type>::span_image_resample_affine;
+                        std::optional<typename span_gen_type::value_type> nodata;
+                        if (nodata_value)
+                        {
+                            nodata = safe_cast<typename span_gen_type::value_type>(*nodata_value);
+                        }
+                        span_gen_type sg(ia, interpolator, filter, nodata);
+                        agg::render_scanlines_bin(rasterizer, scanline, rb, sa, sg);
                     }
-                    span_gen_type sg(ia, interpolator, filter, nodata);
-                    agg::render_scanlines_bin(rasterizer, scanline, rb, sa, sg);
                 }
             }
         }
-    }
+    };
+    thread_pool::instance().parallel_for(target.height(), band_rows, render_band);
 }
 
 namespace detail {
@@ -298,7 +377,8 @@ template MAPNIK_DECL void warp_image(image_rgba8&,
                                      unsigned,
                                      scaling_method_e,
                                      double,
-                                     std::optional<double> const&);
+                                     std::optional<double> const&,
+                                     std::size_t);
 
 template MAPNIK_DECL void warp_image(image_gray8&,
                                      image_gray8 const&,
@@ -310,7 +390,8 @@ template MAPNIK_DECL void warp_image(image_gray8&,
                                      unsigned,
                                      scaling_method_e,
                                      double,
-                                     std::optional<double> const&);
+                                     std::optional<double> const&,
+                                     std::size_t);
 
 template MAPNIK_DECL void warp_image(image_gray16&,
                                      image_gray16 const&,
@@ -322,7 +403,8 @@ template MAPNIK_DECL void warp_image(image_gray16&,
                                      unsigned,
                                      scaling_method_e,
                                      double,
-                                     std::optional<double> const&);
+                                     std::optional<double> const&,
+                                     std::size_t);
 
 template MAPNIK_DECL void warp_image(image_gray32f&,
                                      image_gray32f const&,
@@ -334,6 +416,7 @@ template MAPNIK_DECL void warp_image(image_gray32f&,
                                      unsigned,
                                      scaling_method_e,
                                      double,
-                                     std::optional<double> const&);
+                                     std::optional<double> const&,
+                                     std::size_t);
 
 } // namespace mapnik
@@ -0,0 +1,56 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/warp_mesh_cache.hpp>
+
+// stl
+#include <functional>
+
+namespace mapnik {
+
+template class util::lru_cache<warp_mesh_key, warp_mesh, warp_mesh_key_hash, warp_mesh_cost>;
+template class singleton<warp_mesh_cache, CreateUsingNew>;
+
+std::size_t warp_mesh_key_hash::operator()(warp_mesh_key const& key) const
+{
+    std::size_t seed = std::hash<std::string>{}(key.source_crs);
+    seed ^= std::hash<std::string>{}(key.dest_crs) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    for (double val : {key.source_ext.minx(), key.source_ext.miny(), key.source_ext.maxx(), key.source_ext.maxy()})
+    {
+        seed ^= std::hash<double>{}(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    seed ^= std::hash<std::size_t>{}(key.width) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<std::size_t>{}(key.height) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<unsigned>{}(key.mesh_size) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+warp_mesh_cache::warp_mesh_cache()
+    : warp_mesh_cache(default_capacity)
+{}
+
+warp_mesh_cache::warp_mesh_cache(std::size_t capacity)
+    : warp_mesh_lru(capacity)
+{}
+
+} // namespace mapnik
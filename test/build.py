@@ -29,6 +29,8 @@ else:
     if test_env['PLATFORM'] == 'Linux':
         test_env['LINKFLAGS'].append('-pthread')
     test_env.AppendUnique(LIBS='boost_program_options%s' % env['BOOST_APPEND'])
+    # xyz tiles fetcher
+    test_env.AppendUnique(LIBS='boost_url%s' % env['BOOST_APPEND'])
     test_env_local = test_env.Clone()
 
 
@@ -0,0 +1,111 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_arena.hpp>
+#include <mapnik/feature_factory.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+TEST_CASE("feature arena")
+{
+    SECTION("allocations are aligned and packed into blocks")
+    {
+        mapnik::feature_arena arena;
+        for (std::size_t alignment : {1, 2, 4, 8, 16, 64})
+        {
+            void* ptr = arena.allocate(3, alignment);
+            CHECK(reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0);
+        }
+        CHECK(arena.blocks() == 1);
+        CHECK(arena.allocated() == 18);
+        // oversized allocations get a block of their own
+        arena.allocate(mapnik::feature_arena::block_size * 2, 8);
+        CHECK(arena.blocks() == 2);
+    }
+
+    SECTION("features outlive their scope")
+    {
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        ctx->push("name");
+        CHECK(mapnik::feature_arena::current() == nullptr);
+        std::vector<mapnik::feature_ptr> features;
+        std::weak_ptr<mapnik::feature_arena> weak;
+        {
+            mapnik::feature_arena::scope scope;
+            weak = mapnik::feature_arena::current();
+            REQUIRE(weak.lock() != nullptr);
+            for (int i = 0; i < 100; ++i)
+            {
+                mapnik::feature_ptr feature = mapnik::feature_factory::create_transient(ctx, i);
+                feature->put("name", mapnik::value_integer(i));
+                features.push_back(feature);
+            }
+            CHECK(weak.lock()->allocated() > 0);
+            // attributes live in the arena too, also once they grow
+            CHECK(features.back()->get_data().get_allocator().arena() == weak.lock());
+            features.back()->put_new("extra", mapnik::value_integer(7));
+            CHECK(features.back()->get_data().get_allocator().arena() == weak.lock());
+            CHECK(features.back()->get("extra") == mapnik::value_integer(7));
+            {
+                // a disabled scope hides the enclosing arena
+                mapnik::feature_arena::scope disabled(false);
+                CHECK(mapnik::feature_arena::current() == nullptr);
+            }
+            CHECK(mapnik::feature_arena::current() == weak.lock());
+        }
+        CHECK(mapnik::feature_arena::current() == nullptr);
+        REQUIRE(!weak.expired());
+        // without a scope attributes are allocated from the heap
+        mapnik::feature_ptr heap = mapnik::feature_factory::create_transient(ctx, 0);
+        CHECK(heap->get_data().get_allocator().arena() == nullptr);
+        heap->set_data(features[1]->get_data());
+        CHECK(heap->get_data().get_allocator().arena() == nullptr);
+        CHECK(heap->get("name") == mapnik::value_integer(1));
+        for (int i = 0; i < 100; ++i)
+        {
+            CHECK(features[i]->id() == i);
+            CHECK(features[i]->get("name") == mapnik::value_integer(i));
+        }
+        features.clear();
+        CHECK(weak.expired());
+    }
+
+    SECTION("scopes switch to a fresh arena once the capacity is reached")
+    {
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        mapnik::feature_arena::scope scope(true, 1024);
+        std::weak_ptr<mapnik::feature_arena> first = mapnik::feature_arena::current();
+        std::vector<mapnik::feature_ptr> features;
+        while (mapnik::feature_arena::current() == first.lock())
+        {
+            features.push_back(mapnik::feature_factory::create_transient(ctx, 0));
+        }
+        CHECK(first.lock()->allocated() >= 1024);
+        features.clear();
+        CHECK(first.expired());
+    }
+}
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+
+#include <string>
+#include <vector>
+
+TEST_CASE("feature context")
+{
+    SECTION("lookup")
+    {
+        mapnik::context_type ctx;
+        std::vector<std::string> names;
+        for (int i = 0; i < 100; ++i)
+        {
+            names.push_back("attr_" + std::to_string(99 - i));
+            CHECK(ctx.push(names.back()) == static_cast<std::size_t>(i));
+        }
+        CHECK(ctx.size() == 100);
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            auto itr = ctx.find(names[i]);
+            REQUIRE(itr != ctx.end());
+            CHECK(itr->first == names[i]);
+            CHECK(ctx.index_of(names[i]) == i);
+        }
+        CHECK(ctx.find("attr_100") == ctx.end());
+        CHECK(ctx.index_of("") == mapnik::context_type::npos);
+        // duplicates are ignored
+        ctx.add("attr_0", 1000);
+        CHECK(ctx.index_of("attr_0") == 99);
+        CHECK(ctx.size() == 100);
+        // iteration is ordered by name
+        std::string prev;
+        for (auto const& kv : ctx)
+        {
+            CHECK(prev < kv.first);
+            prev = kv.first;
+        }
+    }
+
+    SECTION("feature attributes")
+    {
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        ctx->push("name");
+        ctx->push("pop");
+        mapnik::feature_ptr feature = mapnik::feature_factory::create(ctx, 1);
+        feature->put("pop", mapnik::value_integer(100));
+        CHECK_THROWS(feature->put("missing", mapnik::value_integer(1)));
+        feature->put_new("added", mapnik::value_integer(3));
+        CHECK(feature->has_key("pop"));
+        CHECK(feature->has_key("added"));
+        CHECK_FALSE(feature->has_key("missing"));
+        CHECK(feature->get("pop") == mapnik::value_integer(100));
+        CHECK(feature->get("added") == mapnik::value_integer(3));
+        CHECK(feature->get("missing").is_null());
+        std::size_t index = ctx->index_of("pop");
+        CHECK(feature->get(index) == mapnik::value_integer(100));
+        CHECK(feature->get(mapnik::context_type::npos).is_null());
+    }
+}
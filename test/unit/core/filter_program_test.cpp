@@ -0,0 +1,80 @@
+#include "catch.hpp"
+
+#include <mapnik/expression.hpp>
+#include <mapnik/expression_evaluator.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/filter_program.hpp>
+#include <mapnik/unicode.hpp>
+
+#include <string>
+#include <vector>
+
+TEST_CASE("filter_program")
+{
+    std::vector<std::string> const filters = {"[name] = 'foo'",
+                                              "[pop] > 1000 and [name] = 'foo'",
+                                              "[pop] + 1 > @threshold",
+                                              "not ([pop] % 3 = 0)",
+                                              "[mapnik::geometry_type] = 1",
+                                              "[name].match('f.*')",
+                                              "[name].replace('o','0') = 'f00'",
+                                              "abs([neg]) = 5",
+                                              "pow([pop], 2) > 10",
+                                              "[missing] = null",
+                                              "[pop] > 1000 or [missing] != null",
+                                              "-[pop] < 0",
+                                              "[pop] / 2.5 >= 1.0",
+                                              "[late] = 7"};
+
+    mapnik::filter_program program;
+    std::vector<mapnik::expression_ptr> exprs;
+    std::vector<std::uint32_t> roots;
+    for (auto const& str : filters)
+    {
+        exprs.push_back(mapnik::parse_expression(str));
+        roots.push_back(program.add(exprs.back()));
+    }
+
+    SECTION("common sub-expressions are shared")
+    {
+        // `[name] = 'foo'` and `[pop] > 1000` are compiled once
+        CHECK(roots[0] == program.instructions()[roots[1]].right);
+        CHECK(program.instructions()[roots[1]].left == program.instructions()[roots[10]].left);
+        CHECK(program.attribute_names().size() == 5);
+        CHECK(program.global_names().size() == 1);
+    }
+
+    SECTION("same results as the expression evaluator")
+    {
+        mapnik::attributes vars{{"threshold", mapnik::value_integer(50)}};
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        ctx->push("name");
+        ctx->push("pop");
+        ctx->push("neg");
+        mapnik::transcoder tr("utf8");
+        mapnik::filter_program::evaluator evaluator(program, vars);
+        for (int i = 0; i < 40; ++i)
+        {
+            mapnik::feature_ptr feature = mapnik::feature_factory::create(ctx, i);
+            feature->put("name", tr.transcode(i % 2 ? "foo" : "bar"));
+            feature->put("pop", mapnik::value_integer(i * 100));
+            feature->put("neg", mapnik::value_integer(i % 5 ? -5 : 3));
+            if (i % 3 == 0)
+                feature->set_geometry(mapnik::geometry::point<double>(1, 2));
+            // attributes added to the context after the first features were evaluated
+            if (i > 30)
+                feature->put_new("late", mapnik::value_integer(7));
+            evaluator.start(*feature);
+            for (std::size_t k = 0; k < filters.size(); ++k)
+            {
+                auto expected = mapnik::util::apply_visitor(
+                  mapnik::evaluate<mapnik::feature_impl, mapnik::value, mapnik::attributes>(*feature, vars),
+                  *exprs[k]);
+                INFO(filters[k] << " feature " << i);
+                CHECK(evaluator.eval(roots[k]) == expected);
+                CHECK(evaluator.pass(roots[k]) == expected.to_bool());
+            }
+        }
+    }
+}
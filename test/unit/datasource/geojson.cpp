@@ -38,7 +38,9 @@
 #include <locale>
 #include <string_view>
 #include <array>
+#include <thread>
 #include <utility>
+#include <vector>
 
 /*
 
@@ -974,5 +976,81 @@ TEST_CASE("geojson")
                 }
             }
         }
+
+        SECTION("GeoJSON shared datasources")
+        {
+            auto& cache = mapnik::datasource_cache::instance();
+            cache.clear_shared();
+            mapnik::parameters params;
+            params["type"] = "geojson";
+            params["file"] = "./test/data/json/point.json";
+            params["cache_features"] = true;
+            auto ds = cache.create_shared(params);
+            CHECK(cache.create_shared(params) == ds);
+            CHECK(cache.shared_size() == 1);
+
+            // other parameters give another datasource
+            mapnik::parameters other(params);
+            other["cache_features"] = false;
+            CHECK(cache.create_shared(other) != ds);
+            CHECK(cache.create(params) != ds);
+
+            // opting in through the parameters
+            mapnik::parameters opt_in(params);
+            opt_in["shared"] = "true";
+            auto shared_ds = cache.create(opt_in);
+            CHECK(cache.create(opt_in) == shared_ds);
+            CHECK(cache.create_shared(opt_in) == shared_ds);
+
+            // concurrent maps loading the same style
+            std::vector<mapnik::datasource_ptr> results(8);
+            std::vector<std::thread> threads;
+            mapnik::parameters concurrent(params);
+            concurrent["file"] = "./test/data/json/featurecollection-multipleprops.geojson";
+            for (auto& result : results)
+            {
+                threads.emplace_back([&] { result = cache.create_shared(concurrent); });
+            }
+            for (auto& t : threads)
+            {
+                t.join();
+            }
+            for (auto const& result : results)
+            {
+                CHECK(result == results.front());
+            }
+            results.clear();
+
+            // released entries are rebuilt, current holders keep theirs
+            CHECK(cache.release_shared(params));
+            CHECK(!cache.release_shared(params));
+            auto rebuilt = cache.create_shared(params);
+            CHECK(rebuilt != ds);
+            CHECK(ds->envelope() == rebuilt->envelope());
+
+            // entries live as long as something holds them
+            rebuilt.reset();
+            std::weak_ptr<mapnik::datasource> weak = ds;
+            ds.reset();
+            CHECK(weak.expired());
+            CHECK(cache.shared_size() == 1); // opt_in
+
+            // expired entries are dropped when another datasource is registered
+            mapnik::parameters next(params);
+            next["file"] = "./test/data/json/points.geojson";
+            auto next_ds = cache.create_shared(next);
+            CHECK(!cache.release_shared(params));
+            CHECK(!cache.release_shared(other));
+            CHECK(cache.release_shared(opt_in));
+            CHECK(cache.release_shared(next));
+
+            // failures are not cached
+            mapnik::parameters missing(params);
+            missing["file"] = "does_not_exist.geojson";
+            REQUIRE_THROWS(cache.create_shared(missing));
+            REQUIRE_THROWS(cache.create_shared(missing));
+            cache.clear_shared();
+            CHECK(cache.shared_size() == 0);
+        }
     }
 }
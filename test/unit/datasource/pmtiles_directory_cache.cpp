@@ -0,0 +1,110 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+
+#include "../../../plugins/input/tiles/pmtiles_directory_cache.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+
+std::vector<mapnik::entryv3> directory(std::uint64_t tile_id)
+{
+    return {mapnik::entryv3(tile_id, 0, 100, 1)};
+}
+
+} // namespace
+
+TEST_CASE("pmtiles directory cache")
+{
+    SECTION("hits, misses and eviction")
+    {
+        mapnik::pmtiles_directory_cache cache(2);
+        std::size_t loads = 0;
+        auto load = [&](std::uint64_t offset) {
+            return cache.find(offset, [&] {
+                ++loads;
+                return directory(offset);
+            });
+        };
+        CHECK(load(10)->front().tile_id == 10);
+        CHECK(load(20)->front().tile_id == 20);
+        CHECK(load(10)->front().tile_id == 10);
+        CHECK(loads == 2);
+        CHECK(cache.hits() == 1);
+        CHECK(cache.misses() == 2);
+        // 20 is the least recently used directory
+        auto dir = load(30);
+        CHECK(cache.size() == 2);
+        CHECK(cache.evictions() == 1);
+        load(10);
+        CHECK(loads == 3);
+        load(20);
+        CHECK(loads == 4);
+        CHECK(cache.size() == 2);
+        CHECK(cache.evictions() == 2);
+        // evicted directories stay valid
+        CHECK(dir->front().tile_id == 30);
+    }
+
+    SECTION("capacity bound")
+    {
+        mapnik::pmtiles_directory_cache cache(4);
+        for (std::uint64_t offset = 0; offset < 10; ++offset)
+        {
+            cache.find(offset, [&] { return directory(offset); });
+            CHECK(cache.size() <= 4);
+        }
+        CHECK(cache.size() == 4);
+        CHECK(cache.evictions() == 6);
+        cache.set_capacity(1);
+        CHECK(cache.capacity() == 1);
+        CHECK(cache.size() == 1);
+        CHECK(cache.evictions() == 9);
+        cache.set_capacity(0);
+        cache.find(42, [&] { return directory(42); });
+        CHECK(cache.size() == 0);
+    }
+
+    SECTION("shared per file and capacity")
+    {
+        auto a = mapnik::pmtiles_directory_cache::get("a.pmtiles", 64);
+        auto b = mapnik::pmtiles_directory_cache::get("a.pmtiles", 64);
+        auto c = mapnik::pmtiles_directory_cache::get("a.pmtiles", 8);
+        auto d = mapnik::pmtiles_directory_cache::get("b.pmtiles", 64);
+        CHECK(a == b);
+        CHECK(a != c);
+        CHECK(a != d);
+        CHECK(c->capacity() == 8);
+        // a file reopened once all its sources are gone starts with an empty cache
+        a->find(1, [&] { return directory(1); });
+        std::weak_ptr<mapnik::pmtiles_directory_cache> expired = a;
+        a.reset();
+        b.reset();
+        CHECK(expired.expired());
+        auto e = mapnik::pmtiles_directory_cache::get("a.pmtiles", 64);
+        CHECK(e->size() == 0);
+    }
+}
@@ -22,7 +22,11 @@
 
 #include "catch.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include <mapnik/quad_tree.hpp>
 #include <mapnik/util/spatial_index.hpp>
@@ -91,5 +95,156 @@ TEST_CASE("spatial_index")
         REQUIRE(results[2] == 3);
         REQUIRE(results[3] == 2);
         REQUIRE(results.size() == 4);
+
+        // in-memory index
+        using buffer_index = mapnik::util::spatial_index<value_type, filter_in_box, mapnik::util::index_buffer>;
+        std::string const data = out.str();
+        mapnik::util::index_buffer buffer{data.data(), data.size()};
+        REQUIRE(buffer_index::bounding_box(buffer) == tree.extent());
+        results.clear();
+        buffer_index::query(filter, buffer, results);
+        REQUIRE(results.size() == 4);
+        REQUIRE(results[0] == 1);
+        REQUIRE(results[1] == 4);
+        REQUIRE(results[2] == 3);
+        REQUIRE(results[3] == 2);
+        results.clear();
+        buffer_index::query(filter_in_box(mapnik::box2d<double>(31, 31, 32, 32)), buffer, results);
+        REQUIRE(results.size() == 1);
+        REQUIRE(results[0] == 2);
+        results.clear();
+        buffer_index::query_first_n(filter, buffer, results, 2);
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0] == 1);
+        REQUIRE(results[1] == 4);
+        // truncated index
+        mapnik::util::index_buffer truncated{data.data(), data.size() - 8};
+        results.clear();
+        REQUIRE_THROWS(buffer_index::query(filter, truncated, results));
+    }
+}
+
+TEST_CASE("quad_tree")
+{
+    using value_type = std::int32_t;
+    using item_type = std::pair<value_type, mapnik::box2d<double>>;
+    mapnik::box2d<double> const extent(0, 0, 100, 100);
+    std::vector<item_type> items;
+    for (value_type i = 0; i < 200; ++i)
+    {
+        double const x = (i * 37) % 97;
+        double const y = (i * 61) % 89;
+        double const size = 1 + i % 13;
+        items.emplace_back(i, mapnik::box2d<double>(x, y, x + size, y + size / 2));
+    }
+
+    SECTION("compact")
+    {
+        mapnik::quad_tree<value_type> tree(extent);
+        for (auto const& item : items)
+        {
+            tree.insert(item.first, item.second);
+        }
+        mapnik::box2d<double> const box(20, 20, 45, 30);
+        auto itr = tree.query_in_box(box);
+        std::vector<value_type> expected(itr, tree.query_end());
+        REQUIRE(!expected.empty());
+        std::ostringstream out1(std::ios::binary);
+        tree.write(out1);
+
+        // compacting keeps the nodes, query results and the index file
+        int const count = tree.count();
+        tree.compact();
+        REQUIRE(tree.count() == count);
+        REQUIRE(tree.count_items() == 200);
+        itr = tree.query_in_box(box);
+        std::vector<value_type> results(itr, tree.query_end());
+        REQUIRE(results == expected);
+        std::ostringstream out2(std::ios::binary);
+        tree.write(out2);
+        REQUIRE(out2.str() == out1.str());
+
+        // also after trimming
+        tree.trim();
+        std::ostringstream out3(std::ios::binary);
+        tree.write(out3);
+        tree.compact();
+        std::ostringstream out4(std::ios::binary);
+        tree.write(out4);
+        REQUIRE(out4.str() == out3.str());
+    }
+
+    SECTION("bulk load")
+    {
+        for (unsigned int max_depth : {1u, 3u, 8u})
+        {
+            mapnik::quad_tree<value_type> tree(extent, max_depth);
+            for (auto const& item : items)
+            {
+                tree.insert(item.first, item.second);
+            }
+            tree.compact();
+            mapnik::quad_tree<value_type> bulk(extent, max_depth);
+            bulk.insert(-1, extent); // replaced by the bulk load
+            bulk.bulk_load(items.begin(), items.end());
+
+            // same nodes in the same order, holding the same items
+            REQUIRE(bulk.count_items() == 200);
+            REQUIRE(std::distance(bulk.begin(), bulk.end()) == std::distance(tree.begin(), tree.end()));
+            auto itr = tree.begin();
+            for (auto const& n : bulk)
+            {
+                REQUIRE(n.extent() == itr->extent());
+                REQUIRE(std::equal(n.begin(), n.end(), itr->begin(), itr->end()));
+                ++itr;
+            }
+            mapnik::box2d<double> const box(20, 20, 45, 30);
+            auto query = tree.query_in_box(box);
+            std::vector<value_type> expected(query, tree.query_end());
+            query = bulk.query_in_box(box);
+            std::vector<value_type> results(query, bulk.query_end());
+            REQUIRE(results == expected);
+            std::ostringstream out1(std::ios::binary);
+            tree.write(out1);
+            std::ostringstream out2(std::ios::binary);
+            bulk.write(out2);
+            REQUIRE(out2.str() == out1.str());
+        }
+        mapnik::quad_tree<value_type> empty(extent);
+        empty.bulk_load(items.end(), items.end());
+        REQUIRE(empty.count() == 1);
+        REQUIRE(empty.count_items() == 0);
+    }
+
+    SECTION("visit in box")
+    {
+        mapnik::quad_tree<value_type> tree(extent);
+        for (auto const& item : items)
+        {
+            tree.insert(item.first, item.second);
+        }
+        mapnik::box2d<double> const box(50, 10, 70, 60);
+        auto itr = tree.query_in_box(box);
+        std::vector<value_type> expected(itr, tree.query_end());
+        std::vector<value_type> visited;
+        REQUIRE(tree.visit_in_box(box, [&](value_type val) {
+            visited.push_back(val);
+            return true;
+        }));
+        REQUIRE(visited == expected);
+
+        // stops at the first false
+        visited.clear();
+        REQUIRE(!tree.visit_in_box(box, [&](value_type val) {
+            visited.push_back(val);
+            return visited.size() < 3;
+        }));
+        REQUIRE(visited.size() == 3);
+        REQUIRE(std::equal(visited.begin(), visited.end(), expected.begin()));
+
+        tree.clear();
+        REQUIRE(tree.extent() == extent);
+        REQUIRE(tree.count_items() == 0);
+        REQUIRE(tree.visit_in_box(box, [](value_type) { return false; }));
     }
 }
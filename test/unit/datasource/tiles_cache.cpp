@@ -0,0 +1,95 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+
+#include "../../../plugins/input/tiles/tiles_cache.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("tiles cache")
+{
+    SECTION("bounded by bytes")
+    {
+        mapnik::tiles_cache cache(100);
+        cache.insert("a", std::string(40, 'a'));
+        cache.insert("b", std::string(40, 'b'));
+        CHECK(cache.size() == 2);
+        CHECK(cache.bytes() == 82);
+        // touch "a" so that "b" is the least recently used entry
+        REQUIRE(cache.find("a") != nullptr);
+        cache.insert("c", std::string(40, 'c'));
+        CHECK(cache.size() == 2);
+        CHECK(cache.bytes() == 82);
+        CHECK(cache.find("b") == nullptr);
+        CHECK(*cache.find("a") == std::string(40, 'a'));
+        CHECK(*cache.find("c") == std::string(40, 'c'));
+        CHECK(cache.hits() == 3);
+        CHECK(cache.misses() == 1);
+        CHECK(cache.evictions() == 1);
+    }
+
+    SECTION("oversized and duplicate entries")
+    {
+        mapnik::tiles_cache cache(10);
+        auto buffer = cache.insert("big", std::string(20, 'x'));
+        CHECK(buffer->size() == 20);
+        CHECK(cache.size() == 0);
+        cache.insert("k", "first");
+        CHECK(*cache.insert("k", "second") == "first");
+        CHECK(cache.bytes() == 6);
+    }
+
+    SECTION("evicted buffers stay valid")
+    {
+        mapnik::tiles_cache cache(100);
+        cache.insert("a", std::string(50, 'a'));
+        auto buffer = cache.find("a");
+        cache.set_capacity(0);
+        CHECK(cache.size() == 0);
+        CHECK(cache.bytes() == 0);
+        CHECK(*buffer == std::string(50, 'a'));
+    }
+
+    SECTION("concurrent access")
+    {
+        mapnik::tiles_cache cache(1000);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&cache] {
+                for (int j = 0; j < 1000; ++j)
+                {
+                    std::string key = std::to_string(j % 50);
+                    if (!cache.find(key))
+                        cache.insert(key, std::string(j % 50, 'x'));
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        CHECK(cache.bytes() <= 1000);
+        CHECK(cache.hits() + cache.misses() == 4000);
+    }
+}
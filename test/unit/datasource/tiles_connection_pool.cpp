@@ -0,0 +1,305 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+
+#include <mapnik/datasource.hpp>
+#include "../../../plugins/input/tiles/http_connection_pool.hpp"
+#include "../../../plugins/input/tiles/xyz_tiles.hpp"
+
+#include <boost/beast/http.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+namespace http = boost::beast::http;
+using tcp = boost::asio::ip::tcp;
+using pool_type = mapnik::http_connection_pool<mapnik::plain_connection>;
+
+// Minimal HTTP/1.1 server on localhost counting accepted connections and requests
+class mock_http_server
+{
+  public:
+    enum mode_type {
+        keep_alive,       // keep connections open
+        connection_close, // answer with `Connection: close` and close
+        drop_idle         // answer with keep-alive but close, as on an idle timeout
+    };
+
+  private:
+    struct session : std::enable_shared_from_this<session>
+    {
+        session(tcp::socket&& socket,
+                mode_type mode,
+                std::atomic<std::size_t>& requests,
+                std::atomic<std::size_t>& closed)
+            : socket_(std::move(socket)),
+              mode_(mode),
+              requests_(requests),
+              closed_(closed)
+        {}
+
+        void read()
+        {
+            req_ = {};
+            http::async_read(socket_,
+                             buffer_,
+                             req_,
+                             [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+                                 if (!ec)
+                                     self->write();
+                             });
+        }
+
+        void write()
+        {
+            ++requests_;
+            res_ = {http::status::ok, 11};
+            res_.keep_alive(req_.keep_alive() && mode_ != connection_close);
+            res_.body() = std::string(req_.target());
+            res_.prepare_payload();
+            http::async_write(socket_, res_, [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+                if (ec)
+                    return;
+                if (self->res_.keep_alive() && self->mode_ == keep_alive)
+                    return self->read();
+                boost::beast::error_code ignored;
+                self->socket_.shutdown(tcp::socket::shutdown_both, ignored);
+                self->socket_.close(ignored);
+                ++self->closed_;
+            });
+        }
+
+        tcp::socket socket_;
+        mode_type mode_;
+        boost::beast::flat_buffer buffer_;
+        http::request<http::empty_body> req_;
+        http::response<http::string_body> res_;
+        std::atomic<std::size_t>& requests_;
+        std::atomic<std::size_t>& closed_;
+    };
+
+  public:
+    explicit mock_http_server(mode_type mode = keep_alive)
+        : acceptor_(ioc_, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0)),
+          mode_(mode),
+          connections_(0),
+          requests_(0),
+          closed_(0)
+    {
+        accept();
+        thread_ = std::thread([this] { ioc_.run(); });
+    }
+
+    ~mock_http_server()
+    {
+        ioc_.stop();
+        thread_.join();
+    }
+
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+    std::string key() const { return "http://127.0.0.1:" + std::to_string(port()); }
+    std::size_t connections() const { return connections_.load(); }
+    std::size_t requests() const { return requests_.load(); }
+    std::size_t closed() const { return closed_.load(); }
+
+  private:
+    void accept()
+    {
+        acceptor_.async_accept([this](boost::beast::error_code ec, tcp::socket socket) {
+            if (ec)
+                return;
+            ++connections_;
+            std::make_shared<session>(std::move(socket), mode_, requests_, closed_)->read();
+            accept();
+        });
+    }
+
+    boost::asio::io_context ioc_;
+    tcp::acceptor acceptor_;
+    mode_type mode_;
+    std::atomic<std::size_t> connections_;
+    std::atomic<std::size_t> requests_;
+    std::atomic<std::size_t> closed_;
+    std::thread thread_;
+};
+
+std::string get(mapnik::plain_connection& conn, unsigned short port, std::string const& target)
+{
+    if (!conn.connected)
+    {
+        conn.lowest_layer().connect(tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), port));
+        conn.connected = true;
+    }
+    http::request<http::empty_body> req{http::verb::get, target, 11};
+    req.set(http::field::host, "127.0.0.1");
+    req.keep_alive(true);
+    http::write(*conn.stream, req);
+    boost::beast::flat_buffer buffer;
+    http::response<http::string_body> res;
+    http::read(*conn.stream, buffer, res);
+    ++conn.requests;
+    return res.body();
+}
+
+std::string fetch(pool_type& pool, mock_http_server const& server, std::string const& target)
+{
+    pool_type::connection_ptr conn = pool.acquire(server.key());
+    if (!conn)
+    {
+        conn = std::make_unique<mapnik::plain_connection>();
+    }
+    std::string body = get(*conn, server.port(), target);
+    pool.release(server.key(), std::move(conn));
+    return body;
+}
+
+// Fetch `targets` with the worker used by the tiles featuresets, returns the tile bodies in the order received
+std::vector<std::string> fetch_tiles(mock_http_server const& server, std::vector<zxy> targets, bool& failed)
+{
+    boost::asio::io_context ioc;
+    queue_type queue(targets.size());
+    tiles_stash stash(ioc, targets, queue);
+    std::atomic<bool> done(false);
+    std::string const port = std::to_string(server.port());
+    xyz_tiles::fetch_tiles("127.0.0.1", port, "http://127.0.0.1:" + port + "/{z}/{x}/{y}.mvt", stash, done);
+    failed = done.load();
+    ioc.run();
+    std::vector<std::string> tiles;
+    queue.consume_all([&](tile_data const& tile) { tiles.push_back(tile.data ? *tile.data : std::string()); });
+    return tiles;
+}
+
+} // namespace
+
+TEST_CASE("tiles http connection pool")
+{
+    pool_type& pool = pool_type::instance();
+
+    SECTION("idle connection is reused")
+    {
+        mock_http_server server;
+        REQUIRE(pool.acquire(server.key()) == nullptr);
+        CHECK(fetch(pool, server, "/0/0/0.mvt") == "/0/0/0.mvt");
+        CHECK(pool.idle(server.key()) == 1);
+        CHECK(fetch(pool, server, "/1/0/0.mvt") == "/1/0/0.mvt");
+        CHECK(fetch(pool, server, "/1/1/0.mvt") == "/1/1/0.mvt");
+        CHECK(server.connections() == 1);
+        CHECK(server.requests() == 3);
+        pool.clear();
+        CHECK(pool.idle(server.key()) == 0);
+    }
+
+    SECTION("keep-alive disabled")
+    {
+        mock_http_server server;
+        mapnik::http_pool_options options;
+        options.max_idle = 0;
+        pool.set_options(server.key(), options);
+        fetch(pool, server, "/0/0/0.mvt");
+        fetch(pool, server, "/1/0/0.mvt");
+        CHECK(pool.idle(server.key()) == 0);
+        CHECK(server.connections() == 2);
+        CHECK(server.requests() == 2);
+    }
+
+    SECTION("limits")
+    {
+        mock_http_server server;
+        mapnik::http_pool_options options;
+        options.max_idle = 1;
+        pool.set_options(server.key(), options);
+        auto conn0 = std::make_unique<mapnik::plain_connection>();
+        auto conn1 = std::make_unique<mapnik::plain_connection>();
+        get(*conn0, server.port(), "/0/0/0.mvt");
+        get(*conn1, server.port(), "/0/0/0.mvt");
+        pool.release(server.key(), std::move(conn0));
+        pool.release(server.key(), std::move(conn1));
+        CHECK(pool.idle(server.key()) == 1);
+
+        // connections which exceeded the number of requests are retired
+        options.max_requests = 1;
+        pool.set_options(server.key(), options);
+        auto conn = pool.acquire(server.key());
+        REQUIRE(conn != nullptr);
+        get(*conn, server.port(), "/1/0/0.mvt");
+        pool.release(server.key(), std::move(conn));
+        CHECK(pool.idle(server.key()) == 0);
+
+        // idle connections expire
+        options.max_requests = 100;
+        options.idle_timeout = std::chrono::seconds(0);
+        pool.set_options(server.key(), options);
+        fetch(pool, server, "/2/0/0.mvt");
+        CHECK(pool.acquire(server.key()) == nullptr);
+
+        // unconnected connections are never pooled
+        pool.release(server.key(), std::make_unique<mapnik::plain_connection>());
+        CHECK(pool.idle(server.key()) == 0);
+    }
+
+    SECTION("worker reconnects when a pooled connection was closed")
+    {
+        mock_http_server server(mock_http_server::drop_idle);
+        bool failed = false;
+        auto tiles = fetch_tiles(server, {{0, 0, 0}}, failed);
+        CHECK(!failed);
+        REQUIRE(tiles.size() == 1);
+        CHECK(tiles[0] == "/0/0/0.mvt");
+        // the server closed the connection after answering, while it waits in the pool
+        REQUIRE(pool.idle(server.key()) == 1);
+        for (int i = 0; i < 100 && server.closed() == 0; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        REQUIRE(server.closed() == 1);
+        tiles = fetch_tiles(server, {{1, 1, 0}}, failed);
+        CHECK(!failed);
+        REQUIRE(tiles.size() == 1);
+        CHECK(tiles[0] == "/1/1/0.mvt");
+        CHECK(server.connections() == 2);
+        CHECK(server.requests() == 2);
+        pool.clear();
+    }
+
+    SECTION("worker reconnects after Connection: close")
+    {
+        mock_http_server server(mock_http_server::connection_close);
+        bool failed = false;
+        auto tiles = fetch_tiles(server, {{1, 0, 0}, {1, 1, 0}, {1, 0, 1}}, failed);
+        CHECK(!failed);
+        REQUIRE(tiles.size() == 3);
+        CHECK(tiles[0] == "/1/0/0.mvt");
+        CHECK(tiles[1] == "/1/1/0.mvt");
+        CHECK(tiles[2] == "/1/0/1.mvt");
+        CHECK(server.connections() == 3);
+        CHECK(server.requests() == 3);
+        // a closed connection isn't pooled
+        CHECK(pool.idle(server.key()) == 0);
+    }
+}
@@ -1,4 +1,5 @@
 #include "catch.hpp"
+#include "random_image.hpp"
 
 // mapnik
 #include <mapnik/value.hpp>
@@ -10,6 +11,36 @@
 // stl
 #include <sstream>
 #include <array>
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+// large enough to be split into several bands
+mapnik::image_rgba8 random_image(std::uint32_t seed, std::size_t width = 613, std::size_t height = 419)
+{
+    return testing::random_image(seed, width, height, true, [](std::uint32_t state, std::size_t, std::size_t) {
+        std::uint32_t a = (state >> 5) % 3 == 0 ? 255 : state >> 24;
+        std::uint32_t r = (state & 0xff) * a / 255;
+        std::uint32_t g = ((state >> 8) & 0xff) * a / 255;
+        std::uint32_t b = ((state >> 16) & 0xff) * a / 255;
+        return r | (g << 8) | (b << 16) | (a << 24);
+    });
+}
+
+// FNV-1a hash of the pixels
+std::uint64_t checksum(mapnik::image_rgba8 const& im)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::uint32_t pixel : im)
+    {
+        hash ^= pixel;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
 
 TEST_CASE("image filter")
 {
@@ -519,4 +550,44 @@ TEST_CASE("image filter")
 
     } // END SECTION
 
+    // expected pixels of the banded and fused filters were captured from the
+    // filters applied one at a time on the whole image
+    SECTION("test fused per pixel filters")
+    {
+        std::string const str = "scale-hsla(0,0.5,0,1,0,1,0.1,0.9) gray color-to-alpha(#336699) invert "
+                                "colorize-alpha(blue,red 0.5,green) color-blind-deuteranope";
+        for (bool premultiplied : {true, false})
+        {
+            mapnik::image_rgba8 im = random_image(1);
+            CHECK(checksum(im) == 0x4d2421d044940952);
+            if (!premultiplied)
+                mapnik::demultiply_alpha(im);
+            mapnik::filter::filter_image(im, str);
+            CHECK(im.get_premultiplied());
+            CHECK(im(0, 0) == 0x4b1d1717);
+            CHECK(im(300, 200) == 0x5c172028);
+            CHECK(checksum(im) == (premultiplied ? 0x3e8ba9d78766e3e6 : 0xf70ededf1a8b1f50));
+        }
+    } // END SECTION
+
+    SECTION("test banded agg stack blur")
+    {
+        mapnik::image_rgba8 im = random_image(2);
+        mapnik::filter::filter_image(im, "agg-stack-blur(7,3)");
+        CHECK(im.get_premultiplied());
+        CHECK(im(0, 0) == 0x8154494c);
+        CHECK(im(300, 200) == 0xa94c4f5b);
+        CHECK(checksum(im) == 0xf4a12e2da4c99cf4);
+    } // END SECTION
+
+    SECTION("test banded convolution")
+    {
+        mapnik::image_rgba8 im = random_image(3);
+        mapnik::filter::filter_image(im, "sharpen");
+        CHECK(!im.get_premultiplied());
+        CHECK(im(0, 0) == 0x3cf700ff);
+        CHECK(im(300, 200) == 0xffdf4fff);
+        CHECK(checksum(im) == 0x0a67cdac643d6027);
+    } // END SECTION
+
 } // END TEST CASE
@@ -0,0 +1,122 @@
+#if defined(HAVE_PNG)
+
+#include "catch.hpp"
+
+// mapnik
+#include <mapnik/color.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/image_reader.hpp>
+#include <mapnik/image_reader_pool.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/filesystem.hpp>
+
+// stl
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("image_reader_pool")
+{
+    std::string const directory_name = mapnik::fs::path(mapnik::fs::temp_directory_path() / "mapnik-tests").string();
+    mapnik::fs::create_directories(directory_name);
+    std::string const filename = directory_name + "/image_reader_pool.png";
+    mapnik::image_rgba8 im(13, 7);
+    mapnik::fill(im, mapnik::color(255, 0, 0));
+    mapnik::save_to_file(im, filename, "png");
+
+    mapnik::image_reader_pool& pool = mapnik::image_reader_pool::instance();
+    std::size_t const capacity = pool.capacity();
+    pool.clear();
+
+    SECTION("released readers are reused")
+    {
+        std::size_t const hits = pool.hits();
+        std::size_t const misses = pool.misses();
+        mapnik::image_reader* first = nullptr;
+        {
+            auto reader = pool.borrow(filename, "png");
+            REQUIRE(reader);
+            CHECK(reader->width() == 13);
+            CHECK(reader->height() == 7);
+            first = reader.get();
+            // a borrowed reader isn't shared
+            auto other = pool.borrow(filename, "png");
+            REQUIRE(other);
+            CHECK(other.get() != first);
+        }
+        CHECK(pool.misses() == misses + 2);
+        CHECK(pool.size() == 2);
+        {
+            auto reader = pool.borrow(filename, "png");
+            REQUIRE(reader);
+            CHECK(pool.hits() == hits + 1);
+            CHECK(pool.size() == 1);
+            mapnik::image_any data = reader->read(0, 0, 13, 7);
+            REQUIRE(data.is<mapnik::image_rgba8>());
+            CHECK(data.get<mapnik::image_rgba8>()(12, 6) == im(12, 6));
+        }
+        CHECK(pool.size() == 2);
+    }
+
+    SECTION("readers of a modified file aren't reused")
+    {
+        {
+            auto reader = pool.borrow(filename, "png");
+            REQUIRE(reader);
+        }
+        CHECK(pool.size() == 1);
+        mapnik::image_rgba8 other(17, 5);
+        mapnik::fill(other, mapnik::color(0, 0, 255));
+        mapnik::save_to_file(other, filename, "png");
+        std::size_t const hits = pool.hits();
+        std::size_t const evictions = pool.evictions();
+        {
+            auto reader = pool.borrow(filename, "png");
+            REQUIRE(reader);
+            CHECK(reader->width() == 17);
+            CHECK(reader->height() == 5);
+            CHECK(pool.hits() == hits);
+            CHECK(pool.evictions() == evictions + 1);
+            CHECK(pool.size() == 0);
+        }
+        CHECK(pool.size() == 1);
+    }
+
+    SECTION("bounded")
+    {
+        {
+            auto a = pool.borrow(filename, "png");
+            auto b = pool.borrow(filename, "png");
+            auto c = pool.borrow(filename, "png");
+        }
+        CHECK(pool.size() == 3);
+        std::size_t const evictions = pool.evictions();
+        pool.set_capacity(1);
+        CHECK(pool.size() == 1);
+        CHECK(pool.evictions() == evictions + 2);
+        pool.set_capacity(0);
+        CHECK(pool.size() == 0);
+        {
+            auto reader = pool.borrow(filename, "png");
+            REQUIRE(reader);
+        }
+        CHECK(pool.size() == 0);
+    }
+
+    SECTION("readers released by an exception are dropped")
+    {
+        try
+        {
+            auto reader = pool.borrow(filename, "png");
+            throw std::runtime_error("read failed");
+        }
+        catch (std::runtime_error const&)
+        {}
+        CHECK(pool.size() == 0);
+    }
+
+    pool.set_capacity(capacity);
+    pool.clear();
+    mapnik::fs::remove(filename);
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "catch.hpp"
+#include "random_image.hpp"
+
+// mapnik
+#include <mapnik/image.hpp>
+#include <mapnik/image_any.hpp>
+#include <mapnik/image_compositing.hpp>
+#include <mapnik/image_simd.hpp>
+#include <mapnik/image_util.hpp>
+
+// stl
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using mapnik::simd::instruction_set;
+
+// width isn't a multiple of the vector size so the scalar remainder is covered too
+mapnik::image_rgba8
+  random_image(std::uint32_t seed, bool premultiplied, std::size_t width = 37, std::size_t height = 23)
+{
+    return testing::random_image(seed, width, height, premultiplied, [](std::uint32_t state, std::size_t, std::size_t) {
+        // plenty of fully opaque and fully transparent pixels
+        if ((state >> 5) % 4 == 0)
+            return state | 0xff000000;
+        if ((state >> 5) % 4 == 1)
+            return state & 0x00ffffff;
+        return state;
+    });
+}
+
+bool same_pixels(mapnik::image_rgba8 const& a, mapnik::image_rgba8 const& b)
+{
+    return a.width() == b.width() && a.height() == b.height() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+std::vector<instruction_set> instruction_sets()
+{
+    std::vector<instruction_set> result{instruction_set::scalar};
+    instruction_set detected = mapnik::simd::detect_instruction_set();
+    if (detected >= instruction_set::sse41)
+        result.push_back(instruction_set::sse41);
+    if (detected >= instruction_set::avx2)
+        result.push_back(instruction_set::avx2);
+    return result;
+}
+
+// runs `op` with every available instruction set and compares with the scalar AGG result
+void check_identical(mapnik::image_rgba8 const& input, std::function<void(mapnik::image_rgba8&)> const& op)
+{
+    instruction_set const active = mapnik::simd::active_instruction_set();
+    mapnik::simd::set_instruction_set(instruction_set::scalar);
+    mapnik::image_rgba8 expected(input);
+    op(expected);
+    for (instruction_set isa : instruction_sets())
+    {
+        mapnik::simd::set_instruction_set(isa);
+        mapnik::image_rgba8 actual(input);
+        op(actual);
+        INFO("instruction set " << static_cast<int>(isa));
+        CHECK(same_pixels(actual, expected));
+    }
+    mapnik::simd::set_instruction_set(active);
+}
+
+// ordering of rgba::mean_sort_cmp
+auto mean_sort_key(std::uint32_t p)
+{
+    std::uint32_t const r = p & 0xff;
+    std::uint32_t const g = (p >> 8) & 0xff;
+    std::uint32_t const b = (p >> 16) & 0xff;
+    std::uint32_t const a = p >> 24;
+    return std::make_tuple(r + g + b + a, a, r, g, b);
+}
+
+// sorted position of `c` in the palette, like the quantizers look it up
+std::size_t nearest_hint(std::vector<std::uint32_t> const& palette, std::uint32_t c)
+{
+    auto it = std::lower_bound(palette.begin(), palette.end(), c, [](std::uint32_t x, std::uint32_t y) {
+        return mean_sort_key(x) < mean_sort_key(y);
+    });
+    return std::min<std::size_t>(it - palette.begin(), palette.size() - 1);
+}
+
+// neighbour search of the quantizers around the sorted position `hint`
+std::size_t nearest_reference(std::vector<std::uint32_t> const& palette, std::uint32_t c, std::size_t hint)
+{
+    int total = 0;
+    auto const distance = [&](std::size_t i) {
+        auto const diff = [&](int shift) {
+            return int((palette[i] >> shift) & 0xff) - int((c >> shift) & 0xff);
+        };
+        int const dr = diff(0);
+        int const dg = diff(8);
+        int const db = diff(16);
+        int const da = diff(24);
+        total = dr + dg + db + da;
+        return dr * dr + dg * dg + db * db + da * da;
+    };
+    std::size_t index = hint;
+    int dist = distance(hint);
+    for (std::size_t i = hint; i-- > 0;)
+    {
+        int const d = distance(i);
+        if (total * total / 4 > dist)
+            break;
+        if (d < dist)
+        {
+            index = i;
+            dist = d;
+        }
+    }
+    for (std::size_t i = hint + 1; i < palette.size(); ++i)
+    {
+        int const d = distance(i);
+        if (total * total / 4 > dist)
+            break;
+        if (d < dist)
+        {
+            index = i;
+            dist = d;
+        }
+    }
+    return index;
+}
+
+} // namespace
+
+TEST_CASE("image simd")
+{
+    SECTION("instruction set")
+    {
+        instruction_set const active = mapnik::simd::active_instruction_set();
+        CHECK(active <= mapnik::simd::detect_instruction_set());
+        mapnik::simd::set_instruction_set(instruction_set::avx2);
+        CHECK(mapnik::simd::active_instruction_set() == mapnik::simd::detect_instruction_set());
+        mapnik::simd::set_instruction_set(instruction_set::scalar);
+        CHECK(mapnik::simd::active_instruction_set() == instruction_set::scalar);
+        CHECK_FALSE(mapnik::simd::premultiply_rgba8(nullptr, 0));
+        CHECK_FALSE(mapnik::simd::can_composite_rgba8(mapnik::src_over));
+        mapnik::simd::set_instruction_set(active);
+    }
+
+    SECTION("premultiply and demultiply")
+    {
+        check_identical(random_image(1, false), [](mapnik::image_rgba8& im) { mapnik::premultiply_alpha(im); });
+        check_identical(random_image(2, true), [](mapnik::image_rgba8& im) { mapnik::demultiply_alpha(im); });
+
+        // every channel value with every alpha value
+        mapnik::image_rgba8 all(256, 256, true, true);
+        for (std::uint32_t a = 0; a < 256; ++a)
+        {
+            for (std::uint32_t c = 0; c < 256; ++c)
+            {
+                all(c, a) = (a << 24) | (c << 16) | ((255 - c) << 8) | c;
+            }
+        }
+        check_identical(all, [](mapnik::image_rgba8& im) { mapnik::demultiply_alpha(im); });
+        all.set_premultiplied(false);
+        check_identical(all, [](mapnik::image_rgba8& im) { mapnik::premultiply_alpha(im); });
+    }
+
+    SECTION("opacity")
+    {
+        for (float opacity : {0.0f, 0.33f, 0.5f, 0.999f, 1.0f})
+        {
+            check_identical(random_image(3, false), [opacity](mapnik::image_rgba8& im) {
+                mapnik::image_any any(std::move(im));
+                mapnik::apply_opacity(any, opacity);
+                im = std::move(mapnik::util::get<mapnik::image_rgba8>(any));
+            });
+        }
+    }
+
+    SECTION("composite")
+    {
+        mapnik::image_rgba8 const src = random_image(4, true, 29, 17);
+        for (auto mode : {mapnik::src_over, mapnik::multiply, mapnik::screen, mapnik::dst_out, mapnik::overlay})
+        {
+            for (float opacity : {1.0f, 0.5f, 0.0f})
+            {
+                for (int offset : {0, 5, -7, 40})
+                {
+                    check_identical(random_image(5, true), [&](mapnik::image_rgba8& im) {
+                        mapnik::composite(im, src, mode, opacity, offset, -offset / 2);
+                    });
+                }
+            }
+        }
+    }
+
+    SECTION("equal runs")
+    {
+        instruction_set const active = mapnik::simd::active_instruction_set();
+        std::vector<std::uint32_t> pixels(53, 0xff102030);
+        for (instruction_set isa : instruction_sets())
+        {
+            INFO("instruction set " << static_cast<int>(isa));
+            mapnik::simd::set_instruction_set(isa);
+            CHECK(mapnik::simd::equal_run_rgba8(pixels.data(), 0) == 0);
+            CHECK(mapnik::simd::equal_run_rgba8(pixels.data(), pixels.size()) == pixels.size());
+            // breaks inside the first vector, in a later vector and in the scalar remainder
+            for (std::size_t end : {1, 3, 9, 17, 50})
+            {
+                std::vector<std::uint32_t> run(pixels);
+                run[end] = 0x00102030;
+                CHECK(mapnik::simd::equal_run_rgba8(run.data(), run.size()) == end);
+                CHECK(mapnik::simd::equal_run_rgba8(run.data() + end, run.size() - end) == 1);
+            }
+        }
+        mapnik::simd::set_instruction_set(active);
+    }
+
+    SECTION("nearest palette entry")
+    {
+        instruction_set const active = mapnik::simd::active_instruction_set();
+        mapnik::image_rgba8 const colors = random_image(7, false, 64, 16);
+        for (std::size_t size : {1, 3, 8, 37, 256})
+        {
+            // few distinct channel values, so that many entries are equally distant
+            std::vector<std::uint32_t> palette;
+            for (std::uint32_t p : random_image(unsigned(size), false, size, 1))
+            {
+                palette.push_back(p & 0xc0c0c0c0);
+            }
+            std::sort(palette.begin(), palette.end(), [](std::uint32_t x, std::uint32_t y) {
+                return mean_sort_key(x) < mean_sort_key(y);
+            });
+            for (instruction_set isa : instruction_sets())
+            {
+                INFO("instruction set " << static_cast<int>(isa) << " palette size " << size);
+                mapnik::simd::set_instruction_set(isa);
+                for (std::uint32_t c : colors)
+                {
+                    std::size_t const hint = nearest_hint(palette, c);
+                    std::size_t const expected = nearest_reference(palette, c, hint);
+                    std::size_t index = palette.size();
+                    if (mapnik::simd::nearest_rgba8(palette.data(), palette.size(), c, hint, index))
+                    {
+                        CHECK(index == expected);
+                    }
+                    else
+                    {
+                        CHECK(isa == instruction_set::scalar);
+                    }
+                }
+            }
+        }
+        mapnik::simd::set_instruction_set(active);
+    }
+}
@@ -0,0 +1,209 @@
+#if defined(HAVE_PNG)
+
+#include "catch.hpp"
+#include "random_image.hpp"
+
+#include <mapnik/image.hpp>
+#include <mapnik/image_reader.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/image_view.hpp>
+#include <mapnik/png_encoder.hpp>
+#include <mapnik/png_io.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// gradients with a little noise and semi transparent blocks, close to rendered tiles
+mapnik::image_rgba8 test_image(std::size_t width, std::size_t height)
+{
+    return testing::random_image(12345, width, height, false, [=](std::uint32_t state, std::size_t x, std::size_t y) {
+        std::uint32_t const noise = (state >> 24) & 0x7;
+        std::uint32_t const r = (x * 255 / width + noise) & 0xff;
+        std::uint32_t const g = (y * 255 / height) & 0xff;
+        std::uint32_t const b = ((x + y) & 0x40) ? 200 : 20;
+        std::uint32_t const a = (x / 16 + y / 16) % 3 == 0 ? 128 : 255;
+        return (a << 24) | (b << 16) | (g << 8) | r;
+    });
+}
+
+mapnik::image_rgba8 decode(std::string const& data)
+{
+    std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(data.data(), data.size()));
+    REQUIRE(reader);
+    return mapnik::util::get<mapnik::image_rgba8>(reader->read(0, 0, reader->width(), reader->height()));
+}
+
+bool same_pixels(mapnik::image_rgba8 const& a, mapnik::image_rgba8 const& b)
+{
+    return a.width() == b.width() && a.height() == b.height() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+} // namespace
+
+TEST_CASE("png io")
+{
+    SECTION("built in encoders decode to the libpng output")
+    {
+        mapnik::image_rgba8 const im = test_image(97, 61);
+        std::vector<std::string> encoders{"zlib"};
+        if (mapnik::png_encoder_available(mapnik::png_encoder::libdeflate))
+        {
+            encoders.emplace_back("libdeflate");
+        }
+        std::vector<std::string> const formats{"png32",
+                                               "png32:t=0",
+                                               "png32:f=all",
+                                               "png32:f=fast",
+                                               "png32:f=auto",
+                                               "png32:z=1:s=rle",
+                                               "png32:z=0",
+                                               "png8",
+                                               "png8:m=o",
+                                               "png8:c=16",
+                                               "png8:c=2:t=1",
+                                               "png8:f=auto"};
+        for (std::string const& format : formats)
+        {
+            mapnik::image_rgba8 const expected = decode(mapnik::save_to_string(im, format));
+            for (std::string const& encoder : encoders)
+            {
+                INFO(format << ":e=" << encoder);
+                std::string const data = mapnik::save_to_string(im, format + ":e=" + encoder);
+                CHECK(same_pixels(decode(data), expected));
+            }
+        }
+        CHECK(same_pixels(decode(mapnik::save_to_string(im, "png32:e=zlib:f=auto")), im));
+    }
+
+    SECTION("parallel chunks")
+    {
+        // large enough for four deflate streams
+        mapnik::image_rgba8 const im = test_image(613, 521);
+        std::string const serial = mapnik::save_to_string(im, "png32:e=zlib");
+        for (std::string const& format : {"png32:e=zlib:j=2", "png32:e=zlib:j=4:f=auto", "png32:e=zlib:j=8:f=all"})
+        {
+            INFO(format);
+            std::string const data = mapnik::save_to_string(im, format);
+            CHECK(same_pixels(decode(data), im));
+            // the dictionary keeps the size close to a single stream
+            CHECK(data.size() < serial.size() * 11 / 10);
+        }
+        mapnik::image_rgba8 const opaque = decode(mapnik::save_to_string(im, "png32:t=0"));
+        CHECK(same_pixels(decode(mapnik::save_to_string(im, "png32:e=zlib:j=4:t=0")), opaque));
+    }
+
+    SECTION("image views")
+    {
+        mapnik::image_rgba8 const im = test_image(64, 48);
+        mapnik::image_view_rgba8 view(5, 7, 40, 30, im);
+        mapnik::image_rgba8 expected(40, 30);
+        for (std::size_t y = 0; y < 30; ++y)
+        {
+            std::copy(view.get_row(y), view.get_row(y) + 40, expected.get_row(y));
+        }
+        CHECK(same_pixels(decode(mapnik::save_to_string(view, "png32:e=zlib")), expected));
+        CHECK(same_pixels(decode(mapnik::save_to_string(view, "png32:f=auto")), expected));
+    }
+
+    SECTION("filter heuristic")
+    {
+        mapnik::image_rgba8 rows(64, 64);
+        mapnik::image_rgba8 columns(64, 64);
+        for (std::size_t y = 0; y < 64; ++y)
+        {
+            for (std::size_t x = 0; x < 64; ++x)
+            {
+                std::uint32_t const noise = ((x * 7919) ^ (x * x * 31)) & 0xff;
+                columns(x, y) = 0xff000000 | noise * 0x010101;
+                rows(y, x) = 0xff000000 | noise * 0x010101;
+            }
+        }
+        // identical rows compress best against the row above, constant rows against the pixel to the left
+        CHECK(mapnik::select_png_filter(columns.bytes(), columns.row_size(), columns.row_size(), 64, 4) ==
+              PNG_FILTER_UP);
+        CHECK(mapnik::select_png_filter(rows.bytes(), rows.row_size(), rows.row_size(), 64, 4) == PNG_FILTER_SUB);
+    }
+
+    SECTION("palette remap")
+    {
+        mapnik::image_rgba8 im = test_image(61, 45);
+        // long runs of one color next to noise
+        std::fill(im.get_row(3), im.get_row(3) + 61, 0xff336699);
+        std::fill(im.get_row(10) + 7, im.get_row(10) + 50, 0x80000000);
+        mapnik::rgba_palette const pal(std::string("\x10\x20\x30\xff\xf0\xe0\xd0\xff\x99\x66\x33\xff"
+                                                   "\x00\x00\x00\x00\x80\x80\x80\x80\xff\x00\x00\xff",
+                                                   24));
+        mapnik::image_rgba8 expected(im.width(), im.height());
+        for (std::size_t y = 0; y < im.height(); ++y)
+        {
+            for (std::size_t x = 0; x < im.width(); ++x)
+            {
+                unsigned const index = pal.quantize(im(x, y));
+                mapnik::rgb const& c = pal.palette()[index];
+                unsigned const a = index < pal.alpha_table().size() ? pal.alpha_table()[index] : 255;
+                expected(x, y) = (a << 24) | (c.b << 16) | (c.g << 8) | c.r;
+            }
+        }
+        // six colors are written with 4 bit indexes
+        CHECK(same_pixels(decode(mapnik::save_to_string(im, "png8", pal)), expected));
+        CHECK(same_pixels(decode(mapnik::save_to_string(im, "png8:e=zlib", pal)), expected));
+
+        // the palette is shared by concurrent encoders
+        std::vector<std::string> outputs(4);
+        std::vector<std::thread> threads;
+        for (std::string& out : outputs)
+        {
+            threads.emplace_back([&] { out = mapnik::save_to_string(im, "png8", pal); });
+        }
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+        for (std::string const& out : outputs)
+        {
+            CHECK(same_pixels(decode(out), expected));
+        }
+    }
+
+    SECTION("sampled palette")
+    {
+        mapnik::image_rgba8 im = test_image(301, 211);
+        std::fill(im.get_row(100), im.get_row(100) + 301, 0x00000000);
+        mapnik::image_rgba8 const full = decode(mapnik::save_to_string(im, "png8"));
+        mapnik::image_rgba8 const sampled = decode(mapnik::save_to_string(im, "png8:sample=1024"));
+        REQUIRE(sampled.width() == im.width());
+        REQUIRE(sampled.height() == im.height());
+        // the transparent row isn't sampled but still gets a transparent entry
+        CHECK(sampled(150, 100) >> 24 == 0);
+        CHECK(full(150, 100) >> 24 == 0);
+        // sampling is skipped for images smaller than the sample
+        CHECK(same_pixels(decode(mapnik::save_to_string(im, "png8:sample=100000")), full));
+    }
+
+    SECTION("options")
+    {
+        mapnik::image_rgba8 const im(16, 16);
+        CHECK_THROWS(mapnik::save_to_string(im, "png32:e=foo"));
+        CHECK_THROWS(mapnik::save_to_string(im, "png32:e=miniz"));
+        CHECK_THROWS(mapnik::save_to_string(im, "png32:j=0"));
+        CHECK_THROWS(mapnik::save_to_string(im, "png32:j=2"));
+        CHECK_NOTHROW(mapnik::save_to_string(im, "png32:e=zlib:j=2"));
+        CHECK_NOTHROW(mapnik::save_to_string(im, "png8:e=libpng:f=auto"));
+        CHECK_NOTHROW(mapnik::save_to_string(im, "png8:sample=64"));
+        CHECK_THROWS(mapnik::save_to_string(im, "png8:sample=-1"));
+        CHECK_THROWS(mapnik::save_to_string(im, "png8:m=o:sample=64"));
+        CHECK_THROWS(mapnik::save_to_string(im, "png32:sample=64"));
+        if (!mapnik::png_encoder_available(mapnik::png_encoder::libdeflate))
+        {
+            CHECK_THROWS(mapnik::save_to_string(im, "png32:e=libdeflate"));
+        }
+    }
+}
+
+#endif
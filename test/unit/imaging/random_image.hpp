@@ -0,0 +1,57 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_TEST_RANDOM_IMAGE_HPP
+#define MAPNIK_TEST_RANDOM_IMAGE_HPP
+
+// mapnik
+#include <mapnik/image.hpp>
+
+// stl
+#include <cstddef>
+#include <cstdint>
+
+namespace testing {
+
+// Fills an image row by row with `pixel(state, x, y)`, where `state` is the next value of
+// a linear congruential generator seeded with `seed`. The images are the same on every
+// platform, so tests can compare them against fixed checksums.
+template<typename F>
+mapnik::image_rgba8
+  random_image(std::uint32_t seed, std::size_t width, std::size_t height, bool premultiplied, F const& pixel)
+{
+    mapnik::image_rgba8 im(width, height, true, premultiplied);
+    std::uint32_t state = seed;
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            state = state * 1664525u + 1013904223u;
+            im(x, y) = pixel(state, x, y);
+        }
+    }
+    return im;
+}
+
+} // namespace testing
+
+#endif // MAPNIK_TEST_RANDOM_IMAGE_HPP
@@ -6,11 +6,17 @@
 #include "catch.hpp"
 
 #include <mapnik/color.hpp>
+#include <mapnik/datasource.hpp>
+#include <mapnik/datasource_cache.hpp>
+#include <mapnik/feature.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_view.hpp>
 #include <mapnik/image_reader.hpp>
+#include <mapnik/raster.hpp>
+#include <mapnik/tiff_block_cache.hpp>
 #include <mapnik/util/file_io.hpp>
 #include <mapnik/util/fs.hpp>
+#include <mapnik/filesystem.hpp>
 #include <boost/interprocess/streams/bufferstream.hpp>
 #include "../../../src/tiff_reader.hpp"
 
@@ -163,6 +169,121 @@ void test_tiff_reader(std::string const& pattern)
     }
 }
 
+// gray8 tiled image of 64x48 followed by reduced resolution subfiles, pixels
+// of level n are x + y + 50 * n
+void write_tiff_with_overviews(std::string const& filename, unsigned levels)
+{
+    TIFF* tif = TIFFOpen(filename.c_str(), "w");
+    REQUIRE(tif != nullptr);
+    for (unsigned level = 0; level <= levels; ++level)
+    {
+        std::uint32_t const width = 64 >> level;
+        std::uint32_t const height = 48 >> level;
+        if (level > 0)
+        {
+            TIFFSetField(tif, TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+        }
+        TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, width);
+        TIFFSetField(tif, TIFFTAG_IMAGELENGTH, height);
+        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+        TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_ADOBE_DEFLATE);
+        TIFFSetField(tif, TIFFTAG_TILEWIDTH, 16);
+        TIFFSetField(tif, TIFFTAG_TILELENGTH, 16);
+        std::vector<std::uint8_t> tile(16 * 16);
+        for (std::uint32_t y = 0; y < height; y += 16)
+        {
+            for (std::uint32_t x = 0; x < width; x += 16)
+            {
+                for (std::uint32_t j = 0; j < 16; ++j)
+                {
+                    for (std::uint32_t i = 0; i < 16; ++i)
+                    {
+                        tile[j * 16 + i] = static_cast<std::uint8_t>(x + i + y + j + 50 * level);
+                    }
+                }
+                TIFFWriteEncodedTile(tif, TIFFComputeTile(tif, x, y, 0, 0), tile.data(), tile.size());
+            }
+        }
+        TIFFWriteDirectory(tif);
+    }
+    TIFFClose(tif);
+}
+
+// gray8 image with 16x16 tiles or strips of 4 rows, pixels are (base + x + 2 * y) % 256
+void write_gray8_tiff(std::string const& filename,
+                      std::uint32_t width,
+                      std::uint32_t height,
+                      bool tiled,
+                      std::uint8_t base = 0)
+{
+    TIFF* tif = TIFFOpen(filename.c_str(), "w");
+    REQUIRE(tif != nullptr);
+    TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, width);
+    TIFFSetField(tif, TIFFTAG_IMAGELENGTH, height);
+    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+    TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_ADOBE_DEFLATE);
+    std::uint32_t const block_width = tiled ? 16 : width;
+    std::uint32_t const block_height = tiled ? 16 : 4;
+    if (tiled)
+    {
+        TIFFSetField(tif, TIFFTAG_TILEWIDTH, block_width);
+        TIFFSetField(tif, TIFFTAG_TILELENGTH, block_height);
+    }
+    else
+    {
+        TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, block_height);
+    }
+    std::vector<std::uint8_t> block(block_width * block_height);
+    for (std::uint32_t y = 0; y < height; y += block_height)
+    {
+        for (std::uint32_t x = 0; x < width; x += block_width)
+        {
+            for (std::uint32_t j = 0; j < block_height; ++j)
+            {
+                for (std::uint32_t i = 0; i < block_width; ++i)
+                {
+                    block[j * block_width + i] = static_cast<std::uint8_t>(base + x + i + 2 * (y + j));
+                }
+            }
+            if (tiled)
+            {
+                TIFFWriteEncodedTile(tif, TIFFComputeTile(tif, x, y, 0, 0), block.data(), block.size());
+            }
+            else
+            {
+                TIFFWriteEncodedStrip(tif, TIFFComputeStrip(tif, y, 0), block.data(), block.size());
+            }
+        }
+    }
+    TIFFClose(tif);
+}
+
+template<typename Reader>
+void check_gray8_tiff(Reader& reader, std::size_t x0, std::size_t y0, std::uint8_t base = 0)
+{
+    mapnik::image_any data = reader.read(x0, y0, reader.width() - x0, reader.height() - y0);
+    REQUIRE(data.is<mapnik::image_gray8>());
+    auto const& im = data.get<mapnik::image_gray8>();
+    REQUIRE(im.width() == reader.width() - x0);
+    REQUIRE(im.height() == reader.height() - y0);
+    std::size_t wrong = 0;
+    for (std::size_t y = 0; y < im.height(); ++y)
+    {
+        for (std::size_t x = 0; x < im.width(); ++x)
+        {
+            if (im(x, y) != static_cast<std::uint8_t>(base + x0 + x + 2 * (y0 + y)))
+                ++wrong;
+        }
+    }
+    CHECK(wrong == 0);
+}
+
 } // namespace
 
 TEST_CASE("tiff io")
@@ -408,6 +529,187 @@ TEST_CASE("tiff io")
         TIFF_ASSERT_NO_ALPHA_GRAY(data);
         TIFF_READ_ONE_PIXEL
     }
+
+    SECTION("block cache")
+    {
+        mapnik::tiff_block_cache& cache = mapnik::tiff_block_cache::instance();
+        std::size_t const capacity = cache.capacity();
+        for (auto const* filename : {"./test/data/tiff/scan_512x512_rgb8_tiled.tif",
+                                     "./test/data/tiff/ndvi_256x256_rgba8_striped.tif",
+                                     "./test/data/tiff/ndvi_256x256_gray32f_tiled.tif"})
+        {
+            cache.set_capacity(0);
+            mapnik::tiff_reader<source_type> uncached(filename);
+            mapnik::image_any const expected = uncached.read(0, 0, uncached.width(), uncached.height());
+            CHECK(cache.size() == 0);
+            cache.set_capacity(capacity);
+            cache.clear();
+
+            mapnik::tiff_reader<source_type> first(filename);
+            mapnik::image_any const data = first.read(0, 0, first.width(), first.height());
+            CHECK(cache.size() > 0);
+            // overlapping region of another reader is served from the cache
+            std::size_t const misses = cache.misses();
+            std::size_t const hits = cache.hits();
+            mapnik::tiff_reader<source_type> second(filename);
+            mapnik::image_any const part = second.read(11, 13, second.width() - 11, second.height() - 13);
+            CHECK(cache.misses() == misses);
+            CHECK(cache.hits() > hits);
+            // in memory images aren't cached
+            std::size_t const size = cache.size();
+            mapnik::util::file file(filename);
+            auto const bytes = file.data();
+            mapnik::tiff_reader<mapnik::util::char_array_buffer> third(bytes.get(), file.size());
+            mapnik::image_any const buffered = third.read(0, 0, third.width(), third.height());
+            CHECK(cache.misses() == misses);
+            CHECK(cache.size() == size);
+
+            mapnik::util::apply_visitor(
+              [&](auto const& im) {
+                  using image_type = std::decay_t<decltype(im)>;
+                  if constexpr (!std::is_same_v<image_type, mapnik::image_null>)
+                  {
+                      REQUIRE(data.is<image_type>());
+                      REQUIRE(part.is<image_type>());
+                      REQUIRE(buffered.is<image_type>());
+                      REQUIRE(identical(im, data.get<image_type>()));
+                      REQUIRE(identical(im, buffered.get<image_type>()));
+                      auto view = mapnik::image_view<image_type>(11, 13, im.width(), im.height(), im);
+                      REQUIRE(identical(view, part.get<image_type>()));
+                  }
+              },
+              expected);
+        }
+        cache.clear();
+    }
+
+    SECTION("overviews")
+    {
+        std::string const directory_name =
+          mapnik::fs::path(mapnik::fs::temp_directory_path() / "mapnik-tests").string();
+        mapnik::fs::create_directories(directory_name);
+        std::string const filename = directory_name + "/tiff_overviews.tif";
+        write_tiff_with_overviews(filename, 2);
+        {
+            std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(filename, "tiff"));
+            auto const overviews = reader->overviews();
+            REQUIRE(overviews.size() == 2);
+            CHECK(overviews[0] == std::make_pair(32u, 24u));
+            CHECK(overviews[1] == std::make_pair(16u, 12u));
+            for (unsigned level : {2u, 0u, 1u})
+            {
+                reader->select_overview(level);
+                REQUIRE(reader->width() == (64u >> level));
+                REQUIRE(reader->height() == (48u >> level));
+                mapnik::image_any data = reader->read(3, 5, reader->width() - 3, reader->height() - 5);
+                REQUIRE(data.is<mapnik::image_gray8>());
+                auto const& im = data.get<mapnik::image_gray8>();
+                CHECK(im(0, 0) == 3 + 5 + 50 * level);
+                CHECK(im(im.width() - 1, im.height() - 1) == reader->width() - 1 + reader->height() - 1 + 50 * level);
+            }
+            CHECK_THROWS(reader->select_overview(3));
+        }
+        // the raster plugin reads from the smallest overview meeting the query resolution
+        if (mapnik::datasource_cache::instance().plugin_registered("raster"))
+        {
+            mapnik::parameters params;
+            params["type"] = std::string("raster");
+            params["file"] = filename;
+            params["extent"] = std::string("0,0,64,48");
+            mapnik::datasource_ptr ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(ds != nullptr);
+            for (unsigned level : {0u, 1u, 2u})
+            {
+                double const resolution = 1.0 / (1 << level);
+                mapnik::query q(ds->envelope(), mapnik::query::resolution_type(resolution, resolution), 1.0);
+                mapnik::feature_ptr feature = ds->features(q)->next();
+                REQUIRE(feature != nullptr);
+                mapnik::raster_ptr raster = feature->get_raster();
+                REQUIRE(raster != nullptr);
+                REQUIRE(raster->data_.is<mapnik::image_gray8>());
+                auto const& im = raster->data_.get<mapnik::image_gray8>();
+                CHECK(im.width() == (64u >> level));
+                CHECK(im.height() == (48u >> level));
+                CHECK(im(0, 0) == 50 * level);
+                CHECK(raster->ext_ == ds->envelope());
+            }
+        }
+        // full resolution image only
+        std::string const plain = directory_name + "/tiff_no_overviews.tif";
+        write_tiff_with_overviews(plain, 0);
+        {
+            std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(plain, "tiff"));
+            CHECK(reader->overviews().empty());
+            CHECK_NOTHROW(reader->select_overview(0));
+            CHECK_THROWS(reader->select_overview(1));
+        }
+        mapnik::fs::remove(plain);
+        mapnik::fs::remove(filename);
+    }
+
+    SECTION("blocks decoded in several ranges")
+    {
+        std::string const directory_name =
+          mapnik::fs::path(mapnik::fs::temp_directory_path() / "mapnik-tests").string();
+        mapnik::fs::create_directories(directory_name);
+        mapnik::tiff_block_cache& cache = mapnik::tiff_block_cache::instance();
+        for (bool tiled : {true, false})
+        {
+            // 48 tiles or 24 strips, split into a range per worker and one for the calling thread
+            std::string const filename = directory_name + (tiled ? "/tiff_ranges_tiled.tif" : "/tiff_ranges.tif");
+            write_gray8_tiff(filename, 128, 96, tiled);
+            cache.clear();
+            {
+                mapnik::tiff_reader<source_type> reader(filename);
+                check_gray8_tiff(reader, 0, 0);
+                cache.clear();
+                check_gray8_tiff(reader, 5, 3);
+            }
+#if !defined(MAPNIK_MEMORY_MAPPED_FILE)
+            // ranges on other threads can't reopen a removed file, the
+            // calling thread decodes their blocks instead
+            {
+                mapnik::tiff_reader<source_type> reader(filename);
+                mapnik::fs::remove(filename);
+                cache.clear();
+                check_gray8_tiff(reader, 0, 0);
+            }
+#endif
+            mapnik::fs::remove(filename);
+        }
+        cache.clear();
+    }
+
+    SECTION("blocks of a rewritten file")
+    {
+        std::string const directory_name =
+          mapnik::fs::path(mapnik::fs::temp_directory_path() / "mapnik-tests").string();
+        mapnik::fs::create_directories(directory_name);
+        std::string const filename = directory_name + "/tiff_rewritten.tif";
+        mapnik::tiff_block_cache& cache = mapnik::tiff_block_cache::instance();
+        cache.clear();
+        write_gray8_tiff(filename, 128, 96, true);
+        {
+            mapnik::tiff_reader<source_type> reader(filename);
+            check_gray8_tiff(reader, 0, 0);
+        }
+        REQUIRE(cache.size() > 0);
+        // same name and block layout, different pixels and file size
+        write_gray8_tiff(filename, 96, 64, true, 100);
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+        mapnik::mapped_memory_cache::instance().remove(filename);
+#endif
+        {
+            std::size_t const hits = cache.hits();
+            mapnik::tiff_reader<source_type> reader(filename);
+            REQUIRE(reader.width() == 96);
+            REQUIRE(reader.height() == 64);
+            check_gray8_tiff(reader, 0, 0, 100);
+            CHECK(cache.hits() == hits);
+        }
+        mapnik::fs::remove(filename);
+        cache.clear();
+    }
 }
 
 #endif
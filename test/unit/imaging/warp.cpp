@@ -0,0 +1,148 @@
+#include "catch.hpp"
+
+// mapnik
+#include <mapnik/image.hpp>
+#include <mapnik/image_scaling.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/warp.hpp>
+#include <mapnik/warp_mesh_cache.hpp>
+
+// stl
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+mapnik::image_rgba8 checkerboard(std::size_t width, std::size_t height)
+{
+    mapnik::image_rgba8 im(width, height, true, true);
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            im(x, y) = ((x / 8 + y / 8) % 2) ? 0xff2040c0 : 0xffc08020;
+        }
+    }
+    return im;
+}
+
+mapnik::image_rgba8 warp(mapnik::image_rgba8 const& source,
+                         mapnik::proj_transform const& prj_trans,
+                         mapnik::box2d<double> const& source_ext,
+                         mapnik::box2d<double> const& target_ext,
+                         mapnik::scaling_method_e scaling,
+                         std::size_t band_rows = 64)
+{
+    mapnik::image_rgba8 target(300, 300, true, true);
+    mapnik::warp_image(target,
+                       source,
+                       prj_trans,
+                       target_ext,
+                       source_ext,
+                       0.0,
+                       0.0,
+                       16,
+                       scaling,
+                       1.0,
+                       std::nullopt,
+                       band_rows);
+    return target;
+}
+
+} // namespace
+
+TEST_CASE("warp")
+{
+    mapnik::projection const source_proj("epsg:4326");
+    mapnik::projection const target_proj("epsg:3857");
+    mapnik::proj_transform const prj_trans(source_proj, target_proj);
+    mapnik::box2d<double> const source_ext(-10.0, 40.0, 10.0, 60.0);
+    mapnik::box2d<double> target_ext(source_ext);
+    prj_trans.forward(target_ext);
+    mapnik::image_rgba8 const source = checkerboard(257, 199);
+    mapnik::warp_mesh_cache& cache = mapnik::warp_mesh_cache::instance();
+    std::size_t const capacity = cache.capacity();
+
+    SECTION("cached meshes give the same result")
+    {
+        for (auto scaling : {mapnik::SCALING_NEAR, mapnik::SCALING_BILINEAR, mapnik::SCALING_LANCZOS})
+        {
+            cache.set_capacity(0);
+            mapnik::image_rgba8 const expected = warp(source, prj_trans, source_ext, target_ext, scaling);
+            CHECK(cache.size() == 0);
+            cache.set_capacity(capacity);
+            cache.clear();
+
+            std::size_t const hits = cache.hits();
+            mapnik::image_rgba8 const first = warp(source, prj_trans, source_ext, target_ext, scaling);
+            CHECK(cache.cost() == 18 * 14);
+            // the mesh doesn't depend on the target extent
+            mapnik::box2d<double> shifted(target_ext);
+            shifted.move(target_ext.width() / 3, 0.0);
+            warp(source, prj_trans, source_ext, shifted, scaling);
+            mapnik::image_rgba8 const second = warp(source, prj_trans, source_ext, target_ext, scaling);
+            CHECK(cache.hits() == hits + 2);
+            CHECK(std::equal(first.begin(), first.end(), expected.begin()));
+            CHECK(std::equal(second.begin(), second.end(), expected.begin()));
+        }
+    }
+
+    SECTION("bands give the same result as a serial pass")
+    {
+        for (auto scaling : {mapnik::SCALING_NEAR, mapnik::SCALING_BILINEAR, mapnik::SCALING_LANCZOS})
+        {
+            mapnik::image_rgba8 const serial = warp(source, prj_trans, source_ext, target_ext, scaling, 300);
+            for (std::size_t band_rows : {64, 17, 1})
+            {
+                mapnik::image_rgba8 const banded = warp(source, prj_trans, source_ext, target_ext, scaling, band_rows);
+                CHECK(std::equal(banded.begin(), banded.end(), serial.begin()));
+            }
+        }
+    }
+
+    SECTION("projections are part of the key")
+    {
+        cache.clear();
+        warp(source, prj_trans, source_ext, target_ext, mapnik::SCALING_NEAR);
+        // another transform between the same projections finds the mesh
+        mapnik::proj_transform const same(mapnik::projection("epsg:4326"), mapnik::projection("epsg:3857"));
+        std::size_t const hits = cache.hits();
+        warp(source, same, source_ext, target_ext, mapnik::SCALING_NEAR);
+        CHECK(cache.hits() == hits + 1);
+        CHECK(cache.size() == 1);
+        // identity and inverse transforms get their own meshes
+        mapnik::proj_transform const identity(source_proj, source_proj);
+        warp(source, identity, source_ext, source_ext, mapnik::SCALING_NEAR);
+        mapnik::proj_transform const inverse(target_proj, source_proj);
+        warp(source, inverse, target_ext, source_ext, mapnik::SCALING_NEAR);
+        CHECK(cache.size() == 3);
+        CHECK(cache.hits() == hits + 1);
+        cache.clear();
+    }
+
+    SECTION("source extent and mesh size are part of the key")
+    {
+        cache.clear();
+        warp(source, prj_trans, source_ext, target_ext, mapnik::SCALING_NEAR);
+        mapnik::box2d<double> other(source_ext);
+        other.move(1.0, 0.0);
+        warp(source, prj_trans, other, target_ext, mapnik::SCALING_NEAR);
+        mapnik::image_rgba8 target(300, 300, true, true);
+        mapnik::warp_image(target,
+                           source,
+                           prj_trans,
+                           target_ext,
+                           source_ext,
+                           0.0,
+                           0.0,
+                           32,
+                           mapnik::SCALING_NEAR,
+                           1.0,
+                           std::nullopt);
+        CHECK(cache.size() == 3);
+        CHECK(cache.cost() == 2 * 18 * 14 + 10 * 8);
+        cache.clear();
+    }
+}
@@ -12,8 +12,13 @@
 #include <mapnik/value/types.hpp>
 #include <mapnik/symbolizer.hpp>
 #include <mapnik/geometry/geometry_type.hpp>
+#include <mapnik/geometry/envelope.hpp>
 #include <mapnik/well_known_srs.hpp>
 
+#include <algorithm>
+#include <functional>
+#include <thread>
+
 struct rendering_result
 {
     unsigned start_map_processing = 0;
@@ -118,6 +123,81 @@ class unbuffered_bbox_datasource : public mapnik::memory_datasource
     mutable unsigned query_count_;
 };
 
+// Creates new features on every query and keeps track of those still alive
+class tracking_datasource : public mapnik::memory_datasource
+{
+    class featureset : public mapnik::Featureset
+    {
+      public:
+        explicit featureset(tracking_datasource const& ds)
+            : ds_(ds),
+              ctx_(std::make_shared<mapnik::context_type>()),
+              index_(0)
+        {}
+
+        mapnik::feature_ptr next() override
+        {
+            if (index_ == ds_.count_)
+                return mapnik::feature_ptr();
+            ++index_;
+            mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx_, index_));
+            feature->set_geometry(mapnik::geometry::point<double>(index_, index_));
+            ds_.features_.push_back(feature);
+            ds_.peak_ = std::max(ds_.peak_, ds_.alive());
+            return feature;
+        }
+
+      private:
+        tracking_datasource const& ds_;
+        mapnik::context_ptr ctx_;
+        std::size_t index_;
+    };
+
+  public:
+    explicit tracking_datasource(std::size_t count)
+        : mapnik::memory_datasource(prepare_params()),
+          count_(count),
+          query_count_(0),
+          peak_(0)
+    {}
+
+    mapnik::featureset_ptr features(mapnik::query const& q) const override
+    {
+        ++query_count_;
+        if (on_query_)
+            on_query_();
+        return std::make_shared<featureset>(*this);
+    }
+
+    mapnik::box2d<double> envelope() const override { return mapnik::box2d<double>(0, 0, count_, count_); }
+
+    void on_query(std::function<void()> callback) { on_query_ = std::move(callback); }
+
+    std::size_t alive() const
+    {
+        return std::count_if(features_.begin(), features_.end(), [](auto const& feature) {
+            return !feature.expired();
+        });
+    }
+
+    std::size_t peak() const { return peak_; }
+    unsigned query_count() const { return query_count_; }
+
+  private:
+    static mapnik::parameters prepare_params()
+    {
+        mapnik::parameters params;
+        params["type"] = "memory";
+        return params;
+    }
+
+    std::size_t count_;
+    std::function<void()> on_query_;
+    mutable std::vector<std::weak_ptr<mapnik::feature_impl>> features_;
+    mutable unsigned query_count_;
+    mutable std::size_t peak_;
+};
+
 std::shared_ptr<mapnik::memory_datasource> prepare_datasource()
 {
     mapnik::parameters params;
@@ -256,6 +336,249 @@ TEST_CASE("feature_style_processor")
         REQUIRE(mapnik::geometry::geometry_type(result.geometries[1]) == mapnik::geometry::geometry_types::LineString);
     }
 
+    SECTION("test_renderer - query-threads keeps painting order")
+    {
+        auto const make_map = [](mapnik::value_integer query_threads) {
+            mapnik::Map map(prepare_map());
+            mapnik::feature_type_style points_style;
+            mapnik::rule rule;
+            mapnik::point_symbolizer point_sym;
+            rule.append(std::move(point_sym));
+            points_style.add_rule(std::move(rule));
+            map.insert_style("points", std::move(points_style));
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                mapnik::layer lyr("layer-" + std::to_string(i));
+                auto datasource = std::make_shared<unbuffered_bbox_datasource>();
+                mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+                for (unsigned j = 0; j <= i; ++j)
+                {
+                    mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, j));
+                    feature->set_geometry(mapnik::geometry::point<double>(i, j));
+                    datasource->push(feature);
+                }
+                lyr.set_datasource(datasource);
+                lyr.set_query_ahead(true);
+                lyr.add_style("lines");
+                if (i % 2 == 0)
+                    lyr.add_style("points");
+                map.add_layer(lyr);
+            }
+            map.get_extra_parameters()["query-threads"] = query_threads;
+            map.zoom_all();
+            return map;
+        };
+
+        mapnik::Map serial_map(make_map(0));
+        rendering_result serial;
+        test_renderer serial_renderer(serial_map, serial);
+        serial_renderer.apply();
+
+        mapnik::Map parallel_map(make_map(2));
+        rendering_result parallel;
+        test_renderer parallel_renderer(parallel_map, parallel);
+        parallel_renderer.apply();
+
+        REQUIRE(parallel_renderer.painted());
+        REQUIRE(parallel.end_layer_processing == serial.end_layer_processing);
+        REQUIRE(parallel.start_style_processing == serial.start_style_processing);
+        REQUIRE(parallel.end_style_processing == serial.end_style_processing);
+        REQUIRE(parallel.layer_query_extents == serial.layer_query_extents);
+        REQUIRE(parallel.geometries.size() == serial.geometries.size());
+        for (std::size_t i = 0; i < parallel.geometries.size(); ++i)
+        {
+            REQUIRE(mapnik::geometry::geometry_type(parallel.geometries[i]) ==
+                    mapnik::geometry::geometry_type(serial.geometries[i]));
+            REQUIRE(mapnik::geometry::envelope(parallel.geometries[i]) ==
+                    mapnik::geometry::envelope(serial.geometries[i]));
+        }
+        for (std::size_t i = 1; i < parallel_map.layers().size(); ++i)
+        {
+            auto const& ds = dynamic_cast<unbuffered_bbox_datasource const&>(*parallel_map.get_layer(i).datasource());
+            REQUIRE(ds.query_count() == 1);
+        }
+    }
+
+    SECTION("test_renderer - only query-ahead layers are queried on the pool")
+    {
+        auto ahead = std::make_shared<tracking_datasource>(3);
+        auto inline_ds = std::make_shared<tracking_datasource>(3);
+        rendering_result result;
+        std::size_t painted = 0;
+        std::thread::id query_thread;
+        inline_ds->on_query([&]() {
+            painted = result.geometries.size();
+            query_thread = std::this_thread::get_id();
+        });
+
+        mapnik::Map map(prepare_map());
+        map.remove_layer(0);
+        for (auto const& ds : {ahead, inline_ds})
+        {
+            mapnik::layer lyr("layer");
+            lyr.set_datasource(ds);
+            lyr.set_query_ahead(ds == ahead);
+            lyr.add_style("lines");
+            map.add_layer(lyr);
+        }
+        map.get_extra_parameters()["query-threads"] = mapnik::value_integer(2);
+        map.zoom_to_box(mapnik::box2d<double>(0, 0, 20, 20));
+
+        test_renderer renderer(map, result);
+        renderer.apply();
+        CHECK(result.geometries.size() == 2 * 3);
+        CHECK(ahead->query_count() == 1);
+        CHECK(inline_ds->query_count() == 1);
+        // the second layer is queried on the rendering thread while preparing it, as without query-threads
+        CHECK(painted == 0);
+        CHECK(query_thread == std::this_thread::get_id());
+    }
+
+    SECTION("test_renderer - cache-features layers share queries")
+    {
+        auto const make_map = [](bool cache_features, mapnik::value_integer query_threads) {
+            mapnik::Map map(prepare_map());
+            auto datasource = std::make_shared<unbuffered_bbox_datasource>();
+            mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+            for (unsigned i = 0; i < 3; ++i)
+            {
+                mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i));
+                feature->set_geometry(mapnik::geometry::point<double>(i, i));
+                datasource->push(feature);
+            }
+            for (unsigned i = 0; i < 3; ++i)
+            {
+                mapnik::layer lyr("shared-" + std::to_string(i));
+                lyr.set_datasource(datasource);
+                lyr.set_cache_features(cache_features);
+                lyr.add_style("lines");
+                map.add_layer(lyr);
+            }
+            map.get_extra_parameters()["query-threads"] = query_threads;
+            map.zoom_all();
+            return map;
+        };
+
+        for (mapnik::value_integer query_threads : {0, 2})
+        {
+            mapnik::Map map(make_map(true, query_threads));
+            rendering_result result;
+            test_renderer renderer(map, result);
+            renderer.apply();
+            auto const& ds = dynamic_cast<unbuffered_bbox_datasource const&>(*map.get_layer(1).datasource());
+            CHECK(ds.query_count() == 1);
+            REQUIRE(result.geometries.size() == 2 + 3 * 3);
+
+            mapnik::Map uncached_map(make_map(false, query_threads));
+            rendering_result uncached;
+            test_renderer uncached_renderer(uncached_map, uncached);
+            uncached_renderer.apply();
+            auto const& uncached_ds =
+              dynamic_cast<unbuffered_bbox_datasource const&>(*uncached_map.get_layer(1).datasource());
+            CHECK(uncached_ds.query_count() == 3);
+            REQUIRE(uncached.geometries.size() == result.geometries.size());
+            for (std::size_t i = 0; i < result.geometries.size(); ++i)
+            {
+                REQUIRE(mapnik::geometry::envelope(result.geometries[i]) ==
+                        mapnik::geometry::envelope(uncached.geometries[i]));
+            }
+        }
+    }
+
+    SECTION("test_renderer - cached queries are filtered by the smaller layer extent")
+    {
+        auto datasource = std::make_shared<unbuffered_bbox_datasource>();
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        {
+            // inside the render extent and inside the buffer only
+            mapnik::feature_ptr inside(mapnik::feature_factory::create(ctx, 1));
+            inside->set_geometry(mapnik::geometry::point<double>(0, 0));
+            datasource->push(inside);
+            mapnik::feature_ptr buffer(mapnik::feature_factory::create(ctx, 2));
+            buffer->set_geometry(mapnik::geometry::point<double>(1100000, 0));
+            datasource->push(buffer);
+        }
+
+        mapnik::Map map(256, 256, mapnik::MAPNIK_WEBMERCATOR_PROJ);
+        map.set_buffer_size(64);
+        mapnik::feature_type_style lines_style;
+        mapnik::rule rule;
+        mapnik::line_symbolizer line_sym;
+        rule.append(std::move(line_sym));
+        lines_style.add_rule(std::move(rule));
+        map.insert_style("lines", std::move(lines_style));
+
+        mapnik::layer buffered("buffered", mapnik::MAPNIK_WEBMERCATOR_PROJ);
+        buffered.set_datasource(datasource);
+        buffered.set_cache_features(true);
+        buffered.add_style("lines");
+        map.add_layer(buffered);
+        mapnik::layer unbuffered("unbuffered", mapnik::MAPNIK_WEBMERCATOR_PROJ);
+        unbuffered.set_datasource(datasource);
+        unbuffered.set_cache_features(true);
+        unbuffered.set_buffer_size(0);
+        unbuffered.add_style("lines");
+        map.add_layer(unbuffered);
+        map.zoom_to_box(mapnik::box2d<double>(-1000000, -1000000, 1000000, 1000000));
+
+        rendering_result result;
+        test_renderer renderer(map, result);
+        renderer.apply();
+
+        CHECK(datasource->query_count() == 1);
+        REQUIRE(result.geometries.size() == 3);
+        CHECK(mapnik::geometry::envelope(result.geometries[2]) == mapnik::box2d<double>(0, 0, 0, 0));
+    }
+
+    SECTION("test_renderer - cached features are released after their last reader")
+    {
+        auto shared = std::make_shared<tracking_datasource>(10);
+        auto last = std::make_shared<tracking_datasource>(1);
+        std::size_t alive = 0;
+        last->on_query([&]() { alive = shared->alive(); });
+
+        mapnik::Map map(prepare_map());
+        map.remove_layer(0);
+        for (auto const& ds : {shared, shared, last})
+        {
+            mapnik::layer lyr("cached");
+            lyr.set_datasource(ds);
+            lyr.set_cache_features(true);
+            lyr.add_style("lines");
+            map.add_layer(lyr);
+        }
+        map.zoom_to_box(mapnik::box2d<double>(0, 0, 20, 20));
+
+        rendering_result result;
+        test_renderer renderer(map, result);
+        renderer.apply();
+        CHECK(shared->query_count() == 1);
+        CHECK(result.geometries.size() == 2 * 10 + 1);
+        // the last layer is queried once the layers sharing the first query are rendered
+        CHECK(last->query_count() == 1);
+        CHECK(alive == 0);
+    }
+
+    SECTION("test_renderer - single style cache-features layers aren't buffered")
+    {
+        auto ds = std::make_shared<tracking_datasource>(10);
+        mapnik::Map map(prepare_map());
+        map.remove_layer(0);
+        mapnik::layer lyr("streamed");
+        lyr.set_datasource(ds);
+        lyr.set_cache_features(true);
+        lyr.add_style("lines");
+        map.add_layer(lyr);
+        map.zoom_to_box(mapnik::box2d<double>(0, 0, 20, 20));
+
+        rendering_result result;
+        test_renderer renderer(map, result);
+        renderer.apply();
+        CHECK(result.geometries.size() == 10);
+        // the feature being rendered and the next one
+        CHECK(ds->peak() <= 2);
+    }
+
     SECTION("query unbuffered bbox equals the metatile before buffer padding when unclipped")
     {
         // Same SRS everywhere with no query clipping: !unbuffered_bbox! must
@@ -0,0 +1,246 @@
+#include "catch.hpp"
+
+// mapnik
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/color.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/vertex_converters.hpp>
+#include <mapnik/view_transform.hpp>
+#include <mapnik/util/math.hpp>
+#include <mapnik/renderer_common/geometry_cache.hpp>
+
+// stl
+#include <cmath>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+mapnik::line_symbolizer make_line(mapnik::color const& stroke, double width)
+{
+    mapnik::line_symbolizer sym;
+    mapnik::put(sym, mapnik::keys::stroke, stroke);
+    mapnik::put(sym, mapnik::keys::stroke_width, width);
+    mapnik::put(sym, mapnik::keys::simplify_tolerance, 0.5);
+    mapnik::put(sym, mapnik::keys::smooth, 0.3);
+    return sym;
+}
+
+mapnik::Map make_map(bool geometry_cache, bool cache_features = true)
+{
+    mapnik::parameters params;
+    params["type"] = "memory";
+    auto ds = std::make_shared<mapnik::memory_datasource>(params);
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    for (int i = 0; i < 40; ++i)
+    {
+        mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i + 1));
+        double const x = std::fmod(i * 37.1, 256.0);
+        double const y = std::fmod(i * 11.3, 256.0);
+        if (i % 2 == 0)
+        {
+            mapnik::geometry::line_string<double> line;
+            for (int k = 0; k < 30; ++k)
+            {
+                line.emplace_back(x - 40 + k * 4, y + 20 * std::sin(k * 0.7 + i));
+            }
+            feature->set_geometry(std::move(line));
+        }
+        else
+        {
+            mapnik::geometry::polygon<double> poly;
+            mapnik::geometry::linear_ring<double> ring;
+            for (int k = 0; k < 24; ++k)
+            {
+                double const angle = k * mapnik::util::pi / 12.0;
+                double const radius = 25 + 5 * std::cos(k * 1.3);
+                ring.emplace_back(x + radius * std::cos(angle), y + radius * std::sin(angle));
+            }
+            ring.push_back(ring.front());
+            poly.push_back(std::move(ring));
+            feature->set_geometry(std::move(poly));
+        }
+        ds->push(feature);
+    }
+
+    mapnik::Map map(256, 256);
+    map.set_background(mapnik::color(240, 240, 220));
+    mapnik::feature_type_style fill;
+    {
+        mapnik::rule r;
+        mapnik::polygon_symbolizer sym;
+        mapnik::put(sym, mapnik::keys::fill, mapnik::color(120, 160, 200));
+        mapnik::put(sym, mapnik::keys::fill_opacity, 0.6);
+        mapnik::put(sym, mapnik::keys::clip, true);
+        r.append(std::move(sym));
+        fill.add_rule(std::move(r));
+    }
+    mapnik::feature_type_style casing;
+    {
+        mapnik::rule r;
+        r.append(make_line(mapnik::color(60, 60, 60), 6.0));
+        casing.add_rule(std::move(r));
+    }
+    mapnik::feature_type_style road;
+    {
+        mapnik::rule r;
+        r.append(make_line(mapnik::color(250, 200, 80), 3.0));
+        road.add_rule(std::move(r));
+    }
+    map.insert_style("fill", std::move(fill));
+    map.insert_style("casing", std::move(casing));
+    map.insert_style("road", std::move(road));
+    mapnik::layer lyr("roads");
+    lyr.set_datasource(ds);
+    lyr.add_style("fill");
+    lyr.add_style("casing");
+    lyr.add_style("road");
+    lyr.set_cache_features(cache_features);
+    map.add_layer(lyr);
+    if (geometry_cache)
+    {
+        map.get_extra_parameters()["geometry-cache"] = true;
+    }
+    map.zoom_to_box(mapnik::box2d<double>(0, 0, 256, 256));
+    return map;
+}
+
+mapnik::image_rgba8 render(mapnik::Map const& map, std::size_t* hits = nullptr)
+{
+    mapnik::image_rgba8 image(map.width(), map.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(map, image);
+    ren.apply();
+    if (hits)
+    {
+        mapnik::geometry_cache const* cache = ren.get_geometry_cache();
+        REQUIRE(cache != nullptr);
+        *hits = cache->hits();
+    }
+    return image;
+}
+
+using vertices_type = std::vector<std::tuple<double, double, unsigned>>;
+
+template<typename Path>
+void append(vertices_type& vertices, Path& path)
+{
+    path.rewind(0);
+    double x;
+    double y;
+    unsigned cmd;
+    while ((cmd = path.vertex(&x, &y)) != mapnik::SEG_END)
+    {
+        vertices.emplace_back(x, y, cmd);
+    }
+}
+
+} // namespace
+
+TEST_CASE("geometry_cache")
+{
+    SECTION("styles of a layer render the same with the cache")
+    {
+        mapnik::image_rgba8 const expected = render(make_map(false));
+        std::size_t hits = 0;
+        mapnik::image_rgba8 const actual = render(make_map(true), &hits);
+        // the road style replays the geometries converted for the casing
+        CHECK(hits > 0);
+        CHECK(mapnik::compare(expected, actual, 0) == 0);
+    }
+
+    SECTION("styles querying the datasource on their own don't use the cache")
+    {
+        mapnik::image_rgba8 const expected = render(make_map(false, false));
+        std::size_t hits = 0;
+        mapnik::image_rgba8 const actual = render(make_map(true, false), &hits);
+        CHECK(hits == 0);
+        CHECK(mapnik::compare(expected, actual, 0) == 0);
+    }
+
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, 7));
+    mapnik::geometry::multi_line_string<double> lines;
+    lines.emplace_back(mapnik::geometry::line_string<double>{{0, 0}, {50, 20}, {100, 0}});
+    lines.emplace_back(mapnik::geometry::line_string<double>{{10, 90}, {90, 90}});
+    feature->set_geometry(std::move(lines));
+
+    mapnik::line_symbolizer sym;
+    mapnik::attributes vars;
+    mapnik::box2d<double> const extent(0, 0, 100, 100);
+    mapnik::view_transform const t(200, 200, extent);
+    mapnik::projection const proj("epsg:4326");
+    mapnik::proj_transform const prj_trans(proj, proj);
+    agg::trans_affine const tr;
+
+    using converter_type = mapnik::vertex_converter<mapnik::transform_tag>;
+    converter_type converter(extent, sym, t, prj_trans, tr, *feature, vars, 1.0);
+    converter.set<mapnik::transform_tag>();
+    auto make_key = [&] {
+        return mapnik::geometry_cache_key(*feature, mapnik::geometry_cache_key::no_clip, extent, tr, sym, vars);
+    };
+
+    SECTION("converted paths are replayed")
+    {
+        vertices_type expected;
+        mapnik::apply_geometry_cache(nullptr, make_key, converter, *feature, [&](auto& path) {
+            append(expected, path);
+        });
+        REQUIRE(expected.size() == 5);
+
+        mapnik::geometry_cache cache;
+        vertices_type first;
+        vertices_type second;
+        mapnik::apply_geometry_cache(&cache, make_key, converter, *feature, [&](auto& path) {
+            append(first, path);
+        });
+        mapnik::apply_geometry_cache(&cache, make_key, converter, *feature, [&](auto& path) {
+            append(second, path);
+        });
+        CHECK(cache.misses() == 1);
+        CHECK(cache.hits() == 1);
+        CHECK(cache.bytes() == sizeof(mapnik::geometry_cache_key) + sizeof(mapnik::geometry_cache::paths_ptr) +
+                                 sizeof(mapnik::geometry_cache::paths_type) +
+                                 2 * sizeof(mapnik::geometry_cache_path) + 5 * sizeof(agg::vertex_d));
+        CHECK(first == expected);
+        CHECK(second == expected);
+
+        // a different geometry transform is a different key
+        agg::trans_affine const scaled = agg::trans_affine_scaling(2.0);
+        mapnik::geometry_cache_key const other(*feature,
+                                               mapnik::geometry_cache_key::no_clip,
+                                               extent,
+                                               scaled,
+                                               sym,
+                                               vars);
+        CHECK(!cache.find(other));
+        CHECK(cache.misses() == 2);
+        cache.clear();
+        CHECK(cache.bytes() == 0);
+    }
+
+    SECTION("bounded")
+    {
+        mapnik::geometry_cache cache(4);
+        vertices_type vertices;
+        mapnik::apply_geometry_cache(&cache, make_key, converter, *feature, [&](auto& path) {
+            append(vertices, path);
+        });
+        CHECK(vertices.size() == 5);
+        CHECK(cache.bytes() == 0);
+        CHECK(!cache.find(make_key()));
+    }
+}
@@ -0,0 +1,196 @@
+#include "catch.hpp"
+
+// mapnik
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/color.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/filesystem.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/marker_sprite_cache.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/parse_path.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/transform/parse_transform.hpp>
+
+// stl
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace {
+
+mapnik::markers_symbolizer make_symbolizer(std::string const& filename)
+{
+    mapnik::markers_symbolizer sym;
+    mapnik::put(sym, mapnik::keys::file, mapnik::parse_path(filename));
+    mapnik::put(sym, mapnik::keys::allow_overlap, true);
+    mapnik::put(sym, mapnik::keys::ignore_placement, true);
+    return sym;
+}
+
+mapnik::Map make_map(mapnik::markers_symbolizer const& red, mapnik::markers_symbolizer const& translucent)
+{
+    mapnik::parameters params;
+    params["type"] = "memory";
+    auto ds = std::make_shared<mapnik::memory_datasource>(params);
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    for (int i = 0; i < 200; ++i)
+    {
+        mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i + 1));
+        double const x = 8 + std::fmod(i * 23.37, 240.0);
+        double const y = 8 + std::fmod(i * 7.91, 240.0);
+        feature->set_geometry(mapnik::geometry::point<double>(x, y));
+        ds->push(feature);
+    }
+
+    mapnik::Map map(256, 256);
+    map.set_background(mapnik::color(240, 240, 220));
+    mapnik::feature_type_style style;
+    mapnik::rule r;
+    r.append(red);
+    r.append(translucent);
+    style.add_rule(std::move(r));
+    map.insert_style("markers", std::move(style));
+    mapnik::layer lyr("markers");
+    lyr.set_datasource(ds);
+    lyr.add_style("markers");
+    map.add_layer(lyr);
+    map.zoom_to_box(mapnik::box2d<double>(0, 0, 256, 256));
+    return map;
+}
+
+// horizontal lines at fractional heights, markers placed along them with a fractional spacing
+mapnik::Map make_line_map(mapnik::markers_symbolizer const& sym)
+{
+    mapnik::parameters params;
+    params["type"] = "memory";
+    auto ds = std::make_shared<mapnik::memory_datasource>(params);
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    for (int i = 0; i < 6; ++i)
+    {
+        mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i + 1));
+        double const y = 20.3 + i * 40.55;
+        mapnik::geometry::line_string<double> line;
+        line.emplace_back(0, y);
+        line.emplace_back(256, y);
+        feature->set_geometry(std::move(line));
+        ds->push(feature);
+    }
+
+    mapnik::Map map(256, 256);
+    map.set_background(mapnik::color(240, 240, 220));
+    mapnik::feature_type_style style;
+    mapnik::rule r;
+    r.append(sym);
+    style.add_rule(std::move(r));
+    map.insert_style("markers", std::move(style));
+    mapnik::layer lyr("markers");
+    lyr.set_datasource(ds);
+    lyr.add_style("markers");
+    map.add_layer(lyr);
+    map.zoom_to_box(mapnik::box2d<double>(0, 0, 256, 256));
+    return map;
+}
+
+mapnik::image_rgba8 render(mapnik::Map const& map)
+{
+    mapnik::image_rgba8 image(map.width(), map.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(map, image);
+    ren.apply();
+    return image;
+}
+
+} // namespace
+
+TEST_CASE("marker_sprite_cache")
+{
+    std::string const directory_name = mapnik::fs::path(mapnik::fs::temp_directory_path() / "mapnik-tests").string();
+    mapnik::fs::create_directories(directory_name);
+    std::string const filename = directory_name + "/marker_sprite_cache.svg";
+    {
+        std::ofstream file(filename);
+        file << "<svg xmlns='http://www.w3.org/2000/svg' width='20' height='16'>"
+                "<path d='M 1 1 Q 10 -4 19 1 L 16 15 L 3 12 Z' fill='#c81e1e' stroke='black' stroke-width='2'/>"
+                "<circle cx='10' cy='7' r='4' fill='#141ee6' fill-opacity='0.7'/>"
+                "</svg>";
+    }
+
+    mapnik::marker_sprite_cache& cache = mapnik::marker_sprite_cache::instance();
+    std::size_t const capacity = cache.capacity();
+
+    mapnik::markers_symbolizer red = make_symbolizer(filename);
+    mapnik::markers_symbolizer translucent = make_symbolizer(filename);
+    mapnik::put(translucent, mapnik::keys::fill, mapnik::color(0, 128, 0));
+    mapnik::put(translucent, mapnik::keys::opacity, 0.5);
+    mapnik::put(translucent, mapnik::keys::image_transform, mapnik::parse_transform("rotate(30) scale(1.5)"));
+    mapnik::Map const map = make_map(red, translucent);
+
+    cache.set_capacity(0);
+    mapnik::image_rgba8 const expected = render(map);
+    CHECK(cache.size() == 0);
+
+    cache.set_capacity(1 << 20);
+    cache.clear();
+    std::size_t const hits = cache.hits();
+    std::size_t const misses = cache.misses();
+    mapnik::image_rgba8 const actual = render(map);
+
+    SECTION("file markers are snapped to pixels, every placement is blitted from one sprite per style")
+    {
+        CHECK(cache.misses() == misses + 2);
+        CHECK(cache.hits() == hits + 2 * 200 - 2);
+        CHECK(cache.size() == 2);
+        // compositing the paths into the sprite first rounds differently
+        CHECK(mapnik::compare(expected, actual, 1) == 0);
+    }
+
+    SECTION("shape markers along lines aren't snapped, placements share sprites per subpixel offset")
+    {
+        mapnik::markers_symbolizer arrow = make_symbolizer("shape://arrow");
+        mapnik::put(arrow, mapnik::keys::markers_placement_type, mapnik::marker_placement_enum::MARKER_LINE_PLACEMENT);
+        mapnik::put(arrow, mapnik::keys::spacing, 17.3);
+        mapnik::put(arrow, mapnik::keys::width, 11.0);
+        mapnik::put(arrow, mapnik::keys::height, 7.0);
+        mapnik::put(arrow, mapnik::keys::fill, mapnik::color(200, 30, 30));
+        mapnik::put(arrow, mapnik::keys::opacity, 0.8);
+        mapnik::Map const line_map = make_line_map(arrow);
+
+        cache.set_capacity(0);
+        mapnik::image_rgba8 const line_expected = render(line_map);
+        cache.set_capacity(1 << 20);
+        cache.clear();
+        std::size_t const line_hits = cache.hits();
+        std::size_t const line_misses = cache.misses();
+        mapnik::image_rgba8 const line_actual = render(line_map);
+
+        std::size_t const placements = cache.hits() - line_hits + cache.misses() - line_misses;
+        constexpr std::size_t offsets = mapnik::marker_sprite_cache::subpixel_steps *
+                                        mapnik::marker_sprite_cache::subpixel_steps;
+        // every line gets a marker per spacing, all but the first at each offset are hits
+        CHECK(placements > 6 * 12);
+        CHECK(cache.size() == cache.misses() - line_misses);
+        CHECK(cache.size() <= offsets);
+        CHECK(cache.hits() - line_hits == placements - cache.size());
+        // markers are moved by at most half a subpixel step, which only shifts their antialiased edges
+        mapnik::image_rgba8 background(256, 256);
+        mapnik::fill(background, mapnik::color(240, 240, 220));
+        std::size_t const painted = mapnik::compare(background, line_expected, 0);
+        REQUIRE(painted > 0);
+        CHECK(mapnik::compare(line_expected, line_actual, 48) == 0);
+        CHECK(mapnik::compare(line_expected, line_actual, 16) < painted / 4);
+    }
+
+    cache.set_capacity(capacity);
+    cache.clear();
+    mapnik::marker_cache::instance().clear();
+    mapnik::fs::remove(filename);
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+#include "../../../utils/mapnik-render/tile_batch.hpp"
+
+// mapnik
+#include <mapnik/filesystem.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/well_known_srs.hpp>
+
+// stl
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using mapnik::detail::tile;
+
+std::vector<std::tuple<unsigned, unsigned, unsigned>> addresses(std::vector<tile> const& tiles)
+{
+    std::vector<std::tuple<unsigned, unsigned, unsigned>> result;
+    for (tile const& t : tiles)
+    {
+        result.emplace_back(t.z, t.x, t.y);
+    }
+    return result;
+}
+
+std::vector<tile> tiles_in_extent(mapnik::box2d<double> const& extent, unsigned min_zoom, unsigned max_zoom)
+{
+    return mapnik::detail::tiles_in_extent(mapnik::MAPNIK_WEBMERCATOR_PROJ, extent, min_zoom, max_zoom);
+}
+
+} // namespace
+
+TEST_CASE("tile batch")
+{
+    using address = std::tuple<unsigned, unsigned, unsigned>;
+    double const max = mapnik::MERC_MAX_EXTENT;
+
+    SECTION("tiles in extent")
+    {
+        // the whole world
+        std::vector<tile> world = tiles_in_extent(mapnik::box2d<double>(-max, -max, max, max), 0, 2);
+        REQUIRE(world.size() == 1 + 4 + 16);
+        CHECK(addresses(world).front() == address(0, 0, 0));
+        CHECK(addresses(world).back() == address(2, 3, 3));
+
+        // an extent ending on tile edges doesn't reach into the next tiles
+        CHECK(addresses(tiles_in_extent(mapnik::box2d<double>(0, 0, max, max), 1, 1)) ==
+              std::vector<address>{address(1, 1, 0)});
+        CHECK(addresses(tiles_in_extent(mapnik::box2d<double>(-max, -max, 0, 0), 1, 2)) ==
+              std::vector<address>{address(1, 0, 1), address(2, 0, 2), address(2, 0, 3), address(2, 1, 2),
+                                   address(2, 1, 3)});
+
+        // a point selects the tile it starts
+        CHECK(addresses(tiles_in_extent(mapnik::box2d<double>(0, 0, 0, 0), 1, 1)) ==
+              std::vector<address>{address(1, 1, 1)});
+
+        // extents beyond the antimeridian and the poles are clipped to the last tiles
+        CHECK(addresses(tiles_in_extent(mapnik::box2d<double>(max - 1, max - 1, 2 * max, 2 * max), 2, 2)) ==
+              std::vector<address>{address(2, 3, 0)});
+        CHECK(tiles_in_extent(mapnik::box2d<double>(-3 * max, -3 * max, 3 * max, 3 * max), 1, 1).size() == 4);
+
+        // geographic extents are projected to web mercator first
+        CHECK(addresses(mapnik::detail::tiles_in_extent(mapnik::MAPNIK_GEOGRAPHIC_PROJ,
+                                                        mapnik::box2d<double>(0, 0, 180, 85),
+                                                        1,
+                                                        1)) == std::vector<address>{address(1, 1, 0)});
+
+        // the deepest zoom level has 2^30 tiles per row, less than 4cm wide
+        CHECK(addresses(tiles_in_extent(mapnik::box2d<double>(max - 0.01, max - 0.01, max, max), 30, 30)) ==
+              std::vector<address>{address(30, (1u << 30) - 1, 0)});
+
+        CHECK_THROWS_AS(tiles_in_extent(mapnik::box2d<double>(-max, -max, max, max), 0, 31), std::runtime_error);
+        CHECK_THROWS_AS(tiles_in_extent(mapnik::box2d<double>(-max, -max, max, max), 3, 2), std::runtime_error);
+    }
+
+    SECTION("read tile list")
+    {
+        std::string const directory_name =
+          mapnik::fs::path(mapnik::fs::temp_directory_path() / "mapnik-tests").string();
+        mapnik::fs::create_directories(directory_name);
+        std::string const filename = directory_name + "/tile_batch_list.txt";
+        auto const write_list = [&filename](std::string const& content) {
+            std::ofstream file(filename, std::ios::out | std::ios::trunc);
+            file << content;
+        };
+
+        write_list("# tiles\n"
+                   "0/0/0\n"
+                   "\n"
+                   "   \t\n"
+                   "  2 3 1  \n"
+                   "  # indented comment\n"
+                   "30/1073741823/0");
+        CHECK(addresses(mapnik::detail::read_tile_list(filename)) ==
+              std::vector<address>{address(0, 0, 0), address(2, 3, 1), address(30, (1u << 30) - 1, 0)});
+
+        write_list("");
+        CHECK(mapnik::detail::read_tile_list(filename).empty());
+
+        for (std::string const line : {"1/2/0",     // x out of range
+                                       "1/0/2",     // y out of range
+                                       "31/0/0",    // zoom out of range
+                                       "-1/0/0",    // negative zoom
+                                       "1/0",       // missing y
+                                       "1/0/0/0",   // trailing field
+                                       "1/0/0 png", // trailing text
+                                       "a/b/c",
+                                       "1,0,0"})
+        {
+            INFO(line);
+            write_list("0/0/0\n# comment\n" + std::string(line) + "\n0/0/0\n");
+            CHECK_THROWS_WITH(mapnik::detail::read_tile_list(filename), Catch::Contains(filename + ":3"));
+        }
+
+        mapnik::fs::remove(filename);
+        CHECK_THROWS_AS(mapnik::detail::read_tile_list(filename), std::runtime_error);
+    }
+}
@@ -0,0 +1,90 @@
+#include "catch.hpp"
+
+#include <mapnik/expression.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/parse_path.hpp>
+#include <mapnik/resolved_symbolizer.hpp>
+#include <mapnik/symbolizer.hpp>
+
+#include <memory>
+
+using namespace mapnik;
+
+namespace {
+
+feature_ptr make_feature(context_ptr const& ctx, double width)
+{
+    feature_ptr feature = feature_factory::create(ctx, 1);
+    feature->put("width", width);
+    return feature;
+}
+
+} // namespace
+
+TEST_CASE("resolved symbolizer")
+{
+    context_ptr ctx = std::make_shared<context_type>();
+    ctx->push("width");
+    feature_ptr f1 = make_feature(ctx, 2.0);
+    feature_ptr f2 = make_feature(ctx, 5.0);
+    attributes vars;
+    vars["scale"] = 3.0;
+
+    SECTION("feature dependence")
+    {
+        CHECK_FALSE(is_feature_dependent(value_double(1.0)));
+        CHECK_FALSE(is_feature_dependent(parse_expression("1 + 2")));
+        CHECK_FALSE(is_feature_dependent(parse_expression("@scale * 2")));
+        CHECK(is_feature_dependent(parse_expression("[width] * 2")));
+        CHECK(is_feature_dependent(parse_expression("max(1, [width])")));
+        CHECK(is_feature_dependent(parse_expression("[mapnik::geometry_type] = polygon")));
+        CHECK_FALSE(is_feature_dependent(parse_path("icon.svg")));
+        CHECK(is_feature_dependent(parse_path("[width].svg")));
+    }
+
+    SECTION("line properties")
+    {
+        line_symbolizer sym;
+        put(sym, keys::stroke_width, parse_expression("[width] * 2"));
+        put(sym, keys::stroke_opacity, parse_expression("@scale / 4"));
+        put(sym, keys::stroke, color(255, 0, 0));
+        put(sym, keys::stroke_linecap, line_cap_enum::ROUND_CAP);
+
+        line_symbolizer_properties props(sym, *f1, vars);
+        CHECK_FALSE(props.stroke_width.constant());
+        CHECK(props.stroke_opacity.constant());
+        CHECK(props.stroke.constant());
+        CHECK_FALSE(props.has_dasharray);
+        CHECK_FALSE(props.geometry_transform);
+
+        for (feature_ptr const& f : {f1, f2})
+        {
+            CHECK(props.stroke_width.get(*f, vars) == get<value_double, keys::stroke_width>(sym, *f, vars));
+            CHECK(props.stroke_opacity.get(*f, vars) == get<value_double, keys::stroke_opacity>(sym, *f, vars));
+            CHECK(props.stroke.get(*f, vars) == get<color, keys::stroke>(sym, *f, vars));
+            CHECK(props.stroke_linecap.get(*f, vars) == line_cap_enum::ROUND_CAP);
+            // unset properties resolve to the symbolizer defaults
+            CHECK(props.stroke_linejoin.get(*f, vars) == get<line_join_enum, keys::stroke_linejoin>(sym, *f, vars));
+            CHECK(props.offset.get(*f, vars) == 0.0);
+        }
+        CHECK(props.stroke_width.get(*f2, vars) == 10.0);
+        CHECK(props.stroke_opacity.get(*f2, vars) == 0.75);
+    }
+
+    SECTION("cache")
+    {
+        polygon_symbolizer poly;
+        put(poly, keys::fill, parse_expression("'#ff0000'"));
+        line_symbolizer line;
+        resolved_symbolizer_cache cache;
+        polygon_symbolizer_properties const& props = cache.get(poly, *f1, vars);
+        CHECK(props.fill.constant());
+        CHECK(props.fill.get(*f2, vars) == color(255, 0, 0));
+        CHECK(&cache.get(poly, *f2, vars) == &props);
+        cache.get(line, *f1, vars);
+        CHECK(cache.size() == 2);
+        cache.clear();
+        CHECK(cache.size() == 0);
+    }
+}
@@ -0,0 +1,176 @@
+#include "catch.hpp"
+
+#include <mapnik/filesystem.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/text/face.hpp>
+#include <mapnik/text/font_library.hpp>
+#include <mapnik/text/glyph_cache.hpp>
+#include <mapnik/text/glyph_positions.hpp>
+#include <mapnik/text/renderer.hpp>
+#include <mapnik/text/text_properties.hpp>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+mapnik::glyph_cache_key make_key(unsigned glyph_index)
+{
+    return mapnik::glyph_cache_key{"DejaVuSans.ttf:0", glyph_index, 16 * 64, 0x10000, 0, 0, 0x10000, 0, 0, 0};
+}
+
+mapnik::glyph_bitmap make_bitmap(unsigned size)
+{
+    return mapnik::glyph_bitmap{0, 0, size, 1, std::vector<unsigned char>(size, 255)};
+}
+
+mapnik::image_rgba8 render_text(mapnik::face_manager& fm,
+                                mapnik::glyph_cache* cache,
+                                mapnik::halo_rasterizer_e rasterizer,
+                                double advance)
+{
+    mapnik::face_ptr face = fm.get_face("DejaVu Sans Book");
+    REQUIRE(face != nullptr);
+    auto format = std::make_unique<mapnik::detail::evaluated_format_properties>();
+    format->text_size = 16;
+    format->text_opacity = 1.0;
+    format->halo_opacity = 1.0;
+    format->fill = mapnik::color(0, 0, 0);
+    format->halo_fill = mapnik::color(255, 255, 255);
+    format->halo_radius = 1.5;
+
+    std::vector<std::unique_ptr<mapnik::glyph_info>> glyphs;
+    mapnik::glyph_positions positions;
+    positions.set_base_point(mapnik::pixel_position(10.25, 30.5));
+    double x = 0;
+    for (char c : std::string("Mapnik Mapnik"))
+    {
+        auto glyph = std::make_unique<mapnik::glyph_info>(FT_Get_Char_Index(face->get_face(), c), 0, format);
+        glyph->face = face;
+        positions.emplace_back(*glyph, mapnik::pixel_position(x, 0), mapnik::rotation());
+        glyphs.push_back(std::move(glyph));
+        x += advance;
+    }
+
+    mapnik::image_rgba8 image(160, 48);
+    mapnik::agg_text_renderer<mapnik::image_rgba8> ren(image,
+                                                       rasterizer,
+                                                       mapnik::src_over,
+                                                       mapnik::src_over,
+                                                       1.0,
+                                                       fm.get_stroker());
+    ren.set_glyph_cache(cache);
+    ren.render(positions);
+    return image;
+}
+
+// Number of pixels with a channel differing by more than `threshold`
+std::size_t differences(mapnik::image_rgba8 const& a, mapnik::image_rgba8 const& b, int threshold)
+{
+    std::size_t count = 0;
+    for (std::size_t y = 0; y < a.height(); ++y)
+    {
+        for (std::size_t x = 0; x < a.width(); ++x)
+        {
+            unsigned pa = a(x, y);
+            unsigned pb = b(x, y);
+            for (unsigned shift = 0; shift < 32; shift += 8)
+            {
+                if (std::abs(static_cast<int>((pa >> shift) & 0xff) - static_cast<int>((pb >> shift) & 0xff)) >
+                    threshold)
+                {
+                    ++count;
+                    break;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+TEST_CASE("glyph cache")
+{
+    SECTION("every field of the key tells glyphs apart")
+    {
+        mapnik::glyph_cache cache(1024 * 1024);
+        cache.insert(make_key(1), make_bitmap(16));
+        CHECK(cache.find(make_key(1)) != nullptr);
+        CHECK(cache.cost() == sizeof(mapnik::glyph_cache_key) + make_key(1).face.size() +
+                                sizeof(mapnik::glyph_bitmap) + 16);
+
+        auto key = make_key(1);
+        key.subpixel_x = 2;
+        CHECK(cache.find(key) == nullptr);
+        key = make_key(1);
+        key.halo_radius = 64;
+        CHECK(cache.find(key) == nullptr);
+        key = make_key(1);
+        key.face = "DejaVuSans-Bold.ttf:0";
+        CHECK(cache.find(key) == nullptr);
+    }
+
+    SECTION("cached glyphs render like uncached glyphs")
+    {
+        mapnik::freetype_engine::register_fonts("fonts/dejavu-fonts-ttf-2.37/ttf/");
+        mapnik::font_library fl;
+        mapnik::freetype_engine::font_file_mapping_type font_file_mapping;
+        mapnik::freetype_engine::font_memory_cache_type font_memory_cache;
+        mapnik::face_manager fm(fl, font_file_mapping, font_memory_cache);
+        mapnik::glyph_cache cache(1024 * 1024);
+
+        for (auto rasterizer : {mapnik::halo_rasterizer_enum::HALO_RASTERIZER_FULL,
+                                mapnik::halo_rasterizer_enum::HALO_RASTERIZER_FAST})
+        {
+            cache.clear();
+            std::size_t const misses = cache.misses();
+            mapnik::image_rgba8 expected = render_text(fm, nullptr, rasterizer, 9.5);
+            mapnik::image_rgba8 first = render_text(fm, &cache, rasterizer, 9.5);
+            CHECK(cache.misses() > misses);
+            CHECK(cache.size() == cache.misses() - misses);
+            mapnik::image_rgba8 second = render_text(fm, &cache, rasterizer, 9.5);
+            CHECK(cache.size() == cache.misses() - misses);
+            CHECK(differences(first, second, 0) == 0);
+            // glyph origins on a quarter pixel aren't moved
+            CHECK(differences(expected, first, 0) == 0);
+
+            // otherwise they're snapped to the nearest quarter pixel
+            expected = render_text(fm, nullptr, rasterizer, 9.3);
+            first = render_text(fm, &cache, rasterizer, 9.3);
+            CHECK(differences(expected, first, 96) < 40);
+        }
+    }
+
+    SECTION("faces of the same name from different files aren't shared")
+    {
+        std::string const font_file = "fonts/dejavu-fonts-ttf-2.37/ttf/DejaVuSans.ttf";
+        std::string const directory_name =
+          mapnik::fs::path(mapnik::fs::temp_directory_path() / "mapnik-tests").string();
+        mapnik::fs::create_directories(directory_name);
+        std::string const copy = directory_name + "/glyph-cache-DejaVuSans.ttf";
+        mapnik::fs::remove(copy);
+        mapnik::fs::copy_file(font_file, copy);
+
+        // two maps registering the face name for their own file
+        mapnik::font_library fl;
+        mapnik::freetype_engine::font_file_mapping_type mapping_a{{"DejaVu Sans Book", {0, font_file}}};
+        mapnik::freetype_engine::font_file_mapping_type mapping_b{{"DejaVu Sans Book", {0, copy}}};
+        mapnik::freetype_engine::font_memory_cache_type font_memory_cache;
+        mapnik::face_manager fm_a(fl, mapping_a, font_memory_cache);
+        mapnik::face_manager fm_b(fl, mapping_b, font_memory_cache);
+        mapnik::glyph_cache cache(1024 * 1024);
+
+        auto const rasterizer = mapnik::halo_rasterizer_enum::HALO_RASTERIZER_FULL;
+        render_text(fm_a, &cache, rasterizer, 9.5);
+        std::size_t const size = cache.size();
+        std::size_t const misses = cache.misses();
+        render_text(fm_b, &cache, rasterizer, 9.5);
+        CHECK(cache.misses() == misses + size);
+        CHECK(cache.size() == 2 * size);
+        mapnik::fs::remove(copy);
+    }
+}
@@ -1,7 +1,9 @@
 #include "catch.hpp"
 #include <mapnik/text/icu_shaper.hpp>
 #include <mapnik/text/harfbuzz_shaper.hpp>
+#include <mapnik/text/shaping_cache.hpp>
 #include <mapnik/text/font_library.hpp>
+#include <mapnik/filesystem.hpp>
 #include <mapnik/unicode.hpp>
 #include <mapnik/util/from_u8string.hpp>
 
@@ -111,3 +113,113 @@ TEST_CASE("shaping")
         test_shaping(fontset, fm, expected, from_u8string(u8"ⵃⴰⵢ ⵚⵉⵏⴰⵄⵉ الحي الصناعي").c_str());
     }
 }
+
+TEST_CASE("shaping cache")
+{
+    mapnik::freetype_engine::register_fonts("fonts/dejavu-fonts-ttf-2.37/ttf/");
+    mapnik::font_set fontset("fontset");
+    fontset.add_face_name("DejaVu Sans Book");
+
+    mapnik::font_library fl;
+    mapnik::freetype_engine::font_file_mapping_type font_file_mapping;
+    mapnik::freetype_engine::font_memory_cache_type font_memory_cache;
+    mapnik::face_manager fm(fl, font_file_mapping, font_memory_cache);
+
+    struct shaped
+    {
+        unsigned glyph_index;
+        unsigned char_index;
+        double advance;
+    };
+
+    auto shape_with = [&](mapnik::face_manager& manager, char const* str, double text_size) {
+        mapnik::transcoder tr("utf8");
+        std::map<unsigned, double> width_map;
+        mapnik::text_itemizer itemizer;
+        auto props = std::make_unique<mapnik::detail::evaluated_format_properties>();
+        props->fontset = fontset;
+        props->text_size = text_size;
+        auto ustr = tr.transcode(str);
+        itemizer.add_text(ustr, props);
+        mapnik::text_line line(0, ustr.length());
+        mapnik::harfbuzz_shaper::shape_text(line, itemizer, width_map, manager, 1.0);
+        std::vector<shaped> result;
+        for (auto const& g : line)
+        {
+            result.push_back({g.glyph_index, g.char_index, g.advance()});
+        }
+        return result;
+    };
+    auto shape = [&](char const* str, double text_size) { return shape_with(fm, str, text_size); };
+
+    mapnik::shaping_cache& cache = mapnik::shaping_cache::instance();
+
+    SECTION("repeated labels are shaped once")
+    {
+        cache.clear();
+        std::size_t const hits = cache.hits();
+        auto first = shape("Mapnik", 12);
+        CHECK(cache.size() == 1);
+        auto second = shape("Mapnik", 12);
+        CHECK(cache.hits() == hits + 1);
+        REQUIRE(first.size() == 6);
+        REQUIRE(second.size() == first.size());
+        // shaping happens at the unscaled size, other text sizes reuse the result
+        auto larger = shape("Mapnik", 24);
+        CHECK(cache.hits() == hits + 2);
+        REQUIRE(larger.size() == first.size());
+        for (std::size_t i = 0; i < first.size(); ++i)
+        {
+            CHECK(first[i].glyph_index != 0);
+            CHECK(second[i].glyph_index == first[i].glyph_index);
+            CHECK(second[i].char_index == first[i].char_index);
+            CHECK(second[i].advance == Approx(first[i].advance));
+            CHECK(larger[i].advance == Approx(2 * first[i].advance));
+        }
+        shape("Mapnik Street", 12);
+        CHECK(cache.size() == 2);
+    }
+
+    SECTION("disabled")
+    {
+        cache.clear();
+        std::size_t const capacity = cache.capacity();
+        cache.set_capacity(0);
+        auto first = shape("Mapnik", 12);
+        CHECK(first.size() == 6);
+        CHECK(cache.size() == 0);
+        cache.set_capacity(capacity);
+    }
+
+    SECTION("faces of the same name from different files aren't shared")
+    {
+        std::string const directory = "fonts/dejavu-fonts-ttf-2.37/ttf/";
+        std::string const temp_directory =
+          mapnik::fs::path(mapnik::fs::temp_directory_path() / "mapnik-tests").string();
+        mapnik::fs::create_directories(temp_directory);
+        std::string const copy = temp_directory + "/shaping-cache-DejaVuSans.ttf";
+        mapnik::fs::remove(copy);
+        mapnik::fs::copy_file(directory + "DejaVuSans.ttf", copy);
+
+        // maps registering "DejaVu Sans Book" for their own file
+        mapnik::freetype_engine::font_file_mapping_type mapping_copy{{"DejaVu Sans Book", {0, copy}}};
+        mapnik::freetype_engine::font_file_mapping_type mapping_mono{
+          {"DejaVu Sans Book", {0, directory + "DejaVuSansMono.ttf"}}};
+        mapnik::face_manager fm_copy(fl, mapping_copy, font_memory_cache);
+        mapnik::face_manager fm_mono(fl, mapping_mono, font_memory_cache);
+
+        cache.clear();
+        auto sans = shape("Mapnik", 12);
+        auto sans_copy = shape_with(fm_copy, "Mapnik", 12);
+        CHECK(cache.size() == 2);
+        auto mono = shape_with(fm_mono, "Mapnik", 12);
+        CHECK(cache.size() == 3);
+        REQUIRE(sans.size() == 6);
+        REQUIRE(sans_copy.size() == sans.size());
+        REQUIRE(mono.size() == sans.size());
+        CHECK(sans_copy[1].advance == Approx(sans[1].advance));
+        CHECK(mono[1].advance != Approx(sans[1].advance));
+        CHECK(mono[0].advance == Approx(mono[1].advance));
+        mapnik::fs::remove(copy);
+    }
+}
@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <mapnik/util/lru_cache.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace {
+
+// values cost their length
+struct length
+{
+    std::size_t operator()(int, std::string const& value) const { return value.size(); }
+};
+
+using cache_type = mapnik::util::lru_cache<int, std::string, std::hash<int>, length>;
+
+} // namespace
+
+TEST_CASE("lru_cache")
+{
+    SECTION("lookups")
+    {
+        cache_type cache(100);
+        CHECK(cache.find(1) == nullptr);
+        auto value = cache.insert(1, "one");
+        REQUIRE(value != nullptr);
+        CHECK(*value == "one");
+        CHECK(cache.find(1) == value);
+        CHECK(cache.hits() == 1);
+        CHECK(cache.misses() == 1);
+
+        // the first value inserted for a key is kept
+        CHECK(cache.insert(1, "uno") == value);
+        CHECK(cache.size() == 1);
+        CHECK(cache.cost() == 3);
+    }
+
+    SECTION("least recently used values are evicted")
+    {
+        cache_type cache(8);
+        cache.insert(1, "aaa");
+        cache.insert(2, "bbb");
+        CHECK(cache.find(1) != nullptr);
+        cache.insert(3, "ccc");
+        CHECK(cache.size() == 2);
+        CHECK(cache.cost() == 6);
+        CHECK(cache.evictions() == 1);
+        CHECK(cache.find(2) == nullptr);
+        CHECK(cache.find(1) != nullptr);
+        CHECK(cache.find(3) != nullptr);
+
+        // shrinking evicts down to the new capacity
+        cache.set_capacity(3);
+        CHECK(cache.evictions() == 2);
+        CHECK(cache.find(1) == nullptr);
+        CHECK(cache.find(3) != nullptr);
+
+        cache.clear();
+        CHECK(cache.size() == 0);
+        CHECK(cache.cost() == 0);
+        CHECK(cache.find(3) == nullptr);
+    }
+
+    SECTION("values costing more than the capacity are returned but not stored")
+    {
+        cache_type cache(4);
+        cache.insert(1, "a");
+        auto value = cache.insert(2, "too long");
+        REQUIRE(value != nullptr);
+        CHECK(*value == "too long");
+        CHECK(cache.find(2) == nullptr);
+        CHECK(cache.find(1) != nullptr);
+        CHECK(cache.evictions() == 0);
+    }
+
+    SECTION("disabled")
+    {
+        cache_type cache(0);
+        CHECK(cache.insert(1, "") != nullptr);
+        CHECK(cache.insert(2, "two") != nullptr);
+        CHECK(cache.size() == 0);
+        CHECK(cache.find(1) == nullptr);
+    }
+
+    SECTION("evicted values stay valid for their users")
+    {
+        cache_type cache(3);
+        auto value = cache.insert(1, "one");
+        cache.insert(2, "two");
+        CHECK(cache.find(1) == nullptr);
+        CHECK(*value == "one");
+    }
+}
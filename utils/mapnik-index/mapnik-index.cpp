@@ -230,6 +230,7 @@ int main(int argc, char** argv)
                 mapnik::util::index_record rec = {std::get<1>(item).first, std::get<1>(item).second, ext_f};
                 tree.insert(rec, ext_f);
             }
+            tree.compact();
 
             std::fstream file((filename + ".index").c_str(),
                               std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
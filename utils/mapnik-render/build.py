@@ -8,6 +8,7 @@ program_env = env.Clone()
 source = Split(
     """
     mapnik-render.cpp
+    tile_batch.cpp
     """
     )
 
@@ -21,6 +22,16 @@ if env['HAS_CAIRO']:
 boost_program_options = 'boost_program_options%s' % env['BOOST_APPEND']
 libraries = [env['MAPNIK_NAME'],boost_program_options]
 libraries.extend(copy(env['LIBMAPNIK_LIBS']))
+
+# MBTiles output of the batch mode
+if 'sqlite' in env['REQUESTED_PLUGINS'] and 'sqlite3' not in env['SKIPPED_DEPS']:
+    program_env.Append(CPPDEFINES = '-DMAPNIK_RENDER_MBTILES')
+    program_env.PrependUnique(CPPPATH = env['SQLITE_INCLUDES'])
+    program_env.PrependUnique(LIBPATH = env['SQLITE_LIBS'])
+    libraries.append('sqlite3')
+    if env['SQLITE_LINKFLAGS']:
+        program_env.Append(LINKFLAGS=env['SQLITE_LINKFLAGS'])
+
 if env['RUNTIME_LINK'] == 'static' and env['PLATFORM'] == 'Linux':
     libraries.append('dl')
 
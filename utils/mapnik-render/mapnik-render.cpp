@@ -11,6 +11,7 @@
 #include <mapnik/proj_transform.hpp>
 #include <mapnik/filesystem.hpp>
 #include <mapnik/warning.hpp>
+#include "tile_batch.hpp"
 MAPNIK_DISABLE_WARNING_PUSH
 #include <mapnik/warning_ignore.hpp>
 #include <boost/algorithm/string.hpp>
@@ -19,6 +20,7 @@ MAPNIK_DISABLE_WARNING_PUSH
 #include <boost/fusion/adapted/struct.hpp>
 MAPNIK_DISABLE_WARNING_POP
 
+#include <memory>
 #include <string>
 
 BOOST_FUSION_ADAPT_STRUCT(mapnik::box2d<double>, (double, minx_)(double, miny_)(double, maxx_)(double, maxy_))
@@ -58,7 +60,17 @@ int main(int argc, char** argv)
             ("bbox", po::value<std::string>(), "bounding box  e.g <minx,miny,maxx,maxy> in Map's SRS")
             ("geographic,g","bounding box is in WGS 84 lon/lat")
             ("plugins-dir", po::value<std::string>(), "directory containing input plug-ins (default: ./plugins/input)")
-            ("fonts-dir", po::value<std::string>(), "directory containing fonts (default: relative to <plugins-dir> or ./fonts if no <plugins-dir> specified)");
+            ("fonts-dir", po::value<std::string>(), "directory containing fonts (default: relative to <plugins-dir> or ./fonts if no <plugins-dir> specified)")
+            ("tiles-dir", po::value<std::string>(), "batch mode: render tiles into <tiles-dir>/{z}/{x}/{y}.<ext>")
+#if defined(MAPNIK_RENDER_MBTILES)
+            ("mbtiles", po::value<std::string>(), "batch mode: render web mercator tiles into an MBTiles file")
+#endif
+            ("zoom", po::value<std::string>(), "batch mode: zoom levels covering <bbox> e.g <min>-<max> or <z>")
+            ("tile-list", po::value<std::string>(), "batch mode: file with one <z>/<x>/<y> tile per line")
+            ("metatile", po::value<unsigned>(), "batch mode: metatile size in tiles (default: 8)")
+            ("tile-size", po::value<unsigned>(), "batch mode: tile size in pixels (default: 256)")
+            ("threads", po::value<unsigned>(), "batch mode: number of render threads (default: number of CPUs)")
+            ("format", po::value<std::string>(), "batch mode: tile image format (default: png)");
         // clang-format on
         po::positional_options_description p;
         p.add("xml", 1);
@@ -99,11 +111,12 @@ int main(int argc, char** argv)
             return -1;
         }
 
+        bool const batch = vm.count("tiles-dir") || vm.count("mbtiles");
         if (vm.count("img"))
         {
             img_file = vm["img"].as<std::string>();
         }
-        else
+        else if (!batch)
         {
             std::clog << "please provide an img as second argument!" << std::endl;
             return -1;
@@ -175,11 +188,11 @@ int main(int argc, char** argv)
         mapnik::Map map(map_width, map_height);
         mapnik::load_map(map, xml_file, true);
 
+        mapnik::box2d<double> bbox;
         if (vm.count("bbox"))
         {
             namespace x3 = boost::spirit::x3;
 
-            mapnik::box2d<double> bbox;
             std::string str = vm["bbox"].as<std::string>();
 
             auto start = str.begin();
@@ -217,9 +230,6 @@ int main(int argc, char** argv)
         {
             map.zoom_all();
         }
-        mapnik::image_rgba8 im(map.width(), map.height());
-        mapnik::request req(map.width(), map.height(), map.get_current_extent());
-        req.set_buffer_size(map.buffer_size());
         mapnik::attributes vars;
         if (params_as_variables)
         {
@@ -244,6 +254,71 @@ int main(int argc, char** argv)
                 }
             }
         }
+        if (batch)
+        {
+            namespace x3 = boost::spirit::x3;
+
+            mapnik::detail::batch_options options;
+            options.scale_factor = scale_factor;
+            if (vm.count("metatile"))
+                options.metatile = vm["metatile"].as<unsigned>();
+            if (vm.count("tile-size"))
+                options.tile_size = vm["tile-size"].as<unsigned>();
+            if (vm.count("threads"))
+                options.threads = vm["threads"].as<unsigned>();
+            if (vm.count("format"))
+                options.format = vm["format"].as<std::string>();
+
+            std::vector<mapnik::detail::tile> tiles;
+            if (vm.count("tile-list"))
+            {
+                tiles = mapnik::detail::read_tile_list(vm["tile-list"].as<std::string>());
+            }
+            else if (vm.count("zoom"))
+            {
+                std::string str = vm["zoom"].as<std::string>();
+                std::vector<unsigned> zooms;
+                auto start = str.begin();
+                auto end = str.end();
+                if (!x3::phrase_parse(start, end, x3::uint_ % '-', x3::space, zooms) || start != end ||
+                    zooms.size() > 2)
+                {
+                    std::cerr << "Failed to parse zoom range: " << str << std::endl;
+                    return -1;
+                }
+                // tiles covering the bbox, or the whole map
+                tiles = mapnik::detail::tiles_in_extent(map.srs(),
+                                                        bbox.valid() ? bbox : map.get_current_extent(),
+                                                        zooms.front(),
+                                                        zooms.back());
+            }
+            else
+            {
+                std::clog << "mapnik-render: batch mode requires --zoom or --tile-list" << std::endl;
+                return -1;
+            }
+
+            std::unique_ptr<mapnik::detail::tile_sink> sink;
+#if defined(MAPNIK_RENDER_MBTILES)
+            if (vm.count("mbtiles"))
+            {
+                sink = std::make_unique<mapnik::detail::mbtiles_sink>(vm["mbtiles"].as<std::string>(),
+                                                                      mapnik::fs::path(xml_file).stem().string(),
+                                                                      options.format);
+            }
+            else
+#endif
+            {
+                sink = std::make_unique<mapnik::detail::directory_sink>(vm["tiles-dir"].as<std::string>(),
+                                                                        options.format);
+            }
+            mapnik::detail::render_tiles(map, tiles, vars, options, *sink);
+            return return_value;
+        }
+
+        mapnik::image_rgba8 im(map.width(), map.height());
+        mapnik::request req(map.width(), map.height(), map.get_current_extent());
+        req.set_buffer_size(map.buffer_size());
         mapnik::agg_renderer<mapnik::image_rgba8> ren(map, req, vars, im, scale_factor, 0, 0);
         ren.apply();
         mapnik::save_to_file(im, img_file);
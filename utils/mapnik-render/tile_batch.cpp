@@ -0,0 +1,473 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "tile_batch.hpp"
+
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/image_view.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/request.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/well_known_srs.hpp>
+#include <mapnik/thread_pool.hpp>
+#include <mapnik/filesystem.hpp>
+
+#if defined(MAPNIK_RENDER_MBTILES)
+#include <sqlite3.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+namespace mapnik {
+namespace detail {
+
+namespace {
+
+constexpr unsigned max_zoom_level = 30;
+
+// block of adjacent tiles rendered in one pass
+struct metatile
+{
+    unsigned z;
+    unsigned x; // top left tile
+    unsigned y;
+    unsigned width; // in tiles
+    unsigned height;
+    std::vector<tile> tiles;
+};
+
+double tile_span(unsigned z)
+{
+    return 2.0 * MERC_MAX_EXTENT / std::ldexp(1.0, static_cast<int>(z));
+}
+
+box2d<double> tile_box(unsigned z, unsigned x, unsigned y, unsigned width, unsigned height)
+{
+    double span = tile_span(z);
+    double minx = -MERC_MAX_EXTENT + x * span;
+    double maxy = MERC_MAX_EXTENT - y * span;
+    return box2d<double>(minx, maxy - height * span, minx + width * span, maxy);
+}
+
+// metatiles covering `tiles` grouped by zoom level
+std::map<unsigned, std::vector<metatile>> make_metatiles(std::vector<tile> const& tiles, unsigned size)
+{
+    std::map<std::tuple<unsigned, unsigned, unsigned>, metatile> blocks;
+    for (tile const& t : tiles)
+    {
+        unsigned num_tiles = 1u << t.z;
+        unsigned n = std::min(size, num_tiles);
+        unsigned x = t.x / n * n;
+        unsigned y = t.y / n * n;
+        auto itr = blocks.find(std::make_tuple(t.z, x, y));
+        if (itr == blocks.end())
+        {
+            metatile mt{t.z, x, y, std::min(n, num_tiles - x), std::min(n, num_tiles - y), {}};
+            itr = blocks.emplace(std::make_tuple(t.z, x, y), std::move(mt)).first;
+        }
+        itr->second.tiles.push_back(t);
+    }
+    std::map<unsigned, std::vector<metatile>> result;
+    for (auto& block : blocks)
+    {
+        result[block.second.z].push_back(std::move(block.second));
+    }
+    return result;
+}
+
+void render_metatile(Map& m,
+                     proj_transform const& tr,
+                     metatile const& mt,
+                     attributes const& vars,
+                     batch_options const& options,
+                     tile_sink& sink)
+{
+    unsigned ts = options.tile_size;
+    box2d<double> box = tile_box(mt.z, mt.x, mt.y, mt.width, mt.height);
+    if (!tr.equal() && !tr.backward(box, PROJ_ENVELOPE_POINTS))
+    {
+        throw std::runtime_error("mapnik-render: failed to project metatile " + std::to_string(mt.z) + "/" +
+                                 std::to_string(mt.x) + "/" + std::to_string(mt.y) + " into " + m.srs());
+    }
+    m.resize(mt.width * ts, mt.height * ts);
+    m.zoom_to_box(box);
+    image_rgba8 im(m.width(), m.height());
+    request req(m.width(), m.height(), m.get_current_extent());
+    req.set_buffer_size(m.buffer_size());
+    agg_renderer<image_rgba8> ren(m, req, vars, im, options.scale_factor, 0, 0);
+    ren.apply();
+
+    // slice and encode the sub-tiles on the shared pool, helping out while waiting
+    thread_pool& pool = thread_pool::instance();
+    std::vector<std::future<std::string>> encoded;
+    encoded.reserve(mt.tiles.size());
+    for (tile const& t : mt.tiles)
+    {
+        image_view_rgba8 view((t.x - mt.x) * ts, (t.y - mt.y) * ts, ts, ts, im);
+        encoded.push_back(pool.submit([view, &options]() { return save_to_string(view, options.format); }));
+    }
+    std::exception_ptr error;
+    for (std::size_t i = 0; i < encoded.size(); ++i)
+    {
+        try
+        {
+            sink.write(mt.tiles[i], pool.get(encoded[i]));
+        }
+        catch (...)
+        {
+            // keep waiting for the remaining tasks, they refer to `im`
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace
+
+std::string tile_extension(std::string const& format)
+{
+    if (format.compare(0, 3, "png") == 0)
+        return "png";
+    if (format.compare(0, 4, "jpeg") == 0 || format.compare(0, 3, "jpg") == 0)
+        return "jpg";
+    if (format.compare(0, 4, "webp") == 0)
+        return "webp";
+    if (format.compare(0, 4, "tiff") == 0)
+        return "tif";
+    return format.substr(0, format.find(':'));
+}
+
+std::vector<tile> tiles_in_extent(std::string const& srs,
+                                  box2d<double> const& extent,
+                                  unsigned min_zoom,
+                                  unsigned max_zoom)
+{
+    if (min_zoom > max_zoom || max_zoom > max_zoom_level)
+    {
+        throw std::runtime_error("mapnik-render: invalid zoom range " + std::to_string(min_zoom) + "-" +
+                                 std::to_string(max_zoom));
+    }
+    box2d<double> box = extent;
+    projection source(srs);
+    projection merc(MAPNIK_WEBMERCATOR_PROJ);
+    proj_transform tr(source, merc);
+    if (!tr.equal() && !tr.forward(box, PROJ_ENVELOPE_POINTS))
+    {
+        throw std::runtime_error("mapnik-render: failed to project extent into web mercator");
+    }
+    box.clip(box2d<double>(-MERC_MAX_EXTENT, -MERC_MAX_EXTENT, MERC_MAX_EXTENT, MERC_MAX_EXTENT));
+
+    std::vector<tile> tiles;
+    for (unsigned z = min_zoom; z <= max_zoom; ++z)
+    {
+        double span = tile_span(z);
+        double last = std::ldexp(1.0, static_cast<int>(z)) - 1;
+        auto index = [span, last](double offset) {
+            return static_cast<unsigned>(std::clamp(std::floor(offset / span), 0.0, last));
+        };
+        unsigned x0 = index(box.minx() + MERC_MAX_EXTENT);
+        unsigned x1 = index(std::nextafter(box.maxx() + MERC_MAX_EXTENT, 0.0));
+        unsigned y0 = index(MERC_MAX_EXTENT - box.maxy());
+        unsigned y1 = index(std::nextafter(MERC_MAX_EXTENT - box.miny(), 0.0));
+        for (unsigned x = x0; x <= std::max(x0, x1); ++x)
+        {
+            for (unsigned y = y0; y <= std::max(y0, y1); ++y)
+            {
+                tiles.push_back(tile{z, x, y});
+            }
+        }
+    }
+    return tiles;
+}
+
+std::vector<tile> read_tile_list(std::string const& filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        throw std::runtime_error("mapnik-render: failed to open tile list " + filename);
+    }
+    std::vector<tile> tiles;
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(file, line))
+    {
+        ++line_number;
+        std::replace(line.begin(), line.end(), '/', ' ');
+        std::istringstream s(line);
+        s >> std::ws;
+        if (s.eof() || s.peek() == '#')
+        {
+            continue;
+        }
+        tile t;
+        std::string rest;
+        if (!(s >> t.z >> t.x >> t.y) || (s >> rest) || t.z > max_zoom_level || t.x >= (1u << t.z) ||
+            t.y >= (1u << t.z))
+        {
+            throw std::runtime_error("mapnik-render: invalid tile at " + filename + ":" + std::to_string(line_number));
+        }
+        tiles.push_back(t);
+    }
+    return tiles;
+}
+
+directory_sink::directory_sink(std::string const& dir, std::string const& format)
+    : dir_(dir),
+      extension_(tile_extension(format))
+{}
+
+void directory_sink::write(tile const& t, std::string const& data)
+{
+    fs::path path = fs::path(dir_) / std::to_string(t.z) / std::to_string(t.x);
+    fs::create_directories(path);
+    path /= std::to_string(t.y) + "." + extension_;
+    std::ofstream file(path.string(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file || !file.write(data.data(), data.size()))
+    {
+        throw std::runtime_error("mapnik-render: failed to write " + path.string());
+    }
+}
+
+#if defined(MAPNIK_RENDER_MBTILES)
+struct mbtiles_sink::impl
+{
+    sqlite3* db = nullptr;
+    sqlite3_stmt* insert = nullptr;
+    std::string name;
+    std::string format;
+
+    void exec(std::string const& sql)
+    {
+        char* err = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK)
+        {
+            std::string msg = err ? err : sqlite3_errmsg(db);
+            sqlite3_free(err);
+            throw std::runtime_error("mapnik-render: " + msg);
+        }
+    }
+
+    void check(int rc)
+    {
+        if (rc != SQLITE_OK && rc != SQLITE_DONE)
+        {
+            throw std::runtime_error(std::string("mapnik-render: ") + sqlite3_errmsg(db));
+        }
+    }
+
+    ~impl()
+    {
+        sqlite3_finalize(insert);
+        sqlite3_close(db);
+    }
+};
+
+mbtiles_sink::mbtiles_sink(std::string const& filename, std::string const& name, std::string const& format)
+    : impl_(std::make_unique<impl>())
+{
+    impl_->name = name;
+    impl_->format = tile_extension(format);
+    if (sqlite3_open(filename.c_str(), &impl_->db) != SQLITE_OK)
+    {
+        throw std::runtime_error("mapnik-render: failed to open " + filename + ": " + sqlite3_errmsg(impl_->db));
+    }
+    impl_->exec("PRAGMA synchronous=OFF");
+    impl_->exec("CREATE TABLE IF NOT EXISTS metadata (name text, value text)");
+    impl_->exec("CREATE TABLE IF NOT EXISTS tiles (zoom_level integer, tile_column integer, tile_row integer, "
+                "tile_data blob)");
+    impl_->exec("CREATE UNIQUE INDEX IF NOT EXISTS tile_index ON tiles (zoom_level, tile_column, tile_row)");
+    impl_->exec("BEGIN");
+    impl_->check(sqlite3_prepare_v2(impl_->db,
+                                    "INSERT OR REPLACE INTO tiles (zoom_level, tile_column, tile_row, tile_data) "
+                                    "VALUES (?, ?, ?, ?)",
+                                    -1,
+                                    &impl_->insert,
+                                    nullptr));
+}
+
+mbtiles_sink::~mbtiles_sink() {}
+
+void mbtiles_sink::write(tile const& t, std::string const& data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    sqlite3_stmt* stmt = impl_->insert;
+    sqlite3_bind_int(stmt, 1, static_cast<int>(t.z));
+    sqlite3_bind_int(stmt, 2, static_cast<int>(t.x));
+    // MBTiles rows are numbered from the south (TMS)
+    sqlite3_bind_int(stmt, 3, static_cast<int>((1u << t.z) - 1 - t.y));
+    sqlite3_bind_blob(stmt, 4, data.data(), static_cast<int>(data.size()), SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    impl_->check(rc);
+}
+
+void mbtiles_sink::finish(std::vector<tile> const& tiles)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned min_zoom = max_zoom_level;
+    unsigned max_zoom = 0;
+    box2d<double> bounds;
+    for (tile const& t : tiles)
+    {
+        min_zoom = std::min(min_zoom, t.z);
+        max_zoom = std::max(max_zoom, t.z);
+        box2d<double> box = tile_box(t.z, t.x, t.y, 1, 1);
+        if (bounds.valid())
+            bounds.expand_to_include(box);
+        else
+            bounds = box;
+    }
+    double minx = bounds.minx(), miny = bounds.miny(), maxx = bounds.maxx(), maxy = bounds.maxy();
+    merc2lonlat(minx, miny);
+    merc2lonlat(maxx, maxy);
+    std::ostringstream bbox;
+    bbox << std::setprecision(12) << minx << "," << miny << "," << maxx << "," << maxy;
+
+    std::vector<std::pair<std::string, std::string>> metadata = {{"name", impl_->name},
+                                                                 {"format", impl_->format},
+                                                                 {"type", "baselayer"},
+                                                                 {"minzoom", std::to_string(min_zoom)},
+                                                                 {"maxzoom", std::to_string(max_zoom)},
+                                                                 {"bounds", bbox.str()}};
+    impl_->exec("DELETE FROM metadata");
+    sqlite3_stmt* stmt = nullptr;
+    impl_->check(sqlite3_prepare_v2(impl_->db, "INSERT INTO metadata (name, value) VALUES (?, ?)", -1, &stmt, nullptr));
+    for (auto const& item : metadata)
+    {
+        sqlite3_bind_text(stmt, 1, item.first.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, item.second.c_str(), -1, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_DONE)
+        {
+            sqlite3_finalize(stmt);
+            impl_->check(rc);
+        }
+    }
+    sqlite3_finalize(stmt);
+    impl_->exec("COMMIT");
+}
+#endif
+
+void render_tiles(Map const& map,
+                  std::vector<tile> const& tiles,
+                  attributes const& vars,
+                  batch_options const& options,
+                  tile_sink& sink)
+{
+    using clock = std::chrono::steady_clock;
+    unsigned threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::size_t total_tiles = 0;
+    clock::duration total_time{0};
+
+    for (auto const& level : make_metatiles(tiles, std::max(1u, options.metatile)))
+    {
+        std::vector<metatile> const& metatiles = level.second;
+        std::atomic<std::size_t> next(0);
+        std::atomic<std::int64_t> render_time(0);
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto work = [&]() {
+            try
+            {
+                // each thread renders with its own copy, datasources are shared
+                Map m(map);
+                projection merc(MAPNIK_WEBMERCATOR_PROJ);
+                projection dest(m.srs());
+                proj_transform tr(dest, merc);
+                std::size_t index;
+                while ((index = next++) < metatiles.size())
+                {
+                    auto start = clock::now();
+                    render_metatile(m, tr, metatiles[index], vars, options, sink);
+                    render_time += std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+                next = metatiles.size();
+            }
+        };
+
+        auto start = clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < std::min<std::size_t>(threads, metatiles.size()); ++i)
+        {
+            workers.emplace_back(work);
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        clock::duration elapsed = clock::now() - start;
+
+        std::size_t num_tiles = 0;
+        for (metatile const& mt : metatiles)
+        {
+            num_tiles += mt.tiles.size();
+        }
+        total_tiles += num_tiles;
+        total_time += elapsed;
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        std::clog << "zoom " << level.first << ": " << num_tiles << " tiles (" << metatiles.size() << " metatiles) in "
+                  << std::fixed << std::setprecision(2) << seconds << "s, " << std::setprecision(1)
+                  << num_tiles / std::max(seconds, 1e-9) << " tiles/s, "
+                  << render_time.load() / 1000.0 / metatiles.size() << "ms/metatile" << std::endl;
+    }
+    sink.finish(tiles);
+    double seconds = std::chrono::duration<double>(total_time).count();
+    std::clog << "rendered " << total_tiles << " tiles with " << threads << " threads in " << std::fixed
+              << std::setprecision(2) << seconds << "s, " << std::setprecision(1)
+              << total_tiles / std::max(seconds, 1e-9) << " tiles/s" << std::endl;
+}
+
+} // namespace detail
+} // namespace mapnik
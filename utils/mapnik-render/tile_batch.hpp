@@ -0,0 +1,117 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2025 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_UTILS_TILE_BATCH_HPP
+#define MAPNIK_UTILS_TILE_BATCH_HPP
+
+#include <mapnik/map.hpp>
+#include <mapnik/attribute.hpp>
+#include <mapnik/geometry/box2d.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mapnik {
+namespace detail {
+
+// XYZ tile address, y grows southwards
+struct tile
+{
+    unsigned z;
+    unsigned x;
+    unsigned y;
+};
+
+struct batch_options
+{
+    unsigned metatile = 8;
+    unsigned tile_size = 256;
+    // render threads, 0 picks the number of CPUs
+    unsigned threads = 0;
+    std::string format = "png";
+    double scale_factor = 1.0;
+};
+
+// Destination of encoded tiles, write() is called concurrently
+class tile_sink
+{
+  public:
+    virtual ~tile_sink() {}
+    virtual void write(tile const& t, std::string const& data) = 0;
+    virtual void finish(std::vector<tile> const& tiles) {}
+};
+
+// <dir>/{z}/{x}/{y}.<ext>
+class directory_sink : public tile_sink
+{
+  public:
+    directory_sink(std::string const& dir, std::string const& format);
+    void write(tile const& t, std::string const& data) override;
+
+  private:
+    std::string dir_;
+    std::string extension_;
+};
+
+#if defined(MAPNIK_RENDER_MBTILES)
+class mbtiles_sink : public tile_sink
+{
+  public:
+    mbtiles_sink(std::string const& filename, std::string const& name, std::string const& format);
+    ~mbtiles_sink();
+    void write(tile const& t, std::string const& data) override;
+    // commits the tiles and writes the metadata table
+    void finish(std::vector<tile> const& tiles) override;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+    std::mutex mutex_;
+};
+#endif
+
+// file extension of the tiles encoded as `format`, e.g. png8:z=1 -> png
+std::string tile_extension(std::string const& format);
+
+// Web mercator tiles of zoom levels [min_zoom, max_zoom] intersecting `extent`, given in `srs`
+std::vector<tile> tiles_in_extent(std::string const& srs,
+                                  box2d<double> const& extent,
+                                  unsigned min_zoom,
+                                  unsigned max_zoom);
+
+// Reads a tile list with one "z/x/y" (or "z x y") per line, blank lines and lines starting with '#' are skipped
+std::vector<tile> read_tile_list(std::string const& filename);
+
+// Renders `tiles` in metatiles on `options.threads` threads, each with its own copy of `map`.
+// The sub-tiles are encoded on the shared thread pool. Throughput is reported per zoom level.
+void render_tiles(Map const& map,
+                  std::vector<tile> const& tiles,
+                  attributes const& vars,
+                  batch_options const& options,
+                  tile_sink& sink);
+
+} // namespace detail
+} // namespace mapnik
+
+#endif // MAPNIK_UTILS_TILE_BATCH_HPP